@@ -116,6 +116,27 @@ class DeviceBase:
   def getDDRPblock(self, ddr):
     return self.DDR_TO_CLOCK_REGIONS[ddr]
 
+  # each clock region column has 2 laguna columns at an SLR boundary, each has 1440 SLL wires
+  LAGUNA_COLUMN_NUM_PER_CR = 2
+  SLL_NUM_PER_LAGUNA_COLUMN = 1440
+
+  # fraction of the laguna columns of a clock region column taken by the Vitis infra
+  LAGUNA_RESERVED_RATIO = {}
+
+  def getSLLCapacityOfColumn(self, x: int) -> float:
+    """
+    number of SLL wires available to user in clock region column x at any SLR boundary
+    """
+    assert 0 <= x < self.CR_NUM_HORIZONTAL, x
+    ratio = 1 - self.LAGUNA_RESERVED_RATIO.get(x, 0)
+    return ratio * self.LAGUNA_COLUMN_NUM_PER_CR * self.SLL_NUM_PER_LAGUNA_COLUMN
+
+  def getSLRCrossingCapacity(self, down_left_x: int, up_right_x: int) -> float:
+    """
+    number of SLL wires available to user at an SLR boundary segment spanning the given columns
+    """
+    return sum(self.getSLLCapacityOfColumn(x) for x in range(down_left_x, up_right_x + 1))
+
 
 class DeviceU250(DeviceBase):
   def _getVitisRegions(self, ddr_list, is_vitis_enabled):
@@ -168,6 +189,9 @@ class DeviceU250(DeviceBase):
   CR_NUM_HORIZONTAL = 8  
   CR_NUM_VERTICAL = 16  
   CR_NUM_VERTICAL_PER_SLR = 4 # each die has 4 CRs vertically
+
+  # the vitis region and the system interconnects use the laguna of the rightmost 1.5 columns
+  LAGUNA_RESERVED_RATIO = {6: 0.5, 7: 1}
   
   # to be compatible with U280
   ACTUAL_SLR_NUM = 4
@@ -276,6 +300,9 @@ class DeviceU280(DeviceBase):
   CR_NUM_HORIZONTAL = 8
   CR_NUM_VERTICAL = 12
   CR_NUM_VERTICAL_PER_SLR = 4
+
+  # the vitis region and the system interconnects use the laguna of the rightmost 1.5 columns
+  LAGUNA_RESERVED_RATIO = {6: 0.5, 7: 1}
   
   TOTAL_AREA = {}
   TOTAL_AREA['BRAM'] = 4032
@@ -1324,6 +1351,9 @@ class DeviceU50(DeviceBase):
   CR_NUM_VERTICAL = 16
   CR_NUM_VERTICAL_PER_SLR = 4
 
+  # the vitis region and the system interconnects use the laguna of the rightmost 1.5 columns
+  LAGUNA_RESERVED_RATIO = {6: 0.5, 7: 1}
+
   CR_NUM_VERTICAL_ACTUAL = 8
 
   VITIS_REGION = f'CLOCKREGION_X6Y0:CLOCKREGION_X7Y6'
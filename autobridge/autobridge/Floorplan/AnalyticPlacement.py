@@ -0,0 +1,268 @@
+import logging
+from collections import defaultdict
+from typing import Dict, List, Optional, Tuple
+
+from autobridge.Floorplan.LegalizeFloorplan import get_legalized_v2s, greedy_legalize_floorplan
+from autobridge.Floorplan.Utilities import (
+  RESOURCE_TYPES,
+  float_range,
+  get_total_wirelength,
+  log_resource_utilization,
+)
+from autobridge.Opt.DataflowGraph import Vertex
+from autobridge.Opt.Slot import Slot
+from autobridge.Opt.SlotManager import SlotManager, Dir
+
+_logger = logging.getLogger('autobridge')
+
+Cluster = Tuple[Vertex, ...]
+Position = Tuple[float, float]
+
+
+def _get_center(slot: Slot) -> Position:
+  return ((slot.down_left_x + slot.up_right_x + 1) / 2,
+          (slot.down_left_y + slot.up_right_y + 1) / 2)
+
+
+def _get_clusters(
+    v_list: List[Vertex],
+    grouping_constraints: List[List[Vertex]],
+) -> List[Cluster]:
+  """
+  merge the vertices that must be assigned to the same slot
+  """
+  parent = {v: v for v in v_list}
+
+  def _find(v):
+    while parent[v] != v:
+      parent[v] = parent[parent[v]]
+      v = parent[v]
+    return v
+
+  for grouping in grouping_constraints:
+    for v in grouping[1:]:
+      parent[_find(v)] = _find(grouping[0])
+
+  root_to_cluster = defaultdict(list)
+  for v in v_list:
+    root_to_cluster[_find(v)].append(v)
+  return [tuple(cluster) for cluster in root_to_cluster.values()]
+
+
+def _get_nets(clusters: List[Cluster]) -> Dict[Cluster, Dict[Cluster, float]]:
+  """
+  connections between clusters weighted by the total wire width
+  """
+  v_to_cluster = {v: c for c in clusters for v in c}
+  nets = {c: defaultdict(float) for c in clusters}
+  for c in clusters:
+    for v in c:
+      for e in v.getOutEdges():
+        other = v_to_cluster[e.dst]
+        if other is not c:
+          nets[c][other] += e.width
+          nets[other][c] += e.width
+  return nets
+
+
+def _get_initial_positions(
+    clusters: List[Cluster],
+    nets: Dict[Cluster, Dict[Cluster, float]],
+    cluster_to_slots: Dict[Cluster, List[Slot]],
+    cluster_to_area: Dict[Cluster, Dict[str, int]],
+    fixed: Dict[Cluster, Position],
+    all_leaf_slots: List[Slot],
+    usage_limit: float,
+) -> Dict[Cluster, Position]:
+  """
+  spread the clusters over the slots to anchor the first global placement
+  Without anchors, the first solve collapses all clusters not connected to a fixed one
+  to a single point. Clusters are visited breadth-first from the fixed ones so that
+  connected clusters are close, and fill the slots in a snake order up to the usage
+  limit, so a small design starts in a single slot.
+  """
+  rows = sorted({s.down_left_y for s in all_leaf_slots})
+  ordered_slots = sorted(
+    all_leaf_slots,
+    key=lambda s: (s.down_left_y, s.down_left_x * (-1 if rows.index(s.down_left_y) % 2 else 1)),
+  )
+
+  order: List[Cluster] = []
+  visited = set()
+  for root in [c for c in clusters if c in fixed] + clusters:
+    if root in visited:
+      continue
+    visited.add(root)
+    queue = [root]
+    while queue:
+      c = queue.pop(0)
+      order.append(c)
+      for other in nets[c]:
+        if other not in visited:
+          visited.add(other)
+          queue.append(other)
+
+  # sizes are in the number of slots filled up to the usage limit
+  capacity = {r: sum(s.area[r] for s in ordered_slots) * usage_limit / len(ordered_slots) for r in RESOURCE_TYPES}
+  cluster_to_pos = {}
+  accumulated = 0.
+  for c in order:
+    size = max((cluster_to_area[c][r] / capacity[r] for r in RESOURCE_TYPES if capacity[r]), default=0.)
+    idx = min(int(accumulated + size / 2), len(ordered_slots) - 1)
+    accumulated += size
+    if c in fixed:
+      cluster_to_pos[c] = fixed[c]
+      continue
+    target_x, target_y = _get_center(ordered_slots[idx])
+    slot = min(
+      cluster_to_slots[c],
+      key=lambda s: (abs(_get_center(s)[0] - target_x) + abs(_get_center(s)[1] - target_y), s.name),
+    )
+    cluster_to_pos[c] = _get_center(slot)
+  return cluster_to_pos
+
+
+def _solve_quadratic(
+    cluster_to_pos: Dict[Cluster, Position],
+    nets: Dict[Cluster, Dict[Cluster, float]],
+    anchors: Dict[Cluster, Tuple[Position, float]],
+    fixed: Dict[Cluster, Position],
+    max_sweeps: int = 20,
+    tolerance: float = 1e-3,
+) -> None:
+  """
+  minimize the quadratic wire length plus the pull of the anchors by Gauss-Seidel sweeps
+  """
+  for _ in range(max_sweeps):
+    max_delta = 0.
+    for c, neighbors in nets.items():
+      if c in fixed:
+        continue
+      (anchor_x, anchor_y), weight_sum = anchors.get(c, ((0., 0.), 0.))
+      sum_x, sum_y = anchor_x * weight_sum, anchor_y * weight_sum
+      for other, weight in neighbors.items():
+        other_x, other_y = cluster_to_pos[other]
+        sum_x += weight * other_x
+        sum_y += weight * other_y
+        weight_sum += weight
+      if weight_sum == 0:
+        continue
+      new_pos = (sum_x / weight_sum, sum_y / weight_sum)
+      old_pos = cluster_to_pos[c]
+      max_delta = max(max_delta, abs(new_pos[0] - old_pos[0]) + abs(new_pos[1] - old_pos[1]))
+      cluster_to_pos[c] = new_pos
+    if max_delta < tolerance:
+      break
+
+
+def _get_base_weight(nets: Dict[Cluster, Dict[Cluster, float]]) -> float:
+  """
+  average connection weight of a cluster, which scales the pull of the anchors
+  """
+  degree = [sum(n.values()) for n in nets.values() if n]
+  return sum(degree) / len(degree) if degree else 1.
+
+
+def _place_under_limit(
+    clusters: List[Cluster],
+    nets: Dict[Cluster, Dict[Cluster, float]],
+    cluster_to_slots: Dict[Cluster, List[Slot]],
+    cluster_to_area: Dict[Cluster, Dict[str, int]],
+    fixed: Dict[Cluster, Position],
+    init_pos: Dict[Cluster, Position],
+    usage_limit: float,
+    iterations: int,
+) -> Optional[Dict[Vertex, Slot]]:
+  """
+  alternate between global placement and legalization, where each legalized result
+  pulls the next global placement with increasing strength, and return the best legal result
+  The first global placement is pulled to the initial positions.
+  """
+  cluster_to_pos = dict(init_pos)
+  base_weight = _get_base_weight(nets)
+
+  best_v2s, best_wirelength = None, None
+  anchors = {c: (init_pos[c], base_weight * 0.2) for c in clusters if c not in fixed}
+  for idx in range(iterations):
+    _solve_quadratic(cluster_to_pos, nets, anchors, fixed)
+    v2s = greedy_legalize_floorplan(cluster_to_pos, cluster_to_slots, cluster_to_area, usage_limit)
+    if v2s is None:
+      return best_v2s
+
+    wirelength = get_total_wirelength(v2s)
+    _logger.debug(f'analytic placement iteration {idx}: wire length {wirelength}')
+    if best_wirelength is None or wirelength < best_wirelength:
+      best_v2s, best_wirelength = v2s, wirelength
+
+    anchor_weight = base_weight * 0.2 * (idx + 1)
+    anchors = {c: (_get_center(v2s[c[0]]), anchor_weight) for c in clusters}
+
+  return best_v2s
+
+
+def analytic_placement(
+  init_v2s: Dict[Vertex, Slot],
+  slot_manager: SlotManager,
+  grouping_constraints: List[List[Vertex]],
+  pre_assignments: Dict[Vertex, Slot],
+  partition_order: Optional[List[Dir]] = None,
+  min_area_limit: float = 0.65,
+  max_area_limit: float = 0.85,
+  iterations: int = 8,
+  **kwargs,
+) -> Optional[Dict[Vertex, Slot]]:
+  """
+  place the vertices on the slot grid analytically instead of solving ILPs
+  Vertices are placed to minimize the quadratic wire length, then legalized greedily
+  to the nearest slot with room. The first placement is anchored to a spread of the
+  vertices over the slots, and each legal result anchors the next placement, which
+  spreads the vertices the same way as the iterative partitioning without its solving time.
+  If the greedy legalization fails under every usage limit, the ILP legalization is used.
+  By default, the slots are the eight half SLRs, as in the iterative partitioning.
+  """
+  if partition_order is None:
+    partition_order = [Dir.horizontal, Dir.horizontal, Dir.vertical]
+  all_leaf_slots = slot_manager.getLeafSlotsAfterPartition(partition_order)
+  clusters = _get_clusters(list(init_v2s.keys()), grouping_constraints)
+  nets = _get_nets(clusters)
+  cluster_to_area = {
+    c: {r: sum(v.getVertexAndInboundFIFOArea()[r] for v in c) for r in RESOURCE_TYPES}
+    for c in clusters
+  }
+
+  # pre-assigned clusters are fixed to their regions
+  cluster_to_slots: Dict[Cluster, List[Slot]] = {}
+  fixed: Dict[Cluster, Position] = {}
+  for c in clusters:
+    targets = [pre_assignments[v] for v in c if v in pre_assignments]
+    cluster_to_slots[c] = [s for s in all_leaf_slots if all(t.containsChildSlot(s) for t in targets)]
+    if not cluster_to_slots[c]:
+      _logger.error(f'conflicting pre-assignments of {[v.name for v in c]}')
+      return None
+    if targets:
+      fixed[c] = _get_center(targets[0])
+
+  init_pos = _get_initial_positions(
+    clusters, nets, cluster_to_slots, cluster_to_area, fixed, all_leaf_slots, min_area_limit)
+  for usage_limit in float_range(min_area_limit, max_area_limit, 0.05):
+    v2s = _place_under_limit(
+      clusters, nets, cluster_to_slots, cluster_to_area, fixed, init_pos, usage_limit, iterations)
+    if v2s:
+      _logger.info(f'Analytic placement succeeded with target usage limit {usage_limit}')
+      log_resource_utilization(v2s)
+      return v2s
+
+  _logger.info('Analytic placement fails to legalize greedily; fall back to ILP legalization')
+  cluster_to_pos = dict(init_pos)
+  anchor_weight = _get_base_weight(nets) * 0.2
+  _solve_quadratic(
+    cluster_to_pos, nets, {c: (init_pos[c], anchor_weight) for c in clusters if c not in fixed}, fixed)
+  nearest_v2s = {
+    v: min(cluster_to_slots[c], key=lambda s: abs(_get_center(s)[0] - cluster_to_pos[c][0]) +
+                                              abs(_get_center(s)[1] - cluster_to_pos[c][1]))
+    for c in clusters for v in c
+  }
+  v2s = get_legalized_v2s(nearest_v2s, grouping_constraints, all_leaf_slots, pre_assignments, max_area_limit)
+  if v2s:
+    log_resource_utilization(v2s)
+  return v2s or None
@@ -0,0 +1,80 @@
+import unittest
+from typing import Dict, List
+
+from autobridge.Device.DeviceManager import DeviceManager
+from autobridge.Floorplan.AnalyticPlacement import (
+  _get_clusters,
+  _get_initial_positions,
+  _get_nets,
+  analytic_placement,
+)
+from autobridge.Floorplan.Utilities import RESOURCE_TYPES
+from autobridge.Opt.DataflowGraph import Edge, Vertex
+from autobridge.Opt.Slot import Slot
+from autobridge.Opt.SlotManager import SlotManager, Dir
+
+
+def _get_chain(num: int, lut: int) -> List[Vertex]:
+  """
+  a chain of vertices connected by 512-bit FIFOs
+  """
+  v_list = []
+  for i in range(num):
+    v = Vertex('task', f'v{i}')
+    v.area = {r: 0 for r in RESOURCE_TYPES}
+    v.area['LUT'] = lut
+    v.area['FF'] = lut
+    v_list.append(v)
+  for i in range(num - 1):
+    e = Edge(f'e{i}')
+    e.src, e.dst = v_list[i], v_list[i + 1]
+    e.width = 512
+    e.setDepth(2)
+    v_list[i].out_edges.append(e)
+    v_list[i + 1].in_edges.append(e)
+  return v_list
+
+
+class AnalyticPlacementTest(unittest.TestCase):
+
+  def setUp(self):
+    self.slot_manager = SlotManager(DeviceManager('U250').getBoard())
+    self.partition_order = [Dir.horizontal, Dir.horizontal, Dir.vertical]
+
+  def _place(self, v_list: List[Vertex], pre_assignments: Dict[Vertex, Slot]) -> Dict[Vertex, Slot]:
+    init_slot = self.slot_manager.getInitialSlot()
+    return analytic_placement(
+      {v: init_slot for v in v_list}, self.slot_manager, [], pre_assignments, self.partition_order)
+
+  def test_first_placement_is_anchored(self):
+    # each vertex fills about a third of a slot, so the design cannot fit in one
+    v_list = _get_chain(12, 30000)
+    clusters = _get_clusters(v_list, [])
+    nets = _get_nets(clusters)
+    slots = self.slot_manager.getLeafSlotsAfterPartition(self.partition_order)
+    init_pos = _get_initial_positions(
+      clusters, nets, {c: slots for c in clusters},
+      {c: c[0].getVertexAndInboundFIFOArea() for c in clusters}, {}, slots, 0.65)
+    self.assertGreater(len(set(init_pos.values())), 1)
+
+  def test_small_design_in_one_slot(self):
+    v2s = self._place(_get_chain(4, 1000), {})
+    self.assertEqual(len(set(v2s.values())), 1)
+
+  def test_large_design(self):
+    v_list = _get_chain(12, 30000)
+    io_slot = self.slot_manager.createSlot('CLOCKREGION_X0Y0:CLOCKREGION_X3Y3')
+    v2s = self._place(v_list, {v_list[0]: io_slot})
+
+    self.assertEqual(set(v2s), set(v_list))
+    self.assertTrue(io_slot.containsChildSlot(v2s[v_list[0]]))
+    for s in set(v2s.values()):
+      usage = sum(v.getVertexAndInboundFIFOArea()['LUT'] for v in v_list if v2s[v] == s)
+      self.assertLessEqual(usage, s.area['LUT'] * 0.85)
+    # the chain is laid out without jumping over slots, which are 4 clock regions wide and high
+    for e in sum((v.getOutEdges() for v in v_list), []):
+      self.assertLessEqual(v2s[e.src].getDistance(v2s[e.dst]), 4)
+
+
+if __name__ == '__main__':
+  unittest.main()
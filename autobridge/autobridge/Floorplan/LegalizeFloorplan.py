@@ -222,4 +222,52 @@ def legalize_floorplan(
       _logger.info(f'Legalization succeeded with target usage limit {curr_limit}')
       return new_v2s
     else:
-      curr_limit += limit_increase_step
\ No newline at end of file
+      curr_limit += limit_increase_step
+
+def greedy_legalize_floorplan(
+  cluster_to_pos: Dict[Tuple[Vertex, ...], Tuple[float, float]],
+  cluster_to_slots: Dict[Tuple[Vertex, ...], List[Slot]],
+  cluster_to_area: Dict[Tuple[Vertex, ...], Dict[str, int]],
+  resource_usage_limit: float,
+) -> Optional[Dict[Vertex, Slot]]:
+  """
+  assign each cluster of vertices to the nearest slot that has room for it
+  larger clusters are assigned first so that they are not left without room
+  return None if some cluster cannot be assigned within the usage limit
+  """
+  def _get_size(cluster_area, slot):
+    return max(cluster_area[r] / slot.area[r] if slot.area[r] else 0 for r in RESOURCE_TYPES)
+
+  def _get_dist(pos, slot):
+    return abs(pos[0] - (slot.down_left_x + slot.up_right_x + 1) / 2) + \
+           abs(pos[1] - (slot.down_left_y + slot.up_right_y + 1) / 2)
+
+  order = sorted(
+    cluster_to_pos,
+    key=lambda c: -max(_get_size(cluster_to_area[c], s) for s in cluster_to_slots[c]),
+  )
+
+  # slots are looked up by name because hashing Slot is slow
+  slot_to_remaining = {
+    s.name: {r: s.area[r] * resource_usage_limit for r in RESOURCE_TYPES}
+    for slots in cluster_to_slots.values() for s in slots
+  }
+  new_v2s = {}
+  for cluster in order:
+    area = cluster_to_area[cluster]
+    candidates = [
+      s for s in cluster_to_slots[cluster]
+      if all(area[r] <= slot_to_remaining[s.name][r] for r in RESOURCE_TYPES)
+    ]
+    if not candidates:
+      _logger.debug(f'Greedy legalization fails to place {[v.name for v in cluster]} '
+                    f'under target ratio {resource_usage_limit}')
+      return None
+
+    slot = min(candidates, key=lambda s: (_get_dist(cluster_to_pos[cluster], s), s.name))
+    for r in RESOURCE_TYPES:
+      slot_to_remaining[slot.name][r] -= area[r]
+    for v in cluster:
+      new_v2s[v] = slot
+
+  return new_v2s
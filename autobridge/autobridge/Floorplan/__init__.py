@@ -2,6 +2,7 @@ import logging
 import os
 
 from typing import Dict, List, Tuple
+from autobridge.Floorplan.AnalyticPlacement import analytic_placement
 from autobridge.Floorplan.Partition import partition
 from autobridge.Floorplan.IterativeBipartion import iterative_bipartition
 from autobridge.Floorplan.Utilities import (
@@ -132,6 +133,17 @@ def get_floorplan(
     else:
       return None, None
 
+  elif floorplan_strategy == 'ANALYTIC_FLOORPLANNING':
+    _logger.info(f'user specifies to use analytic placement')
+    v2s = analytic_placement(
+      init_v2s, slot_manager, grouping_constraints, pre_assignments,
+      min_area_limit=min_area_limit, max_area_limit=max_area_limit,
+    )
+    if v2s:
+      return v2s, get_eight_way_partition_slots(slot_manager)
+    else:
+      return None, None
+
   else:
     if floorplan_strategy != 'HALF_SLR_LEVEL_FLOORPLANNING':
       raise NotImplementedError('unrecognized floorplan strategy %s', floorplan_strategy)
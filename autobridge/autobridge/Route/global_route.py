@@ -3,15 +3,12 @@ import logging
 from bisect import bisect
 from collections import defaultdict
 from mip import Model, minimize, BINARY, xsum, OptimizationStatus, Var
-from typing import List, Dict
+from typing import List, Dict, Set, Tuple
 
 from autobridge.Opt.DataflowGraph import Edge, Vertex
 from autobridge.Opt.Slot import Slot
-from autobridge.Device.DeviceManager import DeviceU250
 from autobridge.util import get_mip_model_silent
 
-U250_inst = DeviceU250()
-
 _logger = logging.getLogger('autobridge')
 
 BEND_COUNT_LIMIT = 2
@@ -19,11 +16,19 @@ VERTICAL_BOUNDARY_CAPACITY = 5280
 SLR_CROSSING_BOUNDARY_CAPACITY = 5760
 NON_SLR_CROSSING_HORIZONTAL_BOUNDARY = 9440
 
+# an SLR crossing used over this ratio of its SLL wires gets an extra pipeline stage per passing FIFO
+CONGESTED_CROSSING_USAGE = 0.5
+
+# how much the usage limit of a congested boundary is relaxed per routing attempt
+BOUNDARY_USAGE_LIMIT_STEP = 0.03
+
+RIP_UP_REROUTE_ITERATIONS = 30
+
 
 class RoutingVertex:
-  def __init__(self, slot_name):
-    self.slot_name = slot_name
-    self.slot = Slot(U250_inst, slot_name)
+  def __init__(self, slot: Slot):
+    self.slot_name = slot.name
+    self.slot = slot
     self.edges = []
     self.neighbors = set()
 
@@ -45,6 +50,7 @@ class RoutingEdge:
     self.vertices = [v1, v2]
     self.total_capacity = total_wire_capacity
     self.capacity = usable_wire_capacity
+    self.is_slr_crossing = v1.slot.getSLR() != v2.slot.getSLR()
     v1.edges.append(self)
     v2.edges.append(self)
     v1.neighbors.add(v2)
@@ -235,11 +241,11 @@ class RoutingGraph:
     self.init_routing_graph()
 
   def init_routing_graph(self):
-    """ FIXME: currently hardcoded for U250/U280 slr/half-slr slots
+    """ FIXME: currently hardcoded for slr/half-slr slots
     """
     # create routing vertices
     for s in self.routing_slot_list:
-      self.slot_name_to_vertex[s.name] = RoutingVertex(s.name)
+      self.slot_name_to_vertex[s.name] = RoutingVertex(s)
 
     # create routing edges
     for s1, s2 in itertools.combinations(self.routing_slot_list, 2):
@@ -248,14 +254,9 @@ class RoutingGraph:
         if s1.getSLR() != s2.getSLR():
           assert s1.down_left_x == s2.down_left_x
           assert s1.up_right_x == s2.up_right_x
-          num_cr = s1.up_right_x - s1.down_left_x + 1
-
-          # exclude the vitis region and the laguna used by system interconnects
-          if s1.up_right_x == 7:
-            num_cr -= 1.5
 
-          # each clock region has 2 laguna columns, each has 1440 wires
-          total_capacity = num_cr * 2880
+          # the SLL wires of each column, excluding the laguna used by the vitis infra
+          total_capacity = s1.board.getSLRCrossingCapacity(s1.down_left_x, s1.up_right_x)
 
         else:
           total_capacity = (s1.up_right_y - s1.down_left_y + 1) * 3000
@@ -330,6 +331,10 @@ class ILPRouter:
     self.slot_to_usage = slot_to_usage
     self.routing_slot_list = routing_slot_list
 
+    # filled by route_design
+    self.fifo_name_to_congested_crossings: Dict[str, List[int]] = {}
+    self.slr_crossing_usage: Dict[str, Dict[str, float]] = {}
+
     for fifo in self.fifo_list:
       src_slot_name = self.v2s[fifo.src].getRTLModuleName()
       dst_slot_name = self.v2s[fifo.dst].getRTLModuleName()
@@ -477,17 +482,116 @@ class ILPRouter:
           break
       assert fifo in fifo_to_selected_path
 
-    # get which paths will pass through a boundary
+    return fifo_to_selected_path, self.get_routing_edge_to_selected_paths(fifo_to_selected_path)
+
+  def get_routing_edge_to_selected_paths(
+    self,
+    fifo_to_selected_path: Dict[Edge, RoutingPath],
+  ) -> Dict[RoutingEdge, List[RoutingPath]]:
+    """
+    get which selected paths will pass through a boundary
+    """
     routing_edge_to_selected_paths = defaultdict(list)
-    for routing_edge, paths in routing_edge_to_paths.items():
+    for path in fifo_to_selected_path.values():
+      for routing_edge in path.edges:
+        routing_edge_to_selected_paths[routing_edge].append(path)
+
+    for routing_edge, paths in routing_edge_to_selected_paths.items():
       _logger.debug(f'boundary {routing_edge._name} is passed by:')
       for path in paths:
-        val = path_to_var[path].x
-        if round(val) == 1:
-          routing_edge_to_selected_paths[routing_edge].append(path)
-          _logger.debug(f'  {path.fifo_name}')
+        _logger.debug(f'  {path.fifo_name}')
+
+    return routing_edge_to_selected_paths
+
+  def rip_up_and_reroute(
+    self,
+    fifo_to_paths: Dict[Edge, List[RoutingPath]],
+    max_iterations: int = RIP_UP_REROUTE_ITERATIONS,
+  ) -> Tuple[Dict[Edge, RoutingPath], Set[RoutingEdge]]:
+    """
+    negotiate the congested boundaries among the candidate paths.
+    Each FIFO starts from its cheapest path. Then in each iteration, the FIFOs passing an overused
+    boundary are ripped up and rerouted with the cost of the boundaries raised by their present
+    and historical overuse, so that the boundaries that are always overused are left to the FIFOs
+    without alternatives. Return the selected paths and the boundaries still overused.
+    """
+    path_to_cost = {path: path.get_cost() for paths in fifo_to_paths.values() for path in paths}
+    routing_edge_to_usage = defaultdict(float)
+    routing_edge_to_history = defaultdict(float)
+    present_factor = 1.
+
+    def _get_overuse(routing_edge: RoutingEdge, extra_width: float = 0) -> float:
+      usage = routing_edge_to_usage[routing_edge] + extra_width
+      return max(0., usage / max(routing_edge.capacity, 1) - 1)
+
+    def _get_negotiated_cost(path: RoutingPath) -> float:
+      congestion = sum(
+        routing_edge_to_history[e] + present_factor * _get_overuse(e, path.data_width) for e in path.edges
+      )
+      return path_to_cost[path] * (1 + congestion)
+
+    def _route(fifo: Edge) -> None:
+      path = min(fifo_to_paths[fifo], key=_get_negotiated_cost)
+      fifo_to_selected_path[fifo] = path
+      for routing_edge in path.edges:
+        routing_edge_to_usage[routing_edge] += path.data_width
+
+    def _rip_up(fifo: Edge) -> None:
+      path = fifo_to_selected_path.pop(fifo)
+      for routing_edge in path.edges:
+        routing_edge_to_usage[routing_edge] -= path.data_width
+
+    # route the wide FIFOs first as they are the hardest to fit
+    fifo_list = sorted(fifo_to_paths.keys(), key=lambda fifo: -fifo.width)
+    fifo_to_selected_path: Dict[Edge, RoutingPath] = {}
+    for fifo in fifo_list:
+      _route(fifo)
+
+    overused = set()
+    for idx in range(max_iterations):
+      overused = {e for e, usage in routing_edge_to_usage.items() if usage > e.capacity}
+      _logger.debug(f'rip-up and reroute iteration {idx}: {len(overused)} overused boundaries')
+      if not overused:
+        break
+
+      for routing_edge in overused:
+        routing_edge_to_history[routing_edge] += _get_overuse(routing_edge)
+      present_factor *= 1.5
 
-    return fifo_to_selected_path, routing_edge_to_selected_paths
+      for fifo in fifo_list:
+        if any(e in overused for e in fifo_to_selected_path[fifo].edges):
+          _rip_up(fifo)
+          _route(fifo)
+
+    overused = {e for e, usage in routing_edge_to_usage.items() if usage > e.capacity}
+    return fifo_to_selected_path, overused
+
+  def record_congestion(
+    self,
+    fifo_to_selected_path: Dict[Edge, RoutingPath],
+    routing_edge_to_selected_paths: Dict[RoutingEdge, List[RoutingPath]],
+  ) -> None:
+    """
+    record the usage of each SLR crossing and which hops of each FIFO pass a congested crossing.
+    The FIFOs will be pipelined by an additional stage at those hops.
+    """
+    congested = set()
+    for routing_edge, paths in routing_edge_to_selected_paths.items():
+      if not routing_edge.is_slr_crossing:
+        continue
+      usage = sum(path.data_width for path in paths)
+      self.slr_crossing_usage[routing_edge._name] = {
+        'usage': usage,
+        'capacity': routing_edge.total_capacity,
+      }
+      if usage > routing_edge.total_capacity * CONGESTED_CROSSING_USAGE:
+        _logger.info(f'SLR crossing {routing_edge._name} is congested with {usage} / {routing_edge.total_capacity} SLL wires')
+        congested.add(routing_edge)
+
+    for fifo, path in fifo_to_selected_path.items():
+      hops = [i for i, routing_edge in enumerate(path.edges) if routing_edge in congested]
+      if hops:
+        self.fifo_name_to_congested_crossings[fifo.name] = hops
 
   def get_fifo_to_path_exclude_src_dst(self, fifo_to_selected_path):
     e_name_to_paths = {}
@@ -502,19 +606,23 @@ class ILPRouter:
       routing_usage_limit: float = 0.6,
       detour_path_limit: int = 4
   ) -> Dict[Edge, List[Slot]]:
+    fifo_to_paths = self.get_fifo_to_candidate_paths(routing_usage_limit, detour_path_limit)
+    routing_edge_to_paths = self.get_routing_edge_to_passing_paths(fifo_to_paths)
+
+    _logger.info(f'there are {len(fifo_to_paths)} dataflow edges')
+
+    # only the boundaries found congested get a higher usage limit
+    routing_edge_to_usage_limit = {routing_edge: routing_usage_limit for routing_edge in routing_edge_to_paths}
+
     while 1:
-      if routing_usage_limit > 1:
-        _logger.error(f'Global routing failed')
-        exit(1)
+      for routing_edge, usage_limit in routing_edge_to_usage_limit.items():
+        routing_edge.capacity = routing_edge.total_capacity * usage_limit
 
-      _logger.info(f'Global routing attempt with routing usage limit {routing_usage_limit}')
+      _logger.info(f'Global routing attempt with routing usage limit up to {max(routing_edge_to_usage_limit.values(), default=routing_usage_limit)}')
 
       m = get_mip_model_silent()
-      fifo_to_paths = self.get_fifo_to_candidate_paths(routing_usage_limit, detour_path_limit)
       path_to_var = self.get_path_to_var(m, fifo_to_paths)
-      routing_edge_to_paths = self.get_routing_edge_to_passing_paths(fifo_to_paths)
 
-      _logger.info(f'there are {len(fifo_to_paths)} dataflow edges')
       _logger.info(f'there are {len(path_to_var)} potential paths to select from')
 
       self.constrain_fifo_to_one_path(m, fifo_to_paths, path_to_var)
@@ -526,23 +634,33 @@ class ILPRouter:
       status = m.optimize()
 
       if status == OptimizationStatus.OPTIMAL:
-        _logger.warning(f'Succeeded: global routing attempt with routing usage limit {routing_usage_limit}')
+        _logger.warning(f'Succeeded: global routing attempt')
+        fifo_to_selected_path, routing_edge_to_selected_paths = \
+          self.get_routing_results(fifo_to_paths, path_to_var, routing_edge_to_paths)
+        break
+
+      # find out which boundaries are congested by rip-up and reroute
+      fifo_to_selected_path, overused = self.rip_up_and_reroute(fifo_to_paths)
+      if not overused:
+        _logger.warning(f'Succeeded: global routing by rip-up and reroute')
+        routing_edge_to_selected_paths = self.get_routing_edge_to_selected_paths(fifo_to_selected_path)
         break
-      else:
-        _logger.warning(f'Failed: global routing attempt with routing usage limit {routing_usage_limit}')
-        routing_usage_limit += 0.03
 
-    # extract results
-    fifo_to_selected_path, routing_edge_to_selected_paths = \
-      self.get_routing_results(fifo_to_paths, path_to_var, routing_edge_to_paths)
+      _logger.warning(f'Failed: global routing attempt with {len(overused)} congested boundaries')
+      for routing_edge in overused:
+        routing_edge_to_usage_limit[routing_edge] += BOUNDARY_USAGE_LIMIT_STEP
+        _logger.info(f'relax the usage limit of boundary {routing_edge._name} to {routing_edge_to_usage_limit[routing_edge]}')
+        if routing_edge_to_usage_limit[routing_edge] > 1:
+          _logger.error(f'Global routing failed: boundary {routing_edge._name} runs out of wires')
+          exit(1)
 
     # _logger and analysis
     self.analyze_routing_results(fifo_to_paths, fifo_to_selected_path, routing_edge_to_selected_paths)
+    self.record_congestion(fifo_to_selected_path, routing_edge_to_selected_paths)
 
     fifo_to_slots = {fifo: path.get_slots_in_path() for fifo, path in fifo_to_selected_path.items()}
     return fifo_to_slots
 
-
 if __name__ == '__main__':
   routing_graph = RoutingGraph()
 
@@ -1,5 +1,5 @@
 import logging
-from typing import List, Dict
+from typing import List, Dict, Optional
 
 from autobridge.util import get_mip_model_silent
 from autobridge.Opt.DataflowGraph import Edge, Vertex
@@ -11,12 +11,22 @@ _logger = logging.getLogger('autobridge')
 cli_logger = get_cli_logger()
 
 
-def get_latency(path: List[Slot]) -> int:
-  """[TODO] This function should synchronize with the codegen"""
-  return len(path)
+def get_latency(path: List[Slot], congested_crossings: Optional[List[int]] = None) -> int:
+  """[TODO] This function should synchronize with the codegen
+  Each congested SLR crossing on the path has an additional pipeline stage.
+  """
+  if congested_crossings is None:
+    congested_crossings = []
+  return len(path) + len(congested_crossings)
 
 
-def latency_balancing(graph, fifo_to_path) -> Dict[str, int]:
+def latency_balancing(
+    graph,
+    fifo_to_path,
+    fifo_name_to_congested_crossings: Optional[Dict[str, List[int]]] = None,
+) -> Dict[str, int]:
+    if fifo_name_to_congested_crossings is None:
+      fifo_name_to_congested_crossings = {}
     name_to_edge: Dict[str, Edge] = graph.getNameToEdgeMap()
     name_to_vertex: Dict[str, Vertex] = graph.getNameToVertexMap()
 
@@ -34,7 +44,7 @@ def latency_balancing(graph, fifo_to_path) -> Dict[str, int]:
       # note that additional pipelining for full_n will not lead to additional latency
       # we only need to increase the grace period of almost full FIFOs by 1
       # [update]: we skip the +1 for the orginial FIFO. We only take care of our own modifications
-      m += vertex_to_var[e.src] >= vertex_to_var[e.dst] + get_latency(fifo_to_path[e])
+      m += vertex_to_var[e.src] >= vertex_to_var[e.dst] + get_latency(fifo_to_path[e], fifo_name_to_congested_crossings.get(e_name, []))
 
     m.objective = minimize(xsum(
       e.width * (vertex_to_var[e.src] - vertex_to_var[e.dst]) for e in name_to_edge.values()
@@ -79,9 +79,10 @@ def annotate_floorplan(config: Dict) -> Dict:
   )
   fifo_to_path: Dict[Edge, List[Slot]] = router.route_design()
 
-  fifo_name_to_depth = latency_balancing(graph, fifo_to_path)
+  fifo_name_to_depth = latency_balancing(graph, fifo_to_path, router.fifo_name_to_congested_crossings)
 
   annotated_config = get_annotated_config(v2s, fifo_to_path, slot_to_usage, fifo_name_to_depth, config)
+  annotate_routing_congestion(annotated_config, router)
 
   analyze_result(annotated_config)
 
@@ -147,6 +148,13 @@ def get_vertex_section(config) -> Dict[str, str]:
 def get_area_section(config) -> Dict[str, Dict[str, int]]:
   return {properties['module']: properties['area'] for v_name, properties in config['vertices'].items()}
 
+def annotate_routing_congestion(config: Dict, router: ILPRouter) -> None:
+  """ record the SLL usage of each SLR crossing and where the edges cross the congested ones
+  """
+  config['slr_crossing_usage'] = router.slr_crossing_usage
+  for fifo_name, hops in router.fifo_name_to_congested_crossings.items():
+    config['edges'][fifo_name]['congested_crossings'] = hops
+
 def get_annotated_config(
     v2s: Dict[Vertex, Slot],
     fifo_to_path: Dict[Edge, List[Slot]],
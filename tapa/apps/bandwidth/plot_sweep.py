@@ -0,0 +1,65 @@
+"""Plot the results of bandwidth-sweep.
+
+For each swept parameter, plots the best bandwidth at each of its values, one
+line per interface width, to a PNG file named after the parameter.
+
+Usage: python3 plot_sweep.py results.csv|results.json [output_dir]
+"""
+
+import csv
+import json
+import os
+import sys
+from collections import defaultdict
+
+PARAMS = ('stride', 'burst', 'write_percent', 'outstanding', 'channels')
+
+
+def load(path):
+  with open(path) as fp:
+    if path.endswith('.json'):
+      rows = json.load(fp)
+    else:
+      rows = list(csv.DictReader(fp))
+  for row in rows:
+    for key in PARAMS + ('width',):
+      row[key] = int(row[key])
+    row['gbps'] = float(row['gbps'])
+  return rows
+
+
+def main(argv):
+  if len(argv) not in (2, 3):
+    sys.exit(__doc__)
+  import matplotlib
+  matplotlib.use('Agg')
+  from matplotlib import pyplot
+
+  rows = load(argv[1])
+  output_dir = argv[2] if len(argv) == 3 else '.'
+  os.makedirs(output_dir, exist_ok=True)
+  for param in PARAMS:
+    if len({row[param] for row in rows}) < 2:
+      continue
+    best = defaultdict(dict)  # {width: {value: gbps}}
+    for row in rows:
+      values = best[row['width']]
+      values[row[param]] = max(values.get(row[param], 0), row['gbps'])
+    figure, axes = pyplot.subplots()
+    for width, values in sorted(best.items()):
+      xs = sorted(values)
+      axes.plot(xs, [values[x] for x in xs], marker='o', label=f'{width} bits')
+    if param in ('stride', 'burst', 'outstanding'):
+      axes.set_xscale('symlog', base=2)
+    axes.set_xlabel(param)
+    axes.set_ylabel('best bandwidth (GB/s)')
+    axes.grid(True)
+    axes.legend()
+    path = os.path.join(output_dir, f'{param}.png')
+    figure.savefig(path)
+    pyplot.close(figure)
+    print(f'wrote {path}')
+
+
+if __name__ == '__main__':
+  main(sys.argv)
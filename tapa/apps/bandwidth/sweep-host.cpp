@@ -0,0 +1,215 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <tapa.h>
+
+#include "sweep.h"
+
+template <typename T>
+using vector = std::vector<T, tapa::aligned_allocator<T>>;
+
+DEFINE_string(bitstream, "",
+              "path to bitstream file, run csim with the memory timing model "
+              "if empty");
+DEFINE_uint64(n, 1 << 16, "requests per channel, must be a power of 2");
+DEFINE_string(widths, "512", "widths of the memory interface in bits");
+DEFINE_string(strides, "1", "distances between bursts in elements");
+DEFINE_string(bursts, "1,16", "consecutive elements per burst");
+DEFINE_string(write_percents, "0", "percentages of bursts that are writes");
+DEFINE_string(outstanding, "32", "requests in flight per direction, 0 for any");
+DEFINE_string(channels, "1", "numbers of active channels");
+DEFINE_string(csv, "", "write the results to this CSV file if not empty");
+DEFINE_string(json, "", "write the results to this JSON file if not empty");
+
+DEFINE_double(clock_mhz, 300, "kernel clock of the memory timing model");
+DEFINE_uint64(latency, tapa::memory_timing().latency,
+              "cycles from issuing a burst to its first data beat");
+DEFINE_uint64(bytes_per_cycle, tapa::memory_timing().bytes_per_cycle,
+              "bytes transferred per cycle by each channel");
+DEFINE_uint64(max_burst_bytes, tapa::memory_timing().max_burst_bytes,
+              "longest burst in bytes");
+DEFINE_uint64(page_bytes, tapa::memory_timing().page_bytes,
+              "bytes per DRAM page");
+DEFINE_uint64(page_miss_cycles, tapa::memory_timing().page_miss_cycles,
+              "cycles added to a burst that opens another page");
+DEFINE_uint64(turnaround_cycles, tapa::memory_timing().turnaround_cycles,
+              "cycles added when switching between reads and writes");
+
+namespace {
+
+struct Config {
+  uint64_t width;
+  uint64_t stride;
+  uint64_t burst;
+  uint64_t write_percent;
+  uint64_t outstanding;
+  uint64_t channels;
+};
+
+struct Result {
+  Config config;
+  uint64_t bytes = 0;
+  double seconds = 0;
+  tapa::memory_stats stats;  // of the slowest channel; csim only
+};
+
+std::vector<uint64_t> ParseList(const std::string& flag) {
+  std::vector<uint64_t> values;
+  std::istringstream is(flag);
+  for (std::string item; std::getline(is, item, ',');) {
+    values.push_back(std::stoull(item));
+  }
+  CHECK(!values.empty()) << "empty list '" << flag << "'";
+  return values;
+}
+
+template <int bits, typename Top>
+Result Run(Top& top, const Config& config) {
+  using Elem = SweepElem<bits>;
+  const uint64_t n = FLAGS_n;
+
+  std::vector<vector<Elem>> bufs(kBankCount, vector<Elem>(n));
+  tapa::memory_stats stats[kBankCount];
+  std::vector<tapa::mmap<Elem>> mems;
+  for (int i = 0; i < kBankCount; ++i) {
+    tapa::memory_timing timing;
+    timing.latency = FLAGS_latency;
+    timing.bytes_per_cycle = FLAGS_bytes_per_cycle;
+    timing.max_burst_bytes = FLAGS_max_burst_bytes;
+    timing.max_outstanding = config.outstanding;
+    timing.page_bytes = FLAGS_page_bytes;
+    timing.page_miss_cycles = FLAGS_page_miss_cycles;
+    timing.turnaround_cycles = FLAGS_turnaround_cycles;
+    timing.stats = &stats[i];
+    mems.push_back(tapa::mmap<Elem>(bufs[i].data(), n).timed(timing));
+  }
+  const std::vector<tapa::mmap<Elem>>& const_mems = mems;
+
+  const int64_t kernel_time_ns = tapa::invoke(
+      top, FLAGS_bitstream,
+      tapa::read_write_mmaps<Elem, kBankCount>(const_mems), n, config.stride,
+      config.burst, config.write_percent, config.outstanding, config.channels);
+
+  Result result;
+  result.config = config;
+  result.bytes = n * sizeof(Elem) * config.channels;
+  if (FLAGS_bitstream.empty()) {
+    for (uint64_t i = 0; i < config.channels; ++i) {
+      CHECK_EQ(stats[i].read_count + stats[i].write_count, n / config.burst *
+                                                               config.burst)
+          << "channel " << i << " did not issue all requests";
+      if (stats[i].cycle_count > result.stats.cycle_count) {
+        result.stats = stats[i];
+      }
+    }
+    result.seconds = result.stats.cycle_count / (FLAGS_clock_mhz * 1e6);
+  } else {
+    result.seconds = kernel_time_ns * 1e-9;
+  }
+  return result;
+}
+
+Result Run(const Config& config) {
+  switch (config.width) {
+    case 128:
+      return Run<128>(Sweep128, config);
+    case 256:
+      return Run<256>(Sweep256, config);
+    case 512:
+      return Run<512>(Sweep512, config);
+  }
+  LOG(FATAL) << "unsupported width " << config.width;
+  return {};
+}
+
+const char kColumns[] =
+    "width,stride,burst,write_percent,outstanding,channels,n,source,bytes,"
+    "seconds,gbps,cycles,read_bursts,write_bursts,page_misses";
+
+std::string ToCsv(const Result& r) {
+  std::ostringstream os;
+  os << r.config.width << ',' << r.config.stride << ',' << r.config.burst << ','
+     << r.config.write_percent << ',' << r.config.outstanding << ','
+     << r.config.channels << ',' << FLAGS_n << ','
+     << (FLAGS_bitstream.empty() ? "model" : "hardware") << ',' << r.bytes
+     << ',' << r.seconds << ',' << r.bytes / r.seconds * 1e-9 << ','
+     << r.stats.cycle_count << ','
+     << r.stats.read_burst_count << ',' << r.stats.write_burst_count << ','
+     << r.stats.page_miss_count;
+  return os.str();
+}
+
+std::string ToJson(const Result& r) {
+  std::istringstream columns(kColumns);
+  std::istringstream values(ToCsv(r));
+  std::ostringstream os;
+  os << '{';
+  for (std::string column, value; std::getline(columns, column, ',') &&
+                                  std::getline(values, value, ',');) {
+    if (column != "width") os << ", ";
+    os << '"' << column << "\": ";
+    if (column == "source") {
+      os << '"' << value << '"';
+    } else {
+      os << value;
+    }
+  }
+  os << '}';
+  return os.str();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  CHECK(FLAGS_n != 0 && (FLAGS_n & (FLAGS_n - 1)) == 0)
+      << "--n must be a power of 2";
+  const auto widths = ParseList(FLAGS_widths);
+  LOG_IF(FATAL, !FLAGS_bitstream.empty() && widths.size() != 1)
+      << "a bitstream implements one width";
+
+  std::vector<Result> results;
+  for (uint64_t width : widths) {
+    for (uint64_t stride : ParseList(FLAGS_strides)) {
+      for (uint64_t burst : ParseList(FLAGS_bursts)) {
+        for (uint64_t write_percent : ParseList(FLAGS_write_percents)) {
+          for (uint64_t outstanding : ParseList(FLAGS_outstanding)) {
+            for (uint64_t channels : ParseList(FLAGS_channels)) {
+              CHECK(burst != 0 && burst <= FLAGS_n) << "invalid burst";
+              CHECK_LE(write_percent, 100) << "invalid write percent";
+              CHECK(channels != 0 && channels <= kBankCount)
+                  << "invalid channel count";
+              results.push_back(Run({width, stride, burst, write_percent,
+                                     outstanding, channels}));
+              LOG(INFO) << ToCsv(results.back());
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (!FLAGS_csv.empty()) {
+    std::ofstream csv(FLAGS_csv);
+    csv << kColumns << '\n';
+    for (const auto& result : results) csv << ToCsv(result) << '\n';
+    CHECK(csv) << "cannot write '" << FLAGS_csv << "'";
+  }
+  if (!FLAGS_json.empty()) {
+    std::ofstream json(FLAGS_json);
+    json << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+      json << "  " << ToJson(results[i]) << (i + 1 < results.size() ? "," : "")
+           << '\n';
+    }
+    json << "]\n";
+    CHECK(json) << "cannot write '" << FLAGS_json << "'";
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include <cstdint>
+
+#include <tapa.h>
+
+#include "sweep.h"
+
+template <typename T>
+void Access(tapa::async_mmap<T>& mem, uint64_t id, uint64_t n, uint64_t stride,
+            uint64_t burst, uint64_t write_percent, uint64_t outstanding,
+            uint64_t channels) {
+  if (id >= channels) return;
+
+  const uint64_t mask = n - 1;
+  const uint64_t burst_count = n / burst;
+  const uint64_t wr_count = burst_count * write_percent / 100 * burst;
+  const uint64_t rd_count = burst_count * burst - wr_count;
+
+  uint64_t rd_base = 0, rd_offset = 0;
+  uint64_t wr_base = n / 2, wr_offset = 0;
+  T elem = {};
+
+  [[tapa::pipeline(1)]]  //
+  for (uint64_t i_rd_req = 0, i_rd_resp = 0, i_wr_req = 0, i_wr_resp = 0;
+       i_rd_resp < rd_count || i_wr_resp < wr_count;) {
+    if (i_rd_req < rd_count &&
+        (outstanding == 0 || i_rd_req < i_rd_resp + outstanding) &&
+        mem.read_addr.try_write((rd_base + rd_offset) & mask)) {
+      ++i_rd_req;
+      if (++rd_offset == burst) {
+        rd_offset = 0;
+        rd_base += stride;
+      }
+    }
+
+    if (!mem.read_data.empty()) {
+      mem.read_data.try_read(elem);
+      ++i_rd_resp;
+    }
+
+    if (i_wr_req < wr_count &&
+        (outstanding == 0 || i_wr_req < i_wr_resp + outstanding) &&
+        !mem.write_addr.full() && !mem.write_data.full()) {
+      mem.write_addr.try_write((wr_base + wr_offset) & mask);
+      mem.write_data.try_write(elem);
+      ++i_wr_req;
+      if (++wr_offset == burst) {
+        wr_offset = 0;
+        wr_base += stride;
+      }
+    }
+
+    if (!mem.write_resp.empty()) {
+      i_wr_resp += mem.write_resp.read(nullptr) + 1;
+    }
+  }
+}
+
+void Access128(tapa::async_mmap<SweepElem<128>>& mem, uint64_t id, uint64_t n,
+               uint64_t stride, uint64_t burst, uint64_t write_percent,
+               uint64_t outstanding, uint64_t channels) {
+  Access(mem, id, n, stride, burst, write_percent, outstanding, channels);
+}
+
+void Access256(tapa::async_mmap<SweepElem<256>>& mem, uint64_t id, uint64_t n,
+               uint64_t stride, uint64_t burst, uint64_t write_percent,
+               uint64_t outstanding, uint64_t channels) {
+  Access(mem, id, n, stride, burst, write_percent, outstanding, channels);
+}
+
+void Access512(tapa::async_mmap<SweepElem<512>>& mem, uint64_t id, uint64_t n,
+               uint64_t stride, uint64_t burst, uint64_t write_percent,
+               uint64_t outstanding, uint64_t channels) {
+  Access(mem, id, n, stride, burst, write_percent, outstanding, channels);
+}
+
+void Sweep128(tapa::mmaps<SweepElem<128>, kBankCount> chan, uint64_t n,
+              uint64_t stride, uint64_t burst, uint64_t write_percent,
+              uint64_t outstanding, uint64_t channels) {
+  tapa::task().invoke<tapa::join, kBankCount>(Access128, chan, tapa::seq(), n,
+                                              stride, burst, write_percent,
+                                              outstanding, channels);
+}
+
+void Sweep256(tapa::mmaps<SweepElem<256>, kBankCount> chan, uint64_t n,
+              uint64_t stride, uint64_t burst, uint64_t write_percent,
+              uint64_t outstanding, uint64_t channels) {
+  tapa::task().invoke<tapa::join, kBankCount>(Access256, chan, tapa::seq(), n,
+                                              stride, burst, write_percent,
+                                              outstanding, channels);
+}
+
+void Sweep512(tapa::mmaps<SweepElem<512>, kBankCount> chan, uint64_t n,
+              uint64_t stride, uint64_t burst, uint64_t write_percent,
+              uint64_t outstanding, uint64_t channels) {
+  tapa::task().invoke<tapa::join, kBankCount>(Access512, chan, tapa::seq(), n,
+                                              stride, burst, write_percent,
+                                              outstanding, channels);
+}
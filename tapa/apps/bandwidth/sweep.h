@@ -0,0 +1,24 @@
+#include <cstdint>
+
+#include <tapa.h>
+
+#include "bandwidth.h"
+
+// Element of `bits` bits, which is the width of the memory interface.
+template <int bits>
+using SweepElem = tapa::vec_t<uint32_t, bits / 32>;
+
+// Each of the first `channels` channels issues `n` requests, where `n` is a
+// power of 2. Request i of each direction accesses element
+// (i / burst * stride + i % burst) % n, and `write_percent`% of the bursts are
+// writes, which start from element n / 2. Each direction keeps at most
+// `outstanding` requests in flight, or any number if 0.
+void Sweep128(tapa::mmaps<SweepElem<128>, kBankCount> chan, uint64_t n,
+              uint64_t stride, uint64_t burst, uint64_t write_percent,
+              uint64_t outstanding, uint64_t channels);
+void Sweep256(tapa::mmaps<SweepElem<256>, kBankCount> chan, uint64_t n,
+              uint64_t stride, uint64_t burst, uint64_t write_percent,
+              uint64_t outstanding, uint64_t channels);
+void Sweep512(tapa::mmaps<SweepElem<512>, kBankCount> chan, uint64_t n,
+              uint64_t stride, uint64_t burst, uint64_t write_percent,
+              uint64_t outstanding, uint64_t channels);
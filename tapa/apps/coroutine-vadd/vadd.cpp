@@ -0,0 +1,42 @@
+#include <cstdint>
+
+#include <tapa.h>
+
+// Add and Stream2Mmap are C++20 stackless coroutines; Mmap2Stream runs as a
+// thread, so the two kinds of tasks exchange tokens through the streams.
+
+tapa::coroutine Add(tapa::istream<float>& a, tapa::istream<float>& b,
+                    tapa::ostream<float>& c, uint64_t n) {
+  for (uint64_t i = 0; i < n; ++i) {
+    const float a_i = co_await a.async_read();
+    const float b_i = co_await b.async_read();
+    co_await c.async_write(a_i + b_i);
+  }
+}
+
+void Mmap2Stream(tapa::mmap<const float> mmap, uint64_t n,
+                 tapa::ostream<float>& stream) {
+  for (uint64_t i = 0; i < n; ++i) {
+    stream << mmap[i];
+  }
+}
+
+tapa::coroutine Stream2Mmap(tapa::istream<float>& stream,
+                            tapa::mmap<float> mmap, uint64_t n) {
+  for (uint64_t i = 0; i < n; ++i) {
+    mmap[i] = co_await stream.async_read();
+  }
+}
+
+void VecAdd(tapa::mmap<const float> a, tapa::mmap<const float> b,
+            tapa::mmap<float> c, uint64_t n) {
+  tapa::stream<float> a_q("a");
+  tapa::stream<float> b_q("b");
+  tapa::stream<float> c_q("c");
+
+  tapa::task()
+      .invoke(Mmap2Stream, a, n, a_q)
+      .invoke(Mmap2Stream, b, n, b_q)
+      .invoke(Add, a_q, b_q, c_q, n)
+      .invoke(Stream2Mmap, c_q, c, n);
+}
@@ -0,0 +1,95 @@
+#include <cmath>
+
+#include <iostream>
+#include <vector>
+
+#include <tapa.h>
+
+#include "gemm-ws.h"
+
+using std::abs;
+using std::clog;
+using std::endl;
+using std::vector;
+
+void GemmWs(tapa::mmap<WsAVec> a, tapa::mmap<WsBMem> b, tapa::mmap<WsCMem> c,
+            uint64_t m, uint64_t n, uint64_t k);
+
+DEFINE_string(bitstream, "", "path to bitstream file, run csim if empty");
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  // A valid 3 x 3 convolution of a 4 x 10 x 10 input to 8 output channels is
+  // lowered to a GEMM with m = 8, n = 8 * 8, and k = 4 * 3 * 3.
+  const int channels = 4;
+  const int height = 10;
+  const int width = 10;
+  const int kernel = 3;
+  const int filters = argc > 1 ? atoi(argv[1]) : 8;
+  const int out_height = height - kernel + 1;
+  const int out_width = width - kernel + 1;
+  const uint64_t m = filters;
+  const uint64_t n = out_height * out_width;
+  const uint64_t k = channels * kernel * kernel;
+  vector<float> in(channels * height * width);
+  vector<float> weight(m * k);
+  for (uint64_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<float>((i * 7) % 17) - 8.f;
+  }
+  for (uint64_t i = 0; i < weight.size(); ++i) {
+    weight[i] = static_cast<float>((i * 5) % 13) - 6.f;
+  }
+  vector<float> lowered(k * n);
+  tapa::systolic::im2col(in.data(), channels, height, width, kernel,
+                         lowered.data());
+  vector<float> out(m * n);
+
+  int64_t kernel_time_ns = tapa::invoke(
+      GemmWs, FLAGS_bitstream,
+      tapa::read_only_mmap<float>(weight).vectorized<GemmWsArray::kRows>(),
+      tapa::read_only_mmap<float>(lowered)
+          .vectorized<GemmWsArray::kCols * GemmWsArray::kTileN>(),
+      tapa::read_write_mmap<float>(out)
+          .vectorized<GemmWsArray::kCols * GemmWsArray::kTileN>(),
+      m, n, k);
+  clog << "kernel time: " << kernel_time_ns * 1e-9 << " s" << endl;
+
+  uint64_t num_errors = 0;
+  const uint64_t threshold = 10;  // only report up to these errors
+  for (int f = 0; f < filters; ++f) {
+    for (int y = 0; y < out_height; ++y) {
+      for (int x = 0; x < out_width; ++x) {
+        float expected = 0.f;
+        for (int c = 0; c < channels; ++c) {
+          for (int p = 0; p < kernel; ++p) {
+            for (int q = 0; q < kernel; ++q) {
+              expected += weight[((f * channels + c) * kernel + p) * kernel +
+                                 q] *
+                          in[(c * height + y + p) * width + x + q];
+            }
+          }
+        }
+        const float actual = out[(f * out_height + y) * out_width + x];
+        if (abs(actual - expected) > 1e-4 * abs(expected)) {
+          if (num_errors < threshold) {
+            clog << "expected: " << expected << ", actual: " << actual
+                 << endl;
+          } else if (num_errors == threshold) {
+            clog << "...";
+          }
+          ++num_errors;
+        }
+      }
+    }
+  }
+  if (num_errors == 0) {
+    clog << "PASS!" << endl;
+  } else {
+    if (num_errors > threshold) {
+      clog << " (+" << (num_errors - threshold) << " more errors)" << endl;
+    }
+    clog << "FAIL!" << endl;
+  }
+  return num_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+#include <cmath>
+
+#include <iostream>
+#include <vector>
+
+#include <tapa.h>
+
+#include "gemm.h"
+
+using std::abs;
+using std::clog;
+using std::endl;
+using std::vector;
+
+void Gemm(tapa::mmap<AVec> a, tapa::mmap<BMem> b, tapa::mmap<CMem> c,
+          uint64_t m, uint64_t n, uint64_t k);
+
+DEFINE_string(bitstream, "", "path to bitstream file, run csim if empty");
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  // A and C are column-major and B is row-major for output-stationary arrays.
+  const uint64_t m = GemmArray::kRows * GemmArray::kTileM * 2;
+  const uint64_t n = GemmArray::kCols * GemmArray::kTileN * 2;
+  const uint64_t k = argc > 1 ? atoll(argv[1]) : 64;
+  vector<float> a(k * m);
+  vector<float> b(k * n);
+  vector<float> c(n * m);
+  vector<float> expected(n * m);
+  for (uint64_t kk = 0; kk < k; ++kk) {
+    for (uint64_t i = 0; i < m; ++i) {
+      a[kk * m + i] = static_cast<float>((i * 7 + kk * 3) % 17) - 8.f;
+    }
+    for (uint64_t j = 0; j < n; ++j) {
+      b[kk * n + j] = static_cast<float>((j * 5 + kk * 11) % 13) - 6.f;
+    }
+  }
+  tapa::systolic::run<GemmArray>(a.data(), b.data(), expected.data(), m, n, k);
+
+  int64_t kernel_time_ns = tapa::invoke(
+      Gemm, FLAGS_bitstream,
+      tapa::read_only_mmap<float>(a).vectorized<GemmArray::kRows>(),
+      tapa::read_only_mmap<float>(b)
+          .vectorized<GemmArray::kCols * GemmArray::kTileN>(),
+      tapa::write_only_mmap<float>(c).vectorized<GemmArray::kRows>(), m, n,
+      k);
+  clog << "kernel time: " << kernel_time_ns * 1e-9 << " s" << endl;
+
+  uint64_t num_errors = 0;
+  const uint64_t threshold = 10;  // only report up to these errors
+  for (uint64_t i = 0; i < n * m; ++i) {
+    if (abs(c[i] - expected[i]) > 1e-4 * abs(expected[i])) {
+      if (num_errors < threshold) {
+        clog << "expected: " << expected[i] << ", actual: " << c[i] << endl;
+      } else if (num_errors == threshold) {
+        clog << "...";
+      }
+      ++num_errors;
+    }
+  }
+  if (num_errors == 0) {
+    clog << "PASS!" << endl;
+  } else {
+    if (num_errors > threshold) {
+      clog << " (+" << (num_errors - threshold) << " more errors)" << endl;
+    }
+    clog << "FAIL!" << endl;
+  }
+  return num_errors > 0 ? 1 : 0;
+}
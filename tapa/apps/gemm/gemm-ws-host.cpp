@@ -0,0 +1,75 @@
+#include <cmath>
+
+#include <iostream>
+#include <vector>
+
+#include <tapa.h>
+
+#include "gemm-ws.h"
+
+using std::abs;
+using std::clog;
+using std::endl;
+using std::vector;
+
+void GemmWs(tapa::mmap<WsAVec> a, tapa::mmap<WsBMem> b, tapa::mmap<WsCMem> c,
+            uint64_t m, uint64_t n, uint64_t k);
+
+DEFINE_string(bitstream, "", "path to bitstream file, run csim if empty");
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  // A, B, and C are row-major for weight-stationary arrays.
+  const uint64_t m = argc > 1 ? atoll(argv[1]) : 64;
+  const uint64_t n = GemmWsArray::kCols * GemmWsArray::kTileN * 2;
+  const uint64_t k = GemmWsArray::kRows * 8;
+  vector<float> a(m * k);
+  vector<float> b(k * n);
+  vector<float> c(m * n);
+  vector<float> expected(m * n);
+  for (uint64_t i = 0; i < m; ++i) {
+    for (uint64_t kk = 0; kk < k; ++kk) {
+      a[i * k + kk] = static_cast<float>((i * 7 + kk * 3) % 17) - 8.f;
+    }
+  }
+  for (uint64_t kk = 0; kk < k; ++kk) {
+    for (uint64_t j = 0; j < n; ++j) {
+      b[kk * n + j] = static_cast<float>((j * 5 + kk * 11) % 13) - 6.f;
+    }
+  }
+  tapa::systolic::run<GemmWsArray>(a.data(), b.data(), expected.data(), m, n,
+                                   k);
+
+  int64_t kernel_time_ns = tapa::invoke(
+      GemmWs, FLAGS_bitstream,
+      tapa::read_only_mmap<float>(a).vectorized<GemmWsArray::kRows>(),
+      tapa::read_only_mmap<float>(b)
+          .vectorized<GemmWsArray::kCols * GemmWsArray::kTileN>(),
+      tapa::read_write_mmap<float>(c)
+          .vectorized<GemmWsArray::kCols * GemmWsArray::kTileN>(),
+      m, n, k);
+  clog << "kernel time: " << kernel_time_ns * 1e-9 << " s" << endl;
+
+  uint64_t num_errors = 0;
+  const uint64_t threshold = 10;  // only report up to these errors
+  for (uint64_t i = 0; i < m * n; ++i) {
+    if (abs(c[i] - expected[i]) > 1e-4 * abs(expected[i])) {
+      if (num_errors < threshold) {
+        clog << "expected: " << expected[i] << ", actual: " << c[i] << endl;
+      } else if (num_errors == threshold) {
+        clog << "...";
+      }
+      ++num_errors;
+    }
+  }
+  if (num_errors == 0) {
+    clog << "PASS!" << endl;
+  } else {
+    if (num_errors > threshold) {
+      clog << " (+" << (num_errors - threshold) << " more errors)" << endl;
+    }
+    clog << "FAIL!" << endl;
+  }
+  return num_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+#include <tapa.h>
+
+#include "gemm-ws.h"
+
+constexpr int kCols = GemmWsArray::kCols;
+
+void FeedA(tapa::mmap<WsAVec> a, tapa::ostream<WsAVec>& out, uint64_t m,
+           uint64_t n, uint64_t k) {
+  tapa::systolic::feed_a<GemmWsArray>(a, out, m, n, k);
+}
+
+void FeedB(tapa::mmap<WsBMem> b, tapa::ostreams<WsBVec, kCols>& out,
+           uint64_t m, uint64_t n, uint64_t k) {
+  tapa::systolic::feed_b<GemmWsArray>(b, out, m, n, k);
+}
+
+void Column(tapa::istream<WsAVec>& a_in, tapa::ostream<WsAVec>& a_out,
+            tapa::istream<WsBVec>& b_in, tapa::ostream<WsCVec>& c_out,
+            uint64_t m, uint64_t n, uint64_t k) {
+  tapa::systolic::column<GemmWsArray>(a_in, a_out, b_in, c_out, m, n, k);
+}
+
+void StoreC(tapa::istream<WsAVec>& a_in, tapa::istreams<WsCVec, kCols>& c_in,
+            tapa::mmap<WsCMem> c, uint64_t m, uint64_t n, uint64_t k) {
+  tapa::systolic::store_c<GemmWsArray>(a_in, c_in, c, m, n, k);
+}
+
+void GemmWs(tapa::mmap<WsAVec> a, tapa::mmap<WsBMem> b, tapa::mmap<WsCMem> c,
+            uint64_t m, uint64_t n, uint64_t k) {
+  tapa::streams<WsAVec, kCols + 1> a_q("a");
+  tapa::streams<WsBVec, kCols> b_q("b");
+  tapa::streams<WsCVec, kCols> c_q("c");
+
+  tapa::task()
+      .invoke(FeedA, a, a_q, m, n, k)
+      .invoke(FeedB, b, b_q, m, n, k)
+      .invoke<tapa::join, kCols>(Column, a_q, a_q, b_q, c_q, m, n, k)
+      .invoke(StoreC, a_q, c_q, c, m, n, k);
+}
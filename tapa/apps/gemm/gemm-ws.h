@@ -0,0 +1,19 @@
+#include <tapa.h>
+#include <tapa/systolic.h>
+
+// 4 x 4 weight-stationary PEs, each keeping 4 elements of B.
+struct GemmWsArray {
+  using type = float;
+  static constexpr int kRows = 4;
+  static constexpr int kCols = 4;
+  static constexpr int kTileM = 1;
+  static constexpr int kTileN = 4;
+  static constexpr tapa::systolic::dataflow kDataflow =
+      tapa::systolic::weight_stationary;
+};
+
+using WsAVec = tapa::systolic::a_vec<GemmWsArray>;
+using WsBVec = tapa::systolic::b_vec<GemmWsArray>;
+using WsCVec = tapa::systolic::c_vec<GemmWsArray>;
+using WsBMem = tapa::systolic::b_mem<GemmWsArray>;
+using WsCMem = tapa::systolic::c_mem<GemmWsArray>;
@@ -0,0 +1,39 @@
+#include <tapa.h>
+
+#include "gemm.h"
+
+constexpr int kCols = GemmArray::kCols;
+
+void FeedA(tapa::mmap<AVec> a, tapa::ostream<AVec>& out, uint64_t m,
+           uint64_t n, uint64_t k) {
+  tapa::systolic::feed_a<GemmArray>(a, out, m, n, k);
+}
+
+void FeedB(tapa::mmap<BMem> b, tapa::ostreams<BVec, kCols>& out, uint64_t m,
+           uint64_t n, uint64_t k) {
+  tapa::systolic::feed_b<GemmArray>(b, out, m, n, k);
+}
+
+void Column(tapa::istream<AVec>& a_in, tapa::ostream<AVec>& a_out,
+            tapa::istream<BVec>& b_in, tapa::ostream<CVec>& c_out, uint64_t m,
+            uint64_t n, uint64_t k) {
+  tapa::systolic::column<GemmArray>(a_in, a_out, b_in, c_out, m, n, k);
+}
+
+void StoreC(tapa::istream<AVec>& a_in, tapa::istreams<CVec, kCols>& c_in,
+            tapa::mmap<CMem> c, uint64_t m, uint64_t n, uint64_t k) {
+  tapa::systolic::store_c<GemmArray>(a_in, c_in, c, m, n, k);
+}
+
+void Gemm(tapa::mmap<AVec> a, tapa::mmap<BMem> b, tapa::mmap<CMem> c,
+          uint64_t m, uint64_t n, uint64_t k) {
+  tapa::streams<AVec, kCols + 1> a_q("a");
+  tapa::streams<BVec, kCols> b_q("b");
+  tapa::streams<CVec, kCols> c_q("c");
+
+  tapa::task()
+      .invoke(FeedA, a, a_q, m, n, k)
+      .invoke(FeedB, b, b_q, m, n, k)
+      .invoke<tapa::join, kCols>(Column, a_q, a_q, b_q, c_q, m, n, k)
+      .invoke(StoreC, a_q, c_q, c, m, n, k);
+}
@@ -0,0 +1,19 @@
+#include <tapa.h>
+#include <tapa/systolic.h>
+
+// 4 x 4 output-stationary PEs, each computing 8 x 4 elements of C.
+struct GemmArray {
+  using type = float;
+  static constexpr int kRows = 4;
+  static constexpr int kCols = 4;
+  static constexpr int kTileM = 8;
+  static constexpr int kTileN = 4;
+  static constexpr tapa::systolic::dataflow kDataflow =
+      tapa::systolic::output_stationary;
+};
+
+using AVec = tapa::systolic::a_vec<GemmArray>;
+using BVec = tapa::systolic::b_vec<GemmArray>;
+using CVec = tapa::systolic::c_vec<GemmArray>;
+using BMem = tapa::systolic::b_mem<GemmArray>;
+using CMem = tapa::systolic::c_mem<GemmArray>;
@@ -0,0 +1,14 @@
+#! /bin/bash
+
+WORK_DIR=run
+mkdir -p "${WORK_DIR}"
+
+tapac \
+  --work-dir "${WORK_DIR}" \
+  --top Gemm \
+  --part-num xcu250-figd2104-2L-e \
+  --clock-period 3.33 \
+  -o "${WORK_DIR}/Gemm.xo" \
+  --floorplan-output "${WORK_DIR}/Gemm_floorplan.tcl" \
+  --connectivity link_config.ini \
+  gemm.cpp
@@ -40,18 +40,33 @@ void Graph(Pid num_partitions, tapa::mmap<const Vid> num_vertices,
            tapa::mmap<const Eid> num_edges, tapa::mmap<VertexAttr> vertices,
            tapa::mmap<const Edge> edges, tapa::mmap<Update> updates);
 
-void GraphBaseline(Vid base_vid, vector<VertexAttr>& vertices,
+void GraphBaseline(Vid base_vid, Vid partition_size,
+                   const vector<Eid>& num_edges, vector<VertexAttr>& vertices,
                    const vector<Edge>& edges) {
-  bool has_update = true;
-  while (has_update) {
-    has_update = false;
-    for (const auto& edge : edges) {
-      if (vertices[edge.src - base_vid] < vertices[edge.dst - base_vid]) {
-        vertices[edge.dst - base_vid] = vertices[edge.src - base_vid];
-        has_update = true;
+  // Shard i contains the edges whose source vertices are in partition i.
+  nxgraph::Frontier<Vid> frontier(base_vid, partition_size, num_edges.size());
+  int iteration = 0;
+  do {
+    Eid num_scanned_edges = 0;
+    auto shard = edges.begin();
+    for (size_t pid = 0; pid < num_edges.size(); shard += num_edges[pid++]) {
+      if (!frontier.IsActive(pid)) {
+        continue;
       }
+      for (auto edge = shard; edge < shard + num_edges[pid]; ++edge) {
+        if (vertices[edge->src - base_vid] < vertices[edge->dst - base_vid]) {
+          vertices[edge->dst - base_vid] = vertices[edge->src - base_vid];
+          frontier.Activate(edge->dst);
+        }
+      }
+      num_scanned_edges += num_edges[pid];
     }
-  }
+    LOG(INFO) << "iteration #" << iteration << ": "
+              << frontier.NumActivePartitions() << "/"
+              << frontier.NumPartitions() << " active partitions, "
+              << num_scanned_edges << "/" << edges.size() << " edges scanned";
+    ++iteration;
+  } while (frontier.Advance());
 }
 
 int main(int argc, char* argv[]) {
@@ -123,7 +138,8 @@ int main(int argc, char* argv[]) {
                tapa::read_write_mmap<VertexAttr>(vertices),
                tapa::read_only_mmap<const Edge>(edges),
                tapa::write_only_mmap<Update>(updates));
-  GraphBaseline(base_vid, vertices_baseline, edges);
+  GraphBaseline(base_vid, partition_size, num_edges, vertices_baseline,
+                edges);
   VLOG(10) << "vertices: ";
   for (auto v : vertices) {
     VLOG(10) << v;
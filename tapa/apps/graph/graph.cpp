@@ -132,7 +132,6 @@ void Control(Pid num_partitions, tapa::mmap<const Vid> num_vertices,
   Vid base_vid_acc = num_vertices[0];
   Vid vid_offset_acc = 0;
   Eid eid_offset_acc = 0;
-  bool done[kMaxNumPartitions] = {};
   [[tapa::pipeline(1)]] for (Pid pid = 0; pid < num_partitions; ++pid) {
     Vid num_vertices_delta = num_vertices[pid + 1];
     Eid num_edges_delta = num_edges[pid];
@@ -160,24 +159,39 @@ void Control(Pid num_partitions, tapa::mmap<const Vid> num_vertices,
   }
   update_config_q.close();
 
+  // A partition is active if its vertices were updated in the last iteration.
+  // Edges of inactive partitions cannot produce new updates and are skipped.
+  bool active[kMaxNumPartitions];
+  for (Pid pid = 0; pid < num_partitions; ++pid) {
+    active[pid] = true;
+  }
+
   bool all_done = false;
-  while (!all_done) {
+  for (int iteration = 0; !all_done; ++iteration) {
     all_done = true;
 
     // Do the scatter phase for each partition, if active.
+    Pid num_active_partitions = 0;
+    Eid num_scanned_edges = 0;
     for (Pid pid = 0; pid < num_partitions; ++pid) {
-      if (!done[pid]) {
+      if (active[pid]) {
         TaskReq req{TaskReq::kScatter,    pid,
                     base_vids[pid],       num_vertices_local[pid],
                     num_edges_local[pid], vid_offsets[pid],
                     eid_offsets[pid]};
         req_q.write(req);
+        ++num_active_partitions;
+        num_scanned_edges += num_edges_local[pid];
       }
     }
+    VLOG(1) << "info@Control: iteration #" << iteration << ": "
+            << num_active_partitions << "/" << num_partitions
+            << " active partitions, " << num_scanned_edges << "/"
+            << eid_offset_acc << " edges scanned";
 
     // Wait until all partitions are done with the scatter phase.
     for (Pid pid = 0; pid < num_partitions;) {
-      if (!done[pid]) {
+      if (active[pid]) {
         bool succeeded;
         TaskResp resp = resp_q.read(succeeded);
         if (succeeded) {
@@ -189,7 +203,8 @@ void Control(Pid num_partitions, tapa::mmap<const Vid> num_vertices,
       }
     }
 
-    // Do the gather phase for each partition.
+    // Do the gather phase for each partition; partitions without updates
+    // return immediately.
     for (Pid pid = 0; pid < num_partitions; ++pid) {
       TaskReq req{TaskReq::kGather,     pid,
                   base_vids[pid],       num_vertices_local[pid],
@@ -205,10 +220,9 @@ void Control(Pid num_partitions, tapa::mmap<const Vid> num_vertices,
       if (succeeded) {
         assert(resp.phase == TaskReq::kGather);
         VLOG(3) << "recv@Control: " << resp;
+        active[pid] = resp.active;
         if (resp.active) {
           all_done = false;
-        } else {
-          done[pid] = true;
         }
         ++pid;
       }
@@ -318,10 +332,10 @@ void ProcElem(tapa::istream<TaskReq>& req_q, tapa::ostream<TaskResp>& resp_q,
     const TaskReq req = req_q.read();
     VLOG(5) << "recv@ProcElem: TaskReq: " << req;
     update_req_q.write({req.phase, req.pid});
-    memcpy(vertices_local, vertices + req.vid_offset,
-           req.num_vertices * sizeof(VertexAttr));
     bool active = false;
     if (req.IsScatter()) {
+      memcpy(vertices_local, vertices + req.vid_offset,
+             req.num_vertices * sizeof(VertexAttr));
       for (Eid eid = 0; eid < req.num_edges; ++eid) {
         auto edge = edges[req.eid_offset + eid];
         auto vertex_attr = vertices_local[edge.src - req.base_vid];
@@ -333,20 +347,31 @@ void ProcElem(tapa::istream<TaskReq>& req_q, tapa::ostream<TaskResp>& resp_q,
       }
       update_out_q.close();
     } else {
-      TAPA_WHILE_NOT_EOT(update_in_q) {
+      // Vertices are not loaded if there is no update, and not stored if no
+      // update changes them.
+      bool is_eot;
+      while (!update_in_q.try_eot(is_eot)) {
+      }
+      if (!is_eot) {
+        memcpy(vertices_local, vertices + req.vid_offset,
+               req.num_vertices * sizeof(VertexAttr));
+        TAPA_WHILE_NOT_EOT(update_in_q) {
 #pragma HLS dependence false variable = vertices_local
-        auto update = update_in_q.read(nullptr);
-        VLOG(5) << "recv@ProcElem: Update: " << update;
-        auto idx = update.dst - req.base_vid;
-        auto old_vertex_value = vertices_local[idx];
-        if (update.value < old_vertex_value) {
-          vertices_local[idx] = update.value;
-          active = true;
+          auto update = update_in_q.read(nullptr);
+          VLOG(5) << "recv@ProcElem: Update: " << update;
+          auto idx = update.dst - req.base_vid;
+          auto old_vertex_value = vertices_local[idx];
+          if (update.value < old_vertex_value) {
+            vertices_local[idx] = update.value;
+            active = true;
+          }
+        }
+        if (active) {
+          memcpy(vertices + req.vid_offset, vertices_local,
+                 req.num_vertices * sizeof(VertexAttr));
         }
       }
       update_in_q.open();
-      memcpy(vertices + req.vid_offset, vertices_local,
-             req.num_vertices * sizeof(VertexAttr));
     }
     TaskResp resp{req.phase, req.pid, active};
     resp_q.write(resp);
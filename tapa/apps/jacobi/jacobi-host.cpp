@@ -5,11 +5,13 @@
 
 #include <tapa.h>
 
+#include "jacobi.h"
+
 using std::clog;
 using std::endl;
 using std::vector;
 
-void Jacobi(tapa::mmap<float> bank_0_t0, tapa::mmap<const float> bank_0_t1,
+void Jacobi(tapa::mmap<Vec> bank_0_t0, tapa::mmap<Vec> bank_0_t1,
             uint64_t coalesced_data_num);
 
 DEFINE_string(bitstream, "", "path to bitstream file, run csim if empty");
@@ -17,14 +19,12 @@ DEFINE_string(bitstream, "", "path to bitstream file, run csim if empty");
 int main(int argc, char* argv[]) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
-  const uint64_t width = 100;
+  const uint64_t width = Jacobi2D::kWidth;
   const uint64_t height = argc > 1 ? atoll(argv[1]) : 100;
   vector<float> t1_vec(height * width);
-  vector<float> t0_vec(
-      height * width +
-      (width * 2 + 1));  // additional space is stencil distance
+  vector<float> t0_vec(height * width);
   auto t1 = reinterpret_cast<float(*)[width]>(t1_vec.data());
-  auto t0 = reinterpret_cast<float(*)[width]>(t0_vec.data() + width);
+  auto t0 = reinterpret_cast<float(*)[width]>(t0_vec.data());
   for (uint64_t i = 0; i < height; ++i) {
     for (uint64_t j = 0; j < width; ++j) {
       auto shuffle = [](uint64_t x, uint64_t n) -> float {
@@ -36,8 +36,10 @@ int main(int argc, char* argv[]) {
   }
 
   int64_t kernel_time_ns = tapa::invoke(
-      Jacobi, FLAGS_bitstream, tapa::write_only_mmap<float>(t0_vec),
-      tapa::read_only_mmap<const float>(t1_vec), height * width / 2);
+      Jacobi, FLAGS_bitstream,
+      tapa::write_only_mmap<float>(t0_vec).vectorized<Jacobi2D::kUnroll>(),
+      tapa::read_only_mmap<float>(t1_vec).vectorized<Jacobi2D::kUnroll>(),
+      height * width / Jacobi2D::kUnroll);
   clog << "kernel time: " << kernel_time_ns * 1e-9 << " s" << endl;
 
   uint64_t num_errors = 0;
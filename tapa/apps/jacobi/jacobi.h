@@ -0,0 +1,18 @@
+#include <tapa.h>
+#include <tapa/stencil.h>
+
+// 5-point Jacobi stencil on a grid of 100 columns, 2 elements per cycle.
+struct Jacobi2D {
+  using type = float;
+  static constexpr int kWidth = 100;
+  static constexpr int kUnroll = 2;
+  static constexpr tapa::stencil::offset kTaps[] = {
+      {-1, 0}, {0, -1}, {0, 0}, {1, 0}, {0, 1}};
+  static float compute(const float (&x)[5]) {
+    return (x[0] + x[1] + x[2] + x[3] + x[4]) * .2f;
+  }
+};
+
+using Vec = tapa::stencil::vec<Jacobi2D>;
+
+constexpr int kIterationCount = 1;
@@ -0,0 +1,36 @@
+#include <cstdint>
+
+#include <tapa.h>
+
+// Mmap2Stream and Stream2Mmap are replaced by the built-in burst movers when
+// the RTL is generated; on the host, they copy with memcpy.
+
+void Add(tapa::istream<float>& a, tapa::istream<float>& b,
+         tapa::ostream<float>& c, uint64_t n) {
+  for (uint64_t i = 0; i < n; ++i) {
+    c << (a.read() + b.read());
+  }
+}
+
+[[tapa::target("rtl", "xilinx")]] void Mmap2Stream(
+    tapa::mmap<const float> mmap, uint64_t n, tapa::ostream<float>& stream) {
+  tapa::mmap_to_stream(mmap, n, stream);
+}
+
+[[tapa::target("rtl", "xilinx")]] void Stream2Mmap(
+    tapa::istream<float>& stream, tapa::mmap<float> mmap, uint64_t n) {
+  tapa::stream_to_mmap(stream, mmap, n);
+}
+
+void VecAdd(tapa::mmap<const float> a, tapa::mmap<const float> b,
+            tapa::mmap<float> c, uint64_t n) {
+  tapa::stream<float> a_q("a");
+  tapa::stream<float> b_q("b");
+  tapa::stream<float> c_q("c");
+
+  tapa::task()
+      .invoke(Mmap2Stream, a, n, a_q)
+      .invoke(Mmap2Stream, b, n, b_q)
+      .invoke(Add, a_q, b_q, c_q, n)
+      .invoke(Stream2Mmap, c_q, c, n);
+}
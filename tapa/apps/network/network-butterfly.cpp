@@ -0,0 +1,54 @@
+#include <tapa.h>
+
+using tapa::detach;
+using tapa::istreams;
+using tapa::mmap;
+using tapa::ostreams;
+using tapa::streams;
+using tapa::task;
+using tapa::vec_t;
+
+using pkt_t = uint64_t;
+constexpr int kN = 8;  // kN x kN network
+
+// Same network as network.cpp, built from the butterfly primitive instead of
+// 2x2 switches synthesized by HLS.
+
+[[tapa::target("rtl", "xilinx")]] void Route(istreams<pkt_t, kN>& in_q,
+                                             ostreams<pkt_t, kN>& out_q) {
+  tapa::butterfly<0>(in_q, out_q);
+}
+
+void Produce(mmap<vec_t<pkt_t, kN>> mmap_in, uint64_t n,
+             ostreams<pkt_t, kN>& out_q) {
+produce:
+  [[tapa::pipeline(1)]] for (uint64_t i = 0; i < n; ++i) {
+    auto buf = mmap_in[i];
+    for (int j = 0; j < kN; ++j) {
+      out_q[j].write(buf[j]);
+    }
+  }
+}
+
+void Consume(mmap<vec_t<pkt_t, kN>> mmap_out, uint64_t n,
+             istreams<pkt_t, kN>& in_q) {
+consume:
+  [[tapa::pipeline(1)]] for (uint64_t i = 0; i < n; ++i) {
+    vec_t<pkt_t, kN> buf;
+    for (int j = 0; j < kN; ++j) {
+      buf.set(j, in_q[j].read());
+    }
+    mmap_out[i] = buf;
+  }
+}
+
+void Network(mmap<vec_t<pkt_t, kN>> mmap_in, mmap<vec_t<pkt_t, kN>> mmap_out,
+             uint64_t n) {
+  streams<pkt_t, kN, 4096> in_q("in");
+  streams<pkt_t, kN, 4096> out_q("out");
+
+  task()
+      .invoke(Produce, mmap_in, n, in_q)
+      .invoke<detach>(Route, in_q, out_q)
+      .invoke(Consume, mmap_out, n, out_q);
+}
@@ -0,0 +1,83 @@
+#include <tapa.h>
+
+using tapa::detach;
+using tapa::istream;
+using tapa::istreams;
+using tapa::mmap;
+using tapa::ostream;
+using tapa::ostreams;
+using tapa::stream;
+using tapa::streams;
+using tapa::task;
+using tapa::vec_t;
+
+using pkt_t = uint64_t;
+constexpr int kN = 8;  // kN x kN network
+
+// Same network as network.cpp, built by merging all inputs into one stream and
+// demultiplexing it. A copy of the merged stream is counted on the side.
+
+[[tapa::target("rtl", "xilinx")]] void Merge(istreams<pkt_t, kN>& in_q,
+                                             ostream<pkt_t>& out_q) {
+  tapa::merge(in_q, out_q);
+}
+
+[[tapa::target("rtl", "xilinx")]] void Broadcast(istream<pkt_t>& in_q,
+                                                 ostreams<pkt_t, 2>& out_q) {
+  tapa::broadcast(in_q, out_q);
+}
+
+[[tapa::target("rtl", "xilinx")]] void Demux(istream<pkt_t>& in_q,
+                                             ostreams<pkt_t, kN>& out_q) {
+  tapa::demux<0>(in_q, out_q);
+}
+
+void Produce(mmap<vec_t<pkt_t, kN>> mmap_in, uint64_t n,
+             ostreams<pkt_t, kN>& out_q) {
+produce:
+  [[tapa::pipeline(1)]] for (uint64_t i = 0; i < n; ++i) {
+    auto buf = mmap_in[i];
+    for (int j = 0; j < kN; ++j) {
+      out_q[j].write(buf[j]);
+    }
+  }
+}
+
+void Count(istream<pkt_t>& in_q, uint64_t n) {
+  uint64_t count[kN] = {};
+count:
+  [[tapa::pipeline(1)]] for (uint64_t i = 0; i < n * kN; ++i) {
+    ++count[in_q.read() % kN];
+  }
+  for (int j = 0; j < kN; ++j) {
+    CHECK_EQ(count[j], n);
+  }
+}
+
+void Consume(mmap<vec_t<pkt_t, kN>> mmap_out, uint64_t n,
+             istreams<pkt_t, kN>& in_q) {
+consume:
+  [[tapa::pipeline(1)]] for (uint64_t i = 0; i < n; ++i) {
+    vec_t<pkt_t, kN> buf;
+    for (int j = 0; j < kN; ++j) {
+      buf.set(j, in_q[j].read());
+    }
+    mmap_out[i] = buf;
+  }
+}
+
+void Network(mmap<vec_t<pkt_t, kN>> mmap_in, mmap<vec_t<pkt_t, kN>> mmap_out,
+             uint64_t n) {
+  streams<pkt_t, kN, 4096> in_q("in");
+  stream<pkt_t, 4096> merged_q("merged");
+  streams<pkt_t, 2, 4096> copied_q("copied");
+  streams<pkt_t, kN, 4096> out_q("out");
+
+  task()
+      .invoke(Produce, mmap_in, n, in_q)
+      .invoke<detach>(Merge, in_q, merged_q)
+      .invoke<detach>(Broadcast, merged_q, copied_q)
+      .invoke<detach>(Demux, copied_q[0], out_q)
+      .invoke(Count, copied_q[1], n)
+      .invoke(Consume, mmap_out, n, out_q);
+}
@@ -0,0 +1,102 @@
+#include <cstdint>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <tapa.h>
+
+#include "qdma.h"
+
+using std::clog;
+using std::endl;
+using std::string;
+using std::vector;
+
+void ScaleQueues(tapa::istreams<float, kQueueCount>& in,
+                 tapa::ostreams<float, kQueueCount>& out, float factor);
+
+DEFINE_bool(file, false,
+            "drive the queues from files instead of memory rings");
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  const float factor = 2.5f;
+
+  // Queues have different lengths, so the sink sees them finish at different
+  // times; queue 0 carries an empty packet.
+  vector<vector<float>> input(kQueueCount);
+  for (uint64_t i = 0; i < kQueueCount; ++i) {
+    input[i].resize(i * 1000);
+    for (uint64_t j = 0; j < input[i].size(); ++j) {
+      input[i][j] = static_cast<float>(i * 10000 + j);
+    }
+  }
+
+  tapa::streams<float, kQueueCount> in_q("in");
+  tapa::streams<float, kQueueCount> out_q("out");
+  vector<vector<float>> output;
+  if (FLAGS_file) {
+    vector<string> input_paths, output_paths;
+    for (uint64_t i = 0; i < kQueueCount; ++i) {
+      input_paths.push_back("qdma-in-" + std::to_string(i) + ".bin");
+      output_paths.push_back("qdma-out-" + std::to_string(i) + ".bin");
+      std::ofstream(input_paths[i], std::ios::binary)
+          .write(reinterpret_cast<const char*>(input[i].data()),
+                 input[i].size() * sizeof(float));
+    }
+    tapa::task()
+        .invoke(tapa::qdma_file_source<float, kQueueCount>, input_paths, in_q)
+        .invoke(ScaleQueues, in_q, out_q, factor)
+        .invoke(tapa::qdma_file_sink<float, kQueueCount>, out_q,
+                output_paths);
+    output.resize(kQueueCount);
+    for (uint64_t i = 0; i < kQueueCount; ++i) {
+      std::ifstream file(output_paths[i], std::ios::binary);
+      for (float value; file.read(reinterpret_cast<char*>(&value),
+                                  sizeof(value));) {
+        output[i].push_back(value);
+      }
+    }
+  } else {
+    tapa::task()
+        .invoke(tapa::qdma_ring_source<float, kQueueCount>, input, in_q)
+        .invoke(ScaleQueues, in_q, out_q, factor)
+        .invoke(tapa::qdma_ring_sink<float, kQueueCount>, out_q, &output);
+  }
+
+  uint64_t num_errors = 0;
+  const uint64_t threshold = 10;  // only report up to these errors
+  for (uint64_t i = 0; i < kQueueCount; ++i) {
+    if (output[i].size() != input[i].size()) {
+      clog << "queue " << i << ": expected " << input[i].size()
+           << " elements, got " << output[i].size() << endl;
+      ++num_errors;
+      continue;
+    }
+    for (uint64_t j = 0; j < input[i].size(); ++j) {
+      const float expected = input[i][j] * factor;
+      if (output[i][j] != expected) {
+        if (num_errors < threshold) {
+          clog << "queue " << i << " [" << j << "]: expected " << expected
+               << ", actual: " << output[i][j] << endl;
+        } else if (num_errors == threshold) {
+          clog << "...";
+        }
+        ++num_errors;
+      }
+    }
+  }
+  if (num_errors == 0) {
+    clog << "PASS!" << endl;
+  } else {
+    if (num_errors > threshold) {
+      clog << " (+" << (num_errors - threshold) << " more errors)" << endl;
+    }
+    clog << "FAIL!" << endl;
+  }
+  return num_errors > 0 ? 1 : 0;
+}
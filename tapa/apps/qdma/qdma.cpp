@@ -0,0 +1,16 @@
+#include <tapa.h>
+
+#include "qdma.h"
+
+// Scales one packet.
+void Scale(tapa::istream<float>& in, tapa::ostream<float>& out, float factor) {
+  TAPA_WHILE_NOT_EOT(in) { out.write(in.read(nullptr) * factor); }
+  in.open();
+  out.close();
+}
+
+// Each channel of `in` and `out` is a QDMA queue.
+void ScaleQueues(tapa::istreams<float, kQueueCount>& in,
+                 tapa::ostreams<float, kQueueCount>& out, float factor) {
+  tapa::task().invoke<tapa::join, kQueueCount>(Scale, in, out, factor);
+}
@@ -0,0 +1,8 @@
+#ifndef TAPA_APPS_QDMA_H_
+#define TAPA_APPS_QDMA_H_
+
+#include <cstdint>
+
+constexpr uint64_t kQueueCount = 4;
+
+#endif  // TAPA_APPS_QDMA_H_
@@ -0,0 +1,45 @@
+#include <cstdint>
+
+#include <tapa.h>
+
+void Add(tapa::istream<float>& a, tapa::istream<float>& b,
+         tapa::ostream<float>& c, uint64_t n) {
+  for (uint64_t i = 0; i < n; ++i) {
+    c << (a.read() + b.read());
+  }
+}
+
+void Mmap2Stream(tapa::mmap<const float> mmap, uint64_t n,
+                 tapa::ostream<float>& stream) {
+  for (uint64_t i = 0; i < n; ++i) {
+    stream << mmap[i];
+  }
+}
+
+// With `--specialize n=...`, `n` of `Load` is bound as well, but it is passed
+// to `Mmap2Stream`, which is also invoked with `m` and thus keeps its `n`.
+void Load(tapa::mmap<const float> mmap, uint64_t n,
+          tapa::ostream<float>& stream) {
+  tapa::task().invoke(Mmap2Stream, mmap, n, stream);
+}
+
+void Stream2Mmap(tapa::istream<float>& stream, tapa::mmap<float> mmap,
+                 uint64_t n) {
+  for (uint64_t i = 0; i < n; ++i) {
+    stream >> mmap[i];
+  }
+}
+
+// `m` must be equal to `n`; it is a separate argument to be left unspecialized.
+void VecAddSpecialized(tapa::mmap<const float> a, tapa::mmap<const float> b,
+                       tapa::mmap<float> c, uint64_t n, uint64_t m) {
+  tapa::stream<float> a_q("a");
+  tapa::stream<float> b_q("b");
+  tapa::stream<float> c_q("c");
+
+  tapa::task()
+      .invoke(Load, a, n, a_q)
+      .invoke(Mmap2Stream, b, m, b_q)
+      .invoke(Add, a_q, b_q, c_q, n)
+      .invoke(Stream2Mmap, c_q, c, n);
+}
@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include <gflags/gflags.h>
@@ -12,6 +15,8 @@ void VecAdd(tapa::mmap<const float> a_array, tapa::mmap<const float> b_array,
             tapa::mmap<float> c_array, uint64_t n);
 
 DEFINE_string(bitstream, "", "path to bitstream file, run csim if empty");
+DEFINE_uint64(instances, 1,
+              "number of kernel instances, each adding a shard of the vectors");
 
 int main(int argc, char* argv[]) {
   gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags=*/true);
@@ -25,9 +30,28 @@ int main(int argc, char* argv[]) {
     b[i] = static_cast<float>(i) * 2;
     c[i] = 0.f;
   }
-  int64_t kernel_time_ns = tapa::invoke(
-      VecAdd, FLAGS_bitstream, tapa::read_only_mmap<const float>(a),
-      tapa::read_only_mmap<const float>(b), tapa::write_only_mmap<float>(c), n);
+  int64_t kernel_time_ns;
+  if (FLAGS_instances == 1) {
+    kernel_time_ns = tapa::invoke(VecAdd, FLAGS_bitstream,
+                                  tapa::read_only_mmap<const float>(a),
+                                  tapa::read_only_mmap<const float>(b),
+                                  tapa::write_only_mmap<float>(c), n);
+  } else {
+    auto shard = [n](uint64_t i, uint64_t count, auto arg) {
+      if constexpr (std::is_same_v<decltype(arg), uint64_t>) {
+        return tapa::shard_evenly::size(i, count, n);
+      } else {
+        return tapa::shard_evenly()(i, count, arg);
+      }
+    };
+    const auto instance_time_ns = tapa::invoke_sharded(
+        VecAdd, vector<std::string>(FLAGS_instances, FLAGS_bitstream), shard,
+        tapa::read_only_mmap<const float>(a),
+        tapa::read_only_mmap<const float>(b), tapa::write_only_mmap<float>(c),
+        n);
+    kernel_time_ns =
+        *std::max_element(instance_time_ns.begin(), instance_time_ns.end());
+  }
   clog << "kernel time: " << kernel_time_ns * 1e-9 << " s" << endl;
 
   uint64_t num_errors = 0;
@@ -15,7 +15,13 @@ module async_mmap #(
   parameter EnableWriteChannel= 1,
   // for burst inference
   parameter MaxWaitTime       = 3,
-  parameter MaxBurstLen       = 15
+  parameter MaxBurstLen       = 15,
+  // number of lines that merge writes to the same address before the burst
+  // detector; if set to 0: write combining is disabled
+  parameter WriteCombineCapacity = 0,
+  // number of reads prefetched ahead once a constant stride is detected;
+  // if set to 0: prefetching is disabled
+  parameter PrefetchDepth     = 0
 ) (
   input wire clk,
   input wire rst, // active high
@@ -91,7 +97,11 @@ module async_mmap #(
   // pop write resp here
   output wire [7:0] write_resp_dout,
   input  wire       write_resp_read,
-  output wire       write_resp_empty_n
+  output wire       write_resp_empty_n,
+
+  // number of read addresses served by prefetches or sent to memory
+  output wire [31:0] read_prefetch_hit_count,
+  output wire [31:0] read_prefetch_miss_count
 );
 
   // write addr buffer, from user to burst detector
@@ -122,6 +132,184 @@ module async_mmap #(
     .if_dout   (write_addr_dout)
   );
 
+  // write data buffer, from user to write combiner or axi
+  wire [DataWidth-1:0] write_data_dout;
+  wire                 write_data_empty_n;
+  wire                 write_data_read;
+  relay_station #(
+    .DATA_WIDTH(DataWidth),
+    .ADDR_WIDTH(BufferSizeLog),
+    .DEPTH     (BufferSize),
+    .LEVEL     (1),
+    .CONNECT   (EnableWriteChannel)
+  ) write_data (
+    .clk  (clk),
+    .reset(rst),
+
+    // from user
+    .if_full_n  (write_data_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (write_data_write),
+    .if_din     (write_data_din),
+
+    // to write combiner or axi
+    .if_empty_n(write_data_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (write_data_read),
+    .if_dout   (write_data_dout)
+  );
+
+  // combined writes, to burst detector and axi
+  wire [AddrWidth-1:0] combined_write_addr_dout;
+  wire                 combined_write_addr_empty_n;
+  wire                 combined_write_addr_read;
+  wire [DataWidth-1:0] combined_write_data_dout;
+  wire [7:0]           combined_write_data_count;  // merged writes minus one
+  wire                 combined_write_data_empty_n;
+  wire                 combined_write_data_read;
+
+  // number of merged writes of each burst, used to generate write responses
+  wire [7:0] write_extra_dout;
+  wire       write_extra_full_n;
+  wire       write_extra_empty_n;
+  wire       write_extra_read;
+
+  generate
+    if (WriteCombineCapacity > 0) begin : write_combine_enabled
+      // each write response counts at most 256 writes
+      localparam MaxMergeCount =
+          MaxBurstLen < 256 ? 256 / (MaxBurstLen + 1) - 1 : 0;
+
+      wire [AddrWidth-1:0]   combined_write_addr_din;
+      wire                   combined_write_addr_full_n;
+      wire                   combined_write_addr_write;
+      wire [8+DataWidth-1:0] combined_write_data_din;
+      wire                   combined_write_data_full_n;
+      wire                   combined_write_data_write;
+
+      write_combine #(
+        .Capacity         (WriteCombineCapacity),
+        .AddrWidth        (AddrWidth),
+        .DataWidth        (DataWidth),
+        .DataWidthBytesLog(DataWidthBytesLog),
+        .CountWidth       (8),
+        .WaitTimeWidth    (WaitTimeWidth),
+        .MaxMergeCount    (MaxMergeCount),
+        .MaxWaitTime      (MaxWaitTime)
+      ) write_combine_unit (
+        .clk(clk),
+        .rst(rst),
+
+        // input: individual writes
+        .addr_dout   (write_addr_dout),
+        .addr_empty_n(write_addr_empty_n),
+        .addr_read   (write_addr_read),
+        .data_dout   (write_data_dout),
+        .data_empty_n(write_data_empty_n),
+        .data_read   (write_data_read),
+
+        // output: combined writes
+        .addr_din   (combined_write_addr_din),
+        .addr_full_n(combined_write_addr_full_n),
+        .addr_write (combined_write_addr_write),
+        .data_din   (combined_write_data_din),
+        .data_full_n(combined_write_data_full_n),
+        .data_write (combined_write_data_write)
+      );
+
+      relay_station #(
+        .DATA_WIDTH(AddrWidth),
+        .ADDR_WIDTH(BufferSizeLog),
+        .DEPTH     (BufferSize),
+        .LEVEL     (1),
+        .CONNECT   (EnableWriteChannel)
+      ) combined_write_addr (
+        .clk  (clk),
+        .reset(rst),
+
+        // from write combiner
+        .if_full_n  (combined_write_addr_full_n),
+        .if_write_ce(1'b1),
+        .if_write   (combined_write_addr_write),
+        .if_din     (combined_write_addr_din),
+
+        // to burst detector
+        .if_empty_n(combined_write_addr_empty_n),
+        .if_read_ce(1'b1),
+        .if_read   (combined_write_addr_read),
+        .if_dout   (combined_write_addr_dout)
+      );
+
+      relay_station #(
+        .DATA_WIDTH(8 + DataWidth),
+        .ADDR_WIDTH(BufferSizeLog),
+        .DEPTH     (BufferSize),
+        .LEVEL     (1),
+        .CONNECT   (EnableWriteChannel)
+      ) combined_write_data (
+        .clk  (clk),
+        .reset(rst),
+
+        // from write combiner
+        .if_full_n  (combined_write_data_full_n),
+        .if_write_ce(1'b1),
+        .if_write   (combined_write_data_write),
+        .if_din     (combined_write_data_din),
+
+        // to axi
+        .if_empty_n(combined_write_data_empty_n),
+        .if_read_ce(1'b1),
+        .if_read   (combined_write_data_read),
+        .if_dout   ({combined_write_data_count, combined_write_data_dout})
+      );
+
+      // sum of merged writes of the ongoing burst
+      reg [7:0] write_extra_sum;
+      always @(posedge clk) begin
+        if (rst) begin
+          write_extra_sum <= 8'd0;
+        end else if (m_axi_WVALID && m_axi_WREADY) begin
+          write_extra_sum <= m_axi_WLAST ?
+              8'd0 : write_extra_sum + combined_write_data_count;
+        end
+      end
+
+      relay_station #(
+        .DATA_WIDTH(8),
+        .ADDR_WIDTH(BufferSizeLog),
+        .DEPTH     (BufferSize),
+        .LEVEL     (1),
+        .CONNECT   (EnableWriteChannel)
+      ) write_extra (
+        .clk  (clk),
+        .reset(rst),
+
+        // from axi, once per burst
+        .if_full_n  (write_extra_full_n),
+        .if_write_ce(1'b1),
+        .if_write   (m_axi_WVALID && m_axi_WREADY && m_axi_WLAST),
+        .if_din     (write_extra_sum + combined_write_data_count),
+
+        // to write resp buffer
+        .if_empty_n(write_extra_empty_n),
+        .if_read_ce(1'b1),
+        .if_read   (write_extra_read),
+        .if_dout   (write_extra_dout)
+      );
+    end else begin : write_combine_disabled
+      assign combined_write_addr_dout    = write_addr_dout;
+      assign combined_write_addr_empty_n = write_addr_empty_n;
+      assign write_addr_read             = combined_write_addr_read;
+      assign combined_write_data_dout    = write_data_dout;
+      assign combined_write_data_count   = 8'd0;
+      assign combined_write_data_empty_n = write_data_empty_n;
+      assign write_data_read             = combined_write_data_read;
+      assign write_extra_dout            = 8'd0;
+      assign write_extra_full_n          = 1'b1;
+      assign write_extra_empty_n         = 1'b1;
+    end
+  endgenerate
+
   // burst write addr buffer, from burst detector to axi
   wire [BurstLenWidth+AddrWidth-1:0] burst_write_addr_din;
   wire                               burst_write_addr_full_n;
@@ -164,9 +352,9 @@ module async_mmap #(
     .max_burst_len(MaxBurstLen[BurstLenWidth-1:0]),
 
     // input: individual addresses
-    .addr_dout   (write_addr_dout),
-    .addr_empty_n(write_addr_empty_n),
-    .addr_read   (write_addr_read),
+    .addr_dout   (combined_write_addr_dout),
+    .addr_empty_n(combined_write_addr_empty_n),
+    .addr_read   (combined_write_addr_read),
 
     // output: inferred burst addresses
     .addr_din   (burst_write_addr_din),
@@ -291,40 +479,18 @@ module async_mmap #(
     .if_empty_n(burst_write_last_empty_n),
     .if_read_ce(1'b1),
     // deal with when last-relay_station is non-empty while data-relay_station is empty
-    .if_read   (m_axi_WREADY && write_data_empty_n),
+    .if_read   (m_axi_WREADY && write_extra_full_n && combined_write_data_empty_n),
     .if_dout   (burst_write_last_dout)
   );
 
-  // write data buffer
-  wire [DataWidth-1:0] write_data_dout;
-  wire                 write_data_empty_n;
-  relay_station #(
-    .DATA_WIDTH(DataWidth),
-    .ADDR_WIDTH(BufferSizeLog),
-    .DEPTH     (BufferSize),
-    .LEVEL     (1),
-    .CONNECT   (EnableWriteChannel)
-  ) write_data (
-    .clk  (clk),
-    .reset(rst),
-
-    // from user
-    .if_full_n  (write_data_full_n),
-    .if_write_ce(1'b1),
-    .if_write   (write_data_write),
-    .if_din     (write_data_din),
-
-    // to axi
-    .if_empty_n(write_data_empty_n),
-    .if_read_ce(1'b1),
-    // deal with when data-relay_station is non empty but last-relay_station is empty
-    .if_read   (m_axi_WREADY && burst_write_last_empty_n),
-    .if_dout   (write_data_dout)
-  );
+  // deal with when data-relay_station is non empty but last-relay_station is empty
+  assign combined_write_data_read =
+      m_axi_WREADY && write_extra_full_n && burst_write_last_empty_n;
 
   // write resp buffer
-  wire [BurstLenWidth-1:0] write_resp_din   = write_req_dout;
-  wire                     write_resp_write = m_axi_BVALID && write_req_empty_n;
+  wire [BurstLenWidth-1:0] write_resp_din   = write_req_dout + write_extra_dout;
+  wire                     write_resp_write =
+      m_axi_BVALID && write_req_empty_n && write_extra_empty_n;
   wire                     write_resp_full_n;
   relay_station #(
     .DATA_WIDTH(BurstLenWidth),
@@ -336,7 +502,7 @@ module async_mmap #(
     .clk  (clk),
     .reset(rst),
 
-    // from write req buffer and axi
+    // from write req buffer, write extra buffer, and axi
     .if_full_n  (write_resp_full_n),
     .if_write_ce(1'b1),
     .if_write   (write_resp_write),
@@ -363,14 +529,16 @@ module async_mmap #(
   assign m_axi_AWQOS    = 0;
 
   // W channel
-  assign m_axi_WVALID = write_data_empty_n && burst_write_last_empty_n;
-  assign m_axi_WDATA  = write_data_dout;
+  assign m_axi_WVALID = combined_write_data_empty_n && burst_write_last_empty_n &&
+                        write_extra_full_n;
+  assign m_axi_WDATA  = combined_write_data_dout;
   assign m_axi_WSTRB  = {(DataWidth/8){1'b1}};  // assume every bit is valid
   assign m_axi_WLAST  = burst_write_last_dout;
 
   // B channel
-  assign m_axi_BREADY   = write_resp_full_n && write_req_empty_n;
-  assign write_req_read = write_resp_full_n && m_axi_BVALID;
+  assign m_axi_BREADY     = write_resp_full_n && write_req_empty_n && write_extra_empty_n;
+  assign write_req_read   = write_resp_full_n && m_axi_BVALID && write_extra_empty_n;
+  assign write_extra_read = write_req_read;
 
   // read addr buffer, from user to burst detector
   wire [AddrWidth-1:0] read_addr_dout;
@@ -393,13 +561,101 @@ module async_mmap #(
     .if_write   (read_addr_write),
     .if_din     (offset + (read_addr_din << $clog2(DataWidth/8))),
 
-    // to axi
+    // to prefetcher or burst detector
     .if_empty_n(read_addr_empty_n),
     .if_read_ce(1'b1),
     .if_read   (read_addr_read),
     .if_dout   (read_addr_dout)
   );
 
+  // read addresses sent to memory, to burst detector
+  wire [AddrWidth-1:0] issued_read_addr_dout;
+  wire                 issued_read_addr_empty_n;
+  wire                 issued_read_addr_read;
+
+  // read resp buffer, from prefetcher or axi to user
+  wire [DataWidth-1:0] read_data_din;
+  wire                 read_data_write;
+  wire                 read_data_full_n;
+
+  generate
+    if (PrefetchDepth > 0) begin : prefetch_enabled
+      wire [AddrWidth-1:0] issued_read_addr_din;
+      wire                 issued_read_addr_full_n;
+      wire                 issued_read_addr_write;
+
+      stride_prefetch #(
+        .AddrWidth     (AddrWidth),
+        .DataWidth     (DataWidth),
+        .Depth         (PrefetchDepth),
+        .DepthLog      ($clog2(PrefetchDepth) > 0 ? $clog2(PrefetchDepth) : 1),
+        .MaxInflight   (BufferSize * 2),
+        .MaxInflightLog(BufferSizeLog + 1)
+      ) stride_prefetch_unit (
+        .clk(clk),
+        .rst(rst),
+
+        // input: user read addresses
+        .addr_dout   (read_addr_dout),
+        .addr_empty_n(read_addr_empty_n),
+        .addr_read   (read_addr_read),
+
+        // output: read addresses sent to memory
+        .mem_addr_din   (issued_read_addr_din),
+        .mem_addr_full_n(issued_read_addr_full_n),
+        .mem_addr_write (issued_read_addr_write),
+
+        // input: R channel
+        .mem_data_valid(m_axi_RVALID),
+        .mem_data_ready(m_axi_RREADY),
+        .mem_data      (m_axi_RDATA),
+
+        // output: user read data
+        .data_din   (read_data_din),
+        .data_full_n(read_data_full_n),
+        .data_write (read_data_write),
+
+        .hit_count (read_prefetch_hit_count),
+        .miss_count(read_prefetch_miss_count)
+      );
+
+      relay_station #(
+        .DATA_WIDTH(AddrWidth),
+        .ADDR_WIDTH(BufferSizeLog),
+        .DEPTH     (BufferSize),
+        .LEVEL     (1),
+        .CONNECT   (EnableReadChannel)
+      ) issued_read_addr (
+        .clk  (clk),
+        .reset(rst),
+
+        // from prefetcher
+        .if_full_n  (issued_read_addr_full_n),
+        .if_write_ce(1'b1),
+        .if_write   (issued_read_addr_write),
+        .if_din     (issued_read_addr_din),
+
+        // to burst detector
+        .if_empty_n(issued_read_addr_empty_n),
+        .if_read_ce(1'b1),
+        .if_read   (issued_read_addr_read),
+        .if_dout   (issued_read_addr_dout)
+      );
+    end else begin : prefetch_disabled
+      assign issued_read_addr_dout    = read_addr_dout;
+      assign issued_read_addr_empty_n = read_addr_empty_n;
+      assign read_addr_read           = issued_read_addr_read;
+
+      // R channel
+      assign m_axi_RREADY    = read_data_full_n;
+      assign read_data_write = m_axi_RVALID;
+      assign read_data_din   = m_axi_RDATA;
+
+      assign read_prefetch_hit_count  = 32'd0;
+      assign read_prefetch_miss_count = 32'd0;
+    end
+  endgenerate
+
   wire [BurstLenWidth+AddrWidth-1:0] burst_read_addr_din;
   wire                               burst_read_addr_full_n;
   wire                               burst_read_addr_write;
@@ -444,9 +700,9 @@ module async_mmap #(
     .max_burst_len(MaxBurstLen[BurstLenWidth-1:0]),
 
     // input: individual addresses
-    .addr_dout   (read_addr_dout),
-    .addr_empty_n(read_addr_empty_n),
-    .addr_read   (read_addr_read),
+    .addr_dout   (issued_read_addr_dout),
+    .addr_empty_n(issued_read_addr_empty_n),
+    .addr_read   (issued_read_addr_read),
 
     // output: inferred burst addresses
     .addr_din   (burst_read_addr_din),
@@ -465,9 +721,6 @@ module async_mmap #(
   );
 
   // read resp buffer
-  wire [DataWidth-1:0] read_data_din;
-  wire                 read_data_write;
-  wire                 read_data_full_n;
   relay_station #(
     .DATA_WIDTH(DataWidth),
     .ADDR_WIDTH(BufferSizeLog),
@@ -478,7 +731,7 @@ module async_mmap #(
     .clk  (clk),
     .reset(rst),
 
-    // from axi
+    // from prefetcher or axi
     .if_full_n  (read_data_full_n),
     .if_write_ce(1'b1),
     .if_write   (read_data_write),
@@ -504,11 +757,6 @@ module async_mmap #(
   assign m_axi_ARPROT         = 0;
   assign m_axi_ARQOS          = 0;
 
-  // R channel
-  assign m_axi_RREADY    = read_data_full_n;
-  assign read_data_write = m_axi_RVALID;
-  assign read_data_din   = m_axi_RDATA;
-
   // unused input signals
   wire _unused = &{1'b0,
     m_axi_BRESP,
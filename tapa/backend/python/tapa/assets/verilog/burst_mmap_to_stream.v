@@ -0,0 +1,185 @@
+`default_nettype none
+
+// Read Count elements of MemWidth bits starting at byte address offset and
+// write them to a stream of StreamWidth-bit elements.
+//
+// Read requests are issued as bursts of up to MaxBurstLen beats that never
+// cross a 4KB boundary. A burst is issued only if the read buffer has room
+// for all of its beats, so RREADY stays high and as many bursts as fit in
+// BufferDepth beats are in flight. Each beat is split into MemWidth /
+// StreamWidth elements, lowest bits first, or StreamWidth / MemWidth beats are
+// concatenated into one element, lowest bits first.
+module burst_mmap_to_stream #(
+  parameter AddrWidth         = 64,
+  parameter MemWidth          = 512,
+  parameter MemWidthBytesLog  = 6,  // must equal log2(MemWidth/8)
+  parameter StreamWidth       = 512,
+  parameter MaxBurstLen       = 64,
+  parameter BufferDepth       = 256,  // must be at least MaxBurstLen
+  parameter BufferDepthLog    = 8
+) (
+  input wire clk,
+  input wire rst,
+
+  // control
+  input  wire                 start,
+  output wire                 idle,
+  output reg                  done,
+  input  wire [AddrWidth-1:0] offset,
+  input  wire [63:0]          count,
+
+  // read address channel
+  output reg  [AddrWidth-1:0] m_axi_ARADDR,
+  output reg  [7:0]           m_axi_ARLEN,
+  output reg                  m_axi_ARVALID,
+  input  wire                 m_axi_ARREADY,
+
+  // read data channel
+  input  wire [MemWidth-1:0]  m_axi_RDATA,
+  input  wire                 m_axi_RVALID,
+  output wire                 m_axi_RREADY,
+
+  // output stream
+  output wire [StreamWidth-1:0] data_din,
+  input  wire                   data_full_n,
+  output wire                   data_write
+);
+
+  // state
+  reg                    busy;
+  reg [AddrWidth-1:0]    next_addr;
+  reg [63:0]             beats_to_request;  // beats not yet requested
+  reg [63:0]             beats_to_consume;  // beats not yet sent downstream
+  reg [BufferDepthLog:0] credits;           // buffer slots not yet reserved
+
+  // fifo signals
+  wire [MemWidth-1:0] buffer_dout;
+  wire                buffer_full_n;
+  wire                buffer_empty_n;
+  wire                buffer_read;
+
+  // address side
+  wire [12:0] page_beats = (13'd4096 - {1'b0, next_addr[11:0]}) >>
+                           MemWidthBytesLog;
+  wire [12:0] max_beats = page_beats < MaxBurstLen ? page_beats : MaxBurstLen;
+  wire [12:0] burst_len = beats_to_request < max_beats ?
+                          beats_to_request[12:0] : max_beats;
+  wire issue = busy && !m_axi_ARVALID && beats_to_request != 64'd0 &&
+               credits >= burst_len;
+
+  assign idle = !busy;
+  assign m_axi_RREADY = buffer_full_n;
+
+  // data side
+  generate
+    if (MemWidth >= StreamWidth) begin : split
+      localparam Ratio = MemWidth / StreamWidth;
+
+      reg [$clog2(Ratio+1)-1:0] lane;
+
+      assign data_din    = buffer_dout[lane*StreamWidth +: StreamWidth];
+      assign data_write  = buffer_empty_n && beats_to_consume != 64'd0;
+      assign buffer_read = data_write && data_full_n && lane == Ratio - 1;
+
+      always @(posedge clk) begin
+        if (rst) begin
+          lane <= 0;
+        end else if (data_write && data_full_n) begin
+          lane <= lane == Ratio - 1 ? 0 : lane + 1'b1;
+        end
+      end
+    end else begin : concat
+      localparam Ratio = StreamWidth / MemWidth;
+
+      reg [StreamWidth-1:0]     acc;
+      reg [$clog2(Ratio+1)-1:0] acc_count;
+
+      assign data_din    = acc;
+      assign data_write  = acc_count == Ratio;
+      assign buffer_read = buffer_empty_n && beats_to_consume != 64'd0 &&
+                           (acc_count != Ratio || data_full_n);
+
+      always @(posedge clk) begin
+        if (rst) begin
+          acc_count <= 0;
+        end else begin
+          if (buffer_read) begin
+            acc <= {buffer_dout, acc[StreamWidth-1:MemWidth]};
+          end
+          if (buffer_read) begin
+            acc_count <= data_write && data_full_n ? 1 : acc_count + 1'b1;
+          end else if (data_write && data_full_n) begin
+            acc_count <= 0;
+          end
+        end
+      end
+    end
+  endgenerate
+
+  // the last element leaves the same cycle its beat is consumed, or the
+  // cycle after for concatenated elements
+  wire is_drained = beats_to_request == 64'd0 && beats_to_consume == 64'd0 &&
+                    !m_axi_ARVALID && !data_write;
+
+  always @(posedge clk) begin
+    if (rst) begin
+      busy          <= 1'b0;
+      done          <= 1'b0;
+      credits       <= BufferDepth;
+      m_axi_ARVALID <= 1'b0;
+    end else begin
+      done <= 1'b0;
+      if (!busy) begin
+        if (start) begin
+          busy             <= 1'b1;
+          next_addr        <= offset;
+          beats_to_request <= count;
+          beats_to_consume <= count;
+        end
+      end else begin
+        if (issue) begin
+          m_axi_ARADDR     <= next_addr;
+          m_axi_ARLEN      <= burst_len - 1'b1;
+          m_axi_ARVALID    <= 1'b1;
+          next_addr        <= next_addr + (burst_len << MemWidthBytesLog);
+          beats_to_request <= beats_to_request - burst_len;
+        end else if (m_axi_ARREADY) begin
+          m_axi_ARVALID <= 1'b0;
+        end
+
+        if (buffer_read) beats_to_consume <= beats_to_consume - 1'b1;
+
+        if (is_drained) begin
+          busy <= 1'b0;
+          done <= 1'b1;
+        end
+      end
+
+      credits <= credits - (issue ? burst_len : 13'd0) + buffer_read;
+    end
+  end
+
+  fifo #(
+    .DATA_WIDTH(MemWidth),
+    .ADDR_WIDTH(BufferDepthLog),
+    .DEPTH     (BufferDepth)
+  ) buffer (
+    .clk  (clk),
+    .reset(rst),
+
+    // from read data channel
+    .if_full_n  (buffer_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (m_axi_RVALID),
+    .if_din     (m_axi_RDATA),
+
+    // to output stream
+    .if_empty_n(buffer_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (buffer_read),
+    .if_dout   (buffer_dout)
+  );
+
+endmodule  // burst_mmap_to_stream
+
+`default_nettype wire
@@ -0,0 +1,235 @@
+`default_nettype none
+
+// Read a stream of StreamWidth-bit elements and write them as Count elements
+// of MemWidth bits starting at byte address offset.
+//
+// Incoming elements are packed into beats, lowest bits first, or split into
+// StreamWidth / MemWidth beats, lowest bits first. A write burst of up to
+// MaxBurstLen beats that never crosses a 4KB boundary is issued only after all
+// of its beats are buffered, so WVALID never stalls inside a burst. At most
+// MaxOutstanding bursts wait for their write responses.
+module burst_stream_to_mmap #(
+  parameter AddrWidth         = 64,
+  parameter MemWidth          = 512,
+  parameter MemWidthBytesLog  = 6,  // must equal log2(MemWidth/8)
+  parameter StreamWidth       = 512,
+  parameter MaxBurstLen       = 64,
+  parameter BufferDepth       = 256,  // must be at least MaxBurstLen
+  parameter BufferDepthLog    = 8,
+  parameter MaxOutstanding    = 16,
+  parameter MaxOutstandingLog = 4
+) (
+  input wire clk,
+  input wire rst,
+
+  // control
+  input  wire                 start,
+  output wire                 idle,
+  output reg                  done,
+  input  wire [AddrWidth-1:0] offset,
+  input  wire [63:0]          count,
+
+  // input stream
+  input  wire [StreamWidth-1:0] data_dout,
+  input  wire                   data_empty_n,
+  output wire                   data_read,
+
+  // write address channel
+  output reg  [AddrWidth-1:0]  m_axi_AWADDR,
+  output reg  [7:0]            m_axi_AWLEN,
+  output reg                   m_axi_AWVALID,
+  input  wire                  m_axi_AWREADY,
+
+  // write data channel
+  output wire [MemWidth-1:0]   m_axi_WDATA,
+  output wire [MemWidth/8-1:0] m_axi_WSTRB,
+  output wire                  m_axi_WLAST,
+  output wire                  m_axi_WVALID,
+  input  wire                  m_axi_WREADY,
+
+  // write response channel
+  input  wire                  m_axi_BVALID,
+  output wire                  m_axi_BREADY
+);
+
+  // state
+  reg                       busy;
+  reg [AddrWidth-1:0]       next_addr;
+  reg [63:0]                beats_to_collect;  // beats not yet buffered
+  reg [63:0]                beats_to_request;  // beats not yet in a burst
+  reg [BufferDepthLog:0]    buffered;          // buffered beats not in a burst
+  reg [MaxOutstandingLog:0] outstanding;       // bursts without a response
+  reg [7:0]                 beat_idx;          // beat index in current burst
+
+  // fifo signals
+  wire [MemWidth-1:0] buffer_din;
+  wire                buffer_full_n;
+  wire                buffer_write;
+  wire [MemWidth-1:0] buffer_dout;
+  wire                buffer_empty_n;
+  wire [7:0]          len_dout;
+  wire                len_full_n;
+  wire                len_empty_n;
+
+  // data side
+  generate
+    if (MemWidth >= StreamWidth) begin : pack
+      localparam Ratio = MemWidth / StreamWidth;
+
+      reg [MemWidth-1:0]        acc;
+      reg [$clog2(Ratio+1)-1:0] lane;
+
+      // the last element of a beat goes directly into the buffer
+      wire [MemWidth-1:0] next_acc = {data_dout, acc[MemWidth-1:StreamWidth]};
+
+      assign data_read    = data_empty_n && beats_to_collect != 64'd0 &&
+                            (lane != Ratio - 1 || buffer_full_n);
+      assign buffer_write = data_read && lane == Ratio - 1;
+      assign buffer_din   = next_acc;
+
+      always @(posedge clk) begin
+        if (rst) begin
+          lane <= 0;
+        end else if (data_read) begin
+          acc  <= next_acc;
+          lane <= lane == Ratio - 1 ? 0 : lane + 1'b1;
+        end
+      end
+    end else begin : split
+      localparam Ratio = StreamWidth / MemWidth;
+
+      reg [StreamWidth-1:0]     element;
+      reg [$clog2(Ratio+1)-1:0] lanes_left;
+
+      assign data_read    = data_empty_n && beats_to_collect != 64'd0 &&
+                            lanes_left == 0;
+      assign buffer_write = lanes_left != 0 && buffer_full_n;
+      assign buffer_din   = element[MemWidth-1:0];
+
+      always @(posedge clk) begin
+        if (rst) begin
+          lanes_left <= 0;
+        end else if (data_read) begin
+          element    <= data_dout;
+          lanes_left <= Ratio;
+        end else if (buffer_write) begin
+          element    <= element >> MemWidth;
+          lanes_left <= lanes_left - 1'b1;
+        end
+      end
+    end
+  endgenerate
+
+  // address side
+  wire [12:0] page_beats = (13'd4096 - {1'b0, next_addr[11:0]}) >>
+                           MemWidthBytesLog;
+  wire [12:0] max_beats = page_beats < MaxBurstLen ? page_beats : MaxBurstLen;
+  wire [12:0] burst_len = beats_to_request < max_beats ?
+                          beats_to_request[12:0] : max_beats;
+  wire issue = busy && !m_axi_AWVALID && beats_to_request != 64'd0 &&
+               buffered >= burst_len && len_full_n &&
+               outstanding != MaxOutstanding;
+
+  // write data and response side
+  wire w_fire = m_axi_WVALID && m_axi_WREADY;
+  wire b_fire = m_axi_BVALID && m_axi_BREADY;
+
+  assign idle = !busy;
+  assign m_axi_WDATA  = buffer_dout;
+  assign m_axi_WSTRB  = {(MemWidth/8){1'b1}};
+  assign m_axi_WLAST  = beat_idx == len_dout;
+  assign m_axi_WVALID = buffer_empty_n && len_empty_n;
+  assign m_axi_BREADY = 1'b1;
+
+  // all bursts are issued, written, and acknowledged
+  wire is_drained = beats_to_request == 64'd0 && !m_axi_AWVALID &&
+                    !len_empty_n && outstanding == 0;
+
+  always @(posedge clk) begin
+    if (rst) begin
+      busy          <= 1'b0;
+      done          <= 1'b0;
+      buffered      <= {(BufferDepthLog+1){1'b0}};
+      outstanding   <= {(MaxOutstandingLog+1){1'b0}};
+      beat_idx      <= 8'd0;
+      m_axi_AWVALID <= 1'b0;
+    end else begin
+      done <= 1'b0;
+      if (!busy) begin
+        if (start) begin
+          busy             <= 1'b1;
+          next_addr        <= offset;
+          beats_to_collect <= count;
+          beats_to_request <= count;
+        end
+      end else begin
+        if (issue) begin
+          m_axi_AWADDR     <= next_addr;
+          m_axi_AWLEN      <= burst_len - 1'b1;
+          m_axi_AWVALID    <= 1'b1;
+          next_addr        <= next_addr + (burst_len << MemWidthBytesLog);
+          beats_to_request <= beats_to_request - burst_len;
+        end else if (m_axi_AWREADY) begin
+          m_axi_AWVALID <= 1'b0;
+        end
+
+        if (buffer_write) beats_to_collect <= beats_to_collect - 1'b1;
+
+        if (is_drained) begin
+          busy <= 1'b0;
+          done <= 1'b1;
+        end
+      end
+
+      buffered    <= buffered + buffer_write - (issue ? burst_len : 13'd0);
+      outstanding <= outstanding + issue - b_fire;
+      if (w_fire) beat_idx <= m_axi_WLAST ? 8'd0 : beat_idx + 1'b1;
+    end
+  end
+
+  fifo #(
+    .DATA_WIDTH(MemWidth),
+    .ADDR_WIDTH(BufferDepthLog),
+    .DEPTH     (BufferDepth)
+  ) buffer (
+    .clk  (clk),
+    .reset(rst),
+
+    // from input stream
+    .if_full_n  (buffer_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (buffer_write),
+    .if_din     (buffer_din),
+
+    // to write data channel
+    .if_empty_n(buffer_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (w_fire),
+    .if_dout   (buffer_dout)
+  );
+
+  // lengths of issued bursts minus one
+  fifo #(
+    .DATA_WIDTH(8),
+    .ADDR_WIDTH(MaxOutstandingLog),
+    .DEPTH     (MaxOutstanding)
+  ) len (
+    .clk  (clk),
+    .reset(rst),
+
+    // from write address side
+    .if_full_n  (len_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (issue),
+    .if_din     (burst_len[7:0] - 8'd1),
+
+    // to write data side
+    .if_empty_n(len_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (w_fire && m_axi_WLAST),
+    .if_dout   (len_dout)
+  );
+
+endmodule  // burst_stream_to_mmap
+
+`default_nettype wire
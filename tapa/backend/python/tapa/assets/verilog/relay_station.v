@@ -1,6 +1,12 @@
 `default_nettype none
 
 // first-word fall-through (FWFT) FIFO that is friendly for floorplanning
+//
+// The FIFO is split into LEVEL units, one per region on the routed path. The
+// first LEVEL-1 units only register the data, the write enable, and full_n,
+// without any skid buffer. The last unit is the FIFO itself, which asserts
+// full_n early enough to absorb the writes in flight, so DEPTH grows by the
+// round-trip latency of the registers instead of each unit buffering data.
 module relay_station #(
     parameter DATA_WIDTH = 32,
     parameter ADDR_WIDTH = 5,
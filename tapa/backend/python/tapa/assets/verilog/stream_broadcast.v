@@ -0,0 +1,34 @@
+`default_nettype none
+
+// Copy each token of a stream to all N outputs, with zero latency.
+//
+// Each token is DataWidth bits of data and the eot bit on top, which is
+// forwarded as-is. A token is written to all outputs in the same cycle, which
+// is a cycle when none of them is full.
+module stream_broadcast #(
+  parameter N         = 2,
+  parameter DataWidth = 32
+) (
+  input wire clk,
+  input wire rst,
+
+  // input stream
+  input  wire [DataWidth:0] in_dout,
+  input  wire               in_empty_n,
+  output wire               in_read,
+
+  // output streams, lane i at bits [i*(DataWidth+1) +: DataWidth+1]
+  output wire [N*(DataWidth+1)-1:0] out_din,
+  input  wire [N-1:0]               out_full_n,
+  output wire [N-1:0]               out_write
+);
+
+  wire transfer = in_empty_n && &out_full_n;
+
+  assign out_din   = {N{in_dout}};
+  assign out_write = {N{transfer}};
+  assign in_read   = transfer;
+
+endmodule  // stream_broadcast
+
+`default_nettype wire
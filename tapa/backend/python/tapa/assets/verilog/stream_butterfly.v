@@ -0,0 +1,101 @@
+`default_nettype none
+
+// Route tokens from N input streams to N output streams through a butterfly
+// network of 2x2 switches, with zero latency.
+//
+// Each token is DataWidth bits of data and the eot bit on top. A data token
+// goes to the output selected by bits [KeyLsb +: log2(N)] of its data, and an
+// eot token goes to output 0 because its data is undefined. N must be a power
+// of 2.
+//
+// Stage s has N/2 switches, each of which connects the two lanes that only
+// differ in bit log2(N)-1-s of their indices and forwards each token to the
+// lane matching the same bit of its key, so a token reaches its output after
+// log2(N) stages. If both tokens of a switch want the same lane, the switch
+// grants one of them and flips its priority once the granted token is
+// accepted. The arbitration only depends on the valid signals, which go
+// forward through the stages, while the ready signals go backward.
+module stream_butterfly #(
+  parameter N         = 2,
+  parameter DataWidth = 32,
+  parameter KeyLsb    = 0
+) (
+  input wire clk,
+  input wire rst,
+
+  // input streams, lane i at bits [i*(DataWidth+1) +: DataWidth+1]
+  input  wire [N*(DataWidth+1)-1:0] in_dout,
+  input  wire [N-1:0]               in_empty_n,
+  output wire [N-1:0]               in_read,
+
+  // output streams, lane i at bits [i*(DataWidth+1) +: DataWidth+1]
+  output wire [N*(DataWidth+1)-1:0] out_din,
+  input  wire [N-1:0]               out_full_n,
+  output wire [N-1:0]               out_write
+);
+
+  localparam Width  = DataWidth + 1;
+  localparam Stages = N > 1 ? $clog2(N) : 0;
+
+  // signals of lane i at the input of stage s, where stage Stages is the output
+  wire [(Stages+1)*N*Width-1:0] data;   // [(s*N+i)*Width +: Width]
+  wire [(Stages+1)*N-1:0]       valid;  // [s*N+i]
+  wire [(Stages+1)*N-1:0]       ready;  // [s*N+i]
+
+  assign data[N*Width-1:0]    = in_dout;
+  assign valid[N-1:0]         = in_empty_n;
+  assign in_read              = ready[N-1:0];
+  assign out_din              = data[Stages*N*Width +: N*Width];
+  assign out_write            = valid[Stages*N +: N];
+  assign ready[Stages*N +: N] = out_full_n;
+
+  genvar s, p;
+  generate
+    for (s = 0; s < Stages; s = s + 1) begin : stage
+      for (p = 0; p < N / 2; p = p + 1) begin : switch
+        localparam Bit = 1 << (Stages - 1 - s);
+        localparam A   = p / Bit * 2 * Bit + p % Bit;  // lane with Bit clear
+        localparam B   = A + Bit;                      // lane with Bit set
+
+        wire [Width-1:0] data_a  = data[(s*N+A)*Width +: Width];
+        wire [Width-1:0] data_b  = data[(s*N+B)*Width +: Width];
+        wire             valid_a = valid[s*N+A];
+        wire             valid_b = valid[s*N+B];
+
+        // whether each token wants lane B; eot tokens want lane A
+        wire to_b_a = !data_a[DataWidth] && data_a[KeyLsb + Stages - 1 - s];
+        wire to_b_b = !data_b[DataWidth] && data_b[KeyLsb + Stages - 1 - s];
+
+        reg  prio;  // 0 if token A wins conflicts, 1 if token B wins
+        wire conflict = valid_a && valid_b && to_b_a == to_b_b;
+        wire grant_a  = valid_a && !(conflict && prio);
+        wire grant_b  = valid_b && !(conflict && !prio);
+
+        // token to lane A
+        wire a_from_a = grant_a && !to_b_a;
+        assign valid[(s+1)*N+A] = a_from_a || (grant_b && !to_b_b);
+        assign data[((s+1)*N+A)*Width +: Width] = a_from_a ? data_a : data_b;
+
+        // token to lane B
+        wire b_from_a = grant_a && to_b_a;
+        assign valid[(s+1)*N+B] = b_from_a || (grant_b && to_b_b);
+        assign data[((s+1)*N+B)*Width +: Width] = b_from_a ? data_a : data_b;
+
+        // a token is accepted if it is granted and its next lane is ready
+        assign ready[s*N+A] = grant_a && ready[(s+1)*N + (to_b_a ? B : A)];
+        assign ready[s*N+B] = grant_b && ready[(s+1)*N + (to_b_b ? B : A)];
+
+        always @(posedge clk) begin
+          if (rst) begin
+            prio <= 1'b0;
+          end else if (conflict && (prio ? ready[s*N+B] : ready[s*N+A])) begin
+            prio <= !prio;
+          end
+        end
+      end
+    end
+  endgenerate
+
+endmodule  // stream_butterfly
+
+`default_nettype wire
@@ -0,0 +1,46 @@
+`default_nettype none
+
+// Route each token of a stream to one of N outputs, with zero latency.
+//
+// Each token is DataWidth bits of data and the eot bit on top. A data token
+// goes to the output selected by bits [KeyLsb +: log2(N)] of its data, and an
+// eot token goes to output 0 because its data is undefined. N must be a power
+// of 2. A token whose output is full blocks the tokens behind it.
+module stream_demux #(
+  parameter N         = 2,
+  parameter DataWidth = 32,
+  parameter KeyLsb    = 0
+) (
+  input wire clk,
+  input wire rst,
+
+  // input stream
+  input  wire [DataWidth:0] in_dout,
+  input  wire               in_empty_n,
+  output wire               in_read,
+
+  // output streams, lane i at bits [i*(DataWidth+1) +: DataWidth+1]
+  output wire [N*(DataWidth+1)-1:0] out_din,
+  input  wire [N-1:0]               out_full_n,
+  output wire [N-1:0]               out_write
+);
+
+  localparam KeyWidth = N > 1 ? $clog2(N) : 1;
+
+  wire                is_eot = in_dout[DataWidth];
+  wire [KeyWidth-1:0] key    = N == 1 || is_eot ? {KeyWidth{1'b0}} :
+                                                  in_dout[KeyLsb +: KeyWidth];
+
+  assign out_din = {N{in_dout}};
+  assign in_read = in_empty_n && out_full_n[key];
+
+  genvar j;
+  generate
+    for (j = 0; j < N; j = j + 1) begin : write
+      assign out_write[j] = in_empty_n && key == j;
+    end
+  endgenerate
+
+endmodule  // stream_demux
+
+`default_nettype wire
@@ -0,0 +1,72 @@
+`default_nettype none
+
+// Merge N streams into one in round-robin order, with zero latency.
+//
+// Each token is DataWidth bits of data and the eot bit on top, which is
+// forwarded as-is. Every cycle, the first non-empty input after the one
+// granted last is forwarded to the output; input 0 has the highest priority
+// after reset. The arbitration only depends on the empty_n signals, so the
+// same input stays granted until the output accepts its token.
+module stream_merge #(
+  parameter N         = 2,
+  parameter DataWidth = 32
+) (
+  input wire clk,
+  input wire rst,
+
+  // input streams, lane i at bits [i*(DataWidth+1) +: DataWidth+1]
+  input  wire [N*(DataWidth+1)-1:0] in_dout,
+  input  wire [N-1:0]               in_empty_n,
+  output wire [N-1:0]               in_read,
+
+  // output stream
+  output wire [DataWidth:0] out_din,
+  input  wire               out_full_n,
+  output wire               out_write
+);
+
+  localparam IdxWidth = N > 1 ? $clog2(N) : 1;
+
+  reg [IdxWidth-1:0] last;   // input granted last
+  reg [IdxWidth-1:0] grant;  // input granted this cycle
+  reg                valid;  // whether any input is granted
+  reg [IdxWidth:0]   idx;
+  integer            i;
+
+  // search from the farthest to the nearest input so that the nearest wins
+  always @* begin
+    valid = 1'b0;
+    grant = {IdxWidth{1'b0}};
+    for (i = N; i > 0; i = i - 1) begin
+      idx = last + i;
+      if (idx >= N) idx = idx - N;
+      if (in_empty_n[idx]) begin
+        valid = 1'b1;
+        grant = idx[IdxWidth-1:0];
+      end
+    end
+  end
+
+  wire transfer = valid && out_full_n;
+
+  assign out_din   = in_dout[grant*(DataWidth+1) +: DataWidth+1];
+  assign out_write = valid;
+
+  genvar j;
+  generate
+    for (j = 0; j < N; j = j + 1) begin : read
+      assign in_read[j] = transfer && grant == j;
+    end
+  endgenerate
+
+  always @(posedge clk) begin
+    if (rst) begin
+      last <= N - 1;
+    end else if (transfer) begin
+      last <= grant;
+    end
+  end
+
+endmodule  // stream_merge
+
+`default_nettype wire
@@ -0,0 +1,273 @@
+`default_nettype none
+
+// Prefetch read addresses that follow a constant stride.
+//
+// Once Threshold + 1 consecutive strides between addresses are the same,
+// the following addresses are requested ahead, at most Depth at a time. A
+// user address that matches the oldest prefetch is served from the prefetch
+// buffer; any other address is sent to memory, and the outstanding prefetches
+// are dropped first. Sequential streams are strides of one element.
+//
+// Memory responses return in order, so each memory request is tagged as a
+// demand or a prefetch, each prefetch is tagged as kept or dropped in issue
+// order, and each user request is tagged as a hit or a miss to merge both
+// sources back in user order.
+module stride_prefetch #(
+  parameter AddrWidth       = 64,
+  parameter DataWidth       = 512,
+  parameter Depth           = 16,
+  parameter DepthLog        = 4,
+  // max number of memory and user requests in flight
+  parameter MaxInflight     = 64,
+  parameter MaxInflightLog  = 6,
+  parameter Threshold       = 2
+) (
+  input wire clk,
+  input wire rst,
+
+  // input: user read addresses
+  input  wire [AddrWidth-1:0] addr_dout,
+  input  wire                 addr_empty_n,
+  output wire                 addr_read,
+
+  // output: memory read addresses
+  output wire [AddrWidth-1:0] mem_addr_din,
+  input  wire                 mem_addr_full_n,
+  output wire                 mem_addr_write,
+
+  // input: memory read data
+  input  wire                 mem_data_valid,
+  output wire                 mem_data_ready,
+  input  wire [DataWidth-1:0] mem_data,
+
+  // output: user read data
+  output wire [DataWidth-1:0] data_din,
+  input  wire                 data_full_n,
+  output wire                 data_write,
+
+  // number of user addresses served by prefetches or sent to memory
+  output reg [31:0] hit_count,
+  output reg [31:0] miss_count
+);
+
+  // state
+  reg [AddrWidth-1:0] last_addr;
+  reg [AddrWidth-1:0] stride;
+  reg [1:0]           confidence;
+  reg [AddrWidth-1:0] next_addr;  // next address to prefetch
+  reg [DepthLog:0]    prefetch_count;
+
+  // fifo signals
+  wire                 mem_tag_dout;  // 1 for prefetches, 0 for demands
+  wire                 mem_tag_full_n;
+  wire                 mem_tag_empty_n;
+  wire                 mem_tag_read;
+  wire                 user_tag_dout;  // 1 for hits, 0 for misses
+  wire                 user_tag_full_n;
+  wire                 user_tag_empty_n;
+  wire                 user_tag_write;
+  wire                 user_tag_read;
+  wire [AddrWidth-1:0] prefetch_addr_dout;
+  wire                 prefetch_addr_full_n;
+  wire                 prefetch_addr_empty_n;
+  wire                 prefetch_addr_read;
+  wire                 prefetch_keep_dout;  // 1 for kept, 0 for dropped
+  wire                 prefetch_keep_full_n;
+  wire                 prefetch_keep_empty_n;
+  wire                 prefetch_keep_write;
+  wire [DataWidth-1:0] prefetch_data_dout;
+  wire                 prefetch_data_full_n;
+  wire                 prefetch_data_empty_n;
+  wire                 prefetch_data_write;
+  wire                 prefetch_data_read;
+
+  // address side
+  wire [AddrWidth-1:0] new_stride = addr_dout - last_addr;
+  wire is_streaming = confidence >= Threshold && stride != 0;
+  wire is_hit = prefetch_addr_empty_n && prefetch_addr_dout == addr_dout;
+  // a miss waits until outstanding prefetches are dropped
+  wire is_flushing = addr_empty_n && prefetch_addr_empty_n && !is_hit;
+
+  wire accept_hit = addr_empty_n && is_hit && user_tag_full_n &&
+                    prefetch_keep_full_n;
+  wire accept_miss = addr_empty_n && !prefetch_addr_empty_n &&
+                     user_tag_full_n && mem_tag_full_n && mem_addr_full_n;
+  wire drop = is_flushing && prefetch_keep_full_n;
+  // demands take priority over prefetches
+  wire issue = is_streaming && !(addr_empty_n && !is_hit) &&
+               prefetch_count < Depth && prefetch_addr_full_n &&
+               mem_tag_full_n && mem_addr_full_n;
+
+  assign addr_read           = accept_hit || accept_miss;
+  assign mem_addr_din        = accept_miss ? addr_dout : next_addr;
+  assign mem_addr_write      = accept_miss || issue;
+  assign user_tag_write      = accept_hit || accept_miss;
+  assign prefetch_addr_read  = accept_hit || drop;
+  assign prefetch_keep_write = accept_hit || drop;
+
+  // data side
+  wire is_head_hit = user_tag_empty_n && user_tag_dout;
+  wire is_head_miss = user_tag_empty_n && !user_tag_dout;
+  wire is_prefetch_ready = prefetch_data_empty_n && prefetch_keep_empty_n;
+  wire discard = is_prefetch_ready && !prefetch_keep_dout;
+  wire serve_hit = is_prefetch_ready && prefetch_keep_dout && is_head_hit &&
+                   data_full_n;
+  wire serve_miss = mem_data_valid && mem_tag_empty_n && !mem_tag_dout &&
+                    is_head_miss && data_full_n;
+
+  assign mem_data_ready = mem_tag_empty_n && (mem_tag_dout ?
+      prefetch_data_full_n : is_head_miss && data_full_n);
+  assign mem_tag_read        = mem_data_valid && mem_data_ready;
+  assign prefetch_data_write = mem_data_valid && mem_tag_empty_n &&
+                               mem_tag_dout && prefetch_data_full_n;
+  assign prefetch_data_read  = discard || serve_hit;
+  assign user_tag_read       = serve_hit || serve_miss;
+  assign data_write          = serve_hit || serve_miss;
+  assign data_din            = serve_hit ? prefetch_data_dout : mem_data;
+
+  always @(posedge clk) begin
+    if (rst) begin
+      last_addr      <= {AddrWidth{1'b0}};
+      stride         <= {AddrWidth{1'b0}};
+      confidence     <= 2'd0;
+      next_addr      <= {AddrWidth{1'b0}};
+      prefetch_count <= {(DepthLog+1){1'b0}};
+      hit_count      <= 32'd0;
+      miss_count     <= 32'd0;
+    end else begin
+      if (addr_read) begin
+        last_addr <= addr_dout;
+        if (new_stride == stride) begin
+          if (confidence != 2'd3) confidence <= confidence + 1'b1;
+        end else begin
+          stride     <= new_stride;
+          confidence <= 2'd0;
+        end
+      end
+
+      // prefetching resumes after the last demand
+      if (accept_miss) begin
+        next_addr <= addr_dout + new_stride;
+      end else if (issue) begin
+        next_addr <= next_addr + stride;
+      end
+
+      if (issue && !prefetch_data_read) begin
+        prefetch_count <= prefetch_count + 1'b1;
+      end else if (!issue && prefetch_data_read) begin
+        prefetch_count <= prefetch_count - 1'b1;
+      end
+
+      if (accept_hit) hit_count <= hit_count + 1'b1;
+      if (accept_miss) miss_count <= miss_count + 1'b1;
+    end
+  end
+
+  fifo #(
+    .DATA_WIDTH(1),
+    .ADDR_WIDTH(MaxInflightLog),
+    .DEPTH     (MaxInflight)
+  ) mem_tag (
+    .clk  (clk),
+    .reset(rst),
+
+    // from address side
+    .if_full_n  (mem_tag_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (mem_addr_write),
+    .if_din     (!accept_miss),
+
+    // to data side
+    .if_empty_n(mem_tag_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (mem_tag_read),
+    .if_dout   (mem_tag_dout)
+  );
+
+  fifo #(
+    .DATA_WIDTH(1),
+    .ADDR_WIDTH(MaxInflightLog),
+    .DEPTH     (MaxInflight)
+  ) user_tag (
+    .clk  (clk),
+    .reset(rst),
+
+    // from address side
+    .if_full_n  (user_tag_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (user_tag_write),
+    .if_din     (accept_hit),
+
+    // to data side
+    .if_empty_n(user_tag_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (user_tag_read),
+    .if_dout   (user_tag_dout)
+  );
+
+  fifo #(
+    .DATA_WIDTH(AddrWidth),
+    .ADDR_WIDTH(DepthLog),
+    .DEPTH     (Depth)
+  ) prefetch_addr (
+    .clk  (clk),
+    .reset(rst),
+
+    // issued prefetches
+    .if_full_n  (prefetch_addr_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (issue),
+    .if_din     (next_addr),
+
+    // hit or dropped
+    .if_empty_n(prefetch_addr_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (prefetch_addr_read),
+    .if_dout   (prefetch_addr_dout)
+  );
+
+  fifo #(
+    .DATA_WIDTH(1),
+    .ADDR_WIDTH(DepthLog),
+    .DEPTH     (Depth)
+  ) prefetch_keep (
+    .clk  (clk),
+    .reset(rst),
+
+    // from address side
+    .if_full_n  (prefetch_keep_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (prefetch_keep_write),
+    .if_din     (accept_hit),
+
+    // to data side
+    .if_empty_n(prefetch_keep_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (prefetch_data_read),
+    .if_dout   (prefetch_keep_dout)
+  );
+
+  fifo #(
+    .DATA_WIDTH(DataWidth),
+    .ADDR_WIDTH(DepthLog),
+    .DEPTH     (Depth)
+  ) prefetch_data (
+    .clk  (clk),
+    .reset(rst),
+
+    // from memory
+    .if_full_n  (prefetch_data_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (prefetch_data_write),
+    .if_din     (mem_data),
+
+    // to user or dropped
+    .if_empty_n(prefetch_data_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (prefetch_data_read),
+    .if_dout   (prefetch_data_dout)
+  );
+
+endmodule  // stride_prefetch
+
+`default_nettype wire
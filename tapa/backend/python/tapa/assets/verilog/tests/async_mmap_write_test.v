@@ -0,0 +1,356 @@
+`default_nettype none
+`timescale 1ns / 1ps
+
+// Writes through an async_mmap into an AXI memory model, then reads the memory
+// back. The writes of each phase hit the same address many times (combined,
+// more often than one line can count), sequential addresses (uncombined),
+// two alternating addresses, strided addresses, and a lone address that is
+// only sent once the write combiner times out.
+//
+// async_mmap does not order reads against writes that are not acknowledged,
+// so each phase waits for the responses of all its writes before reading. By
+// then the memory must hold the last write to each address, every response
+// must count the writes it covers, and every W beat must have all byte enables
+// set, since async_mmap always writes whole words.
+module async_mmap_write_test #(
+  parameter WRITE_COMBINE_CAPACITY = 4
+);
+
+  localparam DATA_WIDTH = 32;
+  localparam WORDS = 256;
+  localparam PHASES = 2;
+  localparam TIMEOUT = 20000;
+
+  reg clk = 1'b0;
+  reg reset = 1'b1;
+  always #1 clk = ~clk;
+
+  reg [31:0] cycle = 0;
+  reg [15:0] lfsr = 16'hace1;  // random backpressure of the memory
+  always @(posedge clk) begin
+    cycle <= cycle + 1;
+    lfsr <= {lfsr[14:0], lfsr[15] ^ lfsr[13] ^ lfsr[12] ^ lfsr[10]};
+  end
+
+  // writes of each phase
+  function integer write_count_of(input integer phase);
+    write_count_of = phase == 0 ? 97 : 20;
+  endfunction
+
+  function [7:0] write_addr_of(input integer phase, input integer i);
+    if (phase == 0) begin
+      if (i < 40) write_addr_of = 5;
+      else if (i < 72) write_addr_of = i - 24;
+      else if (i < 88) write_addr_of = 64 + i % 2;
+      else if (i < 96) write_addr_of = 128 + (i - 88) * 8;
+      else write_addr_of = 200;
+    end else begin
+      case (i)
+        16: write_addr_of = 5;
+        17: write_addr_of = 64;
+        18: write_addr_of = 65;
+        19: write_addr_of = 200;
+        default: write_addr_of = 16 + i / 2;
+      endcase
+    end
+  endfunction
+
+  wire                  m_axi_AWVALID;
+  wire                  m_axi_AWREADY;
+  wire [63:0]           m_axi_AWADDR;
+  wire [7:0]            m_axi_AWLEN;
+  wire                  m_axi_WVALID;
+  wire                  m_axi_WREADY;
+  wire [DATA_WIDTH-1:0] m_axi_WDATA;
+  wire [3:0]            m_axi_WSTRB;
+  wire                  m_axi_WLAST;
+  wire                  m_axi_BVALID;
+  wire                  m_axi_BREADY;
+  wire                  m_axi_ARVALID;
+  wire                  m_axi_ARREADY;
+  wire [63:0]           m_axi_ARADDR;
+  wire [7:0]            m_axi_ARLEN;
+  wire                  m_axi_RVALID;
+  wire                  m_axi_RREADY;
+  wire [DATA_WIDTH-1:0] m_axi_RDATA;
+  wire                  m_axi_RLAST;
+
+  wire [63:0]           read_addr_din;
+  wire                  read_addr_write;
+  wire                  read_addr_full_n;
+  wire [DATA_WIDTH-1:0] read_data_dout;
+  wire                  read_data_read;
+  wire                  read_data_empty_n;
+  wire [63:0]           write_addr_din;
+  wire                  write_addr_write;
+  wire                  write_addr_full_n;
+  wire [DATA_WIDTH-1:0] write_data_din;
+  wire                  write_data_write;
+  wire                  write_data_full_n;
+  wire [7:0]            write_resp_dout;
+  wire                  write_resp_read;
+  wire                  write_resp_empty_n;
+
+  async_mmap #(
+    .DataWidth           (DATA_WIDTH),
+    .DataWidthBytesLog   (2),
+    .WriteCombineCapacity(WRITE_COMBINE_CAPACITY)
+  ) dut (
+    .clk   (clk),
+    .rst   (reset),
+    .offset(64'd0),
+
+    .m_axi_AWVALID(m_axi_AWVALID),
+    .m_axi_AWREADY(m_axi_AWREADY),
+    .m_axi_AWADDR (m_axi_AWADDR),
+    .m_axi_AWID   (),
+    .m_axi_AWLEN  (m_axi_AWLEN),
+    .m_axi_AWSIZE (),
+    .m_axi_AWBURST(),
+    .m_axi_AWLOCK (),
+    .m_axi_AWCACHE(),
+    .m_axi_AWPROT (),
+    .m_axi_AWQOS  (),
+
+    .m_axi_WVALID(m_axi_WVALID),
+    .m_axi_WREADY(m_axi_WREADY),
+    .m_axi_WDATA (m_axi_WDATA),
+    .m_axi_WSTRB (m_axi_WSTRB),
+    .m_axi_WLAST (m_axi_WLAST),
+
+    .m_axi_BVALID(m_axi_BVALID),
+    .m_axi_BREADY(m_axi_BREADY),
+    .m_axi_BRESP (2'd0),
+    .m_axi_BID   (1'd0),
+
+    .m_axi_ARVALID(m_axi_ARVALID),
+    .m_axi_ARREADY(m_axi_ARREADY),
+    .m_axi_ARADDR (m_axi_ARADDR),
+    .m_axi_ARID   (),
+    .m_axi_ARLEN  (m_axi_ARLEN),
+    .m_axi_ARSIZE (),
+    .m_axi_ARBURST(),
+    .m_axi_ARLOCK (),
+    .m_axi_ARCACHE(),
+    .m_axi_ARPROT (),
+    .m_axi_ARQOS  (),
+
+    .m_axi_RVALID(m_axi_RVALID),
+    .m_axi_RREADY(m_axi_RREADY),
+    .m_axi_RDATA (m_axi_RDATA),
+    .m_axi_RLAST (m_axi_RLAST),
+    .m_axi_RID   (1'd0),
+    .m_axi_RRESP (2'd0),
+
+    .read_addr_din   (read_addr_din),
+    .read_addr_write (read_addr_write),
+    .read_addr_full_n(read_addr_full_n),
+
+    .read_data_dout   (read_data_dout),
+    .read_data_read   (read_data_read),
+    .read_data_empty_n(read_data_empty_n),
+
+    .write_addr_din   (write_addr_din),
+    .write_addr_write (write_addr_write),
+    .write_addr_full_n(write_addr_full_n),
+    .write_data_din   (write_data_din),
+    .write_data_write (write_data_write),
+    .write_data_full_n(write_data_full_n),
+
+    .write_resp_dout   (write_resp_dout),
+    .write_resp_read   (write_resp_read),
+    .write_resp_empty_n(write_resp_empty_n),
+
+    .read_prefetch_hit_count (),
+    .read_prefetch_miss_count()
+  );
+
+  // AXI memory with up to 16 outstanding bursts per direction
+  reg [DATA_WIDTH-1:0] mem [0:WORDS-1];
+
+  reg [63:0] aw_addr [0:15];
+  reg [7:0]  aw_len  [0:15];
+  reg [3:0]  aw_head = 0;
+  reg [3:0]  aw_tail = 0;
+  reg [4:0]  aw_count = 0;
+  reg [7:0]  w_beat = 0;
+  reg [31:0] w_beat_count = 0;
+  reg [4:0]  b_count = 0;
+
+  reg [63:0] ar_addr [0:15];
+  reg [7:0]  ar_len  [0:15];
+  reg [3:0]  ar_head = 0;
+  reg [3:0]  ar_tail = 0;
+  reg [4:0]  ar_count = 0;
+  reg [7:0]  r_beat = 0;
+
+  wire [63:0] w_idx = aw_addr[aw_head][63:2] + w_beat;
+  wire [63:0] r_idx = ar_addr[ar_head][63:2] + r_beat;
+
+  wire aw = m_axi_AWVALID && m_axi_AWREADY;
+  wire w  = m_axi_WVALID && m_axi_WREADY;
+  wire w_last = w && w_beat == aw_len[aw_head];
+  wire b  = m_axi_BVALID && m_axi_BREADY;
+  wire ar = m_axi_ARVALID && m_axi_ARREADY;
+  wire r  = m_axi_RVALID && m_axi_RREADY;
+  wire r_last = r && r_beat == ar_len[ar_head];
+
+  assign m_axi_AWREADY = aw_count != 16;
+  assign m_axi_WREADY  = aw_count != 0 && lfsr[0];
+  assign m_axi_BVALID  = b_count != 0;
+  assign m_axi_ARREADY = ar_count != 16;
+  assign m_axi_RVALID  = ar_count != 0 && lfsr[1];
+  assign m_axi_RDATA   = mem[r_idx[7:0]];
+  assign m_axi_RLAST   = r_beat == ar_len[ar_head];
+
+  integer i;
+  always @(posedge clk) begin
+    if (reset) begin
+      for (i = 0; i < WORDS; i = i + 1) mem[i] <= 32'hdead0000 | i;
+    end else begin
+      if (aw) begin
+        if (m_axi_AWADDR[63:2] + m_axi_AWLEN >= WORDS) begin
+          $fatal(1, "write burst at %0h is out of range", m_axi_AWADDR);
+        end
+        aw_addr[aw_tail] <= m_axi_AWADDR;
+        aw_len[aw_tail]  <= m_axi_AWLEN;
+        aw_tail <= aw_tail + 1'b1;
+      end
+      if (w) begin
+        if (m_axi_WSTRB != 4'hf) $fatal(1, "WSTRB is %h", m_axi_WSTRB);
+        if (m_axi_WLAST != w_last) $fatal(1, "WLAST is %b", m_axi_WLAST);
+        for (i = 0; i < DATA_WIDTH / 8; i = i + 1) begin
+          if (m_axi_WSTRB[i]) begin
+            mem[w_idx[7:0]][i*8 +: 8] <= m_axi_WDATA[i*8 +: 8];
+          end
+        end
+        w_beat <= w_last ? 8'd0 : w_beat + 1'b1;
+        if (w_last) aw_head <= aw_head + 1'b1;
+        w_beat_count <= w_beat_count + 1;
+      end
+      aw_count <= aw_count + aw - w_last;
+      b_count  <= b_count + w_last - b;
+
+      if (ar) begin
+        if (m_axi_ARADDR[63:2] + m_axi_ARLEN >= WORDS) begin
+          $fatal(1, "read burst at %0h is out of range", m_axi_ARADDR);
+        end
+        ar_addr[ar_tail] <= m_axi_ARADDR;
+        ar_len[ar_tail]  <= m_axi_ARLEN;
+        ar_tail <= ar_tail + 1'b1;
+      end
+      if (r) begin
+        r_beat <= r_last ? 8'd0 : r_beat + 1'b1;
+        if (r_last) ar_head <= ar_head + 1'b1;
+      end
+      ar_count <= ar_count + ar - r_last;
+    end
+  end
+
+  // user of the async_mmap
+  localparam WRITE = 2'd0;
+  localparam FENCE = 2'd1;
+  localparam READ  = 2'd2;
+  localparam DONE  = 2'd3;
+
+  reg [DATA_WIDTH-1:0] expected [0:WORDS-1];
+  reg [1:0]  state = WRITE;
+  reg [31:0] phase = 0;
+  reg [31:0] write_count = 0;
+  reg [31:0] total_write_count = 0;
+  reg [31:0] total_resp_count = 0;
+  reg [31:0] read_addr_count = 0;
+  reg [31:0] read_data_count = 0;
+
+  wire [7:0] write_addr = write_addr_of(phase, write_count);
+
+  assign write_addr_din   = {56'd0, write_addr};
+  assign write_data_din   = 32'ha0000000 | phase << 16 | write_count;
+  assign write_addr_write = !reset && state == WRITE &&
+                            write_addr_full_n && write_data_full_n;
+  assign write_data_write = write_addr_write;
+  assign write_resp_read  = !reset && write_resp_empty_n;
+  assign read_addr_din    = read_addr_count;
+  assign read_addr_write  = !reset && state == READ && read_addr_count < WORDS;
+  assign read_data_read   = !reset && read_data_empty_n;
+
+  integer j;
+  always @(posedge clk) begin
+    if (reset) begin
+      for (j = 0; j < WORDS; j = j + 1) expected[j] <= 32'hdead0000 | j;
+    end else begin
+      if (write_addr_write) begin
+        expected[write_addr] <= write_data_din;
+        write_count <= write_count + 1;
+        total_write_count <= total_write_count + 1;
+        if (write_count == write_count_of(phase) - 1) state <= FENCE;
+      end
+
+      if (write_resp_read) begin
+        if (total_resp_count + write_resp_dout + 1 > total_write_count) begin
+          $fatal(1, "%0d writes are acknowledged after %0d writes",
+                 total_resp_count + write_resp_dout + 1, total_write_count);
+        end
+        total_resp_count <= total_resp_count + write_resp_dout + 1;
+      end
+
+      if (state == FENCE && total_resp_count == total_write_count) begin
+        for (j = 0; j < WORDS; j = j + 1) begin
+          if (mem[j] != expected[j]) begin
+            $fatal(1, "phase %0d: acknowledged word %0d is %h, expected %h",
+                   phase, j, mem[j], expected[j]);
+          end
+        end
+        state <= READ;
+        read_addr_count <= 0;
+        read_data_count <= 0;
+      end
+
+      if (read_addr_write && read_addr_full_n) begin
+        read_addr_count <= read_addr_count + 1;
+      end
+
+      if (read_data_read) begin
+        if (state != READ || read_data_count == WORDS) begin
+          $fatal(1, "extra read data");
+        end
+        if (read_data_dout != expected[read_data_count]) begin
+          $fatal(1, "phase %0d: read word %0d as %h, expected %h", phase,
+                 read_data_count, read_data_dout, expected[read_data_count]);
+        end
+        read_data_count <= read_data_count + 1;
+        if (read_data_count == WORDS - 1) begin
+          state <= phase == PHASES - 1 ? DONE : WRITE;
+          phase <= phase + 1;
+          write_count <= 0;
+        end
+      end
+    end
+
+    if (cycle == TIMEOUT) begin
+      $fatal(1, "timeout in phase %0d, state %0d, %0d writes, %0d responses",
+             phase, state, total_write_count, total_resp_count);
+    end
+  end
+
+  initial begin
+    repeat (4) @(posedge clk);
+    reset <= 1'b0;
+    wait (state == DONE);
+    repeat (16) @(posedge clk);
+    if (b_count != 0 || write_resp_empty_n || read_data_empty_n) begin
+      $fatal(1, "extra responses");
+    end
+    // combining must have saved W beats, which are otherwise one per write
+    if (WRITE_COMBINE_CAPACITY > 0 ? w_beat_count >= total_write_count
+                                   : w_beat_count != total_write_count) begin
+      $fatal(1, "%0d W beats for %0d writes", w_beat_count, total_write_count);
+    end
+    $display("PASS: WRITE_COMBINE_CAPACITY=%0d, %0d W beats for %0d writes",
+             WRITE_COMBINE_CAPACITY, w_beat_count, total_write_count);
+    $finish;
+  end
+
+endmodule  // async_mmap_write_test
+
+`default_nettype wire
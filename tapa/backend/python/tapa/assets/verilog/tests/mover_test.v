@@ -0,0 +1,316 @@
+`default_nettype none
+`timescale 1ns / 1ps
+
+// Copies COUNT words of an AXI memory model through a burst_mmap_to_stream,
+// a stream of STREAM_WIDTH-bit elements, and a burst_stream_to_mmap. Both
+// regions start a few words before a 4KB boundary, and the memory and the
+// stream stall at random.
+//
+// Each stream element must hold the words it is split from or packed into,
+// lowest bits first, and the destination must equal the source once both
+// movers are done. Bursts must not cross a 4KB boundary, the reader must
+// never stall RREADY because it only requests beats it has room for, and the
+// writer must never stall WVALID inside a burst.
+module mover_test #(
+  parameter MEM_WIDTH    = 64,
+  parameter STREAM_WIDTH = 64
+);
+
+  localparam MEM_BYTES = MEM_WIDTH / 8;
+  localparam MEM_BYTES_LOG = $clog2(MEM_BYTES);
+  localparam WORDS = 4096;
+  localparam PAGE_WORDS = 4096 / MEM_BYTES;
+  localparam COUNT = 1000;  // words to copy
+  localparam SRC_BASE = PAGE_WORDS - 5;
+  localparam DST_BASE = 2048 - 3;
+  localparam SPLIT =
+      MEM_WIDTH >= STREAM_WIDTH ? MEM_WIDTH / STREAM_WIDTH : 1;
+  localparam PACK =
+      STREAM_WIDTH > MEM_WIDTH ? STREAM_WIDTH / MEM_WIDTH : 1;
+  localparam ELEMENTS = COUNT * SPLIT / PACK;
+  localparam TIMEOUT = COUNT * SPLIT * 16;
+
+  reg clk = 1'b0;
+  reg reset = 1'b1;
+  always #1 clk = ~clk;
+
+  reg [31:0] cycle = 0;
+  reg [15:0] lfsr = 16'hace1;  // random stalls
+  always @(posedge clk) begin
+    cycle <= cycle + 1;
+    lfsr <= {lfsr[14:0], lfsr[15] ^ lfsr[13] ^ lfsr[12] ^ lfsr[10]};
+  end
+
+  reg [MEM_WIDTH-1:0] mem [0:WORDS-1];
+
+  function [MEM_WIDTH-1:0] word_of(input integer i);
+    integer lane;
+    for (lane = 0; lane < MEM_WIDTH / 32; lane = lane + 1) begin
+      word_of[lane*32 +: 32] = (i * 8 + lane) * 32'h9e3779b1;
+    end
+  endfunction
+
+  function [STREAM_WIDTH-1:0] element_of(input integer k);
+    integer j;
+    if (MEM_WIDTH >= STREAM_WIDTH) begin
+      element_of = mem[SRC_BASE + k / SPLIT] >> (k % SPLIT * STREAM_WIDTH);
+    end else begin
+      for (j = 0; j < PACK; j = j + 1) begin
+        element_of[j*MEM_WIDTH +: MEM_WIDTH] = mem[SRC_BASE + k * PACK + j];
+      end
+    end
+  endfunction
+
+  reg         start = 1'b0;
+  wire        reader_idle;
+  wire        reader_done;
+  wire        writer_idle;
+  wire        writer_done;
+
+  wire [63:0]           m_axi_ARADDR;
+  wire [7:0]            m_axi_ARLEN;
+  wire                  m_axi_ARVALID;
+  wire                  m_axi_ARREADY;
+  wire [MEM_WIDTH-1:0]  m_axi_RDATA;
+  wire                  m_axi_RVALID;
+  wire                  m_axi_RREADY;
+  wire [63:0]           m_axi_AWADDR;
+  wire [7:0]            m_axi_AWLEN;
+  wire                  m_axi_AWVALID;
+  wire                  m_axi_AWREADY;
+  wire [MEM_WIDTH-1:0]  m_axi_WDATA;
+  wire [MEM_BYTES-1:0]  m_axi_WSTRB;
+  wire                  m_axi_WLAST;
+  wire                  m_axi_WVALID;
+  wire                  m_axi_WREADY;
+  wire                  m_axi_BVALID;
+  wire                  m_axi_BREADY;
+
+  wire [STREAM_WIDTH-1:0] stream_din;
+  wire                    stream_full_n;
+  wire                    stream_write;
+  wire [STREAM_WIDTH-1:0] stream_dout;
+  wire                    stream_empty_n;
+  wire                    stream_read;
+
+  burst_mmap_to_stream #(
+    .MemWidth        (MEM_WIDTH),
+    .MemWidthBytesLog(MEM_BYTES_LOG),
+    .StreamWidth     (STREAM_WIDTH),
+    .MaxBurstLen     (16),
+    .BufferDepth     (32),
+    .BufferDepthLog  (5)
+  ) reader (
+    .clk(clk),
+    .rst(reset),
+
+    .start (start),
+    .idle  (reader_idle),
+    .done  (reader_done),
+    .offset(SRC_BASE * MEM_BYTES),
+    .count (COUNT),
+
+    .m_axi_ARADDR (m_axi_ARADDR),
+    .m_axi_ARLEN  (m_axi_ARLEN),
+    .m_axi_ARVALID(m_axi_ARVALID),
+    .m_axi_ARREADY(m_axi_ARREADY),
+
+    .m_axi_RDATA (m_axi_RDATA),
+    .m_axi_RVALID(m_axi_RVALID),
+    .m_axi_RREADY(m_axi_RREADY),
+
+    .data_din   (stream_din),
+    .data_full_n(stream_full_n),
+    .data_write (stream_write)
+  );
+
+  fifo #(
+    .DATA_WIDTH(STREAM_WIDTH),
+    .ADDR_WIDTH(1),
+    .DEPTH     (2)
+  ) stream (
+    .clk  (clk),
+    .reset(reset),
+
+    .if_full_n  (stream_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (stream_write),
+    .if_din     (stream_din),
+
+    .if_empty_n(stream_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (stream_read),
+    .if_dout   (stream_dout)
+  );
+
+  burst_stream_to_mmap #(
+    .MemWidth         (MEM_WIDTH),
+    .MemWidthBytesLog (MEM_BYTES_LOG),
+    .StreamWidth      (STREAM_WIDTH),
+    .MaxBurstLen      (16),
+    .BufferDepth      (32),
+    .BufferDepthLog   (5),
+    .MaxOutstanding   (4),
+    .MaxOutstandingLog(2)
+  ) writer (
+    .clk(clk),
+    .rst(reset),
+
+    .start (start),
+    .idle  (writer_idle),
+    .done  (writer_done),
+    .offset(DST_BASE * MEM_BYTES),
+    .count (COUNT),
+
+    .data_dout   (stream_dout),
+    .data_empty_n(stream_empty_n && lfsr[2]),
+    .data_read   (stream_read),
+
+    .m_axi_AWADDR (m_axi_AWADDR),
+    .m_axi_AWLEN  (m_axi_AWLEN),
+    .m_axi_AWVALID(m_axi_AWVALID),
+    .m_axi_AWREADY(m_axi_AWREADY),
+
+    .m_axi_WDATA (m_axi_WDATA),
+    .m_axi_WSTRB (m_axi_WSTRB),
+    .m_axi_WLAST (m_axi_WLAST),
+    .m_axi_WVALID(m_axi_WVALID),
+    .m_axi_WREADY(m_axi_WREADY),
+
+    .m_axi_BVALID(m_axi_BVALID),
+    .m_axi_BREADY(m_axi_BREADY)
+  );
+
+  // AXI memory with up to 16 outstanding bursts per direction
+  reg [63:0] ar_addr [0:15];
+  reg [7:0]  ar_len  [0:15];
+  reg [3:0]  ar_head = 0;
+  reg [3:0]  ar_tail = 0;
+  reg [4:0]  ar_count = 0;
+  reg [7:0]  r_beat = 0;
+
+  reg [63:0] aw_addr [0:15];
+  reg [7:0]  aw_len  [0:15];
+  reg [3:0]  aw_head = 0;
+  reg [3:0]  aw_tail = 0;
+  reg [4:0]  aw_count = 0;
+  reg [7:0]  w_beat = 0;
+  reg [4:0]  b_count = 0;
+
+  wire [63:0] r_idx = (ar_addr[ar_head] >> MEM_BYTES_LOG) + r_beat;
+  wire [63:0] w_idx = (aw_addr[aw_head] >> MEM_BYTES_LOG) + w_beat;
+
+  wire ar = m_axi_ARVALID && m_axi_ARREADY;
+  wire r  = m_axi_RVALID && m_axi_RREADY;
+  wire r_last = r && r_beat == ar_len[ar_head];
+  wire aw = m_axi_AWVALID && m_axi_AWREADY;
+  wire w  = m_axi_WVALID && m_axi_WREADY;
+  wire w_last = w && w_beat == aw_len[aw_head];
+  wire b  = m_axi_BVALID && m_axi_BREADY;
+
+  assign m_axi_ARREADY = ar_count != 16 && lfsr[3];
+  assign m_axi_RVALID  = ar_count != 0 && lfsr[0];
+  assign m_axi_RDATA   = mem[r_idx[11:0]];
+  assign m_axi_AWREADY = aw_count != 16 && lfsr[4];
+  assign m_axi_WREADY  = aw_count != 0 && lfsr[1];
+  assign m_axi_BVALID  = b_count != 0;
+
+  integer i;
+  always @(posedge clk) begin
+    if (reset) begin
+      for (i = 0; i < WORDS; i = i + 1) mem[i] <= word_of(i);
+    end else begin
+      if (ar) begin
+        if (m_axi_ARADDR[11:0] + (m_axi_ARLEN + 1) * MEM_BYTES > 4096) begin
+          $fatal(1, "read burst of %0d beats at %h crosses 4KB",
+                 m_axi_ARLEN + 1, m_axi_ARADDR);
+        end
+        ar_addr[ar_tail] <= m_axi_ARADDR;
+        ar_len[ar_tail]  <= m_axi_ARLEN;
+        ar_tail <= ar_tail + 1'b1;
+      end
+      if (m_axi_RVALID && !m_axi_RREADY) $fatal(1, "RREADY stalled");
+      if (r) begin
+        r_beat <= r_last ? 8'd0 : r_beat + 1'b1;
+        if (r_last) ar_head <= ar_head + 1'b1;
+      end
+      ar_count <= ar_count + ar - r_last;
+
+      if (aw) begin
+        if (m_axi_AWADDR[11:0] + (m_axi_AWLEN + 1) * MEM_BYTES > 4096) begin
+          $fatal(1, "write burst of %0d beats at %h crosses 4KB",
+                 m_axi_AWLEN + 1, m_axi_AWADDR);
+        end
+        aw_addr[aw_tail] <= m_axi_AWADDR;
+        aw_len[aw_tail]  <= m_axi_AWLEN;
+        aw_tail <= aw_tail + 1'b1;
+      end
+      if (w_beat != 0 && !m_axi_WVALID) $fatal(1, "WVALID stalled");
+      if (w) begin
+        if (m_axi_WLAST != w_last) $fatal(1, "WLAST is %b", m_axi_WLAST);
+        for (i = 0; i < MEM_BYTES; i = i + 1) begin
+          if (m_axi_WSTRB[i]) begin
+            mem[w_idx[11:0]][i*8 +: 8] <= m_axi_WDATA[i*8 +: 8];
+          end
+        end
+        w_beat <= w_last ? 8'd0 : w_beat + 1'b1;
+        if (w_last) aw_head <= aw_head + 1'b1;
+      end
+      aw_count <= aw_count + aw - w_last;
+      b_count  <= b_count + w_last - b;
+    end
+  end
+
+  // stream elements and completion
+  reg [31:0] element_count = 0;
+  reg        reader_finished = 1'b0;
+  reg        writer_finished = 1'b0;
+
+  always @(posedge clk) begin
+    if (!reset) begin
+      if (stream_write && stream_full_n) begin
+        if (element_count == ELEMENTS) $fatal(1, "extra stream elements");
+        if (stream_din != element_of(element_count)) begin
+          $fatal(1, "element %0d is %h, expected %h", element_count,
+                 stream_din, element_of(element_count));
+        end
+        element_count <= element_count + 1;
+      end
+      if (reader_done) reader_finished <= 1'b1;
+      if (writer_done) writer_finished <= 1'b1;
+    end
+
+    if (cycle == TIMEOUT) begin
+      $fatal(1, "timeout after %0d elements", element_count);
+    end
+  end
+
+  integer k;
+  initial begin
+    repeat (4) @(posedge clk);
+    reset <= 1'b0;
+    @(posedge clk);
+    if (!reader_idle || !writer_idle) $fatal(1, "not idle after reset");
+    start <= 1'b1;
+    @(posedge clk);
+    start <= 1'b0;
+    wait (reader_finished && writer_finished);
+    @(posedge clk);
+    if (!reader_idle || !writer_idle) $fatal(1, "not idle when done");
+    if (element_count != ELEMENTS) begin
+      $fatal(1, "%0d stream elements, expected %0d", element_count, ELEMENTS);
+    end
+    if (b_count != 0) $fatal(1, "done before the write responses");
+    for (k = 0; k < COUNT; k = k + 1) begin
+      if (mem[DST_BASE + k] != mem[SRC_BASE + k]) begin
+        $fatal(1, "word %0d is %h, expected %h", k, mem[DST_BASE + k],
+               mem[SRC_BASE + k]);
+      end
+    end
+    $display("PASS: MEM_WIDTH=%0d, STREAM_WIDTH=%0d", MEM_WIDTH, STREAM_WIDTH);
+    $finish;
+  end
+
+endmodule  // mover_test
+
+`default_nettype wire
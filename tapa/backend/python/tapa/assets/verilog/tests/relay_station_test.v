@@ -0,0 +1,85 @@
+`default_nettype none
+`timescale 1ns / 1ps
+
+// Streams COUNT tokens through a relay_station. The first half is read
+// whenever it is available and must come out at one token per cycle. The
+// second half is read once every 4 cycles, so the almost-full FIFO fills up
+// and must not drop the writes in flight.
+module relay_station_test #(
+  parameter LEVEL = 2
+);
+
+  localparam DATA_WIDTH = 32;
+  localparam COUNT = 1000;
+  localparam TIMEOUT = COUNT * 8;
+
+  reg clk = 1'b0;
+  reg reset = 1'b1;
+  always #1 clk = ~clk;
+
+  reg [31:0] cycle = 0;
+  reg [31:0] write_count = 0;
+  reg [31:0] read_count = 0;
+  reg [31:0] first_read_cycle = 0;
+
+  wire                  full_n;
+  wire                  empty_n;
+  wire [DATA_WIDTH-1:0] dout;
+
+  wire write = !reset && write_count < COUNT;
+  wire ready = read_count < COUNT / 2 || cycle[1:0] == 2'd0;
+  wire read  = !reset && empty_n && ready;
+
+  relay_station #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .ADDR_WIDTH(1),
+    .DEPTH     (2),
+    .LEVEL     (LEVEL)
+  ) dut (
+    .clk  (clk),
+    .reset(reset),
+
+    .if_full_n  (full_n),
+    .if_write_ce(1'b1),
+    .if_write   (write),
+    .if_din     (write_count),
+
+    .if_empty_n(empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (read),
+    .if_dout   (dout)
+  );
+
+  always @(posedge clk) begin
+    cycle <= cycle + 1;
+    if (write && full_n) write_count <= write_count + 1;
+    if (read) begin
+      if (dout != read_count) begin
+        $fatal(1, "LEVEL=%0d: token %0d is %0d", LEVEL, read_count, dout);
+      end
+      if (read_count == 0) first_read_cycle <= cycle;
+      if (read_count == COUNT / 2 - 1 &&
+          cycle - first_read_cycle != COUNT / 2 - 1) begin
+        $fatal(1, "LEVEL=%0d: %0d tokens took %0d cycles", LEVEL, COUNT / 2,
+               cycle - first_read_cycle + 1);
+      end
+      read_count <= read_count + 1;
+    end
+    if (cycle == TIMEOUT) begin
+      $fatal(1, "LEVEL=%0d: timeout after %0d tokens", LEVEL, read_count);
+    end
+  end
+
+  initial begin
+    repeat (4) @(posedge clk);
+    reset <= 1'b0;
+    wait (read_count == COUNT);
+    repeat (LEVEL * 4) @(posedge clk);
+    if (empty_n) $fatal(1, "LEVEL=%0d: extra tokens", LEVEL);
+    $display("PASS: LEVEL=%0d", LEVEL);
+    $finish;
+  end
+
+endmodule  // relay_station_test
+
+`default_nettype wire
@@ -0,0 +1,301 @@
+`default_nettype none
+`timescale 1ns / 1ps
+
+// Streams COUNT tokens from each input of a routing primitive, selected by
+// PRIMITIVE, to its outputs. Inputs become non-empty and outputs become full
+// at random, and every 16th token of each input is an eot token.
+//
+// For every pair of input and output, the output must receive exactly the
+// tokens of the input that are routed to it, in order: all tokens for
+// stream_merge and stream_broadcast, and the tokens whose key is the output
+// index, or eot tokens for output 0, for stream_demux and stream_butterfly.
+// Every cycle, the tokens read must be the tokens written, which checks the
+// zero latency. The arbitration must also match the documented behavior:
+// round robin for stream_merge, the key for stream_demux, all outputs at once
+// for stream_broadcast, and no stall of a token that has no competitor for
+// stream_butterfly.
+module stream_primitive_test #(
+  parameter PRIMITIVE = 0,
+  parameter N         = 4
+);
+
+  localparam MERGE     = 0;
+  localparam DEMUX     = 1;
+  localparam BROADCAST = 2;
+  localparam BUTTERFLY = 3;
+
+  localparam DATA_WIDTH = 32;
+  localparam WIDTH = DATA_WIDTH + 1;
+  localparam KEY_LSB = 2;
+  localparam KEY_WIDTH = N > 1 ? $clog2(N) : 1;
+  localparam N_IN = PRIMITIVE == MERGE || PRIMITIVE == BUTTERFLY ? N : 1;
+  localparam N_OUT = PRIMITIVE == MERGE ? 1 : N;
+  localparam COUNT = 256;  // tokens per input
+  localparam TIMEOUT = COUNT * N * 16;
+
+  reg clk = 1'b0;
+  reg reset = 1'b1;
+  always #1 clk = ~clk;
+
+  reg [31:0] cycle = 0;
+  reg [31:0] rnd = 32'h2545f491;  // xorshift32, random stalls
+  always @(posedge clk) begin
+    cycle <= cycle + 1;
+    rnd <= rnd ^ rnd << 13 ^ (rnd ^ rnd << 13) >> 17 ^
+           (rnd ^ rnd << 13 ^ (rnd ^ rnd << 13) >> 17) << 5;
+  end
+
+  // token: eot, input index, sequence number, and random key bits
+  function [WIDTH-1:0] token_of(input integer src, input integer seq);
+    reg [31:0] src_bits;
+    reg [31:0] seq_bits;
+    reg [31:0] hash;
+    begin
+      src_bits = src;
+      seq_bits = seq;
+      hash = src_bits * 32'h9e3779b1 ^ seq_bits * 32'h85ebca6b;
+      token_of = {seq_bits[3:0] == 4'hf, src_bits[7:0], seq_bits[11:0],
+                  hash[23:12]};
+    end
+  endfunction
+
+  function integer dst_of(input [WIDTH-1:0] token);
+    if (PRIMITIVE == MERGE || token[DATA_WIDTH]) begin
+      dst_of = 0;
+    end else begin
+      dst_of = token[KEY_LSB +: KEY_WIDTH];
+    end
+  endfunction
+
+  function is_routed(input integer src, input integer seq, input integer dst);
+    is_routed = PRIMITIVE == BROADCAST || dst_of(token_of(src, seq)) == dst;
+  endfunction
+
+  // first token of src routed to dst, starting from seq
+  function integer next_seq_of(input integer src, input integer dst,
+                               input integer seq);
+    integer i;
+    begin
+      next_seq_of = COUNT;
+      for (i = COUNT - 1; i >= seq; i = i - 1) begin
+        if (is_routed(src, i, dst)) next_seq_of = i;
+      end
+    end
+  endfunction
+
+  wire [N_IN*WIDTH-1:0]  in_dout;
+  reg  [N_IN-1:0]        in_empty_n = 0;
+  wire [N_IN-1:0]        in_read;
+  wire [N_OUT*WIDTH-1:0] out_din;
+  wire [N_OUT-1:0]       out_full_n;
+  wire [N_OUT-1:0]       out_write;
+
+  generate
+    if (PRIMITIVE == MERGE) begin : merge
+      stream_merge #(
+        .N        (N),
+        .DataWidth(DATA_WIDTH)
+      ) dut (
+        .clk       (clk),
+        .rst       (reset),
+        .in_dout   (in_dout),
+        .in_empty_n(in_empty_n),
+        .in_read   (in_read),
+        .out_din   (out_din),
+        .out_full_n(out_full_n),
+        .out_write (out_write)
+      );
+    end else if (PRIMITIVE == DEMUX) begin : demux
+      stream_demux #(
+        .N        (N),
+        .DataWidth(DATA_WIDTH),
+        .KeyLsb   (KEY_LSB)
+      ) dut (
+        .clk       (clk),
+        .rst       (reset),
+        .in_dout   (in_dout),
+        .in_empty_n(in_empty_n),
+        .in_read   (in_read),
+        .out_din   (out_din),
+        .out_full_n(out_full_n),
+        .out_write (out_write)
+      );
+    end else if (PRIMITIVE == BROADCAST) begin : broadcast
+      stream_broadcast #(
+        .N        (N),
+        .DataWidth(DATA_WIDTH)
+      ) dut (
+        .clk       (clk),
+        .rst       (reset),
+        .in_dout   (in_dout),
+        .in_empty_n(in_empty_n),
+        .in_read   (in_read),
+        .out_din   (out_din),
+        .out_full_n(out_full_n),
+        .out_write (out_write)
+      );
+    end else begin : butterfly
+      stream_butterfly #(
+        .N        (N),
+        .DataWidth(DATA_WIDTH),
+        .KeyLsb   (KEY_LSB)
+      ) dut (
+        .clk       (clk),
+        .rst       (reset),
+        .in_dout   (in_dout),
+        .in_empty_n(in_empty_n),
+        .in_read   (in_read),
+        .out_din   (out_din),
+        .out_full_n(out_full_n),
+        .out_write (out_write)
+      );
+    end
+  endgenerate
+
+  // inputs behave as FIFOs: a token stays at the head until it is read
+  reg [31:0] in_seq [0:N_IN-1];
+
+  genvar g;
+  generate
+    for (g = 0; g < N_IN; g = g + 1) begin : in
+      assign in_dout[g*WIDTH +: WIDTH] = token_of(g, in_seq[g]);
+    end
+    for (g = 0; g < N_OUT; g = g + 1) begin : out
+      assign out_full_n[g] = rnd[8+g] || rnd[16+g];
+    end
+  endgenerate
+
+  // next sequence number expected from input i at output j, at [i*N_OUT+j]
+  reg [31:0] expected_seq [0:N_IN*N_OUT-1];
+
+  reg [31:0]      token_seq;
+  reg [WIDTH-1:0] token;
+  reg [31:0]      src;
+  reg [31:0]      read_count;
+  reg [31:0]      write_count;
+  reg [31:0]      valid_count;
+  reg [31:0]      last;  // input read last by stream_merge
+  reg [N_IN-1:0]  expected_read;
+  integer i, j;
+
+  always @(posedge clk) begin
+    if (reset) begin
+      for (i = 0; i < N_IN; i = i + 1) begin
+        in_seq[i] <= 0;
+        for (j = 0; j < N_OUT; j = j + 1) begin
+          expected_seq[i*N_OUT+j] <= next_seq_of(i, j, 0);
+        end
+      end
+      last <= N - 1;
+    end else begin
+      // inputs
+      read_count = 0;
+      for (i = 0; i < N_IN; i = i + 1) begin
+        if (in_read[i] && !in_empty_n[i]) $fatal(1, "input %0d is empty", i);
+        if (in_read[i] || !in_empty_n[i]) begin
+          token_seq = in_seq[i] + in_read[i];
+          in_seq[i] <= token_seq;
+          in_empty_n[i] <= token_seq < COUNT && rnd[i];
+        end
+        read_count = read_count + in_read[i];
+      end
+
+      // outputs
+      write_count = 0;
+      for (j = 0; j < N_OUT; j = j + 1) begin
+        if (out_write[j] && out_full_n[j]) begin
+          token = out_din[j*WIDTH +: WIDTH];
+          src = token[DATA_WIDTH-1 -: 8];
+          token_seq = token[DATA_WIDTH-9 -: 12];
+          if (src >= N_IN || token != token_of(src, token_seq)) begin
+            $fatal(1, "output %0d got unknown token %h", j, token);
+          end
+          if (!in_read[src]) begin
+            $fatal(1, "output %0d got token %0d of input %0d, which is unread",
+                   j, token_seq, src);
+          end
+          if (token_seq != expected_seq[src*N_OUT+j]) begin
+            $fatal(1, "output %0d got token %0d of input %0d, expected %0d", j,
+                   token_seq, src, expected_seq[src*N_OUT+j]);
+          end
+          expected_seq[src*N_OUT+j] <= next_seq_of(src, j, token_seq + 1);
+          write_count = write_count + 1;
+        end
+      end
+      if (write_count != read_count * (PRIMITIVE == BROADCAST ? N : 1)) begin
+        $fatal(1, "%0d tokens are read but %0d are written", read_count,
+               write_count);
+      end
+
+      // arbitration
+      expected_read = in_read;
+      valid_count = 0;
+      for (i = 0; i < N_IN; i = i + 1) begin
+        valid_count = valid_count + in_empty_n[i];
+      end
+      case (PRIMITIVE)
+        MERGE: begin
+          expected_read = 0;
+          for (i = N; i > 0; i = i - 1) begin
+            if (in_empty_n[(last + i) % N]) begin
+              expected_read = out_full_n[0] << (last + i) % N;
+            end
+          end
+          for (i = 0; i < N; i = i + 1) if (in_read[i]) last <= i;
+        end
+        DEMUX: begin
+          expected_read = in_empty_n[0] && out_full_n[dst_of(in_dout)];
+        end
+        BROADCAST: begin
+          expected_read = in_empty_n[0] && &out_full_n;
+        end
+        BUTTERFLY: begin
+          // a lone token goes through; tokens also go through if no output
+          // is full, though a switch may hold back one of two
+          for (i = 0; i < N; i = i + 1) begin
+            if (valid_count == 1 && in_empty_n[i]) begin
+              token = in_dout[i*WIDTH +: WIDTH];
+              expected_read[i] = out_full_n[dst_of(token)];
+            end
+          end
+          if (valid_count != 0 && &out_full_n && in_read == 0) begin
+            $fatal(1, "no token goes through although no output is full");
+          end
+        end
+      endcase
+      if (in_read != expected_read) begin
+        $fatal(1, "read %b, expected %b, with inputs %b and outputs %b",
+               in_read, expected_read, in_empty_n, out_full_n);
+      end
+    end
+
+    if (cycle == TIMEOUT) $fatal(1, "timeout");
+  end
+
+  reg done = 1'b0;
+  integer k;
+  always @(posedge clk) begin
+    done = 1'b1;
+    for (k = 0; k < N_IN; k = k + 1) done = done && in_seq[k] == COUNT;
+  end
+
+  integer m;
+  initial begin
+    repeat (4) @(posedge clk);
+    reset <= 1'b0;
+    @(posedge clk);
+    wait (done);
+    repeat (4) @(posedge clk);
+    for (m = 0; m < N_IN * N_OUT; m = m + 1) begin
+      if (expected_seq[m] != COUNT) begin
+        $fatal(1, "input %0d did not send token %0d to output %0d", m / N_OUT,
+               expected_seq[m], m % N_OUT);
+      end
+    end
+    $display("PASS: PRIMITIVE=%0d, N=%0d", PRIMITIVE, N);
+    $finish;
+  end
+
+endmodule  // stream_primitive_test
+
+`default_nettype wire
@@ -0,0 +1,207 @@
+`default_nettype none
+`timescale 1ns / 1ps
+
+// Reads SEGMENT_LEN addresses per segment through a stride_prefetch in front
+// of a memory model with a fixed latency. The first segment is sequential and
+// must hit once the stride is learned. The second segment changes the stride
+// while prefetches of the first one are outstanding, which must be dropped,
+// and must hit again once the new stride is learned. The third segment has no
+// constant stride and must never hit. Each segment starts after the
+// prefetcher has had time to fill up, so at most DEPTH prefetches must have
+// been outstanding, and every read must return the data of its own address.
+module stride_prefetch_test #(
+  parameter DEPTH = 4
+);
+
+  localparam DATA_WIDTH = 32;
+  localparam SEGMENTS = 3;
+  localparam SEGMENT_LEN = 64;
+  localparam INTERVAL = 8;  // cycles between user addresses
+  localparam LATENCY = 4;   // cycles of memory reads
+  localparam IDLE = 64;     // cycles between segments
+  // a new stride is learned after Threshold (2) + 1 misses, plus one in the
+  // first segment, whose first address is compared to the reset address
+  localparam MAX_MISSES = 4;
+  localparam TIMEOUT = SEGMENTS * (SEGMENT_LEN * INTERVAL * 2 + IDLE);
+
+  reg clk = 1'b0;
+  reg reset = 1'b1;
+  always #1 clk = ~clk;
+
+  reg [31:0] cycle = 0;
+  always @(posedge clk) cycle <= cycle + 1;
+
+  function [31:0] addr_of(input integer i);
+    if (i < SEGMENT_LEN) begin
+      addr_of = 32'h1000 + i * 4;
+    end else if (i < SEGMENT_LEN * 2) begin
+      addr_of = 32'h1000 + (SEGMENT_LEN - 1) * 4 + (i - SEGMENT_LEN + 1) * 12;
+    end else begin
+      // strides of 4 * (2i + 1) are never the same twice
+      addr_of = 32'h100000 + (i - SEGMENT_LEN * 2) * (i - SEGMENT_LEN * 2) * 4;
+    end
+  endfunction
+
+  function [DATA_WIDTH-1:0] data_of(input [31:0] addr);
+    data_of = addr * 32'h9e3779b1;
+  endfunction
+
+  wire [31:0]           addr_dout;
+  reg                   addr_empty_n = 1'b0;
+  wire                  addr_read;
+  wire [31:0]           mem_addr_din;
+  wire                  mem_addr_full_n;
+  wire                  mem_addr_write;
+  wire                  mem_data_valid;
+  wire                  mem_data_ready;
+  wire [DATA_WIDTH-1:0] mem_data;
+  wire [DATA_WIDTH-1:0] data_din;
+  wire                  data_write;
+  wire [31:0]           hit_count;
+  wire [31:0]           miss_count;
+
+  stride_prefetch #(
+    .AddrWidth(32),
+    .DataWidth(DATA_WIDTH),
+    .Depth    (DEPTH),
+    .DepthLog ($clog2(DEPTH) > 0 ? $clog2(DEPTH) : 1)
+  ) dut (
+    .clk(clk),
+    .rst(reset),
+
+    .addr_dout   (addr_dout),
+    .addr_empty_n(addr_empty_n),
+    .addr_read   (addr_read),
+
+    .mem_addr_din   (mem_addr_din),
+    .mem_addr_full_n(mem_addr_full_n),
+    .mem_addr_write (mem_addr_write),
+
+    .mem_data_valid(mem_data_valid),
+    .mem_data_ready(mem_data_ready),
+    .mem_data      (mem_data),
+
+    .data_din   (data_din),
+    .data_full_n(1'b1),
+    .data_write (data_write),
+
+    .hit_count (hit_count),
+    .miss_count(miss_count)
+  );
+
+  // memory that answers in order, LATENCY cycles after each request
+  reg [31:0] req_addr  [0:63];
+  reg [31:0] req_cycle [0:63];
+  reg [5:0]  req_head = 0;
+  reg [5:0]  req_tail = 0;
+  reg [6:0]  req_count = 0;
+
+  wire mem_data_read = mem_data_valid && mem_data_ready;
+
+  assign mem_addr_full_n = req_count != 64;
+  assign mem_data_valid  = req_count != 0 &&
+                           cycle >= req_cycle[req_head] + LATENCY;
+  assign mem_data        = data_of(req_addr[req_head]);
+
+  always @(posedge clk) begin
+    if (!reset) begin
+      if (mem_addr_write) begin
+        req_addr[req_tail]  <= mem_addr_din;
+        req_cycle[req_tail] <= cycle;
+        req_tail <= req_tail + 1'b1;
+      end
+      if (mem_data_read) req_head <= req_head + 1'b1;
+      req_count <= req_count + mem_addr_write - mem_data_read;
+    end
+  end
+
+  // user of the prefetcher
+  reg [31:0] seg = 0;
+  reg [31:0] addr_count = 0;
+  reg [31:0] data_count = 0;
+  reg [31:0] countdown = 0;
+  reg [31:0] idle = 0;
+  reg [31:0] base_hit_count = 0;
+  reg [31:0] base_miss_count = 0;
+  reg [31:0] max_prefetch_count = 0;
+
+  wire [31:0] seg_hit_count  = hit_count - base_hit_count;
+  wire [31:0] seg_miss_count = miss_count - base_miss_count;
+
+  assign addr_dout = addr_of(addr_count);
+
+  always @(posedge clk) begin
+    if (!reset) begin
+      if (addr_empty_n) begin
+        if (addr_read) begin
+          addr_empty_n <= 1'b0;
+          addr_count <= addr_count + 1;
+          countdown <= INTERVAL - 1;
+        end
+      end else if (countdown != 0) begin
+        countdown <= countdown - 1;
+      end else if (addr_count < (seg + 1) * SEGMENT_LEN &&
+                   seg < SEGMENTS) begin
+        addr_empty_n <= 1'b1;
+      end
+
+      if (data_write) begin
+        if (data_count == addr_count) $fatal(1, "extra data");
+        if (data_din != data_of(addr_of(data_count))) begin
+          $fatal(1, "DEPTH=%0d: read %0d at %h returned %h, expected %h",
+                 DEPTH, data_count, addr_of(data_count), data_din,
+                 data_of(addr_of(data_count)));
+        end
+        data_count <= data_count + 1;
+      end
+
+      if (dut.prefetch_count > DEPTH) begin
+        $fatal(1, "DEPTH=%0d: %0d prefetches outstanding", DEPTH,
+               dut.prefetch_count);
+      end
+      if (dut.prefetch_count > max_prefetch_count) begin
+        max_prefetch_count <= dut.prefetch_count;
+      end
+
+      // let the prefetcher fill up before the next segment
+      if (seg < SEGMENTS && data_count == (seg + 1) * SEGMENT_LEN) begin
+        idle <= idle + 1;
+        if (idle == IDLE) begin
+          if (seg_hit_count + seg_miss_count != SEGMENT_LEN) begin
+            $fatal(1, "DEPTH=%0d: segment %0d has %0d hits and %0d misses",
+                   DEPTH, seg, seg_hit_count, seg_miss_count);
+          end
+          if (seg < 2 ? seg_miss_count > MAX_MISSES : seg_hit_count != 0) begin
+            $fatal(1, "DEPTH=%0d: segment %0d has %0d hits and %0d misses",
+                   DEPTH, seg, seg_hit_count, seg_miss_count);
+          end
+          $display("DEPTH=%0d: segment %0d has %0d hits and %0d misses", DEPTH,
+                   seg, seg_hit_count, seg_miss_count);
+          base_hit_count <= hit_count;
+          base_miss_count <= miss_count;
+          seg <= seg + 1;
+          idle <= 0;
+        end
+      end
+    end
+
+    if (cycle == TIMEOUT) begin
+      $fatal(1, "DEPTH=%0d: timeout after %0d reads", DEPTH, data_count);
+    end
+  end
+
+  initial begin
+    repeat (4) @(posedge clk);
+    reset <= 1'b0;
+    wait (seg == SEGMENTS);
+    if (max_prefetch_count != DEPTH) begin
+      $fatal(1, "DEPTH=%0d: at most %0d prefetches were outstanding", DEPTH,
+             max_prefetch_count);
+    end
+    $display("PASS: DEPTH=%0d", DEPTH);
+    $finish;
+  end
+
+endmodule  // stride_prefetch_test
+
+`default_nettype wire
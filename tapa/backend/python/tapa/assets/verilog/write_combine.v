@@ -0,0 +1,141 @@
+`default_nettype none
+
+// Merge writes to the same address before they reach the burst detector.
+//
+// Up to Capacity lines are held, oldest first. A write to a held line
+// overwrites its data and increments its merge count; a write to another
+// address takes a new line. The oldest line is sent downstream when a new line
+// is needed but all are taken, when a write hits a line whose merge count is
+// saturated, or when no write has arrived for MaxWaitTime cycles, which drains
+// all lines one per cycle. If a line holds the address right after the last
+// line sent, that line is sent instead of the oldest one, so that adjacent
+// lines reach the burst detector in order. Writes to different addresses may
+// be reordered; writes to the same address never are.
+module write_combine #(
+  parameter Capacity          = 4,
+  parameter AddrWidth         = 64,
+  parameter DataWidth         = 512,
+  parameter DataWidthBytesLog = 6,  // must equal log2(DataWidth/8)
+  parameter CountWidth        = 8,
+  parameter WaitTimeWidth     = 4,
+  // max number of merged writes minus one per line
+  parameter MaxMergeCount     = 15,
+  parameter MaxWaitTime       = 3
+) (
+  input wire clk,
+  input wire rst,
+
+  // input: individual writes
+  input  wire [AddrWidth-1:0] addr_dout,
+  input  wire                 addr_empty_n,
+  output wire                 addr_read,
+  input  wire [DataWidth-1:0] data_dout,
+  input  wire                 data_empty_n,
+  output wire                 data_read,
+
+  // output: combined writes and the number of merged writes minus one
+  output wire [AddrWidth-1:0]            addr_din,
+  input  wire                            addr_full_n,
+  output wire                            addr_write,
+  output wire [CountWidth+DataWidth-1:0] data_din,
+  input  wire                            data_full_n,
+  output wire                            data_write
+);
+
+  // state
+  reg                  valid [0:Capacity-1];
+  reg [AddrWidth-1:0]  addr  [0:Capacity-1];
+  reg [DataWidth-1:0]  data  [0:Capacity-1];
+  reg [CountWidth-1:0] count [0:Capacity-1];
+  reg [WaitTimeWidth-1:0] wait_time;
+  reg [AddrWidth-1:0]     last_addr;
+
+  // logic
+  reg                          hit;
+  reg [$clog2(Capacity+1)-1:0] hit_idx;
+  reg [$clog2(Capacity+1)-1:0] free_idx;
+  reg [$clog2(Capacity+1)-1:0] evict_idx;
+
+  integer i;
+  always @* begin
+    hit = 1'b0;
+    hit_idx = 0;
+    free_idx = Capacity;
+    evict_idx = 0;
+    for (i = Capacity - 1; i >= 0; i = i - 1) begin
+      // held addresses are unique
+      if (valid[i] && addr[i] == addr_dout) begin
+        hit = 1'b1;
+        hit_idx = i;
+      end
+      if (valid[i] && addr[i] == last_addr + (1 << DataWidthBytesLog)) begin
+        evict_idx = i;
+      end
+      // valid lines are packed at the lowest indices
+      if (!valid[i]) free_idx = i;
+    end
+  end
+
+  wire in_valid  = addr_empty_n && data_empty_n;
+  wire out_ready = addr_full_n && data_full_n;
+  wire is_full   = valid[Capacity-1];
+  wire mergeable = hit && count[hit_idx] != MaxMergeCount[CountWidth-1:0];
+
+  // a line leaves if the input needs room or no input arrives
+  wire evict = out_ready && valid[0] && (in_valid ?
+      !mergeable && (hit || is_full) : wait_time >= MaxWaitTime);
+  wire accept = in_valid && (mergeable || (!hit && (!is_full || evict)));
+
+  // lines after the evicted one shift down, making room at the tail
+  wire [$clog2(Capacity+1)-1:0] insert_idx = evict ? free_idx - 1 : free_idx;
+
+  assign addr_read  = accept;
+  assign data_read  = accept;
+  assign addr_write = evict;
+  assign data_write = evict;
+  assign addr_din   = addr[evict_idx];
+  assign data_din   = {count[evict_idx], data[evict_idx]};
+
+  always @(posedge clk) begin
+    if (rst) begin
+      for (i = 0; i < Capacity; i = i + 1) valid[i] <= 1'b0;
+      wait_time <= {WaitTimeWidth{1'b0}};
+    end else begin
+      if (evict) begin
+        for (i = 0; i < Capacity - 1; i = i + 1) begin
+          if (i >= evict_idx) begin
+            valid[i] <= valid[i+1];
+            addr[i]  <= addr[i+1];
+            data[i]  <= data[i+1];
+            count[i] <= count[i+1];
+          end
+        end
+        valid[Capacity-1] <= 1'b0;
+      end
+
+      // a merged line is never evicted in the same cycle
+      if (accept) begin
+        if (mergeable) begin
+          data[hit_idx]  <= data_dout;
+          count[hit_idx] <= count[hit_idx] + 1'b1;
+        end else begin
+          valid[insert_idx] <= 1'b1;
+          addr[insert_idx]  <= addr_dout;
+          data[insert_idx]  <= data_dout;
+          count[insert_idx] <= {CountWidth{1'b0}};
+        end
+      end
+
+      if (evict) last_addr <= addr[evict_idx];
+
+      if (accept) begin
+        wait_time <= {WaitTimeWidth{1'b0}};
+      end else if (wait_time < MaxWaitTime) begin
+        wait_time <= wait_time + 1'b1;
+      end
+    end
+  end
+
+endmodule  // write_combine
+
+`default_nettype wire
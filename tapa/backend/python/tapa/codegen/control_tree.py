@@ -0,0 +1,135 @@
+from typing import Dict, Iterable, List, Optional, Tuple
+
+from tapa.verilog import ast
+from tapa.verilog import xilinx as rtl
+
+__all__ = [
+    'CONTROL_TREE_FANOUT',
+    'ControlTree',
+    'add_reduction',
+    'get_instance_slots',
+]
+
+# max number of instances sharing one slot-local copy when not floorplanned
+CONTROL_TREE_FANOUT = 16
+
+
+def get_instance_slots(
+    instance_names: Iterable[str],
+    instance_name_to_slr: Dict[str, int],
+) -> Dict[str, str]:
+  """Group task instances into slots that share slot-local signal copies.
+
+  Floorplanned instances are grouped by their SLR so that each SLR has its own
+  copy. Other instances are grouped by their order of instantiation, at most
+  CONTROL_TREE_FANOUT per group, which bounds the fan-out of each copy.
+
+  Returns:
+      Dict mapping instance names to slot names.
+  """
+  slots = {}
+  idx = 0
+  for name in instance_names:
+    if name in instance_name_to_slr:
+      slots[name] = f'slr_{instance_name_to_slr[name]}'
+    else:
+      slots[name] = f'grp_{idx // CONTROL_TREE_FANOUT}'
+      idx += 1
+  return slots
+
+
+class ControlTree:
+  """Register-pipelined distribution tree of broadcast signals.
+
+  A broadcast signal, e.g., ap_start or a scalar argument, is registered into
+  one trunk pipeline per slot, and then into one leaf register per instance.
+  The trunk is one stage shorter than the requested level so that the total
+  latency stays the same as a per-instance pipeline of the requested level,
+  while each register drives at most one slot or one instance.
+
+  A level below 2 leaves no stage for the trunk, so the signal would drive the
+  leaves of all slots directly. Such signals are not distributed by the tree;
+  each instance gets its own pipeline of the requested level instead.
+  """
+
+  def __init__(self, module: rtl.Module) -> None:
+    self._module = module
+    self._trunks: Dict[Tuple[str, str], rtl.Pipeline] = {}
+
+  @staticmethod
+  def split_level(level: int) -> Tuple[int, int]:
+    """Return the levels of the trunk and leaf pipelines.
+
+    The trunk level is 0 if the signal is not distributed by the tree.
+    """
+    if level < 2:
+      return 0, level
+    return level - 1, 1
+
+  def add_leaf(
+      self,
+      name: str,
+      trunk_name: str,
+      slot: str,
+      level: int,
+      init: ast.Node,
+      width: Optional[int] = None,
+  ) -> rtl.Pipeline:
+    """Add a per-instance copy of the signal driven by init.
+
+    Args:
+        name: Name of the per-instance pipeline.
+        trunk_name: Name of the signal shared by instances in the same slot.
+        slot: Slot of the instance.
+        level: Total number of register stages from init to the instance.
+        init: Value used to drive the first stage of the trunk.
+        width: Width of the signal.
+
+    Returns:
+        rtl.Pipeline: The per-instance pipeline.
+    """
+    trunk_level, leaf_level = self.split_level(level)
+    if trunk_level == 0:
+      leaf = rtl.Pipeline(name, level=leaf_level, width=width)
+      self._module.add_pipeline(leaf, init=init)
+      return leaf
+
+    key = (trunk_name, slot)
+    trunk = self._trunks.get(key)
+    if trunk is None:
+      trunk = rtl.Pipeline(f'{trunk_name}__{slot}',
+                           level=trunk_level,
+                           width=width)
+      self._module.add_pipeline(trunk, init=init)
+      self._trunks[key] = trunk
+    assert trunk.level == trunk_level, f'inconsistent level of {trunk_name}'
+
+    leaf = rtl.Pipeline(name, level=leaf_level, width=width)
+    self._module.add_pipeline(leaf, init=trunk[-1])
+    return leaf
+
+
+def add_reduction(
+    module: rtl.Module,
+    name: str,
+    signals: Dict[str, List[ast.Node]],
+) -> List[rtl.Pipeline]:
+  """Register the AND of the signals in each slot.
+
+  Args:
+      module: Module to add the registers to.
+      name: Name prefix of the per-slot registers.
+      signals: Dict mapping slot names to the signals in that slot.
+
+  Returns:
+      List[rtl.Pipeline]: One single-stage pipeline per slot.
+  """
+  reduced = []
+  for slot, slot_signals in signals.items():
+    q = rtl.Pipeline(f'{name}__{slot}', level=1)
+    module.add_pipeline(
+        q,
+        init=ast.make_operation(operator=ast.Land, nodes=slot_signals),
+    )
+    reduced.append(q)
+  return reduced
@@ -0,0 +1,96 @@
+import collections
+import unittest
+from typing import Dict, List
+
+from tapa.codegen.control_tree import ControlTree, get_instance_slots
+from tapa.verilog import ast
+from tapa.verilog import xilinx as rtl
+
+
+class _Module:
+  """Records the registers that `rtl.Module.add_pipeline` would generate."""
+
+  def __init__(self) -> None:
+    # stage name -> name of the signal driving it
+    self.drivers: Dict[str, str] = {}
+    # stage name -> whether the stage is a register
+    self.is_reg: Dict[str, bool] = {}
+
+  def add_pipeline(self, q: rtl.Pipeline, init: ast.Identifier) -> None:
+    self.drivers[q[0].name] = init.name
+    self.is_reg[q[0].name] = False
+    for i in range(q.level):
+      self.drivers[q[i + 1].name] = q[i].name
+      self.is_reg[q[i + 1].name] = True
+
+  def get_latency(self, name: str) -> int:
+    """Returns the number of registers from the source to signal `name`."""
+    latency = 0
+    while name in self.drivers:
+      latency += self.is_reg[name]
+      name = self.drivers[name]
+    return latency
+
+  def get_fanout(self, name: str) -> int:
+    return sum(driver == name for driver in self.drivers.values())
+
+
+class ControlTreeTest(unittest.TestCase):
+
+  def build(self, level: int, instance_name_to_slr: Dict[str, int],
+            num_instances: int) -> _Module:
+    module = _Module()
+    tree = ControlTree(module)
+    names = [f'inst_{i}' for i in range(num_instances)]
+    slots = get_instance_slots(names, instance_name_to_slr)
+    self.leaves: List[rtl.Pipeline] = [
+        tree.add_leaf(
+            name=f'{name}__ap_start',
+            trunk_name='ap_start',
+            slot=slots[name],
+            level=level,
+            init=ast.Identifier('ap_start'),
+        ) for name in names
+    ]
+    return module
+
+  def check_latency(self, module: _Module, level: int) -> None:
+    for leaf in self.leaves:
+      self.assertEqual(module.get_latency(leaf[-1].name), level)
+
+  def test_single_slr(self):
+    # single-SLR parts use one register level
+    for level in (0, 1):
+      module = self.build(level, {}, 4)
+      self.check_latency(module, level)
+      # no trunk without a stage for it
+      self.assertFalse(any('__grp_' in x for x in module.drivers))
+
+  def test_multi_slr(self):
+    instance_name_to_slr = {f'inst_{i}': i % 4 for i in range(8)}
+    for level in (2, 3, 4):
+      module = self.build(level, instance_name_to_slr, 8)
+      self.check_latency(module, level)
+      # the source drives one trunk per slot, each registered at least once
+      self.assertEqual(module.get_fanout('ap_start'), 4)
+      trunks = [x for x in module.drivers if x.endswith('__q0')]
+      for slr in range(4):
+        trunk = f'ap_start__slr_{slr}'
+        self.assertIn(f'{trunk}__q0', trunks)
+        self.assertEqual(module.get_latency(f'{trunk}__q{level - 1}'),
+                         level - 1)
+        # the last trunk stage drives the two instances in its slot
+        self.assertEqual(module.get_fanout(f'{trunk}__q{level - 1}'), 2)
+
+  def test_not_floorplanned(self):
+    module = self.build(2, {}, 40)
+    self.check_latency(module, 2)
+    # instances are grouped by at most 16, so 3 groups share the source
+    self.assertEqual(module.get_fanout('ap_start'), 3)
+    fanouts = collections.Counter(
+        module.get_fanout(f'ap_start__grp_{i}__q1') for i in range(3))
+    self.assertEqual(fanouts, {16: 2, 8: 1})
+
+
+if __name__ == '__main__':
+  unittest.main()
@@ -0,0 +1,331 @@
+"""Generate RTL tasks that implement library movers with built-in modules.
+
+A task annotated with ``[[tapa::target("rtl", "xilinx")]]`` forwards its
+parameters to one of ``tapa::mmap_to_stream`` and ``tapa::stream_to_mmap``.
+Instead of synthesizing such a task with HLS, its module is a wrapper with the
+same interface as an HLS-generated module that instantiates the burst mover
+from the Verilog assets.
+"""
+
+import math
+import xml.etree.ElementTree as ET
+from typing import Dict, List, Tuple, Union
+
+from tapa.instance import Port
+from tapa.verilog.xilinx.m_axi import (M_AXI_PORT_WIDTHS, M_AXI_PORTS,
+                                       M_AXI_PREFIX)
+
+__all__ = [
+    'MOVER_ASSETS',
+    'generate_mover',
+    'generate_report',
+]
+
+MOVER_ASSETS = (
+    'burst_mmap_to_stream.v',
+    'burst_stream_to_mmap.v',
+)
+
+# {library function: (roles of its arguments, module name)}
+_MOVERS = {
+    'mmap_to_stream': (('mmap', 'count', 'ostream'), 'burst_mmap_to_stream'),
+    'stream_to_mmap': (('istream', 'mmap', 'count'), 'burst_stream_to_mmap'),
+}
+
+_ADDR_WIDTH = 64
+_MAX_OUTSTANDING = 16
+
+# AXI channels used by each mover; ports of other channels are tied off
+_READ_CHANNELS = ('AR', 'R')
+_WRITE_CHANNELS = ('AW', 'W', 'B')
+
+
+def _width(width: int) -> str:
+  return f'[{width - 1}:0] ' if width > 1 else ''
+
+
+def _m_axi_port_width(port: str, data_width: int) -> int:
+  width = M_AXI_PORT_WIDTHS[port]
+  if width == 0:
+    if port == 'ADDR':
+      return _ADDR_WIDTH
+    if port == 'DATA':
+      return data_width
+    if port == 'STRB':
+      return data_width // 8
+  return width
+
+
+def _get_roles(
+    name: str,
+    ports: Dict[str, Port],
+    rtl_module: str,
+    rtl_args: List[str],
+) -> Dict[str, Port]:
+  """Map each argument role of the mover to the task port passed to it."""
+  if rtl_module not in _MOVERS:
+    raise ValueError(f'task {name} calls {rtl_module}, which has no RTL '
+                     'implementation')
+  roles, _ = _MOVERS[rtl_module]
+  if len(rtl_args) != len(roles):
+    raise ValueError(f'task {name} passes {len(rtl_args)} arguments to '
+                     f'{rtl_module}, expecting {len(roles)}')
+  role_to_port: Dict[str, Port] = {}
+  for role, arg in zip(roles, rtl_args):
+    port = ports[arg]
+    cat = {
+        'mmap': port.cat.is_sync_mmap,
+        'count': port.cat.is_scalar,
+        'istream': port.cat.is_istream,
+        'ostream': port.cat.is_ostream,
+    }[role]
+    if not cat:
+      raise ValueError(f'argument {arg} of {rtl_module} in task {name} '
+                       f'must be a {role}')
+    role_to_port[role] = port
+
+  for port in ports.values():
+    if port.cat.is_async_mmap or port.cat.is_ibuffer or port.cat.is_obuffer:
+      raise ValueError(f'port {port.name} of task {name} is not supported in '
+                       'rtl tasks')
+
+  mem_width = role_to_port['mmap'].width
+  stream_port = role_to_port.get('istream', role_to_port.get('ostream'))
+  stream_width = stream_port.width
+  if mem_width < 8 or mem_width > 1024 or mem_width & (mem_width - 1):
+    raise ValueError(f'mmap {role_to_port["mmap"].name} of task {name} must '
+                     'be 8 to 1024 bits wide and a power of 2, got '
+                     f'{mem_width}')
+  if max(mem_width, stream_width) % min(mem_width, stream_width):
+    raise ValueError(f'mmap and stream widths of task {name} must divide one '
+                     f'another, got {mem_width} and {stream_width}')
+  return role_to_port
+
+
+def _get_params(mem_width: int, stream_width: int) -> Dict[str, int]:
+  # each burst moves up to 4KB, and up to 4 bursts are buffered
+  max_burst_len = min(256, 4096 * 8 // mem_width)
+  buffer_depth = max_burst_len * 4
+  return {
+      'AddrWidth': _ADDR_WIDTH,
+      'MemWidth': mem_width,
+      'MemWidthBytesLog': int(math.log2(mem_width // 8)),
+      'StreamWidth': stream_width,
+      'MaxBurstLen': max_burst_len,
+      'BufferDepth': buffer_depth,
+      'BufferDepthLog': int(math.log2(buffer_depth)),
+  }
+
+
+def _get_area(
+    rtl_module: str,
+    mem_width: int,
+    stream_width: int,
+    params: Dict[str, int],
+) -> Dict[str, int]:
+  """Estimate the area of a mover, which is dominated by its buffer."""
+  bram = math.ceil(mem_width / 36) * math.ceil(params['BufferDepth'] / 512)
+  ff = 2 * mem_width + stream_width + 400
+  lut = mem_width + stream_width + 600
+  if rtl_module == 'stream_to_mmap':
+    bram += 1  # burst length fifo
+  return {'BRAM_18K': bram, 'DSP': 0, 'FF': ff, 'LUT': lut, 'URAM': 0}
+
+
+def generate_report(
+    name: str,
+    area: Dict[str, int],
+    clock_period: Union[int, float, str],
+) -> str:
+  """Generate a report with the same structure as HLS csynth reports."""
+  profile = ET.Element('profile')
+  info = ET.SubElement(profile, 'UserAssignments')
+  ET.SubElement(info, 'TopModelName').text = name
+  ET.SubElement(info, 'TargetClockPeriod').text = str(clock_period)
+  perf = ET.SubElement(profile, 'PerformanceEstimates')
+  timing = ET.SubElement(perf, 'SummaryOfTimingAnalysis')
+  ET.SubElement(timing, 'unit').text = 'ns'
+  ET.SubElement(timing, 'EstimatedClockPeriod').text = str(clock_period)
+  resources = ET.SubElement(ET.SubElement(profile, 'AreaEstimates'),
+                            'Resources')
+  for key, value in area.items():
+    ET.SubElement(resources, key).text = str(value)
+  return ET.tostring(profile, encoding='unicode')
+
+
+def generate_mover(
+    name: str,
+    ports: Dict[str, Port],
+    rtl_module: str,
+    rtl_args: List[str],
+    clock_period: Union[int, float, str],
+) -> Tuple[str, str]:
+  """Generate the module and the report of an RTL task.
+
+  Args:
+    name: Name of the task and the module.
+    ports: A dict mapping port names to Port objects of the task.
+    rtl_module: Name of the library function called by the task.
+    rtl_args: Names of the task ports passed to the library function.
+    clock_period: Target clock period, reported as the estimated one.
+
+  Raises:
+    ValueError: If the task cannot be implemented by a built-in mover.
+
+  Returns:
+    Verilog code of the module and XML code of the report.
+  """
+  roles = _get_roles(name, ports, rtl_module, rtl_args)
+  mem = roles['mmap'].name
+  count = roles['count']
+  stream = roles.get('istream', roles.get('ostream'))
+  is_read = rtl_module == 'mmap_to_stream'
+  mem_width = roles['mmap'].width
+  params = _get_params(mem_width, stream.width)
+  if not is_read:
+    params['MaxOutstanding'] = _MAX_OUTSTANDING
+    params['MaxOutstandingLog'] = int(math.log2(_MAX_OUTSTANDING))
+
+  # port declarations in the same style as HLS-generated modules
+  decls: List[Tuple[str, int, str]] = [
+      ('input', 1, 'ap_clk'),
+      ('input', 1, 'ap_rst_n'),
+      ('input', 1, 'ap_start'),
+      ('output', 1, 'ap_done'),
+      ('output', 1, 'ap_idle'),
+      ('output', 1, 'ap_ready'),
+  ]
+  for port in ports.values():
+    if port.cat.is_istream:
+      decls.append(('input', port.width + 1, f'{port.name}_dout'))
+      decls.append(('input', 1, f'{port.name}_empty_n'))
+      decls.append(('output', 1, f'{port.name}_read'))
+    elif port.cat.is_ostream:
+      decls.append(('output', port.width + 1, f'{port.name}_din'))
+      decls.append(('input', 1, f'{port.name}_full_n'))
+      decls.append(('output', 1, f'{port.name}_write'))
+    elif port.cat.is_sync_mmap:
+      for channel, axi_ports in M_AXI_PORTS.items():
+        for axi_port, direction in axi_ports:
+          decls.append((
+              direction,
+              _m_axi_port_width(axi_port, port.width),
+              f'{M_AXI_PREFIX}{port.name}_{channel}{axi_port}',
+          ))
+      decls.append(('input', _ADDR_WIDTH, f'{port.name}_offset'))
+    else:
+      decls.append(('input', port.width, port.name))
+
+  lines = [
+      f'// {name}: tapa::{rtl_module} implemented by {_MOVERS[rtl_module][1]}',
+      '`timescale 1 ns / 1 ps',
+      '',
+      f'module {name} (',
+      ',\n'.join(f'  {x[2]}' for x in decls),
+      ');',
+      '',
+  ]
+  lines.extend(
+      f'{direction} wire {_width(width)}{port};'
+      for direction, width, port in decls)
+
+  # tie off unused outputs, including the m_axi ports of other mmaps
+  used_channels = _READ_CHANNELS if is_read else _WRITE_CHANNELS
+  driven = {
+      'ARADDR', 'ARLEN', 'ARVALID', 'RREADY', 'AWADDR', 'AWLEN', 'AWVALID',
+      'WDATA', 'WSTRB', 'WLAST', 'WVALID', 'BREADY'
+  }
+  constants = {
+      'BURST': "2'b01",  # INCR
+      'SIZE': f"3'd{params['MemWidthBytesLog']}",
+      'CACHE': "4'b0011",  # modifiable, bufferable
+  }
+  lines.append('')
+  for port in ports.values():
+    if port.cat.is_sync_mmap:
+      for channel, axi_ports in M_AXI_PORTS.items():
+        for axi_port, direction in axi_ports:
+          if direction != 'output':
+            continue
+          is_used = port.name == mem and channel in used_channels
+          if is_used and channel + axi_port in driven:
+            continue
+          value = constants.get(axi_port, "1'b0") if is_used else "1'b0"
+          if not is_used and channel + axi_port in {'RREADY', 'BREADY'}:
+            value = "1'b1"
+          lines.append(
+              f'assign {M_AXI_PREFIX}{port.name}_{channel}{axi_port} = '
+              f'{value};')
+    elif port.cat.is_ostream and port is not stream:
+      lines.append(f"assign {port.name}_din = {port.width + 1}'d0;")
+      lines.append(f"assign {port.name}_write = 1'b0;")
+    elif port.cat.is_istream and port is not stream:
+      lines.append(f"assign {port.name}_read = 1'b0;")
+
+  # the mover accepts ap_start only when idle, which is when it is ready
+  if count.width < 64:
+    count_arg = f"{{{64 - count.width}'d0, {count.name}}}"
+  else:
+    count_arg = f'{count.name}[63:0]'
+  m_axi = f'{M_AXI_PREFIX}{mem}'
+  lines.extend([
+      '',
+      'wire mover_idle;',
+      '',
+      'assign ap_idle  = mover_idle;',
+      'assign ap_ready = ap_start && mover_idle;',
+  ])
+  if is_read:
+    lines.append(f"assign {stream.name}_din[{stream.width}] = 1'b0;")
+  lines.extend([
+      '',
+      f'{_MOVERS[rtl_module][1]} #(',
+      ',\n'.join(f'  .{k}({v})' for k, v in params.items()),
+      ') mover (',
+      '  .clk   (ap_clk),',
+      '  .rst   (!ap_rst_n),',
+      '  .start (ap_start),',
+      '  .idle  (mover_idle),',
+      '  .done  (ap_done),',
+      f'  .offset({mem}_offset),',
+      f'  .count ({count_arg}),',
+  ])
+  if is_read:
+    lines.extend([
+        f'  .m_axi_ARADDR ({m_axi}_ARADDR),',
+        f'  .m_axi_ARLEN  ({m_axi}_ARLEN),',
+        f'  .m_axi_ARVALID({m_axi}_ARVALID),',
+        f'  .m_axi_ARREADY({m_axi}_ARREADY),',
+        f'  .m_axi_RDATA  ({m_axi}_RDATA),',
+        f'  .m_axi_RVALID ({m_axi}_RVALID),',
+        f'  .m_axi_RREADY ({m_axi}_RREADY),',
+        f'  .data_din   ({stream.name}_din[{stream.width - 1}:0]),',
+        f'  .data_full_n({stream.name}_full_n),',
+        f'  .data_write ({stream.name}_write)',
+    ])
+  else:
+    lines.extend([
+        f'  .data_dout   ({stream.name}_dout[{stream.width - 1}:0]),',
+        f'  .data_empty_n({stream.name}_empty_n),',
+        f'  .data_read   ({stream.name}_read),',
+        f'  .m_axi_AWADDR ({m_axi}_AWADDR),',
+        f'  .m_axi_AWLEN  ({m_axi}_AWLEN),',
+        f'  .m_axi_AWVALID({m_axi}_AWVALID),',
+        f'  .m_axi_AWREADY({m_axi}_AWREADY),',
+        f'  .m_axi_WDATA  ({m_axi}_WDATA),',
+        f'  .m_axi_WSTRB  ({m_axi}_WSTRB),',
+        f'  .m_axi_WLAST  ({m_axi}_WLAST),',
+        f'  .m_axi_WVALID ({m_axi}_WVALID),',
+        f'  .m_axi_WREADY ({m_axi}_WREADY),',
+        f'  .m_axi_BVALID ({m_axi}_BVALID),',
+        f'  .m_axi_BREADY ({m_axi}_BREADY)',
+    ])
+  lines.extend([
+      ');',
+      '',
+      'endmodule',
+      '',
+  ])
+
+  area = _get_area(rtl_module, mem_width, stream.width, params)
+  return '\n'.join(lines), generate_report(name, area, clock_period)
@@ -0,0 +1,233 @@
+"""Generate RTL tasks that implement stream routing primitives.
+
+A task annotated with ``[[tapa::target("rtl", "xilinx")]]`` forwards its
+parameters to one of ``tapa::merge``, ``tapa::demux``, ``tapa::broadcast``,
+and ``tapa::butterfly``. Instead of synthesizing such a task with HLS, its
+module is a wrapper with the same interface as an HLS-generated module that
+instantiates the zero-latency primitive from the Verilog assets. The
+primitives never finish, so these tasks must be invoked with ``tapa::detach``.
+"""
+
+import math
+from typing import Dict, List, Tuple, Union
+
+from tapa.codegen.mover import generate_report
+from tapa.instance import Port
+
+__all__ = [
+    'PRIMITIVE_ASSETS',
+    'PRIMITIVES',
+    'generate_primitive',
+]
+
+PRIMITIVE_ASSETS = (
+    'stream_broadcast.v',
+    'stream_butterfly.v',
+    'stream_demux.v',
+    'stream_merge.v',
+)
+
+# {library function: (categories of its arguments, module name, is keyed)}
+_PRIMITIVES = {
+    'merge': (('istreams', 'ostream'), 'stream_merge', False),
+    'demux': (('istream', 'ostreams'), 'stream_demux', True),
+    'broadcast': (('istream', 'ostreams'), 'stream_broadcast', False),
+    'butterfly': (('istreams', 'ostreams'), 'stream_butterfly', True),
+}
+
+PRIMITIVES = frozenset(_PRIMITIVES)
+
+
+def _width(width: int) -> str:
+  return f'[{width - 1}:0] ' if width > 1 else ''
+
+
+def _get_lanes(
+    name: str,
+    ports: Dict[str, Port],
+    rtl_module: str,
+    rtl_args: List[str],
+) -> List[List[Port]]:
+  """Map each argument of the primitive to its task ports, one per lane."""
+  cats, _, _ = _PRIMITIVES[rtl_module]
+  if len(rtl_args) != len(cats):
+    raise ValueError(f'task {name} passes {len(rtl_args)} arguments to '
+                     f'{rtl_module}, expecting {len(cats)}')
+  args: List[List[Port]] = []
+  for cat, arg in zip(cats, rtl_args):
+    if cat.endswith('s'):
+      lanes = []
+      while f'{arg}_{len(lanes)}' in ports:
+        lanes.append(ports[f'{arg}_{len(lanes)}'])
+    else:
+      lanes = [ports[arg]] if arg in ports else []
+    is_input = cat.startswith('i')
+    if not lanes or not all(
+        (x.cat.is_istream if is_input else x.cat.is_ostream) for x in lanes):
+      raise ValueError(f'argument {arg} of {rtl_module} in task {name} '
+                       f'must be {cat}')
+    args.append(lanes)
+
+  for port in ports.values():
+    if not (port.cat.is_istream or port.cat.is_ostream or port.cat.is_scalar):
+      raise ValueError(f'port {port.name} of task {name} is not supported in '
+                       'rtl tasks')
+  return args
+
+
+def _get_area(
+    rtl_module: str,
+    n: int,
+    width: int,
+) -> Dict[str, int]:
+  """Estimate the area of a primitive, which is dominated by its muxes."""
+  stages = int(math.log2(n)) if n > 1 else 0
+  lut, ff = {
+      'merge': (n * (width + 1) // 2 + 4 * n, stages),
+      'demux': (2 * n, 0),
+      'broadcast': (n, 0),
+      'butterfly': (stages * n * (width + 9), stages * n // 2),
+  }[rtl_module]
+  return {'BRAM_18K': 0, 'DSP': 0, 'FF': ff + 1, 'LUT': lut + 2, 'URAM': 0}
+
+
+def generate_primitive(
+    name: str,
+    ports: Dict[str, Port],
+    rtl_module: str,
+    rtl_args: List[str],
+    rtl_template_args: List[int],
+    clock_period: Union[int, float, str],
+) -> Tuple[str, str]:
+  """Generate the module and the report of an RTL task.
+
+  Args:
+    name: Name of the task and the module.
+    ports: A dict mapping port names to Port objects of the task.
+    rtl_module: Name of the library function called by the task.
+    rtl_args: Names of the task ports passed to the library function.
+    rtl_template_args: Integral template arguments of the library function.
+    clock_period: Target clock period, reported as the estimated one.
+
+  Raises:
+    ValueError: If the task cannot be implemented by a built-in primitive.
+
+  Returns:
+    Verilog code of the module and XML code of the report.
+  """
+  _, module_name, is_keyed = _PRIMITIVES[rtl_module]
+  in_lanes, out_lanes = _get_lanes(name, ports, rtl_module, rtl_args)
+  width = in_lanes[0].width
+  if any(x.width != width for x in in_lanes + out_lanes):
+    raise ValueError(f'streams of {rtl_module} in task {name} must have the '
+                     'same width')
+  if len(in_lanes) > 1 and len(out_lanes) > 1 and \
+      len(in_lanes) != len(out_lanes):
+    raise ValueError(f'{rtl_module} in task {name} must have as many input '
+                     'streams as output streams')
+  n = max(len(in_lanes), len(out_lanes))
+  params = {'N': n, 'DataWidth': width}
+  if is_keyed:
+    key_lsb = rtl_template_args[0]
+    if n & (n - 1):
+      raise ValueError(f'{rtl_module} in task {name} must have a power of 2 '
+                       f'streams, got {n}')
+    if key_lsb < 0 or key_lsb + int(math.log2(n)) > width:
+      raise ValueError(f'key of {rtl_module} in task {name} is out of the '
+                       f'{width}-bit element')
+    params['KeyLsb'] = key_lsb
+
+  # port declarations in the same style as HLS-generated modules
+  decls: List[Tuple[str, int, str]] = [
+      ('input', 1, 'ap_clk'),
+      ('input', 1, 'ap_rst_n'),
+      ('input', 1, 'ap_start'),
+      ('output', 1, 'ap_done'),
+      ('output', 1, 'ap_idle'),
+      ('output', 1, 'ap_ready'),
+  ]
+  for port in ports.values():
+    if port.cat.is_istream:
+      decls.append(('input', port.width + 1, f'{port.name}_dout'))
+      decls.append(('input', 1, f'{port.name}_empty_n'))
+      decls.append(('output', 1, f'{port.name}_read'))
+    elif port.cat.is_ostream:
+      decls.append(('output', port.width + 1, f'{port.name}_din'))
+      decls.append(('input', 1, f'{port.name}_full_n'))
+      decls.append(('output', 1, f'{port.name}_write'))
+    else:
+      decls.append(('input', port.width, port.name))
+
+  lines = [
+      f'// {name}: tapa::{rtl_module} implemented by {module_name}',
+      '`timescale 1 ns / 1 ps',
+      '',
+      f'module {name} (',
+      ',\n'.join(f'  {x[2]}' for x in decls),
+      ');',
+      '',
+  ]
+  lines.extend(
+      f'{direction} wire {_width(width)}{port};'
+      for direction, width, port in decls)
+
+  # tie off streams not passed to the primitive
+  used = {x.name for x in in_lanes + out_lanes}
+  lines.append('')
+  for port in ports.values():
+    if port.name in used:
+      continue
+    if port.cat.is_ostream:
+      lines.append(f"assign {port.name}_din = {port.width + 1}'d0;")
+      lines.append(f"assign {port.name}_write = 1'b0;")
+    elif port.cat.is_istream:
+      lines.append(f"assign {port.name}_read = 1'b0;")
+
+  # the primitive runs forever once started; tokens are not moved before that
+  lines.extend([
+      '',
+      'reg running;',
+      '',
+      "assign ap_done  = 1'b0;",
+      'assign ap_idle  = !running;',
+      'assign ap_ready = ap_start;',
+      '',
+      'always @(posedge ap_clk) begin',
+      '  if (!ap_rst_n) begin',
+      "    running <= 1'b0;",
+      '  end else if (ap_start) begin',
+      "    running <= 1'b1;",
+      '  end',
+      'end',
+  ])
+
+  def concat(lanes: List[Port], suffix: str) -> str:
+    """Concatenate the signals of all lanes, lane 0 at the lowest bits."""
+    if len(lanes) == 1:
+      return f'{lanes[0].name}_{suffix}'
+    return '{' + ', '.join(f'{x.name}_{suffix}' for x in lanes[::-1]) + '}'
+
+  running = '{' + f'{len(in_lanes)}{{running}}' + '}'
+  if len(in_lanes) == 1:
+    running = 'running'
+  lines.extend([
+      '',
+      f'{module_name} #(',
+      ',\n'.join(f'  .{k}({v})' for k, v in params.items()),
+      ') router (',
+      '  .clk       (ap_clk),',
+      '  .rst       (!ap_rst_n),',
+      f'  .in_dout   ({concat(in_lanes, "dout")}),',
+      f'  .in_empty_n({concat(in_lanes, "empty_n")} & {running}),',
+      f'  .in_read   ({concat(in_lanes, "read")}),',
+      f'  .out_din   ({concat(out_lanes, "din")}),',
+      f'  .out_full_n({concat(out_lanes, "full_n")}),',
+      f'  .out_write ({concat(out_lanes, "write")})',
+      ');',
+      '',
+      'endmodule',
+      '',
+  ])
+
+  area = _get_area(rtl_module, n, width)
+  return '\n'.join(lines), generate_report(name, area, clock_period)
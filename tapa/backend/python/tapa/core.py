@@ -1,5 +1,7 @@
 import collections
 import decimal
+import hashlib
+import io
 import itertools
 import json
 import logging
@@ -20,11 +22,19 @@ import toposort
 import yaml
 from haoda.backend import xilinx as hls
 
-from tapa import util
+from tapa import jobserver, trace, util
 from tapa.codegen.axi_pipeline import get_axi_pipeline_wrapper
 from tapa.codegen.buffer import BufferConfig
 from tapa.codegen.buffergen import generate_buffer_from_config, index_generator
+from tapa.codegen.control_tree import (
+    ControlTree,
+    add_reduction,
+    get_instance_slots,
+)
 from tapa.codegen.duplicate_s_axi_control import duplicate_s_axi_ctrl
+from tapa.codegen.mover import MOVER_ASSETS, generate_mover
+from tapa.codegen.primitive import (PRIMITIVE_ASSETS, PRIMITIVES,
+                                    generate_primitive)
 from tapa.floorplan import (
     checkpoint_floorplan,
     generate_floorplan,
@@ -117,6 +127,9 @@ class Program:
       self.buffer_configs_names_to_hashes[buffer_name] = buffer_hash
       self.buffer_configs_hashes_to_names[buffer_hash] = buffer_name
     self.tasks_to_recompile = {}
+    self.async_mmap_write_combine = 0
+    self.async_mmap_prefetch_args: List[str] = []
+    self.async_mmap_prefetch_depth = 0
 
     self.frt_interface = obj['tasks'][self.top].get('frt_interface')
     self.files: Dict[str, str] = {}
@@ -184,6 +197,20 @@ class Program:
                         (util.get_module_name(name) if prefix else name) +
                         rtl.RTL_SUFFIX)
 
+  def get_rtl_hash(self, name: str) -> str:
+    """Hash of the HLS-generated RTL of a task and its subtasks."""
+    hasher = hashlib.sha256()
+    # only hash the file contents; the reports and tar headers have timestamps
+    with tarfile.open(self.get_tar(name), 'r') as tarfileobj:
+      for member in sorted(tarfileobj.getmembers(), key=lambda x: x.name):
+        if member.isfile() and member.name.startswith('hdl/'):
+          hasher.update(member.name.encode())
+          hasher.update(tarfileobj.extractfile(member).read())
+    subtask_names = {x.task.name for x in self.get_task(name).instances}
+    for subtask_name in sorted(subtask_names):
+      hasher.update(self.get_rtl_hash(subtask_name).encode())
+    return hasher.hexdigest()
+
   def get_post_syn_rpt(self, module_name: str) -> str:
     return f'{self.work_dir}/report/{module_name}.hier.util.rpt'
 
@@ -219,6 +246,7 @@ class Program:
         header_fp.write(content)
     return self
 
+  @trace.traced('step')
   def run_hls(
       self,
       clock_period: Union[int, float, str],
@@ -231,6 +259,9 @@ class Program:
     _logger.info('running HLS')
 
     def worker(task: Task, idx: int) -> None:
+      if task.is_rtl:
+        self._generate_rtl_task_tar(task, clock_period)
+        return
       os.nice(idx % 19)
       hls_cflags = ' '.join((
           self.cflags,
@@ -239,18 +270,21 @@ class Program:
           '-DTAPA_TARGET_=XILINX_HLS',
       ))
       with open(self.get_tar(task.name), 'wb') as tarfileobj:
-        with hls.RunHls(
-            tarfileobj,
-            kernel_files=[(self.get_cpp(task.name), hls_cflags)],
-            top_name=task.name,
-            clock_period=clock_period,
-            part_num=part_num,
-            auto_prefix=True,
-            hls='vitis_hls',
-            std='c++17',
-            other_configs=other_configs,
-        ) as proc:
+        with jobserver.job(), trace.span(
+            task.name, cat='hls') as span, hls.RunHls(
+                tarfileobj,
+                kernel_files=[(self.get_cpp(task.name), hls_cflags)],
+                top_name=task.name,
+                clock_period=clock_period,
+                part_num=part_num,
+                auto_prefix=True,
+                hls='vitis_hls',
+                std='c++17',
+                other_configs=other_configs,
+            ) as proc:
+          span.track(proc)
           stdout, stderr = proc.communicate()
+          span.args['returncode'] = proc.returncode
       if proc.returncode != 0:
         if b'Pre-synthesis failed.' in stdout and b'\nERROR:' not in stdout:
           _logger.error(
@@ -273,6 +307,41 @@ class Program:
 
     return self
 
+  def _generate_rtl_task_tar(
+      self,
+      task: Task,
+      clock_period: Union[int, float, str],
+  ) -> None:
+    """Generate the tarball of an RTL task in the same layout as HLS."""
+    _logger.info('using the built-in RTL of %s for %s', task.rtl_module,
+                 task.name)
+    if task.rtl_module in PRIMITIVES:
+      code, report = generate_primitive(
+          name=task.name,
+          ports=task.ports,
+          rtl_module=task.rtl_module,
+          rtl_args=task.rtl_args,
+          rtl_template_args=task.rtl_template_args,
+          clock_period=clock_period,
+      )
+    else:
+      code, report = generate_mover(
+          name=task.name,
+          ports=task.ports,
+          rtl_module=task.rtl_module,
+          rtl_args=task.rtl_args,
+          clock_period=clock_period,
+      )
+    with tarfile.open(self.get_tar(task.name), 'w') as tarfileobj:
+      for name, content in (
+          (f'hdl/{util.get_module_name(task.name)}{rtl.RTL_SUFFIX}', code),
+          (f'report/{task.name}_csynth.xml', report),
+      ):
+        data = content.encode()
+        info = tarfile.TarInfo(name)
+        info.size = len(data)
+        tarfileobj.addfile(info, io.BytesIO(data))
+
   def find_buffer_user(self, task: Task, buffer_name: str,
                        direction: str) -> Tuple[Task, str]:
     if task.level == Task.Level.LOWER:
@@ -285,6 +354,7 @@ class Program:
                                      direction)
     raise ValueError("Buffer never used")
 
+  @trace.traced('step')
   def generate_task_rtl(
       self,
       additional_fifo_pipelining: bool = False,
@@ -322,9 +392,13 @@ class Program:
         'generate_last.v',
         'priority_encoder.v',
         'relay_station.v',
+        'stride_prefetch.v',
+        'write_combine.v',
         'a_axi_write_broadcastor_1_to_3.v',
         'a_axi_write_broadcastor_1_to_4.v',
         'a_axi_write_broadcastor_1_to_2.v',
+        *MOVER_ASSETS,
+        *PRIMITIVE_ASSETS,
     ):
       shutil.copy(
           os.path.join(os.path.dirname(util.__file__), 'assets', 'verilog',
@@ -409,6 +483,7 @@ class Program:
 
     return self
 
+  @trace.traced('step')
   def generate_post_synth_task_area(
       self,
       part_num: str,
@@ -424,6 +499,7 @@ class Program:
         max_parallel_synth_jobs,
     )
 
+  @trace.traced('step')
   def run_floorplanning(
       self,
       part_num,
@@ -432,6 +508,7 @@ class Program:
       read_only_args: List[str] = [],
       write_only_args: List[str] = [],
       separate_complex_buffer_tasks: bool = False,
+      eco_floorplan: bool = False,
       **kwargs,
   ) -> 'Program':
     _logger.info('Running floorplanning')
@@ -448,7 +525,9 @@ class Program:
         autobridge_dir=self.autobridge_dir,
         top_task=self.top_task,
         fifo_width_getter=self._get_fifo_width,
+        rtl_hash_getter=self.get_rtl_hash,
         separate_complex_buffer_tasks=separate_complex_buffer_tasks,
+        eco=eco_floorplan,
         **kwargs,
     )
 
@@ -465,9 +544,18 @@ class Program:
 
     return self
 
-  def generate_top_rtl(self, constraint: TextIO, register_level: int,
-                       additional_fifo_pipelining: bool, device_info: Dict,
-                       other_hls_config: str) -> 'Program':
+  @trace.traced('step')
+  def generate_top_rtl(
+      self,
+      constraint: TextIO,
+      register_level: int,
+      additional_fifo_pipelining: bool,
+      device_info: Dict,
+      other_hls_config: str,
+      async_mmap_write_combine: int = 0,
+      async_mmap_prefetch_args: Optional[List[str]] = None,
+      async_mmap_prefetch_depth: int = 16,
+  ) -> 'Program':
     """Instrument HDL files generated from HLS.
 
     Args:
@@ -475,6 +563,11 @@ class Program:
         register_level: Non-zero value overrides self.register_level.
         part_num: optinally provide the part_num to enable board-specific optimization
         additional_fifo_pipelining: replace every FIFO by a relay_station of LEVEL 2
+        async_mmap_write_combine: number of lines of the write combiner in
+            each async_mmap; 0 disables write combining
+        async_mmap_prefetch_args: regular expressions of the async_mmap
+            arguments whose reads are prefetched
+        async_mmap_prefetch_depth: number of reads prefetched ahead
 
     Returns:
         Program: Return self.
@@ -531,6 +624,10 @@ class Program:
     _logger.info('top task register level set to %d',
                  self.top_task.module.register_level)
 
+    self.async_mmap_write_combine = async_mmap_write_combine
+    self.async_mmap_prefetch_args = async_mmap_prefetch_args or []
+    self.async_mmap_prefetch_depth = async_mmap_prefetch_depth
+
     # instrument the top-level RTL
     _logger.info('instrumenting top-level RTL')
     self._instrument_top_task(self.top_task, part_num, task_inst_to_slr,
@@ -551,6 +648,7 @@ class Program:
 
     return self
 
+  @trace.traced('step')
   def pack_rtl(self, output_file: BinaryIO) -> 'Program':
     _logger.info('packaging RTL code')
     rtl.pack(top_name=self.top,
@@ -716,11 +814,18 @@ class Program:
       width_table: Dict[str, int],
       part_num: str,
       instance_name_to_slr: Dict[str, int],
-  ) -> List[ast.Identifier]:
-    is_done_signals: List[rtl.Pipeline] = []
+  ) -> Dict[str, List[rtl.Pipeline]]:
+    is_done_signals: Dict[str, List[rtl.Pipeline]] = collections.OrderedDict()
     arg_table: Dict[str, rtl.Pipeline] = {}
     async_mmap_args: Dict[Instance.Arg, List[str]] = collections.OrderedDict()
 
+    # broadcast signals reach instances via slot-local copies
+    tree = ControlTree(task.module)
+    instance_slots = get_instance_slots(
+        (instance.name for instance in task.instances),
+        instance_name_to_slr,
+    )
+
     task.add_m_axi(width_table, self.files)
 
     # now that each SLR has an control_s_axi, slightly reduce the
@@ -736,6 +841,7 @@ class Program:
         argname_suffix = f'_slr_{instance_name_to_slr[instance.name]}'
       else:
         argname_suffix = ''
+      slot = instance_slots[instance.name]
 
       child_port_set = set(instance.task.module.ports)
 
@@ -747,19 +853,25 @@ class Program:
             width = width_table.get(arg.name, 0)
             if width == 0:
               width = int(arg.name.split("'d")[0])
-          q = rtl.Pipeline(
-              name=instance.get_instance_arg(arg.name),
-              level=scalar_register_level,
-              width=width,
-          )
-          arg_table[arg.name] = q
 
           # arg.name may be a constant
           if arg.name in width_table:
-            id_name = arg.name + argname_suffix
+            q = tree.add_leaf(
+                name=instance.get_instance_arg(arg.name),
+                trunk_name=arg.name,
+                slot=slot,
+                level=scalar_register_level,
+                init=ast.Identifier(arg.name + argname_suffix),
+                width=width,
+            )
           else:
-            id_name = arg.name
-          task.module.add_pipeline(q, init=ast.Identifier(id_name))
+            q = rtl.Pipeline(
+                name=instance.get_instance_arg(arg.name),
+                level=scalar_register_level,
+                width=width,
+            )
+            task.module.add_pipeline(q, init=ast.Identifier(arg.name))
+          arg_table[arg.name] = q
 
         # arg.name is the upper-level name
         # arg.port is the lower-level name
@@ -793,15 +905,22 @@ class Program:
                 ))
 
       # add reset registers
-      rst_q = rtl.Pipeline(instance.rst_n, level=self.register_level)
-      task.module.add_pipeline(rst_q, init=rtl.RST_N)
+      rst_q = tree.add_leaf(
+          name=instance.rst_n,
+          trunk_name=rtl.RST_N.name,
+          slot=slot,
+          level=self.register_level,
+          init=rtl.RST_N,
+      )
 
       # add start registers
-      start_q = rtl.Pipeline(
-          f'{instance.start.name}_global',
+      start_q = tree.add_leaf(
+          name=f'{instance.start.name}_global',
+          trunk_name=f'{rtl.START.name}_global',
+          slot=slot,
           level=self.register_level,
+          init=self.start_q[0],
       )
-      task.module.add_pipeline(start_q, self.start_q[0])
 
       if instance.is_autorun:
         # autorun modules start when the global start signal is asserted
@@ -826,17 +945,20 @@ class Program:
             ),
         ])
       else:
-        # set up state
+        # set up state; is_done is reduced per slot in the global FSM, which
+        # adds one more stage
         is_done_q = rtl.Pipeline(
             f'{instance.is_done.name}',
-            level=self.register_level,
+            level=max(self.register_level - 1, 0),
         )
-        done_q = rtl.Pipeline(
-            f'{instance.done.name}_global',
+        task.module.add_pipeline(is_done_q, instance.is_state(STATE10))
+        done_q = tree.add_leaf(
+            name=f'{instance.done.name}_global',
+            trunk_name=f'{rtl.DONE.name}_global',
+            slot=slot,
             level=self.register_level,
+            init=self.done_q[0],
         )
-        task.module.add_pipeline(is_done_q, instance.is_state(STATE10))
-        task.module.add_pipeline(done_q, self.done_q[0])
 
         if_branch = (instance.set_state(STATE00))
         else_branch = ((
@@ -888,7 +1010,7 @@ class Program:
             ),
         ])
 
-        is_done_signals.append(is_done_q)
+        is_done_signals.setdefault(slot, []).append(is_done_q)
 
       # insert handshake signals
       task.module.add_signals(instance.handshake_signals)
@@ -959,12 +1081,18 @@ class Program:
 
     if task.is_upper:
       for arg in async_mmap_args:
+        prefetch_depth = 0
+        if any(re.match(x, arg.name) for x in self.async_mmap_prefetch_args):
+          _logger.info('prefetching reads of %s', arg.name)
+          prefetch_depth = self.async_mmap_prefetch_depth
         task.module.add_async_mmap_instance(
             name=arg.mmap_name,
             offset_name=arg_table[arg.name][-1],
             tags=async_mmap_args[arg],
             data_width=width_table[arg.name],
             addr_width=addr_width,
+            write_combine_capacity=self.async_mmap_write_combine,
+            prefetch_depth=prefetch_depth,
         )
 
     return is_done_signals
@@ -972,10 +1100,22 @@ class Program:
   def _instantiate_global_fsm(
       self,
       task: Task,
-      is_done_signals: List[rtl.Pipeline],
+      is_done_signals: Dict[str, List[rtl.Pipeline]],
   ) -> None:
     # global state machine
 
+    # collect is_done of each slot first so that the final AND has a small
+    # fan-in; instances shorten their is_done pipelines by this stage so that
+    # the latency of ap_done stays the same
+    slot_is_done = add_reduction(
+        task.module,
+        'is_done',
+        {
+            slot: [x[-1] for x in reversed(signals)]
+            for slot, signals in is_done_signals.items()
+        },
+    )
+
     def is_state(state: ast.IntConst) -> ast.Eq:
       return ast.Eq(left=rtl.STATE, right=state)
 
@@ -991,11 +1131,11 @@ class Program:
     ])
 
     state01_action = set_state(STATE10)
-    if is_done_signals:
+    if slot_is_done:
       state01_action = ast.make_if_with_block(
           cond=ast.make_operation(
               operator=ast.Land,
-              nodes=(x[-1] for x in reversed(is_done_signals)),
+              nodes=(x[-1] for x in reversed(slot_is_done)),
           ),
           true=state01_action,
       )
@@ -1149,6 +1289,7 @@ class Program:
     # TODO: err properly if not integer literals
     return int(port.width.msb.value) - int(port.width.lsb.value) + 1
 
+  @trace.traced('step')
   def recompile_buffer_producers(self, device_config,
                                  other_hls_configs) -> None:
     top_task = self.top_task
@@ -1217,18 +1358,21 @@ class Program:
           '-DTAPA_TARGET_=XILINX_HLS',
       ))
       with open(self.get_tar(task_name), 'wb') as tarfileobj:
-        with hls.RunHls(
-            tarfileobj,
-            kernel_files=[(self.get_cpp(task_name), hls_cflags)],
-            top_name=task_name,
-            clock_period=device_config['clock_period'],
-            part_num=device_config['part_num'],
-            auto_prefix=True,
-            hls='vitis_hls',
-            std='c++17',
-            other_configs=other_hls_configs,
-        ) as proc:
+        with jobserver.job(), trace.span(
+            task_name, cat='hls') as span, hls.RunHls(
+                tarfileobj,
+                kernel_files=[(self.get_cpp(task_name), hls_cflags)],
+                top_name=task_name,
+                clock_period=device_config['clock_period'],
+                part_num=device_config['part_num'],
+                auto_prefix=True,
+                hls='vitis_hls',
+                std='c++17',
+                other_configs=other_hls_configs,
+            ) as proc:
+          span.track(proc)
           stdout, stderr = proc.communicate()
+          span.args['returncode'] = proc.returncode
       if proc.returncode != 0:
         if b'Pre-synthesis failed.' in stdout and b'\nERROR:' not in stdout:
           _logger.error(
@@ -1,3 +1,4 @@
+import copy
 import itertools
 import json
 import logging
@@ -11,7 +12,7 @@ from typing import Callable, Dict, List, Optional, TextIO, Tuple
 from autobridge.main import annotate_floorplan
 from haoda.report.xilinx import rtl as report
 
-from tapa import util
+from tapa import jobserver, trace, util
 from tapa.hardware import (
     get_ctrl_instance_region,
     get_port_region,
@@ -69,12 +70,15 @@ def generate_floorplan(
     autobridge_dir: str,
     top_task: Task,
     fifo_width_getter: Callable[[Task, str], int],
+    rtl_hash_getter: Callable[[str], str],
     separate_complex_buffer_tasks: bool,
+    eco: bool = False,
     **kwargs,
 ) -> Tuple[Dict, Dict]:
   """
   get the target region of each vertex
   get the pipeline level of each edge
+  in ECO mode, tasks with unchanged RTL stay in their previous regions
   """
   config = get_floorplan_config(
       autobridge_dir,
@@ -82,6 +86,7 @@ def generate_floorplan(
       physical_connectivity,
       top_task,
       fifo_width_getter,
+      rtl_hash_getter,
       user_floorplan_pre_assignments,
       read_only_args,
       write_only_args,
@@ -89,11 +94,132 @@ def generate_floorplan(
       **kwargs,
   )
 
-  config_with_floorplan = annotate_floorplan(config)
+  prev_config = load_prev_floorplan(autobridge_dir) if eco else None
+  if prev_config is not None:
+    pinned = get_eco_pre_assignments(config, prev_config)
+    eco_config = copy.deepcopy(config)
+    for v_name, region in pinned.items():
+      eco_config['floorplan_pre_assignments'].setdefault(region,
+                                                         []).append(v_name)
+    config_with_floorplan = _annotate_floorplan(eco_config, pinned=len(pinned))
+    if config_with_floorplan.get('floorplan_status') == 'FAILED':
+      _logger.warning('ECO floorplanning failed with %d pinned tasks; '
+                      'floorplan all tasks again', len(pinned))
+      config_with_floorplan = _annotate_floorplan(config)
+    else:
+      config_with_floorplan['eco'] = get_eco_summary(prev_config,
+                                                     config_with_floorplan,
+                                                     pinned)
+  else:
+    config_with_floorplan = _annotate_floorplan(config)
 
   return config, config_with_floorplan
 
 
+def _annotate_floorplan(config: Dict, **args) -> Dict:
+  """Runs the ILP-based floorplanning of AutoBridge in a trace span."""
+  with trace.span('floorplan',
+                  cat='ilp',
+                  strategy=config.get('floorplan_strategy'),
+                  **args) as span:
+    config_with_floorplan = annotate_floorplan(config)
+    span.args['status'] = config_with_floorplan.get('floorplan_status')
+  return config_with_floorplan
+
+
+def load_prev_floorplan(autobridge_dir: str) -> Optional[Dict]:
+  """Load the floorplan of the previous run for ECO floorplanning."""
+  path = f'{autobridge_dir}/post-floorplan-config.json'
+  try:
+    with open(path) as fp:
+      prev_config = json.load(fp)
+  except (OSError, ValueError):
+    _logger.warning('no previous floorplan at %s; ECO mode is ignored', path)
+    return None
+
+  if prev_config.get('floorplan_status') != 'SUCCEED':
+    _logger.warning('previous floorplan failed; ECO mode is ignored')
+    return None
+  return prev_config
+
+
+def get_eco_pre_assignments(config: Dict, prev_config: Dict) -> Dict[str, str]:
+  """Pin the tasks whose RTL is unchanged to their previous regions.
+
+  Changed and new tasks are left to the floorplanner. If tasks grouped to the
+  same slot were placed apart before, e.g., because the grouping is new, the
+  whole group is left to the floorplanner.
+
+  Returns:
+      Dict mapping vertex names to regions.
+  """
+  for param in ('part_num', 'floorplan_strategy'):
+    if prev_config.get(param) != config.get(param):
+      _logger.warning('%s differs from the previous floorplan; '
+                      'ECO mode is ignored', param)
+      return {}
+
+  pre_assigned = {
+      v_name for v_names in config['floorplan_pre_assignments'].values()
+      for v_name in v_names
+  }
+
+  pinned = {}
+  for v_name, props in config['vertices'].items():
+    if props['category'] != 'TASK_VERTEX' or v_name in pre_assigned:
+      continue
+    prev_props = prev_config['vertices'].get(v_name, {})
+    if ('floorplan_region' in prev_props and
+        prev_props.get('rtl_hash') == props['rtl_hash']):
+      pinned[v_name] = prev_props['floorplan_region']
+
+  for grouping in config['grouping_constraints']:
+    if len({pinned.get(v_name) for v_name in grouping}) > 1:
+      for v_name in grouping:
+        pinned.pop(v_name, None)
+
+  _logger.info('ECO floorplanning: %d tasks are pinned, %d are re-placed',
+               len(pinned),
+               sum(props['category'] == 'TASK_VERTEX'
+                   for props in config['vertices'].values()) - len(pinned))
+  return pinned
+
+
+def get_eco_summary(
+    prev_config: Dict,
+    config_with_floorplan: Dict,
+    pinned: Dict[str, str],
+) -> Dict[str, List[str]]:
+  """Summarize which tasks and regions an ECO floorplan changed."""
+
+  def get_region_to_vertices(config: Dict) -> Dict[str, List[str]]:
+    region_to_vertices = defaultdict(list)
+    for v_name, props in config['vertices'].items():
+      if 'floorplan_region' in props:
+        region_to_vertices[props['floorplan_region']].append(v_name)
+    return {k: sorted(v) for k, v in region_to_vertices.items()}
+
+  prev_regions = get_region_to_vertices(prev_config)
+  curr_regions = get_region_to_vertices(config_with_floorplan)
+  changed_regions = sorted(
+      region for region in prev_regions.keys() | curr_regions.keys()
+      if prev_regions.get(region) != curr_regions.get(region))
+  for region in changed_regions:
+    _logger.info('ECO floorplanning changed region %s', region)
+
+  return {
+      'pinned_vertices':
+          sorted(pinned),
+      'replaced_vertices':
+          sorted(v_name for v_name, props in
+                 config_with_floorplan['vertices'].items()
+                 if props['category'] == 'TASK_VERTEX' and
+                 v_name not in pinned),
+      'changed_regions':
+          changed_regions,
+  }
+
+
 def get_floorplan_result(
     autobridge_dir: str,
     constraint: TextIO,
@@ -151,28 +277,53 @@ def extract_task_locations(config_with_floorplan) -> Dict[str, int]:
   return task_inst_to_slr
 
 
+def get_pipeline_regions(properties) -> List[str]:
+  """Get the region of each pipeline stage of a routed edge.
+
+  Each hop of the routed path that passes a congested SLR crossing gets one
+  more stage in the region before the crossing, so that the SLL wires are
+  registered on both sides.
+
+  Args:
+      properties: Properties of the edge in the post-floorplan config.
+
+  Returns:
+      List[str]: Region of each pipeline stage.
+  """
+  congested_crossings = set(properties.get('congested_crossings', ()))
+  regions = []
+  for i, region in enumerate(properties['path']):
+    regions.append(region)
+    if i in congested_crossings:
+      regions.append(region)
+  return regions
+
+
 def extract_pipeline_level(
     config_with_floorplan,) -> Tuple[Dict[str, str], Dict[str, int]]:
   """ extract the pipeline level of fifos and axi edges """
   if config_with_floorplan.get('floorplan_status') == 'FAILED':
     return {}, {}, {}
 
+  # the routes of the global router decide the pipeline levels
   fifo_pipeline_level = {}
   for edge, properties in config_with_floorplan['edges'].items():
     if properties['category'] == 'FIFO_EDGE':
-      fifo_pipeline_level[properties['instance']] = len(properties['path'])
+      fifo_pipeline_level[properties['instance']] = len(
+          get_pipeline_regions(properties))
 
   buffer_pipeline_level = {}
   for edge, properties in config_with_floorplan['edges'].items():
     if properties['category'] == 'BUFFER_EDGE':
-      buffer_pipeline_level[properties['instance']] = len(properties['path'])
+      buffer_pipeline_level[properties['instance']] = len(
+          get_pipeline_regions(properties))
 
   axi_pipeline_level = {}
   for edge, properties in config_with_floorplan['edges'].items():
     if properties['category'] == 'AXI_EDGE':
       # if the AXI module is at the same region as the external port, then no pipelining
       # sync with get_vivado_tcl
-      level = len(properties['path']) - 1
+      level = len(get_pipeline_regions(properties)) - 1
 
       axi_pipeline_level[properties['port_name']] = level
 
@@ -186,7 +337,7 @@ def _get_axi_pipeline_tcl(config_with_floorplan) -> List[str]:
   for edge, properties in config_with_floorplan['edges'].items():
     if properties['category'] == 'AXI_EDGE':
       port_name = properties['port_name']
-      path = properties['path']
+      path = get_pipeline_regions(properties)
       pipeline_level = len(path) - 1  # sync with extract_pipeline_level
 
       if pipeline_level:
@@ -263,7 +414,7 @@ def get_vivado_tcl(config_with_floorplan):
   for edge, properties in config_with_floorplan['edges'].items():
     if properties['category'] == 'FIFO_EDGE':
       fifo_name = properties['instance']
-      path = properties['path']
+      path = get_pipeline_regions(properties)
       if len(path) > 1:
         for i in range(len(path)):
           region_to_inst[path[i]].append(f'{fifo_name}/inst\\\\[{i}]\\\\.unit')
@@ -271,7 +422,7 @@ def get_vivado_tcl(config_with_floorplan):
         region_to_inst[path[0]].append(f'{fifo_name}/.*.unit')
     elif properties['category'] == "BUFFER_EDGE":
       buffer_name = properties['instance']
-      path = properties['path']
+      path = get_pipeline_regions(properties)
       if len(path) > 1:
         for i in range(len(path)):
           region_to_inst[path[i]].append(
@@ -375,6 +526,7 @@ def get_floorplan_config(
     physical_connectivity: TextIO,
     top_task: Task,
     fifo_width_getter: Callable[[Task, str], int],
+    rtl_hash_getter: Callable[[str], str],
     user_floorplan_pre_assignments: Optional[TextIO],
     read_only_args: List[str],
     write_only_args: List[str],
@@ -391,6 +543,10 @@ def get_floorplan_config(
   edges = get_edges(top_task, fifo_width_getter, read_only_args,
                     write_only_args)
   vertices = get_vertices(top_task, arg_name_to_external_port)
+  # used by ECO floorplanning to find the unchanged tasks
+  for properties in vertices.values():
+    if properties['category'] == 'TASK_VERTEX':
+      properties['rtl_hash'] = rtl_hash_getter(properties['module'])
   floorplan_pre_assignments = get_floorplan_pre_assignments(
       part_num,
       user_floorplan_pre_assignments,
@@ -483,27 +639,35 @@ def get_post_synth_area(
     if os.path.isfile(rpt_path):
       rpt_path_mtime = os.path.getmtime(rpt_path)
 
-    # generate report if and only if C++ source is newer than report.
-    if os.path.getmtime(cpp_getter(module_name)) > rpt_path_mtime:
-      os.nice(idx % 19)
-      with report.ReportDirUtil(
-          rtl_dir,
-          rpt_path,
-          module_name,
-          part_num,
-          synth_kwargs={'mode': 'out_of_context'},
-      ) as proc:
-        stdout, stderr = proc.communicate()
-
-      # err if output report does not exist or is not newer than previous
-      if (not os.path.isfile(rpt_path) or
-          os.path.getmtime(rpt_path) <= rpt_path_mtime):
-        sys.stdout.write(stdout.decode('utf-8'))
-        sys.stderr.write(stderr.decode('utf-8'))
-        raise InputError(f'failed to generate report for {module_name}')
-
-    with open(rpt_path) as rpt_file:
-      return report.parse_hierarchical_utilization_report(rpt_file)
+    with trace.span(module_name, cat='synth') as span:
+      # generate report if and only if C++ source is newer than report.
+      span.args['cached'] = (os.path.getmtime(cpp_getter(module_name)) <=
+                             rpt_path_mtime)
+      if not span.args['cached']:
+        os.nice(idx % 19)
+        with jobserver.job(), report.ReportDirUtil(
+            rtl_dir,
+            rpt_path,
+            module_name,
+            part_num,
+            synth_kwargs={'mode': 'out_of_context'},
+        ) as proc:
+          span.track(proc)
+          stdout, stderr = proc.communicate()
+
+        # err if output report does not exist or is not newer than previous
+        if (not os.path.isfile(rpt_path) or
+            os.path.getmtime(rpt_path) <= rpt_path_mtime):
+          sys.stdout.write(stdout.decode('utf-8'))
+          sys.stderr.write(stderr.decode('utf-8'))
+          raise InputError(f'failed to generate report for {module_name}')
+
+      with open(rpt_path) as rpt_file:
+        utilization = report.parse_hierarchical_utilization_report(rpt_file)
+      for resource in ('Total LUTs', 'FFs', 'RAMB36', 'RAMB18', 'URAM',
+                       'DSP Blocks'):
+        span.args[resource] = utilization[resource]
+      return utilization
 
   _logger.info('generating post-synthesis resource utilization reports')
   _logger.info(
@@ -0,0 +1,150 @@
+"""Client of the GNU make jobserver protocol.
+
+Vendor tools, e.g., HLS and logic synthesis, are run as jobs that each hold
+one token of the jobserver. If tapa is run by GNU make, e.g., when several
+kernels are built by CMake in parallel, the tokens are shared with make so that
+all kernels share the concurrency budget given by `make -j`. Otherwise, a
+standalone jobserver with `nproc` tokens is created and advertised to
+subprocesses in MAKEFLAGS.
+
+See https://www.gnu.org/software/make/manual/html_node/Job-Slots.html.
+"""
+
+import atexit
+import contextlib
+import logging
+import os
+import re
+import select
+import shutil
+import tempfile
+import threading
+from typing import Iterator, Optional, Tuple
+
+from tapa import trace, util
+
+__all__ = [
+    'Jobserver',
+    'job',
+]
+
+_logger = logging.getLogger().getChild(__name__)
+
+
+class Jobserver:
+  """Job slots shared with GNU make or other jobserver clients.
+
+  Each process implicitly owns one slot, which is used before reading tokens
+  from the jobserver.
+  """
+
+  def __init__(self, makeflags: Optional[str] = None) -> None:
+    self._lock = threading.Lock()
+    self._is_implicit_slot_free = True
+
+    if makeflags is None:
+      makeflags = os.environ.get('MAKEFLAGS', '')
+    fds = self._open_from_makeflags(makeflags)
+    if fds is None:
+      fds = self._create_standalone(util.nproc())
+    self._read_fd, self._write_fd = fds
+
+  @contextlib.contextmanager
+  def job(self) -> Iterator[None]:
+    """Holds one job slot in the context."""
+    with trace.span('wait for job slot', cat='jobserver'):
+      token = self._acquire()
+    try:
+      yield
+    finally:
+      self._release(token)
+
+  def _acquire(self) -> Optional[bytes]:
+    with self._lock:
+      if self._is_implicit_slot_free:
+        self._is_implicit_slot_free = False
+        return None
+    # The read end may be non-blocking, and other processes may take the token
+    # between `select` and `read`.
+    while True:
+      select.select([self._read_fd], [], [])
+      try:
+        token = os.read(self._read_fd, 1)
+      except (BlockingIOError, InterruptedError):
+        continue
+      if token:
+        return token
+
+  def _release(self, token: Optional[bytes]) -> None:
+    if token is None:
+      with self._lock:
+        self._is_implicit_slot_free = True
+    else:
+      os.write(self._write_fd, token)
+
+  @staticmethod
+  def _open_from_makeflags(makeflags: str) -> Optional[Tuple[int, int]]:
+    # Only the last jobserver option is effective if there are several.
+    matches = re.findall(r'--jobserver-(?:auth|fds)=(\S+)', makeflags)
+    if not matches:
+      return None
+    auth = matches[-1]
+
+    if auth.startswith('fifo:'):
+      path = auth[len('fifo:'):]
+      try:
+        fd = os.open(path, os.O_RDWR)
+      except OSError as e:
+        _logger.warning('cannot open jobserver fifo %s: %s', path, e)
+        return None
+      _logger.info('using jobserver fifo %s from make', path)
+      return fd, fd
+
+    match = re.fullmatch(r'(\d+),(\d+)', auth)
+    if match is None:
+      _logger.warning('unrecognized jobserver in MAKEFLAGS: %s', auth)
+      return None
+    read_fd, write_fd = map(int, match.groups())
+    try:
+      os.fstat(read_fd)
+      os.fstat(write_fd)
+    except OSError:
+      # make closes the pipe for recipes not marked as recursive
+      _logger.warning(
+          'jobserver pipe (%d,%d) from make is not available; prefix the '
+          'recipe with `+` to share job slots with make', read_fd, write_fd)
+      return None
+    _logger.info('using jobserver pipe (%d,%d) from make', read_fd, write_fd)
+    return read_fd, write_fd
+
+  @staticmethod
+  def _create_standalone(job_count: int) -> Tuple[int, int]:
+    # A named fifo lets subprocesses join without inheriting file descriptors.
+    fifo_dir = tempfile.mkdtemp(prefix='tapa-jobserver-')
+    atexit.register(shutil.rmtree, fifo_dir, ignore_errors=True)
+    path = os.path.join(fifo_dir, 'fifo')
+    os.mkfifo(path, 0o600)
+    fd = os.open(path, os.O_RDWR)
+    os.write(fd, b'+' * (job_count - 1))
+    os.environ['MAKEFLAGS'] = ' '.join(
+        x for x in (os.environ.get('MAKEFLAGS', ''), f'-j{job_count}',
+                    f'--jobserver-auth=fifo:{path}') if x)
+    _logger.info('created standalone jobserver with %d job slots', job_count)
+    return fd, fd
+
+
+_jobserver: Optional[Jobserver] = None
+_jobserver_lock = threading.Lock()
+
+
+def job() -> 'contextlib.AbstractContextManager[None]':
+  """Holds one slot of the process-wide jobserver in the context.
+
+  Returns:
+      Context manager that acquires a slot on entry and releases it on exit.
+  """
+  global _jobserver
+  with _jobserver_lock:
+    if _jobserver is None:
+      _jobserver = Jobserver()
+  return _jobserver.job()
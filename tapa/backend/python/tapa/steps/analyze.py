@@ -12,6 +12,7 @@ import click
 import tapa
 import tapa.core
 import tapa.steps.common
+import tapa.trace
 import tapa.util
 from tapa.common.graph import Graph as TapaGraph
 
@@ -39,6 +40,14 @@ _logger = logging.getLogger().getChild(__name__)
               type=str,
               default=(),
               help='Compiler flags for the kernel, may appear many times.')
+@click.option('--specialize',
+              'specializations',
+              metavar='NAME=VALUE',
+              multiple=True,
+              type=str,
+              default=(),
+              help='Bind a scalar argument of the top-level task to a '
+              'compile-time constant, may appear many times.')
 @click.option('--tapacc',
               type=click.Path(dir_okay=False, readable=True, exists=True),
               help='Specify a `tapacc` instead of searching in `PATH`.')
@@ -46,7 +55,8 @@ _logger = logging.getLogger().getChild(__name__)
               type=click.Path(dir_okay=False, readable=True, exists=True),
               help='Specify a `tapa-clang` instead of searching in `PATH`.')
 def analyze(ctx, input: Tuple[str, ...], top: str, cflags: Tuple[str, ...],
-            tapacc: str, tapa_clang: str) -> None:
+            specializations: Tuple[str, ...], tapacc: str,
+            tapa_clang: str) -> None:
 
   tapacc = find_clang_binary('tapacc', tapacc)
   tapa_clang = find_clang_binary('tapa-clang', tapa_clang)
@@ -56,7 +66,12 @@ def analyze(ctx, input: Tuple[str, ...], top: str, cflags: Tuple[str, ...],
 
   flatten_files = run_flatten(tapa_clang, input, cflags, work_dir)
   tapacc_cflags = find_tapacc_cflags(cflags)
-  graph_dict = run_tapacc(tapacc, flatten_files, top, tapacc_cflags)
+  for specialization in specializations:
+    if '=' not in specialization:
+      raise click.BadParameter(f'expecting NAME=VALUE, got {specialization}',
+                               param_hint='--specialize')
+  graph_dict = run_tapacc(tapacc, flatten_files, top, tapacc_cflags,
+                          specializations)
   graph_dict['cflags'] = tapacc_cflags
 
   # Flatten the graph
@@ -67,6 +82,21 @@ def analyze(ctx, input: Tuple[str, ...], top: str, cflags: Tuple[str, ...],
   tapa.steps.common.store_persistent_context('graph', graph_dict)
   tapa.steps.common.store_persistent_context('settings', {})
 
+  # Always re-run because included headers are only known after flattening.
+  # Downstream steps depend on the content of `graph.json` instead.
+  tapa.steps.common.store_step_stamp(
+      'analyze',
+      tapa.steps.common.get_step_digest(
+          'analyze',
+          {
+              'top': top,
+              'cflags': cflags,
+              'specializations': specializations,
+          },
+      ),
+      outputs=[os.path.join(work_dir, 'graph.json')],
+  )
+
   tapa.steps.common.is_pipelined('analyze', True)
 
 
@@ -151,10 +181,12 @@ def run_and_check(cmd: Tuple[str, ...]) -> str:
   Returns:
     Stdout of the command execution.
   """
-  proc = subprocess.run(cmd,
-                        stdout=subprocess.PIPE,
-                        universal_newlines=True,
-                        check=False)
+  with tapa.trace.span(os.path.basename(cmd[0]), cat='step') as span:
+    with subprocess.Popen(cmd,
+                          stdout=subprocess.PIPE,
+                          universal_newlines=True) as proc:
+      span.track(proc)
+      stdout, _ = proc.communicate()
   if proc.returncode != 0:
     _logger.error(
         'command %s failed with exit code %d',
@@ -163,7 +195,7 @@ def run_and_check(cmd: Tuple[str, ...]) -> str:
     )
     exit(proc.returncode)
 
-  return proc.stdout
+  return stdout
 
 
 def run_flatten(tapa_clang: str, files: Tuple[str, ...],
@@ -210,19 +242,25 @@ def run_flatten(tapa_clang: str, files: Tuple[str, ...],
   return tuple(flatten_files)
 
 
-def run_tapacc(tapacc: str, files: Tuple[str, ...], top: str,
-               cflags: Tuple[str, ...]) -> Dict:
+def run_tapacc(tapacc: str,
+               files: Tuple[str, ...],
+               top: str,
+               cflags: Tuple[str, ...],
+               specializations: Tuple[str, ...] = ()) -> Dict:
   """Execute tapacc and return the program description.
 
   Args:
     tapacc: The path of the tapacc binary.
     files: C/C++ files to flatten.
     cflags: User specified CFLAGS with TAPA specific headers.
+    specializations: NAME=VALUE bindings of top-level scalars.
 
   Returns:
     Output description of the TAPA program.
   """
 
-  tapacc_args = ('-top', top, '--') + cflags
+  tapacc_args = ('-top', top)
+  tapacc_args += tuple(f'-specialize={x}' for x in specializations)
+  tapacc_args += ('--',) + cflags
   tapacc_cmd = (tapacc,) + files + tapacc_args
   return json.loads(run_and_check(tapacc_cmd))
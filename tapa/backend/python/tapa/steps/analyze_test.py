@@ -0,0 +1,150 @@
+import os
+import shutil
+import tempfile
+import unittest
+from typing import Dict
+
+from tapa.steps.analyze import find_tapacc_cflags, run_tapacc
+
+# Set by CTest to the tapacc built in the same tree.
+_TAPACC = os.environ.get('TAPACC') or shutil.which('tapacc')
+
+_KERNEL = r'''
+#include <cstdint>
+
+#include <tapa.h>
+
+constexpr int kTile = 64;
+constexpr int kBlock = 512;
+
+// Each section is accessed once per element, in order.
+void Load(tapa::mmap<const float> mem, tapa::obuffer<float[kTile], 2>& buf,
+          int n) {
+  for (int t = 0; t < n; ++t) {
+    auto section = buf.acquire();
+    auto& ref = section();
+    for (int i = 0; i < kTile; ++i) {
+      ref[i] = mem[t * kTile + i];
+    }
+  }
+}
+
+// `in` is accessed in order but `out` is not.
+void Reverse(tapa::ibuffer<float[kTile], 2>& in,
+             tapa::obuffer<float[kTile], 2>& out, int n) {
+  for (int t = 0; t < n; ++t) {
+    auto section_in = in.acquire();
+    auto section_out = out.acquire();
+    auto& ref_in = section_in();
+    auto& ref_out = section_out();
+    for (int i = 0; i < kTile; ++i) {
+      ref_out[kTile - 1 - i] = ref_in[i];
+    }
+  }
+}
+
+// `q` is staged through a local array that is read out of order.
+void Transpose(tapa::ibuffer<float[kTile], 2>& in, tapa::istream<float>& q,
+               tapa::ostream<float>& out, int n) {
+  for (int t = 0; t < n; ++t) {
+    auto section = in.acquire();
+    auto& ref = section();
+    float block[kBlock];
+    for (int i = 0; i < kBlock; ++i) {
+      block[i] = q.read();
+    }
+    for (int i = 0; i < kBlock; ++i) {
+      const float v = block[i % 8 * (kBlock / 8) + i / 8];
+      out.write(v + ref[i % kTile]);
+    }
+  }
+}
+
+// Staged in order, so the stream is kept.
+void Copy(tapa::istream<float>& in, tapa::ostream<float>& out, int n) {
+  for (int t = 0; t < n; ++t) {
+    float block[kBlock];
+    for (int i = 0; i < kBlock; ++i) {
+      block[i] = in.read();
+    }
+    for (int i = 0; i < kBlock; ++i) {
+      out.write(block[i]);
+    }
+  }
+}
+
+void Produce(tapa::mmap<const float> mem, tapa::ostream<float>& q, int n) {
+  for (int i = 0; i < n * kBlock; ++i) {
+    q.write(mem[i]);
+  }
+}
+
+void Store(tapa::istream<float>& q, tapa::mmap<float> mem, int n) {
+  for (int i = 0; i < n * kBlock; ++i) {
+    mem[i] = q.read();
+  }
+}
+
+void Top(tapa::mmap<const float> a, tapa::mmap<const float> b,
+         tapa::mmap<float> c, int n) {
+  tapa::buffer<float[kTile], 2> loaded;
+  tapa::buffer<float[kTile], 2> reversed;
+  tapa::stream<float, 2> produced;
+  tapa::stream<float, 2> transposed;
+  tapa::stream<float, 2> copied;
+  tapa::task()
+      .invoke(Load, a, loaded, n)
+      .invoke(Reverse, loaded, reversed, n)
+      .invoke(Produce, b, produced, n)
+      .invoke(Transpose, reversed, produced, transposed, n)
+      .invoke(Copy, transposed, copied, n)
+      .invoke(Store, copied, c, n);
+}
+'''
+
+
+@unittest.skipIf(_TAPACC is None, 'tapacc is not found')
+class ConversionTest(unittest.TestCase):
+
+  @classmethod
+  def setUpClass(cls):
+    with tempfile.TemporaryDirectory() as tmp_dir:
+      path = os.path.join(tmp_dir, 'kernel.cpp')
+      with open(path, 'w') as fp:
+        fp.write(_KERNEL)
+      cls.tasks = run_tapacc(_TAPACC, (path,), 'Top',
+                             find_tapacc_cflags(('-std=c++17',)))['tasks']
+
+  def get_conversions(self, task: str) -> Dict[str, Dict]:
+    return {x['port']: x for x in self.tasks[task].get('conversions', ())}
+
+  def check_conversion(self, conversion: Dict, **expected) -> None:
+    self.assertEqual({x: conversion[x] for x in expected}, expected)
+
+  def test_buffer_to_stream(self):
+    # 32-bit x 64 x 2 sections fit in one BRAM18
+    self.check_conversion(self.get_conversions('Load')['buf'],
+                          to='ostream',
+                          bram_delta=-1,
+                          latency_delta=-64)
+    conversions = self.get_conversions('Reverse')
+    self.check_conversion(conversions['in'], to='istream')
+    self.assertNotIn('out', conversions)
+
+  def test_stream_to_buffer(self):
+    # double buffering needs 2 BRAM18 instead of 1
+    conversions = self.get_conversions('Transpose')
+    self.check_conversion(conversions['q'],
+                          to='ibuffer',
+                          bram_delta=1,
+                          latency_delta=-512)
+    # `ref` is indexed by `i % kTile` instead of the loop variable
+    self.assertNotIn('in', conversions)
+
+  def test_no_conversion(self):
+    for task in 'Copy', 'Produce', 'Store', 'Top':
+      self.assertEqual(self.get_conversions(task), {}, task)
+
+
+if __name__ == '__main__':
+  unittest.main()
@@ -1,15 +1,21 @@
+import hashlib
 import json
 import logging
 import os
-from typing import Dict, Optional, Tuple
+from typing import Any, Dict, Iterable, Optional, Tuple
 
 import click
 
+import tapa
 import tapa.core
 import tapa.util
 
 _logger = logging.getLogger().getChild(__name__)
 
+# Digest of outputs that cannot be read, which matches no digest of existing
+# files, so the step and the steps consuming its outputs are rerun.
+_MISSING_OUTPUTS = 'missing'
+
 
 def forward_applicable(ctx: click.Context, command: click.Command,
                        kwargs: Dict):
@@ -112,3 +118,146 @@ def switch_work_dir(path: str):
   # update tapa.core.Program if created
   if 'tapa-program' in click.get_current_context().obj:
     click.get_current_context().obj['tapa-program'].work_dir = path
+
+
+def is_incremental() -> bool:
+  """Returns whether up-to-date steps may be skipped in this run."""
+  return click.get_current_context().obj.get('incremental', False)
+
+
+def _hash_param(value: Any) -> Any:
+  # click.File parameters are hashed by content instead of file object
+  name = getattr(value, 'name', None)
+  if isinstance(name, str) and os.path.isfile(name):
+    hash = hashlib.sha256()
+    with open(name, 'rb') as fp:
+      hash.update(fp.read())
+    return {'path': name, 'sha256': hash.hexdigest()}
+  return str(value)
+
+
+def _hash_files(paths: Iterable[str]) -> str:
+  """Hashes files and directories, or returns `_MISSING_OUTPUTS`."""
+  hash = hashlib.sha256()
+  for path in sorted(paths):
+    if os.path.isdir(path):
+      files = sorted(
+          os.path.join(root, name)
+          for root, _, names in os.walk(path)
+          for name in names)
+    else:
+      files = [path]
+    for file in files:
+      # names are relative to the parent of `path`, so renaming a file or
+      # directory changes the digest but moving the work dir does not
+      hash.update(os.path.relpath(file, os.path.dirname(path)).encode())
+      hash.update(b'\0')
+      try:
+        with open(file, 'rb') as fp:
+          for chunk in iter(lambda: fp.read(1 << 20), b''):
+            hash.update(chunk)
+      except OSError as e:
+        _logger.info('cannot hash output %s: %s', file, e)
+        return _MISSING_OUTPUTS
+  return hash.hexdigest()
+
+
+def _get_stamp_file(step: str) -> str:
+  return os.path.join(get_work_dir(), 'stamps', f'{step}.json')
+
+
+def load_step_stamp(step: str) -> Dict:
+  """Loads the stamp recorded by the last run of a step.
+
+  Args:
+    step: Name of the step, e.g. synth.
+
+  Returns:
+    The stamp, or an empty dict if the step was never recorded.
+  """
+  try:
+    with open(_get_stamp_file(step), 'r') as input_fp:
+      return json.load(input_fp)
+  except (FileNotFoundError, json.JSONDecodeError):
+    return {}
+
+
+def get_step_digest(step: str,
+                    params: Dict[str, Any],
+                    upstreams: Iterable[str] = ()) -> str:
+  """Hashes the inputs of a step.
+
+  Args:
+    step: Name of the step, e.g. synth.
+    params: Parameters that affect the outputs of the step.
+    upstreams: Steps whose outputs are consumed by the step.
+
+  Returns:
+    Digest of the TAPA version, the parameters, and the upstream outputs.
+  """
+  with open(os.path.join(os.path.dirname(tapa.__file__), 'VERSION')) as fp:
+    version = fp.read().strip()
+  obj = {
+      'step': step,
+      'version': version,
+      'params': {key: _hash_param(value) for key, value in params.items()},
+      'upstreams': {
+          upstream: load_step_stamp(upstream).get('outputs')
+          for upstream in upstreams
+      },
+  }
+  return hashlib.sha256(json.dumps(obj, sort_keys=True).encode()).hexdigest()
+
+
+def is_step_up_to_date(step: str, digest: str) -> bool:
+  """Checks if a step can be skipped.
+
+  A step is up-to-date if incremental build is enabled, its inputs have the
+  same digest as in the last run, and all its recorded outputs still exist.
+
+  Args:
+    step: Name of the step, e.g. synth.
+    digest: Digest of the current inputs, from `get_step_digest`.
+
+  Returns:
+    True if the step is up-to-date.
+  """
+  if not is_incremental():
+    return False
+  stamp = load_step_stamp(step)
+  if stamp.get('inputs') != digest:
+    return False
+  if stamp.get('outputs') == _MISSING_OUTPUTS:
+    _logger.info('outputs of `%s` were missing in the last run', step)
+    return False
+  missing = [x for x in stamp.get('files', []) if not os.path.exists(x)]
+  if missing:
+    _logger.info('outputs of `%s` are missing: %s', step, missing)
+    return False
+  _logger.info('`%s` is up-to-date; reusing its outputs.', step)
+  return True
+
+
+def store_step_stamp(step: str,
+                     digest: str,
+                     outputs: Iterable[str],
+                     settings: Optional[Dict] = None) -> None:
+  """Records the inputs and outputs of a step that just finished.
+
+  Args:
+    step: Name of the step, e.g. synth.
+    digest: Digest of the inputs, from `get_step_digest`.
+    outputs: Files and directories generated by the step.
+    settings: Settings written by the step, restored when it is skipped.
+  """
+  outputs = [os.path.abspath(x) for x in outputs]
+  stamp = {
+      'inputs': digest,
+      'outputs': _hash_files(outputs),
+      'files': outputs,
+      'settings': settings or {},
+  }
+  stamp_file = _get_stamp_file(step)
+  os.makedirs(os.path.dirname(stamp_file), exist_ok=True)
+  with open(stamp_file, 'w') as output_fp:
+    json.dump(stamp, output_fp)
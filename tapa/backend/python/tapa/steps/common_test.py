@@ -0,0 +1,95 @@
+import os
+import tempfile
+import unittest
+
+import click
+
+import tapa.steps.common as common
+
+
+class StepStampTest(unittest.TestCase):
+
+  def setUp(self):
+    self._tmp_dir = tempfile.TemporaryDirectory()
+    self.work_dir = self._tmp_dir.name
+    self.ctx = click.Context(click.Command('tapa'),
+                             obj={
+                                 'work-dir': self.work_dir,
+                                 'incremental': True,
+                             })
+    self.ctx.__enter__()
+
+  def tearDown(self):
+    self.ctx.__exit__(None, None, None)
+    self._tmp_dir.cleanup()
+
+  def write(self, name: str, content: str) -> str:
+    path = os.path.join(self.work_dir, name)
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'w') as fp:
+      fp.write(content)
+    return path
+
+  def test_up_to_date(self):
+    output = self.write('out/a.v', 'module a;')
+    digest = common.get_step_digest('synth', {'part_num': 'xcu250'})
+    common.store_step_stamp('synth', digest, [os.path.dirname(output)])
+    self.assertTrue(common.is_step_up_to_date('synth', digest))
+
+  def test_not_incremental(self):
+    output = self.write('out/a.v', 'module a;')
+    digest = common.get_step_digest('synth', {})
+    common.store_step_stamp('synth', digest, [output])
+    self.ctx.obj['incremental'] = False
+    self.assertFalse(common.is_step_up_to_date('synth', digest))
+
+  def test_never_run(self):
+    digest = common.get_step_digest('synth', {})
+    self.assertFalse(common.is_step_up_to_date('synth', digest))
+
+  def test_params_changed(self):
+    output = self.write('out/a.v', 'module a;')
+    digest = common.get_step_digest('synth', {'clock_period': 3.33})
+    common.store_step_stamp('synth', digest, [output])
+    self.assertFalse(
+        common.is_step_up_to_date(
+            'synth', common.get_step_digest('synth', {'clock_period': 2.5})))
+
+  def test_upstream_changed(self):
+    upstream = self.write('graph.json', '{}')
+    common.store_step_stamp('analyze', 'inputs', [upstream])
+    digest = common.get_step_digest('synth', {}, upstreams=('analyze',))
+    common.store_step_stamp('synth', digest, [self.write('out/a.v', '')])
+    self.write('graph.json', '{"top": "VecAdd"}')
+    common.store_step_stamp('analyze', 'inputs', [upstream])
+    self.assertFalse(
+        common.is_step_up_to_date(
+            'synth',
+            common.get_step_digest('synth', {}, upstreams=('analyze',))))
+
+  def test_output_removed(self):
+    output = self.write('out/a.v', 'module a;')
+    digest = common.get_step_digest('synth', {})
+    common.store_step_stamp('synth', digest, [output])
+    os.remove(output)
+    self.assertFalse(common.is_step_up_to_date('synth', digest))
+
+  def test_output_unreadable(self):
+    output_dir = os.path.dirname(self.write('out/a.v', 'module a;'))
+    os.symlink(os.path.join(self.work_dir, 'nonexistent'),
+               os.path.join(output_dir, 'b.v'))
+    digest = common.get_step_digest('synth', {})
+    common.store_step_stamp('synth', digest, [output_dir])
+    self.assertEqual(common.load_step_stamp('synth')['outputs'],
+                     common._MISSING_OUTPUTS)
+    self.assertFalse(common.is_step_up_to_date('synth', digest))
+
+  def test_file_names_are_hashed(self):
+    a = self.write('a.v', 'module a;')
+    b = self.write('b.v', 'module a;')
+    self.assertNotEqual(common._hash_files([a]), common._hash_files([b]))
+    self.assertEqual(common._hash_files([a]), common._hash_files([a]))
+
+
+if __name__ == '__main__':
+  unittest.main()
@@ -1,6 +1,6 @@
 import logging
 import os
-from typing import Optional
+from typing import Optional, Tuple
 
 import click
 
@@ -26,7 +26,34 @@ _logger = logging.getLogger().getChild(__name__)
     help='Use a specific register level of top-level scalar signals '
     'instead of inferring from the floorplanning directive.',
 )
-def link(ctx, floorplan_output: Optional[str], register_level: int):
+@click.option(
+    '--async-mmap-write-combine',
+    type=int,
+    default=0,
+    help='Merge writes to the same address in each async_mmap with a write '
+    'combiner of this many lines. Defaults to 0, which disables it.',
+)
+@click.option(
+    '--async-mmap-prefetch-args',
+    multiple=True,
+    default=[],
+    help='Prefetch strided reads of the async_mmap arguments of the top '
+    'function that match. Regular expression supported.',
+)
+@click.option(
+    '--async-mmap-prefetch-depth',
+    type=int,
+    default=16,
+    help='Number of reads prefetched ahead by each prefetching async_mmap.',
+)
+def link(
+    ctx,
+    floorplan_output: Optional[str],
+    register_level: int,
+    async_mmap_write_combine: int,
+    async_mmap_prefetch_args: Tuple[str, ...],
+    async_mmap_prefetch_depth: int,
+):
 
   program = tapa.steps.common.load_tapa_program()
   settings = tapa.steps.common.load_persistent_context('settings')
@@ -59,9 +86,26 @@ def link(ctx, floorplan_output: Optional[str], register_level: int):
       register_level,
       settings['additional_fifo_pipelining'],
       settings['part_num'],
+      async_mmap_write_combine=async_mmap_write_combine,
+      async_mmap_prefetch_args=list(async_mmap_prefetch_args),
+      async_mmap_prefetch_depth=async_mmap_prefetch_depth,
   )
 
   settings['linked'] = True
   tapa.steps.common.store_persistent_context('settings')
 
+  # Always re-run because `synth` re-extracts the RTL instrumented here.
+  outputs = [program.rtl_dir]
+  if floorplan_output is not None:
+    outputs.append(floorplan_output)
+  tapa.steps.common.store_step_stamp(
+      'link',
+      tapa.steps.common.get_step_digest(
+          'link',
+          {'register_level': register_level},
+          upstreams=('synth', 'optimize-floorplan'),
+      ),
+      outputs=outputs,
+  )
+
   tapa.steps.common.is_pipelined('link', True)
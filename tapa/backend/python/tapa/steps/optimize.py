@@ -105,7 +105,7 @@ _logger = logging.getLogger().getChild(__name__)
     '--floorplan-strategy',
     type=click.Choice([
         'QUICK_FLOORPLANNING', 'SLR_LEVEL_FLOORPLANNING',
-        'HALF_SLR_LEVEL_FLOORPLANNING'
+        'HALF_SLR_LEVEL_FLOORPLANNING', 'ANALYTIC_FLOORPLANNING'
     ]),
     default='HALF_SLR_LEVEL_FLOORPLANNING',
     help='Override the automatic choosed floorplanning method. '
@@ -114,7 +114,18 @@ _logger = logging.getLogger().getChild(__name__)
     'SLR_LEVEL_FLOORPLANNING: only partition the device into SLR level '
     'slots. Do not perform half-SLR-level floorplanning. '
     'HALF_SLR_LEVEL_FLOORPLANNING: partition the device into half-SLR level '
-    'slots.',
+    'slots. ANALYTIC_FLOORPLANNING: place tasks onto half-SLR level slots '
+    'analytically without ILP solving, which typically takes less than a '
+    'second; useful for early design iterations.',
+)
+@click.option(
+    '--eco-floorplan / --no-eco-floorplan',
+    type=bool,
+    default=False,
+    help='Keep the tasks whose RTL is unchanged since the previous '
+    'floorplanning in their previous regions, and only floorplan the changed '
+    'or new tasks. This preserves the timing closure of the unchanged part '
+    'after a small change.',
 )
 @click.option(
     '--floorplan-opt-priority',
@@ -144,6 +155,18 @@ def optimize_floorplan(ctx, **kwargs: Dict):
   kwargs['work_dir'] = tapa.steps.common.get_work_dir()
   kwargs['part_num'] = settings['part_num']
 
+  digest = tapa.steps.common.get_step_digest(
+      'optimize-floorplan',
+      {k: v for k, v in kwargs.items() if k != 'max_parallel_synth_jobs'},
+      upstreams=('synth',),
+  )
+  if tapa.steps.common.is_step_up_to_date('optimize-floorplan', digest):
+    stamp = tapa.steps.common.load_step_stamp('optimize-floorplan')
+    settings.update(stamp['settings'])
+    tapa.steps.common.store_persistent_context('settings')
+    tapa.steps.common.is_pipelined('optimize-floorplan', True)
+    return
+
   if kwargs['enable_hbm_binding_adjustment']:
     if not kwargs['part_num'].startswith('xcu280'):
       raise click.BadArgumentUsage(
@@ -162,5 +185,15 @@ def optimize_floorplan(ctx, **kwargs: Dict):
       kwargs['enable_hbm_binding_adjustment']
 
   tapa.steps.common.store_persistent_context('settings')
+  tapa.steps.common.store_step_stamp(
+      'optimize-floorplan',
+      digest,
+      outputs=[program.autobridge_dir],
+      settings={
+          'connectivity': settings['connectivity'],
+          'enable_hbm_binding_adjustment':
+              settings['enable_hbm_binding_adjustment'],
+      },
+  )
 
   tapa.steps.common.is_pipelined('optimize-floorplan', True)
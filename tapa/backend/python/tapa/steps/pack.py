@@ -31,6 +31,11 @@ def pack(ctx, output: str, bitstream_script: Optional[str]):
   with open(output, 'wb') as packed_obj:
     program.pack_rtl(packed_obj)
     _logger.info('generate the v++ xo file at %s', output)
+  tapa.steps.common.store_step_stamp(
+      'pack',
+      tapa.steps.common.get_step_digest('pack', {}, upstreams=('link',)),
+      outputs=[output],
+  )
 
   if bitstream_script is not None:
 
@@ -1,4 +1,6 @@
 import logging
+import os
+import shutil
 from typing import Dict, Optional
 
 import click
@@ -48,11 +50,29 @@ def synth(ctx, part_num: Optional[str], platform: Optional[str],
   settings['additional_fifo_pipelining'] = additional_fifo_pipelining
 
   # Generate RTL code
-  program.run_hls(clock_period, part_num)
+  digest = tapa.steps.common.get_step_digest(
+      'synth',
+      {
+          'part_num': part_num,
+          'platform': platform,
+          'clock_period': clock_period,
+          'cflags': program.cflags,
+          'hls': shutil.which('vitis_hls'),
+      },
+      upstreams=('analyze',),
+  )
+  if not tapa.steps.common.is_step_up_to_date('synth', digest):
+    program.run_hls(clock_period, part_num)
+  # RTL is always re-extracted because downstream steps parse and modify it
   program.generate_task_rtl(additional_fifo_pipelining, part_num)
 
   settings['synthed'] = True
   tapa.steps.common.store_persistent_context('settings')
+  tapa.steps.common.store_step_stamp(
+      'synth',
+      digest,
+      outputs=[os.path.join(program.work_dir, 'tar')],
+  )
 
   tapa.steps.common.is_pipelined('synth', True)
 
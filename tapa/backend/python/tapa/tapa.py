@@ -14,6 +14,7 @@ import tapa.steps.meta
 import tapa.steps.optimize
 import tapa.steps.pack
 import tapa.steps.synth
+import tapa.trace
 import tapa.util
 
 _logger = logging.getLogger().getChild(__name__)
@@ -40,12 +41,29 @@ _logger = logging.getLogger().getChild(__name__)
               default=3000,
               metavar='limit',
               help='Override Python recursion limit.')
+@click.option('--incremental / --no-incremental',
+              type=bool,
+              default=True,
+              help='Skip expensive steps, e.g. HLS and floorplanning, whose '
+              'inputs are unchanged since their last run in the working '
+              'directory.')
+@click.option('--build-trace',
+              metavar='FILE',
+              type=click.Path(dir_okay=False),
+              help='Write the duration of each step and the peak memory of '
+              'the vendor tools to FILE in the Chrome trace format.')
 @click.pass_context
-def entry_point(ctx, verbose, quiet, work_dir, recursion_limit):
+def entry_point(ctx, verbose, quiet, work_dir, recursion_limit, incremental,
+                build_trace):
   tapa.util.setup_logging(verbose, quiet, work_dir)
 
+  if build_trace is not None:
+    tapa.trace.enable()
+    ctx.call_on_close(lambda: tapa.trace.save(build_trace))
+
   # Setup execution context
   obj = ctx.ensure_object(dict)
+  obj['incremental'] = incremental
   tapa.steps.common.switch_work_dir(work_dir)
 
   # Read versions from VERSION file and write log
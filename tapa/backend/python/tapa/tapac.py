@@ -15,10 +15,12 @@ import haoda.backend.xilinx
 from absl import flags
 
 import tapa.core
+import tapa.trace
 import tapa.util
 from tapa.bitstream import get_vitis_script
 from tapa.floorplan_dse import run_floorplan_dse
 from tapa.hardware import is_part_num_supported
+from tapa.verilator import generate_verilator_sim
 
 _logger = logging.getLogger().getChild(__name__)
 
@@ -68,6 +70,16 @@ def create_parser() -> argparse.ArgumentParser:
       dest='work_dir',
       help='Use a specific working directory instead of a temporary one.',
   )
+  parser.add_argument(
+      '--build-trace',
+      type=str,
+      metavar='file',
+      dest='build_trace',
+      help=('Write the duration of each step, including HLS and logic '
+            'synthesis of each task, and the peak memory of the vendor tools '
+            'to a JSON file in the Chrome trace format, which can be opened in '
+            'chrome://tracing or https://ui.perfetto.dev.'),
+  )
   parser.add_argument(
       '--top',
       type=str,
@@ -100,6 +112,17 @@ def create_parser() -> argparse.ArgumentParser:
       dest='cflags',
       help='Compiler flags for the kernel, may appear many times.',
   )
+  parser.add_argument(
+      '--specialize',
+      action='append',
+      default=[],
+      dest='specializations',
+      metavar='NAME=VALUE',
+      help='Bind a scalar argument of the top-level task to a compile-time '
+      'constant, may appear many times. The scalar is removed from the ports '
+      'of all children tasks that receive it, and its value is substituted in '
+      'the generated HLS code. The host must still pass the same value.',
+  )
   parser.add_argument(
       '-o',
       '--output',
@@ -184,6 +207,37 @@ def create_parser() -> argparse.ArgumentParser:
       help='Package RTL as a Xilinx object file.',
   )
 
+  group = parser.add_argument_group(
+      title='Simulation',
+      description='Fast RTL simulation of the generated kernel with Verilator.',
+  )
+  group.add_argument(
+      '--verilator-sim',
+      type=str,
+      metavar='file.so',
+      dest='verilator_sim',
+      help=('Build the top-level RTL with Verilator into a shared library '
+            'after generating the top-level RTL. Pass the shared library as '
+            'the bitstream to ``tapa::invoke`` to run RTL simulation.'),
+  )
+  group.add_argument(
+      '--verilator-stub-dir',
+      type=str,
+      metavar='dir',
+      dest='verilator_stub_dir',
+      help=('Directory of synthesizable stand-ins for RTL files that '
+            'Verilator cannot compile, e.g., HLS tasks using vendor IP. Each '
+            'file replaces the generated RTL file of the same name.'),
+  )
+  group.add_argument(
+      '--verilator',
+      type=str,
+      metavar='file',
+      dest='verilator',
+      default='verilator',
+      help='Path to the ``verilator`` executable.',
+  )
+
   group = parser.add_argument_group(
       title='Floorplanning',
       description=('Coarse-grained floorplanning via AutoBridge '
@@ -257,6 +311,34 @@ def create_parser() -> argparse.ArgumentParser:
       help=('Use a specific register level of top-level scalar signals '
             'instead of inferring from the floorplanning directive.'),
   )
+  group.add_argument(
+      '--async-mmap-write-combine',
+      type=int,
+      dest='async_mmap_write_combine',
+      default=0,
+      metavar='INT',
+      help=('Merge writes to the same address in each async_mmap with a '
+            'write combiner of this many lines. Defaults to 0, which '
+            'disables write combining.'),
+  )
+  group.add_argument(
+      '--async-mmap-prefetch-args',
+      action='append',
+      dest='async_mmap_prefetch_args',
+      default=[],
+      type=str,
+      metavar='REGEX',
+      help=('Prefetch strided reads of the async_mmap arguments of the top '
+            'function that match. Regular expression supported.'),
+  )
+  group.add_argument(
+      '--async-mmap-prefetch-depth',
+      type=int,
+      dest='async_mmap_prefetch_depth',
+      default=16,
+      metavar='INT',
+      help='Number of reads prefetched ahead by each prefetching async_mmap.',
+  )
   group.add_argument(
       '--min-area-limit',
       type=float,
@@ -373,6 +455,7 @@ def create_parser() -> argparse.ArgumentParser:
           'QUICK_FLOORPLANNING',
           'SLR_LEVEL_FLOORPLANNING',
           'HALF_SLR_LEVEL_FLOORPLANNING',
+          'ANALYTIC_FLOORPLANNING',
       ],
       help=(
           'Override the automatic choosed floorplanning method. '
@@ -381,7 +464,18 @@ def create_parser() -> argparse.ArgumentParser:
           'tasks. SLR_LEVEL_FLOORPLANNING: only partition the device into SLR '
           'level slots. Do not perform half-SLR-level floorplanning. '
           'HALF_SLR_LEVEL_FLOORPLANNING: partition the device into half-SLR '
-          'level slots. '),
+          'level slots. ANALYTIC_FLOORPLANNING: place tasks onto half-SLR '
+          'level slots analytically without ILP solving, which typically '
+          'takes less than a second; useful for early design iterations.'),
+  )
+  strategies.add_argument(
+      '--eco-floorplan',
+      dest='eco_floorplan',
+      action='store_true',
+      help=('Keep the tasks whose RTL is unchanged since the previous '
+            'floorplanning in their previous regions, and only floorplan the '
+            'changed or new tasks. This preserves the timing closure of the '
+            'unchanged part after a small change.'),
   )
   strategies.add_argument(
       '--floorplan-opt-priority',
@@ -463,6 +557,12 @@ def parse_steps(args, parser) -> Tuple[bool, str]:
                         'Use --enable-hbm-binding-adjustment to allow '
                         'optimal port binding selection.')
 
+  if args.verilator_sim is not None:
+    if args.work_dir is None:
+      parser.error('--work-dir must be set to enable Verilator simulation')
+    if not args.verilator_sim.endswith('.so'):
+      parser.error('the Verilator simulation must be a .so shared library')
+
   if args.run_floorplan_dse:
     if not args.work_dir:
       parser.error('--work-dir must be set to enable floorplan DSE.')
@@ -473,9 +573,10 @@ def parse_steps(args, parser) -> Tuple[bool, str]:
     if not args.work_dir:
       parser.error(
           '--work-dir must be set to enable automatic HBM binding adjustment.')
-    if args.floorplan_strategy == 'QUICK_FLOORPLANNING':
+    if args.floorplan_strategy in ('QUICK_FLOORPLANNING',
+                                   'ANALYTIC_FLOORPLANNING'):
       parser.error('--enable-hbm-binding-adjustment not supported '
-                   'yet for QUICK_FLOORPLANNING')
+                   f'yet for {args.floorplan_strategy}')
 
     _logger.warning(
         'HBM port binding adjustment is enabled. The final binding may be '
@@ -493,6 +594,18 @@ def main(argv: Optional[List[str]] = None):
 
   tapa.util.setup_logging(args.verbose, args.quiet, args.work_dir)
 
+  if args.build_trace is not None:
+    tapa.trace.enable()
+  try:
+    with tapa.trace.span('tapac', cat='step'):
+      _compile(args, parser)
+  finally:
+    if args.build_trace is not None:
+      tapa.trace.save(args.build_trace)
+
+
+def _compile(args: argparse.Namespace,
+             parser: argparse.ArgumentParser) -> None:
   _logger.info('tapa version: %s', tapa.__version__)
 
   # RTL parsing may require a deep stack
@@ -529,7 +642,13 @@ def main(argv: Optional[List[str]] = None):
         '..',
         'src',
     )
-    tapacc_cmd += '-top', args.top, '--', '-I', tapa_include_dir
+    tapacc_cmd += '-top', args.top
+    for specialization in args.specializations:
+      if '=' not in specialization:
+        parser.error(f'invalid --specialize {specialization}, '
+                     'expecting NAME=VALUE')
+      tapacc_cmd.append(f'-specialize={specialization}')
+    tapacc_cmd += '--', '-I', tapa_include_dir
 
     if args.enable_buffer_support is not None:
       cflag_list += '-DTAPA_BUFFER_SUPPORT',
@@ -560,10 +679,12 @@ def main(argv: Optional[List[str]] = None):
 
     tapacc_cmd += cflag_list
 
-    proc = subprocess.run(tapacc_cmd,
-                          stdout=subprocess.PIPE,
-                          universal_newlines=True,
-                          check=False)
+    with tapa.trace.span('tapacc', cat='step') as span:
+      with subprocess.Popen(tapacc_cmd,
+                            stdout=subprocess.PIPE,
+                            universal_newlines=True) as proc:
+        span.track(proc)
+        stdout, _ = proc.communicate()
     if proc.returncode != 0:
       _logger.error(
           'tapacc command %s failed with exit code %d',
@@ -571,7 +692,7 @@ def main(argv: Optional[List[str]] = None):
           proc.returncode,
       )
       parser.exit(status=proc.returncode)
-    tapa_program_json_dict = json.loads(proc.stdout)
+    tapa_program_json_dict = json.loads(stdout)
 
     # Use -MM to find all user headers
     input_file_basename = os.path.basename(args.input_file)
@@ -657,6 +778,7 @@ def main(argv: Optional[List[str]] = None):
           'floorplan_strategy',
           'floorplan_opt_priority',
           'enable_hbm_binding_adjustment',
+          'eco_floorplan',
       )
       for param in floorplan_params:
         if hasattr(args, param):
@@ -673,11 +795,30 @@ def main(argv: Optional[List[str]] = None):
       )
 
   if all_steps or args.generate_top_rtl is not None:
-    program.generate_top_rtl(args.floorplan_output,
-                             args.register_level or 0,
-                             args.additional_fifo_pipelining,
-                             _get_device_info(parser, args),
-                             other_hls_config=args.other_hls_configs)
+    program.generate_top_rtl(
+        args.floorplan_output,
+        args.register_level or 0,
+        args.additional_fifo_pipelining,
+        _get_device_info(parser, args),
+        other_hls_config=args.other_hls_configs,
+        async_mmap_write_combine=args.async_mmap_write_combine,
+        async_mmap_prefetch_args=args.async_mmap_prefetch_args,
+        async_mmap_prefetch_depth=args.async_mmap_prefetch_depth,
+    )
+
+    if args.verilator_sim is not None:
+      clock_period = args.clock_period
+      if clock_period is None:
+        clock_period = program.get_clock_period(program.top)
+      generate_verilator_sim(
+          top=program.top,
+          ports=program.toplevel_ports,
+          rtl_dir=program.rtl_dir,
+          output_file=args.verilator_sim,
+          clock_period=clock_period,
+          stub_dir=args.verilator_stub_dir,
+          verilator=args.verilator,
+      )
 
   if all_steps or args.pack_xo is not None:
     try:
@@ -27,6 +27,12 @@ class Task:
     level: Task.Level, upper or lower.
     name: str, name of the task, function name as defined in the source code.
     code: str, HLS C++ code of this task.
+    target: str, 'hls' for tasks synthesized by HLS, or 'rtl' for tasks
+        implemented by a built-in RTL module.
+    rtl_module: str, name of the library function implemented in RTL.
+    rtl_args: A list of parameter names passed to the library function.
+    rtl_template_args: A list of integral template arguments of the library
+        function.
     tasks: A dict mapping child task names to json instance description objects.
     fifos: A dict mapping child fifo names to json FIFO description objects.
     ports: A dict mapping port names to Port objects for the current task.
@@ -59,6 +65,10 @@ class Task:
     self.level = level
     self.name: str = kwargs.pop('name')
     self.code: str = kwargs.pop('code')
+    self.target: str = kwargs.pop('target', 'hls')
+    self.rtl_module: str = kwargs.pop('rtl_module', '')
+    self.rtl_args: List[str] = kwargs.pop('rtl_args', [])
+    self.rtl_template_args: List[int] = kwargs.pop('rtl_template_args', [])
     self.tasks = collections.OrderedDict()
     self.fifos = collections.OrderedDict()
     self.buffers = collections.OrderedDict()
@@ -89,6 +99,8 @@ class Task:
               'buffer_nature': False  # by default it's a complex
           }
       self.ports = {i.name: i for i in map(Port, kwargs.pop('ports', ()))}
+    elif self.is_rtl:
+      self.ports = {i.name: i for i in map(Port, kwargs.pop('ports', ()))}
     self.module = rtl.Module('')
     self._instances: Optional[Tuple[Instance, ...]] = None
     self._args: Optional[Dict[str, List[Instance.Arg]]] = None
@@ -105,6 +117,10 @@ class Task:
   def is_lower(self) -> bool:
     return self.level == Task.Level.LOWER
 
+  @property
+  def is_rtl(self) -> bool:
+    return self.target == 'rtl'
+
   @property
   def instances(self) -> Tuple[Instance, ...]:
     if self._instances is not None:
@@ -353,10 +369,13 @@ class Task:
         'consumed_by': 'produced_by',
         'produced_by': 'consumed_by',
     }[self.get_fifo_directions(axis_name)[0]]
-    data_width = self.ports[axis_name].width
+    # channels of istreams/ostreams are separate AXIS ports, e.g., `in[0]`
+    # becomes `in_0`
+    port_name_prefix = rtl.sanitize_array_name(axis_name)
+    data_width = self.ports[port_name_prefix].width
 
     # add FIFO registerings to provide timing isolation
-    fifo_name = 'tapa_fifo_' + axis_name
+    fifo_name = 'tapa_fifo_' + port_name_prefix
     self.module.add_fifo_instance(
         name=fifo_name,
         width=data_width + 1,
@@ -373,7 +392,7 @@ class Task:
     # add constant outputs for AXIS output ports
     if direction_axis == 'consumed_by':
       for axis_suffix, bit in rtl.AXIS_CONSTANTS.items():
-        port_name = self.module.find_port(axis_name, axis_suffix)
+        port_name = self.module.find_port(port_name_prefix + '_', axis_suffix)
         width = rtl.get_axis_port_width_int(axis_suffix, data_width)
 
         self.module.add_logics([
@@ -389,7 +408,7 @@ class Task:
 
       offset = 0
       for axis_suffix in rtl.STREAM_TO_AXIS[suffix]:
-        port_name = self.module.find_port(axis_name, axis_suffix)
+        port_name = self.module.find_port(port_name_prefix + '_', axis_suffix)
         width = rtl.get_axis_port_width_int(axis_suffix, data_width)
 
         if len(rtl.STREAM_TO_AXIS[suffix]) > 1:
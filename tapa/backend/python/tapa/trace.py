@@ -0,0 +1,236 @@
+"""Build-time trace of the tapa flow in the Chrome trace event format.
+
+Each step of the flow is recorded as a span on the thread that runs it, so
+parallel workers of thread pools show up as separate lanes. Spans that run
+subprocesses also record the peak RSS of the subprocess and its descendants,
+which is sampled from /proc. The trace is written as JSON that can be opened
+in chrome://tracing or https://ui.perfetto.dev.
+
+Tracing is disabled unless `enable` is called; until then `span` is a no-op.
+
+See https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU.
+"""
+
+import contextlib
+import functools
+import json
+import logging
+import os
+import subprocess
+import threading
+import time
+from typing import Any, Callable, Dict, Iterator, List, Optional, TypeVar
+
+__all__ = [
+    'Span',
+    'Tracer',
+    'enable',
+    'save',
+    'span',
+    'traced',
+]
+
+_logger = logging.getLogger().getChild(__name__)
+
+_Func = TypeVar('_Func', bound=Callable)
+
+# Interval of RSS sampling in seconds.
+_RSS_INTERVAL = 1.0
+
+
+class Span:
+  """A span being recorded, whose arguments are shown in the trace viewer."""
+
+  def __init__(self, tracer: Optional['Tracer'], args: Dict[str, Any]) -> None:
+    self.args = args
+    self._tracer = tracer
+    self._pids: List[int] = []
+
+  def track(self, proc: subprocess.Popen) -> None:
+    """Records the peak RSS of `proc` and its descendants in this span."""
+    if self._tracer is not None:
+      self._tracer._track(proc.pid)
+      self._pids.append(proc.pid)
+
+  def _untrack(self) -> None:
+    peak_rss = 0
+    for pid in self._pids:
+      peak_rss = max(peak_rss, self._tracer._untrack(pid))
+    if peak_rss:
+      self.args['peak_rss_mb'] = round(peak_rss / 2**20, 1)
+
+
+class Tracer:
+  """Collects trace events of this process."""
+
+  def __init__(self) -> None:
+    self._lock = threading.Lock()
+    self._events: List[Dict[str, Any]] = []
+    self._thread_names: Dict[int, str] = {}
+    self._origin = time.monotonic()
+
+    # pid of tracked subprocess -> peak RSS in bytes
+    self._peak_rss: Dict[int, int] = {}
+    self._sampler: Optional[threading.Thread] = None
+
+  @contextlib.contextmanager
+  def span(self, name: str, cat: str, **args: Any) -> Iterator[Span]:
+    """Records the context as a complete event on the current thread."""
+    thread = threading.current_thread()
+    span = Span(self, args)
+    begin = self._now()
+    try:
+      yield span
+    finally:
+      span._untrack()
+      end = self._now()
+      with self._lock:
+        self._thread_names.setdefault(thread.ident, thread.name)
+        self._events.append({
+            'name': name,
+            'cat': cat,
+            'ph': 'X',
+            'ts': begin,
+            'dur': end - begin,
+            'pid': os.getpid(),
+            'tid': thread.ident,
+            'args': span.args,
+        })
+
+  def save(self, path: str) -> None:
+    """Writes the events recorded so far to `path`."""
+    with self._lock:
+      events = list(self._events)
+      events += ({
+          'name': 'thread_name',
+          'ph': 'M',
+          'pid': os.getpid(),
+          'tid': tid,
+          'args': {
+              'name': name
+          },
+      } for tid, name in self._thread_names.items())
+    with open(path, 'w') as fp:
+      json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, fp)
+    _logger.info('build trace written to %s', path)
+
+  def _now(self) -> int:
+    return int((time.monotonic() - self._origin) * 1e6)
+
+  def _track(self, pid: int) -> None:
+    with self._lock:
+      self._peak_rss[pid] = 0
+      if self._sampler is None and os.path.isdir('/proc'):
+        self._sampler = threading.Thread(
+            target=self._sample,
+            name='rss sampler',
+            daemon=True,
+        )
+        self._sampler.start()
+
+  def _untrack(self, pid: int) -> int:
+    with self._lock:
+      return self._peak_rss.pop(pid, 0)
+
+  def _sample(self) -> None:
+    page_size = os.sysconf('SC_PAGE_SIZE')
+    last_total = 0
+    while True:
+      with self._lock:
+        roots = list(self._peak_rss)
+      if roots or last_total:
+        children: Dict[int, List[int]] = {}
+        rss: Dict[int, int] = {}
+        for entry in os.listdir('/proc'):
+          if not entry.isdigit():
+            continue
+          try:
+            with open(f'/proc/{entry}/stat') as fp:
+              # the command name is in parentheses and may contain spaces
+              fields = fp.read().rpartition(')')[2].split()
+          except OSError:
+            continue  # the process exited
+          pid = int(entry)
+          children.setdefault(int(fields[1]), []).append(pid)
+          rss[pid] = int(fields[21]) * page_size
+
+        total = 0
+        with self._lock:
+          for root in roots:
+            tree_rss, stack = 0, [root]
+            while stack:
+              pid = stack.pop()
+              tree_rss += rss.get(pid, 0)
+              stack += children.get(pid, ())
+            total += tree_rss
+            if root in self._peak_rss:
+              self._peak_rss[root] = max(self._peak_rss[root], tree_rss)
+          self._events.append({
+              'name': 'subprocess RSS',
+              'ph': 'C',
+              'ts': self._now(),
+              'pid': os.getpid(),
+              'args': {
+                  'MB': round(total / 2**20, 1)
+              },
+          })
+        last_total = total
+      time.sleep(_RSS_INTERVAL)
+
+
+_tracer: Optional[Tracer] = None
+
+
+def enable() -> None:
+  """Starts recording the trace of this process."""
+  global _tracer
+  if _tracer is None:
+    _tracer = Tracer()
+
+
+def save(path: str) -> None:
+  """Writes the trace recorded since `enable` to `path`."""
+  if _tracer is not None:
+    _tracer.save(path)
+
+
+@contextlib.contextmanager
+def span(name: str, cat: str = 'tapa', **args: Any) -> Iterator[Span]:
+  """Records the context as a span if tracing is enabled.
+
+  Args:
+      name: Name shown in the trace viewer.
+      cat: Category of the span, e.g., `step` or `hls`.
+      **args: Arguments shown in the trace viewer; more can be added to
+          `Span.args` in the context.
+
+  Returns:
+      Context manager that yields the `Span`.
+  """
+  if _tracer is None:
+    yield Span(None, args)
+  else:
+    with _tracer.span(name, cat, **args) as result:
+      yield result
+
+
+def traced(cat: str) -> Callable[[_Func], _Func]:
+  """Decorates a function so that each call is recorded as a span.
+
+  Args:
+      cat: Category of the span; the name is that of the function.
+
+  Returns:
+      Decorator of the function.
+  """
+
+  def decorator(func: _Func) -> _Func:
+
+    @functools.wraps(func)
+    def wrapper(*args, **kwargs):
+      with span(func.__name__, cat):
+        return func(*args, **kwargs)
+
+    return wrapper
+
+  return decorator
@@ -0,0 +1,456 @@
+"""Fast RTL simulation of tapac outputs with Verilator.
+
+The top-level RTL, the task RTL, and the TAPA Verilog library are compiled by
+Verilator together with a C++ harness into a shared library. The harness acts
+as the host: it programs the kernel arguments via ``s_axi_control`` and serves
+each ``m_axi`` port from the host buffers passed to ``tapa::invoke``. The host
+library loads the shared library if the bitstream passed to ``tapa::invoke``
+ends with ``.so``.
+
+If the environment variable ``TAPA_VERILATOR_MAX_CYCLES`` is set to a positive
+number, the harness aborts once the kernel runs for that many cycles without
+finishing, so that a hanging design fails instead of blocking the host.
+"""
+
+import decimal
+import glob
+import logging
+import os
+import re
+import subprocess
+from typing import Dict, Iterable, List, Optional, Tuple
+
+from tapa import trace
+from tapa.instance import Port
+from tapa.verilog.xilinx.m_axi import M_AXI_PREFIX
+
+_logger = logging.getLogger().getChild(__name__)
+
+__all__ = [
+    'generate_verilator_sim',
+]
+
+HARNESS_FILE = 'tapa_verilator_tb.cpp'
+RTL_EXTENSIONS = ('.v', '.sv')
+
+# The first argument register of HLS-generated s_axi_control.
+S_AXI_ARG_BASE = 0x10
+
+HARNESS_HEADER = r'''// Generated by tapac; do not edit.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "verilated.h"
+
+#include "V$top.h"
+
+double sc_time_stamp() { return 0; }
+
+namespace {
+
+constexpr size_t kMaxOutstanding = 16;
+constexpr uint64_t kPageSize = 4096;
+constexpr int kResetCycles = 16;
+
+struct Region {
+  uint64_t base;
+  uint8_t* data;
+  uint64_t size;
+};
+
+std::vector<Region> regions;
+
+uint8_t* Translate(uint64_t addr, uint64_t size) {
+  for (auto& region : regions) {
+    if (addr >= region.base && addr + size <= region.base + region.size) {
+      return region.data + (addr - region.base);
+    }
+  }
+  fprintf(stderr, "tapa-verilator: access out of bound: 0x%lx (%lu bytes)\n",
+          static_cast<unsigned long>(addr), static_cast<unsigned long>(size));
+  abort();
+}
+
+bool GetBit(const void* data, size_t idx) {
+  return (static_cast<const uint8_t*>(data)[idx / 8] >> (idx % 8)) & 1;
+}
+
+// AXI4 slave memory model of one m_axi port; bursts are INCR only.
+struct MemoryPort {
+  struct Burst {
+    uint64_t addr;
+    uint64_t len;
+    uint64_t size;
+    uint64_t id;
+  };
+
+  std::deque<Burst> reads;
+  std::deque<Burst> writes;
+  std::deque<uint64_t> responses;
+
+  // Copies the next read beat into `data` of `data_bytes` bytes.
+  void Read(void* data, size_t data_bytes) {
+    const auto& burst = reads.front();
+    memset(data, 0, data_bytes);
+    memcpy(static_cast<uint8_t*>(data) + burst.addr % data_bytes,
+           Translate(burst.addr, burst.size), burst.size);
+  }
+
+  void PopRead() {
+    auto& burst = reads.front();
+    burst.addr += burst.size;
+    if (--burst.len == 0) reads.pop_front();
+  }
+
+  // Applies the write beat in `data` under `strb` and pops it.
+  void Write(const void* data, const void* strb, size_t data_bytes) {
+    auto& burst = writes.front();
+    const auto offset = burst.addr % data_bytes;
+    auto dst = Translate(burst.addr, burst.size);
+    for (uint64_t i = 0; i < burst.size; ++i) {
+      if (GetBit(strb, offset + i)) {
+        dst[i] = static_cast<const uint8_t*>(data)[offset + i];
+      }
+    }
+    burst.addr += burst.size;
+    if (--burst.len == 0) {
+      responses.push_back(burst.id);
+      writes.pop_front();
+    }
+  }
+};
+
+}  // namespace
+
+extern "C" int64_t tapa_rtl_sim_run(const void* const* args,
+                                    const uint64_t* sizes, size_t n) {
+'''
+
+
+@trace.traced('step')
+def generate_verilator_sim(
+    top: str,
+    ports: Iterable[Port],
+    rtl_dir: str,
+    output_file: str,
+    clock_period: decimal.Decimal,
+    stub_dir: Optional[str] = None,
+    verilator: str = 'verilator',
+) -> str:
+  """Builds a Verilator simulation of the top-level kernel.
+
+  Args:
+    top: Name of the top-level module.
+    ports: Ports of the top-level task, in the order of the kernel arguments.
+    rtl_dir: Directory of the generated RTL.
+    output_file: Path of the shared library to generate.
+    clock_period: Clock period in nanoseconds, used to report the kernel time.
+    stub_dir: Optional directory of synthesizable stand-ins. Each RTL file in
+        it replaces the file of the same name in ``rtl_dir``, e.g., for HLS
+        modules that instantiate vendor IP not supported by Verilator.
+    verilator: Path to the ``verilator`` executable.
+
+  Returns:
+    Path to the generated shared library.
+
+  Raises:
+    ValueError: If the top-level task has ports not supported by the harness.
+  """
+  clock_period = decimal.Decimal(clock_period)
+  ports = tuple(ports)
+  for port in ports:
+    if port.cat.is_istream or port.cat.is_ostream:
+      raise ValueError(
+          f"stream port '{port.name}' of the top-level task is not supported "
+          'in Verilator simulation')
+
+  output_file = os.path.abspath(output_file)
+  build_dir = os.path.join(os.path.dirname(output_file),
+                           os.path.basename(output_file) + '.build')
+  os.makedirs(build_dir, exist_ok=True)
+
+  harness = os.path.join(build_dir, HARNESS_FILE)
+  with open(harness, 'w') as fp:
+    fp.write(
+        _generate_harness(top, ports, _get_arg_offsets(top, ports, rtl_dir),
+                          clock_period))
+
+  cmd = [
+      verilator,
+      '--cc',
+      '--exe',
+      '--build',
+      '-O3',
+      '--top-module',
+      top,
+      '--Mdir',
+      build_dir,
+      '-Wno-fatal',
+      '-Wno-lint',
+      '-Wno-style',
+      '-Wno-TIMESCALEMOD',
+      '-CFLAGS',
+      '-fPIC -O2',
+      '-LDFLAGS',
+      '-shared',
+      '-o',
+      output_file,
+      harness,
+      *_get_rtl_files(rtl_dir, stub_dir),
+  ]
+  _logger.info('building Verilator simulation %s', output_file)
+  _logger.debug('verilator command: %s', ' '.join(cmd))
+  proc = subprocess.run(cmd,
+                        stdout=subprocess.PIPE,
+                        stderr=subprocess.STDOUT,
+                        universal_newlines=True)
+  if proc.returncode != 0:
+    _logger.error('%s', proc.stdout)
+    raise RuntimeError(f'Verilator failed with exit code {proc.returncode}')
+  return output_file
+
+
+def _get_rtl_files(rtl_dir: str, stub_dir: Optional[str]) -> List[str]:
+  files: Dict[str, str] = {}
+  for directory in rtl_dir, stub_dir:
+    if directory is None:
+      continue
+    for ext in RTL_EXTENSIONS:
+      for path in glob.glob(os.path.join(directory, '*' + ext)):
+        name = os.path.basename(path)
+        if directory == stub_dir and name in files:
+          _logger.info('using stand-in %s', path)
+        files[name] = os.path.abspath(path)
+  return sorted(files.values())
+
+
+def _get_arg_width(port: Port) -> int:
+  return 64 if port.cat.is_mmap else port.width
+
+
+def _get_arg_offsets(top: str, ports: Tuple[Port, ...],
+                     rtl_dir: str) -> List[List[int]]:
+  """Returns the s_axi_control offset of each 32-bit word of each argument.
+
+  The offsets are parsed from the address map that HLS documents in the
+  comments of the s_axi_control module. If that is not found, the offsets are
+  computed following the same layout, i.e., each argument occupies its data
+  words followed by one reserved word.
+  """
+  documented: Dict[str, List[int]] = {}
+  s_axi_files = glob.glob(os.path.join(rtl_dir, f'{top}_control_s_axi.v'))
+  if s_axi_files:
+    pattern = re.compile(r'//\s*0x([0-9a-fA-F]+)\s*:\s*Data signal of (\w+)')
+    with open(s_axi_files[0]) as fp:
+      for line in fp:
+        match = pattern.search(line)
+        if match is not None:
+          documented.setdefault(match[2], []).append(int(match[1], 16))
+  else:
+    _logger.warning('cannot find s_axi_control of %s; assuming default layout',
+                    top)
+
+  offsets = []
+  offset = S_AXI_ARG_BASE
+  for port in ports:
+    word_count = (_get_arg_width(port) + 31) // 32
+    offsets.append(documented.get(
+        port.name, [offset + 4 * i for i in range(word_count)]))
+    offset += 4 * (word_count + 1)
+  return offsets
+
+
+def _generate_harness(top: str, ports: Tuple[Port, ...],
+                      offsets: List[List[int]],
+                      clock_period: decimal.Decimal) -> str:
+  mmaps = [(idx, port) for idx, port in enumerate(ports) if port.cat.is_mmap]
+
+  is_mmap = ', '.join('true' if port.cat.is_mmap else 'false'
+                      for port in ports) or 'false'
+
+  lines = [HARNESS_HEADER.replace('$top', top)]
+  lines += [
+      f'  if (n != {len(ports)}) {{',
+      '    fprintf(stderr, "tapa-verilator: expecting %d arguments, got %lu\\n",',
+      f'            {len(ports)}, static_cast<unsigned long>(n));',
+      '    abort();',
+      '  }',
+      '',
+      '  // Map each buffer to a 4 KiB aligned virtual address.',
+      '  regions.clear();',
+      '  std::vector<uint64_t> bases(n);',
+      f'  static const bool kIsMmap[] = {{{is_mmap}}};',
+      '  uint64_t next_base = kPageSize;',
+      '  for (size_t i = 0; i < n; ++i) {',
+      '    if (kIsMmap[i]) {',
+      '      regions.push_back({next_base, static_cast<uint8_t*>(',
+      '                                        const_cast<void*>(args[i])),',
+      '                         sizes[i]});',
+      '      bases[i] = next_base;',
+      '      next_base += (sizes[i] + kPageSize - 1) / kPageSize * kPageSize +',
+      '                   kPageSize;',
+      '    }',
+      '  }',
+      '',
+      '  // Returns the `k`-th 32-bit word of argument `i`.',
+      '  auto word = [&](size_t i, size_t k) -> uint32_t {',
+      '    uint32_t value = 0;',
+      '    const uint8_t* data = static_cast<const uint8_t*>(args[i]);',
+      '    uint64_t size = sizes[i];',
+      '    if (kIsMmap[i]) {',
+      '      data = reinterpret_cast<const uint8_t*>(&bases[i]);',
+      '      size = sizeof(bases[i]);',
+      '    }',
+      '    if (k * 4 < size) {',
+      '      memcpy(&value, data + k * 4, std::min<uint64_t>(size - k * 4, 4));',
+      '    }',
+      '    return value;',
+      '  };',
+      '',
+      '  // Register writes: arguments, then GIE, IER, and ap_start.',
+      '  std::deque<std::pair<uint32_t, uint32_t>> ctrl_writes = {',
+  ]
+  for idx, (port, port_offsets) in enumerate(zip(ports, offsets)):
+    for word, offset in enumerate(port_offsets):
+      lines.append(
+          f'      {{0x{offset:x}, word({idx}, {word})}},  // {port.name}')
+  lines += [
+      '      {0x04, 1},',
+      '      {0x08, 1},',
+      '      {0x00, 1},',
+      '  };',
+      '',
+      f'  std::vector<MemoryPort> ports({len(mmaps)});',
+      '',
+      '  const char* max_cycles_env = getenv("TAPA_VERILATOR_MAX_CYCLES");',
+      '  const uint64_t max_cycles =',
+      '      max_cycles_env == nullptr ? 0 : strtoull(max_cycles_env, nullptr, 0);',
+      '',
+      f'  std::unique_ptr<V{top}> top(new V{top});',
+      '  uint64_t cycle = 0;',
+      '  auto tick = [&] {',
+      '    top->ap_clk = 1;',
+      '    top->eval();',
+      '    top->ap_clk = 0;',
+      '    top->eval();',
+      '    ++cycle;',
+      '  };',
+      '',
+      '  top->ap_clk = 0;',
+      '  top->ap_rst_n = 0;',
+      '  top->eval();',
+      '  for (int i = 0; i < kResetCycles; ++i) tick();',
+      '  top->ap_rst_n = 1;',
+      '  cycle = 0;',
+      '',
+      '  bool aw_done = false, w_done = false;',
+      '  while (!top->interrupt) {',
+      '    if (max_cycles != 0 && cycle >= max_cycles) {',
+      '      fprintf(stderr, "tapa-verilator: kernel did not finish in %lu "',
+      '                      "cycles\\n",',
+      '              static_cast<unsigned long>(max_cycles));',
+      '      abort();',
+      '    }',
+      '    // Sample handshakes before the rising edge.',
+      '    if (!ctrl_writes.empty()) {',
+      '      aw_done |= top->s_axi_control_AWVALID && '
+      'top->s_axi_control_AWREADY;',
+      '      w_done |= top->s_axi_control_WVALID && '
+      'top->s_axi_control_WREADY;',
+      '    }',
+      '    const bool b_fire =',
+      '        top->s_axi_control_BVALID && top->s_axi_control_BREADY;',
+  ]
+  for port_idx, (_, port) in enumerate(mmaps):
+    lines += _sample_m_axi(port_idx, M_AXI_PREFIX + port.name)
+  lines += [
+      '',
+      '    tick();',
+      '',
+      '    // Update inputs after the rising edge.',
+      '    if (b_fire) {',
+      '      ctrl_writes.pop_front();',
+      '      aw_done = w_done = false;',
+      '    }',
+      '    const bool has_write = !ctrl_writes.empty();',
+      '    top->s_axi_control_AWVALID = has_write && !aw_done;',
+      '    top->s_axi_control_WVALID = has_write && !w_done;',
+      '    top->s_axi_control_AWADDR = has_write ? ctrl_writes.front().first : 0;',
+      '    top->s_axi_control_WDATA = has_write ? ctrl_writes.front().second : 0;',
+      '    top->s_axi_control_WSTRB = 0xf;',
+      '    top->s_axi_control_BREADY = 1;',
+      '    top->s_axi_control_ARVALID = 0;',
+      '    top->s_axi_control_RREADY = 1;',
+  ]
+  for port_idx, (_, port) in enumerate(mmaps):
+    lines += _drive_m_axi(port_idx, M_AXI_PREFIX + port.name)
+  lines += [
+      '    top->eval();',
+      '  }',
+      '',
+      '  top->final();',
+      f'  return static_cast<int64_t>(cycle * {clock_period});  // in ns',
+      '}',
+      '',
+  ]
+  return '\n'.join(lines)
+
+
+def _sample_m_axi(port_idx: int, name: str) -> List[str]:
+  return [
+      f'    {{  // {name}',
+      f'      auto& port = ports[{port_idx}];',
+      f'      if (top->{name}_ARVALID && top->{name}_ARREADY) {{',
+      f'        port.reads.push_back({{top->{name}_ARADDR,',
+      f'                              top->{name}_ARLEN + 1u,',
+      f'                              1u << top->{name}_ARSIZE,',
+      f'                              top->{name}_ARID}});',
+      '      }',
+      f'      if (top->{name}_RVALID && top->{name}_RREADY) port.PopRead();',
+      f'      if (top->{name}_AWVALID && top->{name}_AWREADY) {{',
+      f'        port.writes.push_back({{top->{name}_AWADDR,',
+      f'                               top->{name}_AWLEN + 1u,',
+      f'                               1u << top->{name}_AWSIZE,',
+      f'                               top->{name}_AWID}});',
+      '      }',
+      f'      if (top->{name}_WVALID && top->{name}_WREADY) {{',
+      f'        port.Write(&top->{name}_WDATA, &top->{name}_WSTRB,',
+      f'                   sizeof(top->{name}_WDATA));',
+      '      }',
+      f'      if (top->{name}_BVALID && top->{name}_BREADY) {{',
+      '        port.responses.pop_front();',
+      '      }',
+      '    }',
+  ]
+
+
+def _drive_m_axi(port_idx: int, name: str) -> List[str]:
+  return [
+      f'    {{  // {name}',
+      f'      auto& port = ports[{port_idx}];',
+      f'      top->{name}_ARREADY = port.reads.size() < kMaxOutstanding;',
+      f'      top->{name}_AWREADY = port.writes.size() < kMaxOutstanding;',
+      f'      top->{name}_RVALID = !port.reads.empty();',
+      f'      top->{name}_RRESP = 0;',
+      '      if (!port.reads.empty()) {',
+      f'        port.Read(&top->{name}_RDATA, sizeof(top->{name}_RDATA));',
+      f'        top->{name}_RLAST = port.reads.front().len == 1;',
+      f'        top->{name}_RID = port.reads.front().id;',
+      '      }',
+      f'      top->{name}_WREADY = !port.writes.empty();',
+      f'      top->{name}_BVALID = !port.responses.empty();',
+      f'      top->{name}_BRESP = 0;',
+      '      if (!port.responses.empty()) {',
+      f'        top->{name}_BID = port.responses.front();',
+      '      }',
+      '    }',
+  ]
@@ -551,6 +551,8 @@ class Module:
     module_name = 'fifo'
     level = []
     if partition_count > 1:
+      # pipeline registers followed by an almost-full FIFO; the FIFO replaces
+      # the endpoint FIFO rather than adding to it
       module_name = 'relay_station'
       level.append(
           ast.ParamArg(
@@ -665,6 +667,8 @@ class Module:
       max_wait_time: int = 3,
       max_burst_len: Optional[int] = None,
       offset_name: str = '',
+      write_combine_capacity: int = 0,
+      prefetch_depth: int = 0,
   ) -> 'Module':
     rst_q = Pipeline(f'{name}__rst', level=self.register_level)
     self.add_pipeline(rst_q, init=ast.Unot(RST_N))
@@ -706,6 +710,14 @@ class Module:
     paramargs.append(
         ast.ParamArg(paramname='MaxBurstLen',
                      argname=ast.Constant(max_burst_len)))
+    if write_combine_capacity:
+      paramargs.append(
+          ast.ParamArg(paramname='WriteCombineCapacity',
+                       argname=ast.Constant(write_combine_capacity)))
+    if prefetch_depth:
+      paramargs.append(
+          ast.ParamArg(paramname='PrefetchDepth',
+                       argname=ast.Constant(prefetch_depth)))
 
     for channel, ports in M_AXI_PORTS.items():
       for port, direction in ports:
@@ -0,0 +1,397 @@
+#include "conversion.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "clang/AST/AST.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+
+#include "nlohmann/json.hpp"
+
+#include "buffer.h"
+#include "stream.h"
+
+using std::string;
+using std::to_string;
+using std::unordered_map;
+using std::unordered_set;
+using std::vector;
+
+using clang::ArraySubscriptExpr;
+using clang::ASTContext;
+using clang::BinaryOperator;
+using clang::CompoundAssignOperator;
+using clang::ConstantArrayType;
+using clang::CXXMemberCallExpr;
+using clang::CXXOperatorCallExpr;
+using clang::DeclRefExpr;
+using clang::DeclStmt;
+using clang::Expr;
+using clang::ForStmt;
+using clang::FunctionDecl;
+using clang::ParmVarDecl;
+using clang::RecursiveASTVisitor;
+using clang::Stmt;
+using clang::UnaryOperator;
+using clang::VarDecl;
+
+using llvm::dyn_cast;
+using llvm::dyn_cast_or_null;
+using llvm::StringRef;
+
+using nlohmann::json;
+
+namespace {
+
+// Capacity of an 18Kb block RAM.
+constexpr int64_t kBram18Bits = 18 * 1024;
+
+// Memories no larger than this are assumed to be implemented in LUTRAM.
+constexpr int64_t kLutramBits = 1024;
+
+int64_t GetBramCount(int64_t width, int64_t depth) {
+  const int64_t bits = width * depth;
+  if (bits <= kLutramBits) return 0;
+  return (bits + kBram18Bits - 1) / kBram18Bits;
+}
+
+const VarDecl* GetVar(const Expr* expr) {
+  if (expr == nullptr) return nullptr;
+  if (auto ref = dyn_cast<DeclRefExpr>(expr->IgnoreImpCasts())) {
+    return dyn_cast<VarDecl>(ref->getDecl());
+  }
+  return nullptr;
+}
+
+bool EvaluatesTo(const Expr* expr, const ASTContext& context, int64_t* value) {
+  clang::Expr::EvalResult result;
+  if (expr == nullptr || !expr->EvaluateAsInt(result, context)) return false;
+  *value = result.Val.getInt().getExtValue();
+  return true;
+}
+
+// Returns the object on which `method` is called in the subtree of `stmt`.
+const VarDecl* FindMemberCallObject(const Stmt* stmt, StringRef method) {
+  if (stmt == nullptr) return nullptr;
+  if (auto call = dyn_cast<CXXMemberCallExpr>(stmt)) {
+    if (call->getMethodDecl() != nullptr &&
+        call->getMethodDecl()->getName() == method) {
+      return GetVar(call->getImplicitObjectArgument());
+    }
+  }
+  for (auto child : stmt->children()) {
+    if (auto var = FindMemberCallObject(child, method)) return var;
+  }
+  return nullptr;
+}
+
+// Returns the object on which `operator()` is called in the subtree of `stmt`.
+const VarDecl* FindFunctionCallObject(const Stmt* stmt) {
+  if (stmt == nullptr) return nullptr;
+  if (auto call = dyn_cast<CXXOperatorCallExpr>(stmt)) {
+    if (call->getOperator() == clang::OO_Call && call->getNumArgs() > 0) {
+      return GetVar(call->getArg(0));
+    }
+  }
+  for (auto child : stmt->children()) {
+    if (auto var = FindFunctionCallObject(child)) return var;
+  }
+  return nullptr;
+}
+
+// If `loop` is `for (i = 0; i < n; ++i)`, returns `i` and sets `trip_count`.
+const VarDecl* GetSequentialLoopVar(const ForStmt* loop,
+                                    const ASTContext& context,
+                                    int64_t* trip_count) {
+  if (loop == nullptr) return nullptr;
+
+  const VarDecl* var = nullptr;
+  int64_t init_value = -1;
+  if (auto decl_stmt = dyn_cast_or_null<DeclStmt>(loop->getInit())) {
+    if (decl_stmt->isSingleDecl()) {
+      var = dyn_cast<VarDecl>(decl_stmt->getSingleDecl());
+      if (var == nullptr ||
+          !EvaluatesTo(var->getInit(), context, &init_value)) {
+        return nullptr;
+      }
+    }
+  } else if (auto assign = dyn_cast_or_null<BinaryOperator>(loop->getInit())) {
+    if (assign->getOpcode() == clang::BO_Assign) {
+      var = GetVar(assign->getLHS());
+      if (!EvaluatesTo(assign->getRHS(), context, &init_value)) return nullptr;
+    }
+  }
+  if (var == nullptr || init_value != 0) return nullptr;
+
+  auto cond = dyn_cast_or_null<BinaryOperator>(
+      loop->getCond() == nullptr ? nullptr : loop->getCond()->IgnoreImpCasts());
+  if (cond == nullptr ||
+      (cond->getOpcode() != clang::BO_LT && cond->getOpcode() != clang::BO_NE) ||
+      GetVar(cond->getLHS()) != var ||
+      !EvaluatesTo(cond->getRHS(), context, trip_count)) {
+    return nullptr;
+  }
+
+  const Stmt* inc = loop->getInc();
+  if (auto unary = dyn_cast_or_null<UnaryOperator>(inc)) {
+    if (unary->isIncrementOp() && GetVar(unary->getSubExpr()) == var) {
+      return var;
+    }
+  } else if (auto compound = dyn_cast_or_null<CompoundAssignOperator>(inc)) {
+    int64_t step = 0;
+    if (compound->getOpcode() == clang::BO_AddAssign &&
+        GetVar(compound->getLHS()) == var &&
+        EvaluatesTo(compound->getRHS(), context, &step) && step == 1) {
+      return var;
+    }
+  }
+  return nullptr;
+}
+
+const ConstantArrayType* GetLocalArrayType(const VarDecl* var) {
+  if (var == nullptr || !var->isLocalVarDecl()) return nullptr;
+  auto type = dyn_cast_or_null<ConstantArrayType>(
+      var->getType()->getAsArrayTypeUnsafe());
+  // Only one-dimensional arrays are considered.
+  if (type == nullptr || type->getElementType()->isArrayType()) return nullptr;
+  return type;
+}
+
+struct Access {
+  const ForStmt* loop;  // Innermost loop enclosing the access.
+  const Expr* index;
+};
+
+class AccessCollector : public RecursiveASTVisitor<AccessCollector> {
+ public:
+  // Accesses of buffer ports via sections.
+  unordered_map<const ParmVarDecl*, vector<Access>> buffer_accesses;
+  // Uses of sections that are not array subscripts, e.g., passed to a
+  // function.
+  unordered_map<const ParmVarDecl*, int> escaped_buffer_uses;
+
+  // Local arrays that stage data read from or written to stream ports.
+  unordered_map<const VarDecl*, const ParmVarDecl*> staged_streams;
+  unordered_map<const VarDecl*, vector<Access>> staging_accesses;
+  // Accesses of the local arrays other than the staging accesses.
+  unordered_map<const VarDecl*, vector<Access>> array_accesses;
+
+  bool TraverseForStmt(ForStmt* loop) {
+    loops_.push_back(loop);
+    const bool result =
+        RecursiveASTVisitor<AccessCollector>::TraverseForStmt(loop);
+    loops_.pop_back();
+    return result;
+  }
+
+  bool VisitVarDecl(VarDecl* var) {
+    // `auto section = buffer.acquire();`
+    if (auto buffer = dyn_cast_or_null<ParmVarDecl>(
+            FindMemberCallObject(var->getInit(), "acquire"))) {
+      if (IsBufferInterface(buffer)) sections_[var] = buffer;
+    }
+    // `auto& ref = section();`
+    if (auto section = FindFunctionCallObject(var->getInit())) {
+      auto it = sections_.find(section);
+      if (it != sections_.end()) {
+        refs_[var] = it->second;
+        --escaped_buffer_uses[it->second];
+      }
+    }
+    return true;
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr* ref) {
+    auto var = dyn_cast<VarDecl>(ref->getDecl());
+    if (sections_.count(var)) ++escaped_buffer_uses[sections_[var]];
+    if (refs_.count(var)) ++escaped_buffer_uses[refs_[var]];
+    return true;
+  }
+
+  bool VisitArraySubscriptExpr(ArraySubscriptExpr* expr) {
+    const Access access{loops_.empty() ? nullptr : loops_.back(),
+                        expr->getIdx()};
+    const auto base = expr->getBase()->IgnoreImpCasts();
+
+    // `ref[i]` or `section()[i]`
+    const ParmVarDecl* buffer = nullptr;
+    if (auto var = GetVar(base)) {
+      if (refs_.count(var)) buffer = refs_[var];
+    } else if (auto section = FindFunctionCallObject(base)) {
+      if (sections_.count(section)) buffer = sections_[section];
+    }
+    if (buffer != nullptr) {
+      buffer_accesses[buffer].push_back(access);
+      --escaped_buffer_uses[buffer];
+      return true;
+    }
+
+    if (auto var = GetVar(base)) {
+      if (GetLocalArrayType(var) != nullptr && !staging_exprs_.count(expr)) {
+        array_accesses[var].push_back(access);
+      }
+    }
+    return true;
+  }
+
+  // `array[i] = stream.read();`
+  bool VisitBinaryOperator(BinaryOperator* op) {
+    if (op->getOpcode() != clang::BO_Assign) return true;
+    auto lhs = dyn_cast<ArraySubscriptExpr>(op->getLHS()->IgnoreImpCasts());
+    if (lhs == nullptr) return true;
+    for (auto method : {"read", "pop"}) {
+      auto stream =
+          dyn_cast_or_null<ParmVarDecl>(FindMemberCallObject(op->getRHS(),
+                                                             method));
+      if (stream != nullptr && IsTapaType(stream, "istream")) {
+        AddStagingAccess(lhs, stream);
+        break;
+      }
+    }
+    return true;
+  }
+
+  // `stream.write(array[i]);`
+  bool VisitCXXMemberCallExpr(CXXMemberCallExpr* call) {
+    if (call->getMethodDecl() == nullptr ||
+        call->getMethodDecl()->getName() != "write" ||
+        call->getNumArgs() != 1) {
+      return true;
+    }
+    auto stream =
+        dyn_cast_or_null<ParmVarDecl>(GetVar(call->getImplicitObjectArgument()));
+    auto arg = dyn_cast<ArraySubscriptExpr>(call->getArg(0)->IgnoreImpCasts());
+    if (stream != nullptr && arg != nullptr && IsTapaType(stream, "ostream")) {
+      AddStagingAccess(arg, stream);
+    }
+    return true;
+  }
+
+ private:
+  vector<const ForStmt*> loops_;
+  unordered_map<const VarDecl*, const ParmVarDecl*> sections_;
+  unordered_map<const VarDecl*, const ParmVarDecl*> refs_;
+  unordered_set<const ArraySubscriptExpr*> staging_exprs_;
+
+  void AddStagingAccess(const ArraySubscriptExpr* expr,
+                        const ParmVarDecl* stream) {
+    auto array = GetVar(expr->getBase());
+    if (GetLocalArrayType(array) == nullptr) return;
+    // Pre-order traversal visits the parent before the subscript itself.
+    staging_exprs_.insert(expr);
+    staged_streams[array] = stream;
+    staging_accesses[array].push_back(
+        {loops_.empty() ? nullptr : loops_.back(), expr->getIdx()});
+  }
+};
+
+// Returns the trip count if all accesses happen exactly once per iteration of
+// the same sequential loop, indexed by the loop variable; -1 otherwise.
+int64_t GetSequentialTripCount(const vector<Access>& accesses,
+                               const ASTContext& context) {
+  if (accesses.empty()) return -1;
+  const auto loop = accesses[0].loop;
+  int64_t trip_count = -1;
+  const auto var = GetSequentialLoopVar(loop, context, &trip_count);
+  if (var == nullptr) return -1;
+  for (const auto& access : accesses) {
+    if (access.loop != loop || GetVar(access.index) != var) return -1;
+  }
+  return trip_count;
+}
+
+bool IsInOrder(const Access& access, const ASTContext& context) {
+  int64_t trip_count;
+  auto var = GetSequentialLoopVar(access.loop, context, &trip_count);
+  return var != nullptr && GetVar(access.index) == var;
+}
+
+}  // namespace
+
+json SuggestChannelConversions(const FunctionDecl* func) {
+  auto suggestions = json::array();
+  if (!func->hasBody()) return suggestions;
+
+  auto& context = func->getASTContext();
+  auto& diagnostics = context.getDiagnostics();
+  static const auto diagnostic_id = diagnostics.getCustomDiagID(
+      clang::DiagnosticsEngine::Remark,
+      "'%0' could be a tapa::%1 instead of a tapa::%2 (estimated %3 BRAM18, "
+      "%4 cycles of latency)");
+  auto suggest = [&](const ParmVarDecl* param, const string& from,
+                     const string& to, int64_t bram_delta,
+                     int64_t latency_delta) {
+    auto diagnostics_builder =
+        diagnostics.Report(param->getLocation(), diagnostic_id);
+    diagnostics_builder.AddString(param->getNameAsString());
+    diagnostics_builder.AddString(to);
+    diagnostics_builder.AddString(from);
+    diagnostics_builder.AddString((bram_delta > 0 ? "+" : "") +
+                                  to_string(bram_delta));
+    diagnostics_builder.AddString((latency_delta > 0 ? "+" : "") +
+                                  to_string(latency_delta));
+    suggestions.push_back({{"port", param->getNameAsString()},
+                           {"from", from},
+                           {"to", to},
+                           {"bram_delta", bram_delta},
+                           {"latency_delta", latency_delta}});
+  };
+
+  AccessCollector collector;
+  collector.TraverseStmt(func->getBody());
+
+  // Buffer ports accessed exactly once per element, in order.
+  for (const auto param : func->parameters()) {
+    if (!IsBufferInterface(param)) continue;
+    auto it = collector.buffer_accesses.find(param);
+    if (it == collector.buffer_accesses.end() ||
+        collector.escaped_buffer_uses[param] > 0) {
+      continue;
+    }
+    const auto config = ParseBufferType(param->getType(), false);
+    if (config.dims.size() != 1) continue;
+    const int64_t trip_count = GetSequentialTripCount(it->second, context);
+    if (trip_count != config.dims[0]) continue;
+
+    const int64_t width = context.getTypeInfo(config.qualType).Width;
+    const bool is_input = IsTapaType(param, "ibuffer");
+    // The stream no longer waits for a full section before the consumer
+    // starts.
+    suggest(param, is_input ? "ibuffer" : "obuffer",
+            is_input ? "istream" : "ostream",
+            -GetBramCount(width, trip_count * config.n_sections), -trip_count);
+  }
+
+  // Stream ports staged through local arrays that are accessed out of order.
+  for (const auto& staged : collector.staged_streams) {
+    const auto array = staged.first;
+    const auto stream = staged.second;
+    const auto array_type = GetLocalArrayType(array);
+    const int64_t size = array_type->getSize().getZExtValue();
+    if (GetSequentialTripCount(collector.staging_accesses[array], context) !=
+        size) {
+      continue;
+    }
+    const auto& accesses = collector.array_accesses[array];
+    bool is_reordered = false;
+    for (const auto& access : accesses) {
+      if (!IsInOrder(access, context)) is_reordered = true;
+    }
+    if (!is_reordered) continue;
+
+    const int64_t width =
+        context.getTypeInfo(array_type->getElementType()).Width;
+    const bool is_input = IsTapaType(stream, "istream");
+    // A double-buffered section replaces the local array, and the staging
+    // loop is removed.
+    suggest(stream, is_input ? "istream" : "ostream",
+            is_input ? "ibuffer" : "obuffer",
+            GetBramCount(width, size * 2) - GetBramCount(width, size), -size);
+  }
+
+  return suggestions;
+}
@@ -0,0 +1,19 @@
+#ifndef TAPA_CONVERSION_H_
+#define TAPA_CONVERSION_H_
+
+#include "clang/AST/AST.h"
+
+#include "nlohmann/json.hpp"
+
+// Analyzes how a lower-level task accesses its channels and suggests
+//   * converting a buffer port to a stream port if each section is accessed
+//     exactly once in sequential order, which saves the double-buffered
+//     memory and lets the consumer start before a section is complete;
+//   * converting a stream port to a buffer port if the stream is staged
+//     through a local array that is accessed out of order, which removes the
+//     staging copy.
+// Each suggestion is reported as a remark and returned as a JSON object with
+// the estimated area and latency deltas.
+nlohmann::json SuggestChannelConversions(const clang::FunctionDecl* func);
+
+#endif  // TAPA_CONVERSION_H_
@@ -0,0 +1,105 @@
+#include "specialize.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "clang/AST/AST.h"
+#include "clang/Lex/Lexer.h"
+
+using std::map;
+using std::pair;
+using std::string;
+
+using clang::CharSourceRange;
+using clang::FunctionDecl;
+using clang::Lexer;
+using clang::ParmVarDecl;
+using clang::Rewriter;
+using clang::SourceLocation;
+
+using llvm::dyn_cast;
+
+namespace {
+
+using ParamKey = pair<const FunctionDecl*, unsigned>;
+
+map<ParamKey, string>& GetSpecializedValues() {
+  static map<ParamKey, string> values;
+  return values;
+}
+
+ParamKey GetParamKey(const ParmVarDecl* param) {
+  auto func = dyn_cast<FunctionDecl>(param->getDeclContext());
+  if (func != nullptr && func->isTemplateInstantiation()) {
+    func = func->getPrimaryTemplate()->getTemplatedDecl();
+  }
+  if (func != nullptr) func = func->getCanonicalDecl();
+  return {func, param->getFunctionScopeIndex()};
+}
+
+}  // namespace
+
+void SetSpecializedValue(const ParmVarDecl* param, const string& value) {
+  GetSpecializedValues()[GetParamKey(param)] = value;
+}
+
+void ClearSpecializedValue(const ParmVarDecl* param) {
+  GetSpecializedValues().erase(GetParamKey(param));
+}
+
+const string* GetSpecializedValue(const ParmVarDecl* param) {
+  auto& values = GetSpecializedValues();
+  if (values.empty()) return nullptr;
+  auto it = values.find(GetParamKey(param));
+  return it == values.end() ? nullptr : &it->second;
+}
+
+void RewriteSpecializedParams(const FunctionDecl* func, Rewriter& rewriter,
+                              bool define_constants) {
+  const auto& source_manager = rewriter.getSourceMgr();
+  const auto& lang_opts = rewriter.getLangOpts();
+  auto end_of = [&](SourceLocation loc) {
+    return Lexer::getLocForEndOfToken(loc, 0, source_manager, lang_opts);
+  };
+
+  string constants;
+  bool has_kept_param = false;
+  const unsigned num_params = func->getNumParams();
+  for (unsigned i = 0; i < num_params; ++i) {
+    const auto param = func->getParamDecl(i);
+    const auto value = GetSpecializedValue(param);
+    if (value == nullptr) {
+      has_kept_param = true;
+      continue;
+    }
+
+    // Remove the parameter together with one adjacent comma.
+    SourceLocation begin, end;
+    if (has_kept_param) {
+      // `..., T kept, T removed` -> `..., T kept`
+      begin = end_of(func->getParamDecl(i - 1)->getEndLoc());
+      end = end_of(param->getEndLoc());
+    } else if (i + 1 < num_params) {
+      // `T removed, T next, ...` -> `T next, ...`
+      begin = param->getBeginLoc();
+      end = func->getParamDecl(i + 1)->getBeginLoc();
+    } else {
+      begin = param->getBeginLoc();
+      end = end_of(param->getEndLoc());
+    }
+    rewriter.RemoveText(CharSourceRange::getCharRange(begin, end));
+
+    constants += "\n  const " +
+                 param->getType()
+                     .getNonReferenceType()
+                     .getUnqualifiedType()
+                     .getAsString() +
+                 " " + param->getNameAsString() + " = (" + *value + ");";
+  }
+
+  if (define_constants && !constants.empty() && func->hasBody()) {
+    rewriter.InsertTextAfterToken(func->getBody()->getBeginLoc(),
+                                  constants + "\n");
+  }
+}
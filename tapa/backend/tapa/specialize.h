@@ -0,0 +1,40 @@
+#ifndef TAPA_SPECIALIZE_H_
+#define TAPA_SPECIALIZE_H_
+
+#include <string>
+
+#include "clang/AST/AST.h"
+#include "clang/Rewrite/Core/Rewriter.h"
+
+#include "type.h"
+
+// Scalar parameters bound to compile-time constants via `tapacc -specialize`.
+// Parameters are identified by their canonical function and position so that
+// redeclarations and template instantiations share the same binding.
+
+// Returns true if the parameter can be specialized, i.e., it is a scalar.
+inline bool IsSpecializable(const clang::ParmVarDecl* param) {
+  return !IsTapaType(param, ".+");
+}
+
+void SetSpecializedValue(const clang::ParmVarDecl* param,
+                         const std::string& value);
+
+// Removes the binding of the parameter, if any.
+void ClearSpecializedValue(const clang::ParmVarDecl* param);
+
+// Returns the bound value or nullptr if the parameter is not specialized.
+const std::string* GetSpecializedValue(const clang::ParmVarDecl* param);
+
+inline bool IsSpecialized(const clang::ParmVarDecl* param) {
+  return GetSpecializedValue(param) != nullptr;
+}
+
+// Removes specialized parameters from the signature of `func`. If
+// `define_constants` is true, the removed parameters are re-defined as
+// constants at the beginning of the function body.
+void RewriteSpecializedParams(const clang::FunctionDecl* func,
+                              clang::Rewriter& rewriter,
+                              bool define_constants);
+
+#endif  // TAPA_SPECIALIZE_H_
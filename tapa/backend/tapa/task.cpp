@@ -1,7 +1,9 @@
 #include "task.h"
 
 #include <cstdlib>
+#include <functional>
 #include <regex>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -12,7 +14,9 @@
 #include "nlohmann/json.hpp"
 
 #include "buffer.h"
+#include "conversion.h"
 #include "mmap.h"
+#include "specialize.h"
 #include "stream.h"
 
 using std::initializer_list;
@@ -21,8 +25,10 @@ using std::to_string;
 using std::unordered_map;
 using std::vector;
 
+using clang::CallExpr;
 using clang::CharSourceRange;
 using clang::CXXBindTemporaryExpr;
+using clang::CXXConstructExpr;
 using clang::CXXMemberCallExpr;
 using clang::CXXMethodDecl;
 using clang::CXXOperatorCallExpr;
@@ -34,6 +40,7 @@ using clang::FunctionDecl;
 using clang::ImplicitCastExpr;
 using clang::Lexer;
 using clang::MaterializeTemporaryExpr;
+using clang::ParmVarDecl;
 using clang::SourceLocation;
 using clang::SourceRange;
 using clang::Stmt;
@@ -60,6 +67,13 @@ static std::map<TapaTargetAttr::TargetType,
              {TapaTargetAttr::VendorType::Xilinx,
               XilinxHLSTarget::GetInstance()},
          }},
+        // RTL tasks are never synthesized by HLS; their code is rewritten as
+        // HLS code only to keep the generated C++ valid.
+        {TapaTargetAttr::TargetType::RTL,
+         {
+             {TapaTargetAttr::VendorType::Xilinx,
+              XilinxHLSTarget::GetInstance()},
+         }},
     };
 
 extern const string* top_name;
@@ -97,10 +111,144 @@ vector<const CXXMemberCallExpr*> GetTapaInvokes(const Stmt* stmt) {
   return invokes;
 }
 
+// Names of library functions that have an RTL implementation.
+const std::set<string> kRtlFuncs = {
+    "mmap_to_stream", "stream_to_mmap",          // movers
+    "merge", "demux", "broadcast", "butterfly",  // routing primitives
+};
+
+// Given a Stmt, find all calls to RTL-implemented library functions via DFS.
+void GetTapaRtlCalls(const Stmt* stmt, vector<const CallExpr*>& calls) {
+  if (stmt == nullptr) return;
+  for (auto child : stmt->children()) {
+    GetTapaRtlCalls(child, calls);
+  }
+  if (const auto call = dyn_cast<CallExpr>(stmt)) {
+    if (const auto callee = call->getDirectCallee()) {
+      const string name = callee->getQualifiedNameAsString();
+      if (name.rfind("tapa::", 0) == 0 &&
+          kRtlFuncs.count(callee->getNameAsString())) {
+        calls.push_back(call);
+      }
+    }
+  }
+}
+
 bool IsTapaTopLevel(const FunctionDecl* func) {
   return *top_name == func->getNameAsString();
 }
 
+// Calls `visit(param, arg)` for each scalar argument of each invocation in
+// `tasks`, where `param` is the parameter of the invoked child and `arg` is the
+// parameter of the parent passed to it, or nullptr if the argument is not a
+// parameter of the parent.
+void ForEachScalarArg(
+    const vector<const FunctionDecl*>& tasks,
+    const std::function<void(const ParmVarDecl*, const ParmVarDecl*)>& visit) {
+  for (auto upper : tasks) {
+    auto task = GetTapaTask(upper->getBody());
+    if (task == nullptr) continue;
+    for (auto invoke : GetTapaInvokes(task)) {
+      auto decl_ref = dyn_cast<DeclRefExpr>(invoke->getArg(0));
+      if (decl_ref == nullptr) continue;
+      auto callee = dyn_cast<FunctionDecl>(decl_ref->getDecl());
+      if (callee == nullptr) continue;
+      if (callee->isTemplateInstantiation()) {
+        callee = callee->getPrimaryTemplate()->getTemplatedDecl();
+      }
+      bool has_name = false;
+      if (auto method = dyn_cast<CXXMethodDecl>(invoke->getCalleeDecl())) {
+        auto args = method->getTemplateSpecializationArgs()->asArray();
+        has_name = args.size() > 0 &&
+                   args.rbegin()->getKind() == TemplateArgument::Integral;
+      }
+      for (unsigned i = has_name ? 2 : 1; i < invoke->getNumArgs(); ++i) {
+        auto param = callee->getParamDecl(has_name ? i - 2 : i - 1);
+        if (!IsSpecializable(param)) continue;
+        const ParmVarDecl* arg = nullptr;
+        if (auto arg_ref =
+                dyn_cast<DeclRefExpr>(invoke->getArg(i)->IgnoreImpCasts())) {
+          arg = dyn_cast<ParmVarDecl>(arg_ref->getDecl());
+        }
+        visit(param, arg);
+      }
+    }
+  }
+}
+
+void SpecializeTasks(const vector<const FunctionDecl*>& tasks,
+                     const unordered_map<string, string>& bindings) {
+  if (tasks.empty() || bindings.empty()) return;
+  auto top = tasks[0];
+  auto& diagnostics = top->getASTContext().getDiagnostics();
+
+  unordered_map<string, const ParmVarDecl*> top_params;
+  for (const auto param : top->parameters()) {
+    top_params[param->getNameAsString()] = param;
+  }
+  for (const auto& binding : bindings) {
+    auto it = top_params.find(binding.first);
+    if (it == top_params.end() || !IsSpecializable(it->second)) {
+      static const auto diagnostic_id = diagnostics.getCustomDiagID(
+          clang::DiagnosticsEngine::Error,
+          "cannot specialize '%0': not a scalar parameter of '%1'");
+      auto diagnostics_builder = diagnostics.Report(diagnostic_id);
+      diagnostics_builder.AddString(binding.first);
+      diagnostics_builder.AddString(top->getNameAsString());
+      continue;
+    }
+    SetSpecializedValue(it->second, binding.second);
+  }
+
+  // Bindings only flow from parents to children, so each round specializes at
+  // least one more level of the hierarchy until a fixed point is reached.
+  for (bool changed = true; changed;) {
+    changed = false;
+    // Values passed to each child parameter; nullptr if not a constant.
+    unordered_map<const ParmVarDecl*, const string*> passed_values;
+    unordered_map<const ParmVarDecl*, bool> is_conflicting;
+    ForEachScalarArg(tasks, [&](const ParmVarDecl* param,
+                                const ParmVarDecl* arg) {
+      const string* value = arg == nullptr ? nullptr : GetSpecializedValue(arg);
+      auto it = passed_values.find(param);
+      if (it == passed_values.end()) {
+        passed_values[param] = value;
+      } else if (it->second == nullptr || value == nullptr ||
+                 *it->second != *value) {
+        is_conflicting[param] = true;
+      }
+    });
+    for (const auto& passed_value : passed_values) {
+      const auto param = passed_value.first;
+      if (passed_value.second == nullptr || is_conflicting[param] ||
+          IsSpecialized(param)) {
+        continue;
+      }
+      SetSpecializedValue(param, *passed_value.second);
+      changed = true;
+    }
+  }
+
+  // A specialized parameter of an upper-level task has no port, so it cannot
+  // be passed to a child parameter that is not specialized, e.g., if the child
+  // is also invoked with another value. Such parameters keep their ports, which
+  // may in turn require the parameter of the parent passed to them to keep its
+  // port, until a fixed point is reached. The top-level task keeps all ports.
+  for (bool changed = true; changed;) {
+    changed = false;
+    ForEachScalarArg(tasks, [&](const ParmVarDecl* param,
+                                const ParmVarDecl* arg) {
+      if (arg == nullptr || IsSpecialized(param) || !IsSpecialized(arg)) {
+        return;
+      }
+      auto func = dyn_cast<FunctionDecl>(arg->getDeclContext());
+      if (func == nullptr || IsTapaTopLevel(func)) return;
+      ClearSpecializedValue(arg);
+      changed = true;
+    });
+  }
+}
+
 thread_local const FunctionDecl* Visitor::rewriting_func{nullptr};
 thread_local const FunctionDecl* Visitor::current_task{nullptr};
 thread_local Target* Visitor::current_target{nullptr};
@@ -164,6 +312,13 @@ bool Visitor::VisitFunctionDecl(FunctionDecl* func) {
           } else {
             ProcessLowerLevelTask(func);
           }
+          // The top-level signature is kept as-is because the host passes
+          // arguments by position.
+          if (!IsTapaTopLevel(func)) {
+            const bool is_lower = GetTapaTask(func->getBody()) == nullptr;
+            RewriteSpecializedParams(func, GetRewriter(),
+                                     /*define_constants=*/is_lower);
+          }
         } else {
           current_target->RewriteFuncArguments(func, GetRewriter(),
                                                IsTapaTopLevel(func));
@@ -209,54 +364,7 @@ void Visitor::ProcessUpperLevelTask(const ExprWithCleanups* task,
   metadata["fifos"] = json::object();
   metadata["buffers"] = json::object();
 
-  for (const auto param : func->parameters()) {
-    const auto param_name = param->getNameAsString();
-    auto add_mmap_meta = [&](const string& name) {
-      metadata["ports"].push_back(
-          {{"name", name},
-           {"cat", IsTapaType(param, "async_mmap") ? "async_mmap" : "mmap"},
-           {"width",
-            GetTypeWidth(GetTemplateArg(param->getType(), 0)->getAsType())},
-           {"type", GetMmapElemType(param) + "*"}});
-    };
-    // TODO: extend to support streams as well
-    auto add_stream_meta = [&](const string& name) {
-      metadata["ports"].push_back(
-          {{"name", name},
-           {"cat", IsTapaType(param, "istream") ? "istream" : "ostream"},
-           {"width",
-            GetTypeWidth(GetTemplateArg(param->getType(), 0)->getAsType())},
-           {"type", GetStreamElemType(param)}});
-    };
-    // buffer support methods
-    auto add_buffer_meta = [&](const string& name) {
-      BufferConfig bufferConfig = ParseBufferType(param->getType(), false);
-      auto config = bufferConfig.toJson();
-      auto qualType = bufferConfig.qualType;
-      config["name"] = name;
-      config["cat"] = IsTapaType(param, "ibuffer") ? "ibuffer" : "obuffer";
-      config["width"] = GetTypeWidthBuffer(qualType);
-      metadata["ports"].push_back(config);
-    };
-    if (IsTapaType(param, "(async_)?mmap")) {
-      add_mmap_meta(param_name);
-    } else if (IsTapaType(param, "mmaps")) {
-      for (int i = 0; i < GetArraySize(param); ++i) {
-        add_mmap_meta(param_name + "[" + to_string(i) + "]");
-      }
-    } else if (IsStreamInterface(param)) {
-      add_stream_meta(param_name);
-    } else if (IsBufferInterface(param)) {
-      // TODO: Note that `buffers` similar to `streams` gets treated as
-      // scalars. Do we need to change that?
-      add_buffer_meta(param_name);
-    } else {
-      metadata["ports"].push_back({{"name", param_name},
-                                   {"cat", "scalar"},
-                                   {"width", GetTypeWidth(param->getType())},
-                                   {"type", param->getType().getAsString()}});
-    }
-  }
+  ProcessTaskPorts(func);
 
   // Process stream declarations.
   unordered_map<string, const VarDecl*> fifo_decls;
@@ -614,6 +722,8 @@ void Visitor::ProcessUpperLevelTask(const ExprWithCleanups* task,
                 register_buffer_producer(arg, config);
                 register_arg(arg, ArrayNameAt(param_name, i));
               }
+            } else if (IsSpecialized(param)) {
+              // Bound at compile time; there is no port to connect.
             } else if (arg_is_seq) {
               param_cat = "scalar";
               register_arg("64'd" + std::to_string(seq_access_pos[arg]++));
@@ -715,6 +825,129 @@ void Visitor::ProcessUpperLevelTask(const ExprWithCleanups* task,
 // Apply tapa s2s transformations on a lower-level task.
 void Visitor::ProcessLowerLevelTask(const FunctionDecl* func) {
   current_target->RewriteLowerLevelFunc(func, GetRewriter());
+
+  auto conversions = SuggestChannelConversions(func);
+  if (!conversions.empty()) GetMetadata()["conversions"] = conversions;
+
+  if (auto attr = func->getAttr<TapaTargetAttr>();
+      attr != nullptr && attr->getTarget() == TapaTargetAttr::TargetType::RTL) {
+    ProcessRtlTask(func);
+  }
+}
+
+// Obtain the port metadata of a task.
+// ports: [{name, cat, width, type}]
+void Visitor::ProcessTaskPorts(const FunctionDecl* func) {
+  auto& metadata = GetMetadata();
+  for (const auto param : func->parameters()) {
+    if (!IsTapaTopLevel(func) && IsSpecialized(param)) continue;
+    const auto param_name = param->getNameAsString();
+    auto add_mmap_meta = [&](const string& name) {
+      metadata["ports"].push_back(
+          {{"name", name},
+           {"cat", IsTapaType(param, "async_mmap") ? "async_mmap" : "mmap"},
+           {"width",
+            GetTypeWidth(GetTemplateArg(param->getType(), 0)->getAsType())},
+           {"type", GetMmapElemType(param) + "*"}});
+    };
+    // TODO: extend to support streams as well
+    auto add_stream_meta = [&](const string& name) {
+      metadata["ports"].push_back(
+          {{"name", name},
+           {"cat", IsTapaType(param, "istreams?") ? "istream" : "ostream"},
+           {"width",
+            GetTypeWidth(GetTemplateArg(param->getType(), 0)->getAsType())},
+           {"type", GetStreamElemType(param)}});
+    };
+    // buffer support methods
+    auto add_buffer_meta = [&](const string& name) {
+      BufferConfig bufferConfig = ParseBufferType(param->getType(), false);
+      auto config = bufferConfig.toJson();
+      auto qualType = bufferConfig.qualType;
+      config["name"] = name;
+      config["cat"] = IsTapaType(param, "ibuffer") ? "ibuffer" : "obuffer";
+      config["width"] = GetTypeWidthBuffer(qualType);
+      metadata["ports"].push_back(config);
+    };
+    if (IsTapaType(param, "(async_)?mmap")) {
+      add_mmap_meta(param_name);
+    } else if (IsTapaType(param, "mmaps")) {
+      for (int i = 0; i < GetArraySize(param); ++i) {
+        add_mmap_meta(param_name + "[" + to_string(i) + "]");
+      }
+    } else if (IsStreamInterface(param)) {
+      add_stream_meta(param_name);
+    } else if (IsTapaType(param, "(i|o)streams")) {
+      for (int i = 0; i < GetArraySize(param); ++i) {
+        add_stream_meta(ArrayNameAt(param_name, i));
+      }
+    } else if (IsBufferInterface(param)) {
+      // TODO: Note that `buffers` similar to `streams` gets treated as
+      // scalars. Do we need to change that?
+      add_buffer_meta(param_name);
+    } else {
+      metadata["ports"].push_back({{"name", param_name},
+                                   {"cat", "scalar"},
+                                   {"width", GetTypeWidth(param->getType())},
+                                   {"type", param->getType().getAsString()}});
+    }
+  }
+}
+
+// Obtain the ports and the library function of an RTL task, which must call
+// exactly one RTL-implemented library function with its parameters.
+// rtl_module: name of the library function
+// rtl_args: names of the parameters passed to the library function
+// rtl_template_args: integral template arguments of the library function
+void Visitor::ProcessRtlTask(const FunctionDecl* func) {
+  auto& metadata = GetMetadata();
+  ProcessTaskPorts(func);
+
+  auto& diagnostics = context_.getDiagnostics();
+  vector<const CallExpr*> calls;
+  GetTapaRtlCalls(func->getBody(), calls);
+  if (calls.size() != 1) {
+    static const auto diagnostic_id = diagnostics.getCustomDiagID(
+        clang::DiagnosticsEngine::Error,
+        "rtl task must call exactly one RTL-implemented tapa function");
+    diagnostics.Report(func->getLocation(), diagnostic_id);
+    return;
+  }
+
+  const auto call = calls[0];
+  const auto callee = call->getDirectCallee();
+  metadata["rtl_module"] = callee->getNameAsString();
+  metadata["rtl_template_args"] = json::array();
+  if (const auto args = callee->getTemplateSpecializationArgs()) {
+    for (const auto& arg : args->asArray()) {
+      if (arg.getKind() == TemplateArgument::Integral) {
+        metadata["rtl_template_args"].push_back(
+            arg.getAsIntegral().getExtValue());
+      }
+    }
+  }
+  metadata["rtl_args"] = json::array();
+  for (const auto arg : call->arguments()) {
+    // mmaps are passed by value via their copy constructors
+    const Expr* expr = arg->IgnoreImplicit();
+    if (const auto construct = dyn_cast<CXXConstructExpr>(expr);
+        construct != nullptr && construct->getNumArgs() == 1) {
+      expr = construct->getArg(0)->IgnoreImplicit();
+    }
+    const auto decl_ref = dyn_cast<DeclRefExpr>(expr);
+    const auto param = decl_ref == nullptr
+                           ? nullptr
+                           : dyn_cast<ParmVarDecl>(decl_ref->getDecl());
+    if (param == nullptr) {
+      static const auto diagnostic_id = diagnostics.getCustomDiagID(
+          clang::DiagnosticsEngine::Error,
+          "rtl task must pass its parameters to %0 as-is");
+      diagnostics.Report(arg->getBeginLoc(), diagnostic_id)
+          .AddString(string(metadata["rtl_module"]));
+      return;
+    }
+    metadata["rtl_args"].push_back(param->getNameAsString());
+  }
 }
 
 string Visitor::GetFrtInterface(const FunctionDecl* func) {
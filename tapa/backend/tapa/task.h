@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <queue>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -64,6 +65,8 @@ class Visitor : public clang::RecursiveASTVisitor<Visitor> {
                              const clang::FunctionDecl* func);
 
   void ProcessLowerLevelTask(const clang::FunctionDecl* func);
+  void ProcessTaskPorts(const clang::FunctionDecl* func);
+  void ProcessRtlTask(const clang::FunctionDecl* func);
   std::string GetFrtInterface(const clang::FunctionDecl* func);
 
   clang::CharSourceRange GetCharSourceRange(const clang::Stmt* stmt);
@@ -157,6 +160,15 @@ inline std::vector<const clang::FunctionDecl*> FindAllTasks(
   return tasks;
 }
 
+// Bind scalar parameters of the top-level task to compile-time constants and
+// propagate the bindings to children tasks. A child parameter is specialized
+// only if every invocation passes the same specialized parameter of the parent.
+// `tasks` must start with the top-level task, e.g., as returned by
+// `FindAllTasks`.
+void SpecializeTasks(
+    const std::vector<const clang::FunctionDecl*>& tasks,
+    const std::unordered_map<std::string, std::string>& bindings);
+
 // Return the body of a loop stmt or nullptr if the input is not a loop.
 inline const clang::Stmt* GetLoopBody(const clang::Stmt* loop) {
   if (loop != nullptr) {
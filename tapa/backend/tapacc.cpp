@@ -54,6 +54,7 @@ namespace tapa {
 namespace internal {
 
 const string* top_name;
+const unordered_map<string, string>* specializations;
 
 class Consumer : public ASTConsumer {
  public:
@@ -106,6 +107,9 @@ class Consumer : public ASTConsumer {
         };
     if (func_table.count(*top_name)) {
       auto tasks = FindAllTasks(func_table[*top_name][0]);
+      if (specializations != nullptr) {
+        SpecializeTasks(tasks, *specializations);
+      }
       funcs_.clear();
       for (auto task : tasks) {
         auto task_name = task->getNameAsString();
@@ -169,12 +173,28 @@ static OptionCategory tapa_option_category("TAPA Compiler Companion");
 static llvm::cl::opt<string> tapa_opt_top_name(
     "top", NumOccurrencesFlag::Required, ValueExpected::ValueRequired,
     llvm::cl::desc("Top-level task name"), llvm::cl::cat(tapa_option_category));
+static llvm::cl::list<string> tapa_opt_specializations(
+    "specialize", NumOccurrencesFlag::ZeroOrMore, ValueExpected::ValueRequired,
+    llvm::cl::desc("Bind a top-level scalar to a compile-time constant"),
+    llvm::cl::value_desc("name=value"), llvm::cl::cat(tapa_option_category));
 
 int main(int argc, const char** argv) {
   CommonOptionsParser parser{argc, argv, tapa_option_category};
   ClangTool tool{parser.getCompilations(), parser.getSourcePathList()};
   string top_name{tapa_opt_top_name.getValue()};
   tapa::internal::top_name = &top_name;
+  unordered_map<string, string> specializations;
+  for (const string& specialization : tapa_opt_specializations) {
+    auto pos = specialization.find('=');
+    if (pos == string::npos || pos == 0 || pos + 1 == specialization.size()) {
+      llvm::errs() << "invalid specialization '" << specialization
+                   << "', expecting name=value\n";
+      return 1;
+    }
+    specializations[specialization.substr(0, pos)] =
+        specialization.substr(pos + 1);
+  }
+  tapa::internal::specializations = &specializations;
   int ret = tool.run(newFrontendActionFactory<tapa::internal::Action>().get());
   return ret;
 }
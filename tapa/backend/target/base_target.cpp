@@ -1,5 +1,6 @@
 #include "base_target.h"
 
+#include "../tapa/specialize.h"
 #include "../tapa/type.h"
 
 namespace tapa {
@@ -98,6 +99,8 @@ std::vector<std::string> BaseTarget::GenerateCodeForMiddleLevelFunc(
   LINES_FUNCTIONS;
 
   for (const auto param : func->parameters()) {
+    // Specialized scalars are removed from the signature.
+    if (IsSpecialized(param)) continue;
     if (IsTapaType(param, "(i|o)streams?")) {
       AddCodeForMiddleLevelStream(param, add_line, add_pragma);
     } else if (IsTapaType(param, "(i|o)buffers?")) {
@@ -121,6 +124,8 @@ std::vector<std::string> BaseTarget::GenerateCodeForLowerLevelFunc(
   LINES_FUNCTIONS;
 
   for (const auto param : func->parameters()) {
+    // Specialized scalars are removed from the signature.
+    if (IsSpecialized(param)) continue;
     if (IsTapaType(param, "(i|o)streams?")) {
       AddCodeForLowerLevelStream(param, add_line, add_pragma);
     } else if (IsTapaType(param, "(i|o)buffers?")) {
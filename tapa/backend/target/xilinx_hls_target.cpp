@@ -14,6 +14,14 @@ using llvm::StringRef;
 namespace tapa {
 namespace internal {
 
+// Returns the AXI-Stream type of a top-level (i|o)stream(s) parameter.
+static std::string GetQdmaAxisType(const clang::ParmVarDecl *param) {
+  int width = param->getASTContext()
+                  .getTypeInfo(GetTemplateArg(param->getType(), 0)->getAsType())
+                  .Width;
+  return "qdma_axis<" + std::to_string(width) + ", 0, 0, 0>";
+}
+
 static void AddDummyStreamRW(ADD_FOR_PARAMS_ARGS_DEF, bool qdma) {
   auto param_name = param->getNameAsString();
   auto add_dummy_read = [&add_line](std::string name) {
@@ -29,30 +37,26 @@ static void AddDummyStreamRW(ADD_FOR_PARAMS_ARGS_DEF, bool qdma) {
   } else if (IsTapaType(param, "ostream")) {
     auto type = GetStreamElemType(param);
     if (qdma) {
-      int width =
-          param->getASTContext()
-              .getTypeInfo(GetTemplateArg(param->getType(), 0)->getAsType())
-              .Width;
-      type = "qdma_axis<" + std::to_string(width) + ", 0, 0, 0>";
+      type = GetQdmaAxisType(param);
     }
     add_dummy_write(param_name, type);
 
   } else if (IsTapaType(param, "istreams")) {
-    if (qdma) {
-      add_line("#error istreams not supported for qdma-based tasks");
-    } else {
-      for (int i = 0; i < GetArraySize(param); ++i) {
-        add_dummy_read(ArrayNameAt(param_name, i));
-      }
+    for (int i = 0; i < GetArraySize(param); ++i) {
+      // Each QDMA queue is a separate parameter after rewriting.
+      add_dummy_read(qdma ? GetArrayElem(param_name, i)
+                          : ArrayNameAt(param_name, i));
     }
 
   } else if (IsTapaType(param, "ostreams")) {
+    auto type = GetStreamElemType(param);
     if (qdma) {
-      add_line("#error ostreams not supported for qdma-based tasks");
-    } else {
-      for (int i = 0; i < GetArraySize(param); ++i) {
-        add_dummy_write(ArrayNameAt(param_name, i), GetStreamElemType(param));
-      }
+      type = GetQdmaAxisType(param);
+    }
+    for (int i = 0; i < GetArraySize(param); ++i) {
+      add_dummy_write(
+          qdma ? GetArrayElem(param_name, i) : ArrayNameAt(param_name, i),
+          type);
     }
   }
 }
@@ -121,7 +125,15 @@ void XilinxHLSTarget::AddCodeForTopLevelFunc(ADD_FOR_FUNC_ARGS_DEF) {
 }
 
 void XilinxHLSTarget::AddCodeForTopLevelStream(ADD_FOR_PARAMS_ARGS_DEF) {
-  add_pragma({"HLS interface axis port =", param->getNameAsString()});
+  auto param_name = param->getNameAsString();
+  if (IsTapaType(param, "(i|o)streams")) {
+    // One QDMA queue per channel.
+    for (int i = 0; i < GetArraySize(param); ++i) {
+      add_pragma({"HLS interface axis port =", GetArrayElem(param_name, i)});
+    }
+  } else {
+    add_pragma({"HLS interface axis port =", param_name});
+  }
   AddDummyStreamRW(ADD_FOR_PARAMS_ARGS, true);
 }
 
@@ -358,15 +370,20 @@ void XilinxHLSTarget::RewriteFuncArguments(const clang::FunctionDecl *func,
         rewritten_text += "uint64_t " + GetArrayElem(param_name, i);
       }
       rewriter.ReplaceText(param->getSourceRange(), rewritten_text);
-    } else if (top && IsTapaType(param, "(i|o)stream")) {
-      // TODO: support streams
-      int width =
-          param->getASTContext()
-              .getTypeInfo(GetTemplateArg(param->getType(), 0)->getAsType())
-              .Width;
-      rewriter.ReplaceText(
-          param->getTypeSourceInfo()->getTypeLoc().getSourceRange(),
-          "hls::stream<qdma_axis<" + std::to_string(width) + ", 0, 0, 0> >&");
+    } else if (top && IsTapaType(param, "(i|o)streams?")) {
+      const std::string type =
+          "hls::stream<" + GetQdmaAxisType(param) + " >&";
+      if (IsTapaType(param, "(i|o)streams")) {
+        std::string rewritten_text;
+        for (int i = 0; i < GetArraySize(param); ++i) {
+          if (!rewritten_text.empty()) rewritten_text += ", ";
+          rewritten_text += type + " " + GetArrayElem(param_name, i);
+        }
+        rewriter.ReplaceText(param->getSourceRange(), rewritten_text);
+      } else {
+        rewriter.ReplaceText(
+            param->getTypeSourceInfo()->getTypeLoc().getSourceRange(), type);
+      }
       if (!qdma_header_inserted) {
         rewriter.InsertText(func->getBeginLoc(),
                             "#include \"ap_axi_sdata.h\"\n"
@@ -121,11 +121,18 @@ function(add_tapa_target target_name)
   list(APPEND tapa_cmd pack)
   list(APPEND tapa_cmd --output ${TAPA_OUTPUT})
 
+  # Let tapa share job slots of GNU make with other targets, so that parallel
+  # builds of several kernels do not oversubscribe HLS and synthesis jobs.
+  set(tapa_job_server_aware)
+  if(CMAKE_VERSION VERSION_GREATER_EQUAL 3.28)
+    set(tapa_job_server_aware JOB_SERVER_AWARE TRUE)
+  endif()
+
   add_custom_command(
     OUTPUT ${TAPA_OUTPUT}
     COMMAND ${tapa_cmd}
     DEPENDS ${TAPA_INPUT}
-    VERBATIM)
+    VERBATIM ${tapa_job_server_aware})
 
   add_custom_target(${target_name} DEPENDS ${TAPA_OUTPUT})
   set_target_properties(
@@ -1,6 +1,7 @@
 if(PROJECT_NAME STREQUAL "tapa")
   set(TAPA tapa)
   set(TAPA_CLI PYTHONPATH=${CMAKE_SOURCE_DIR}/backend/python python3 -m tapa.tapa)
+  set(TAPAC PYTHONPATH=${CMAKE_SOURCE_DIR}/backend/python python3 -m tapa.tapac)
   set(TAPACC $<TARGET_FILE:tapacc>)
   set(TAPA_CLANG ${CMAKE_BINARY_DIR}/backend/tapa-clang)
   include_directories(SYSTEM "${CMAKE_SOURCE_DIR}/src")
@@ -13,6 +14,7 @@ else()
   find_package(TAPA REQUIRED)
   find_package(FRT)
   set(TAPA tapa::tapa)
+  find_program(TAPAC tapac)
 endif()
 
 set(CMAKE_CXX_FLAGS "${CMAKE_C_FLAGS} -Wno-attributes")
@@ -198,42 +198,13 @@ bool verify(std::vector<DATA_TYPE> &sw_dist,
 }
 
 
-void Generate_sw_verif_data(std::vector<DATA_TYPE> &query,
-                            std::vector<DATA_TYPE> &searchSpace,
-                            std::vector<DATA_TYPE> &dist,
-                            std::vector<int> &id,
-                            unsigned int num_of_points)
+// Computes the top K (distance, ID) pairs of one query.
+void Compute_sw_top_k(const DATA_TYPE* query,
+                      std::vector<DATA_TYPE> &searchSpace,
+                      DATA_TYPE* dist,
+                      int* id,
+                      unsigned int num_of_points)
 {
-    // Generate random DATA_TYPE data
-    std::fill(query.begin(), query.end(), 0.0);
-    std::fill(searchSpace.begin(), searchSpace.end(), 0.0);
-    std::fill(dist.begin(), dist.end(), MAX_DATA_TYPE_VAL);
-    std::fill(id.begin(), id.end(), 0);
-
-    for (unsigned int i=0; i<INPUT_DIM; ++i){
-        // For a float payload, we want to normalize everything between 0 and 1
-        query[i] = static_cast <DATA_TYPE>(rand()) / static_cast<DATA_TYPE>(RAND_MAX);
-    }
-
-#if DATA_TYPE_TOTAL_SZ <= 20
-    unsigned long long int two_pow_data_type_total_sz = pow(static_cast<double> (2),
-                                                    static_cast<double> (DATA_TYPE_TOTAL_SZ));
-    unsigned long long int num_of_non_max_values = two_pow_data_type_total_sz / 4;
-    //unsigned long long int num_of_non_max_values = 500;
-    unsigned int start_of_non_max_values = rand() % (num_of_points - num_of_non_max_values);
-    //unsigned int start_of_non_max_values = 15;
-
-    printf("\nStart of non-max values = %d\n", start_of_non_max_values);
-    printf("\nNum of non-max value = %lld\n", num_of_non_max_values);
-#endif
-
-
-    for (unsigned long long int i=0; i<num_of_points*INPUT_DIM; ++i){
-        // For a float payload, we want to normalize everything between 0 and 1
-        searchSpace[i] = static_cast <DATA_TYPE>(rand()) / static_cast<DATA_TYPE>(RAND_MAX);
-
-    }
-
     DATA_TYPE delta_sum=0.0;
     DATA_TYPE delta=0.0;
     std::vector<DATA_TYPE> distance(num_of_points);
@@ -307,6 +278,48 @@ void Generate_sw_verif_data(std::vector<DATA_TYPE> &query,
         printf("KDEBUG: dist[%d]        = %f\n", i, dist[i]);
         printf("KDEBUG: searchSpace[%d] = %f\n", i, searchSpace[i]);
     }
+}
+
+void Generate_sw_verif_data(std::vector<DATA_TYPE> &query,
+                            std::vector<DATA_TYPE> &searchSpace,
+                            std::vector<DATA_TYPE> &dist,
+                            std::vector<int> &id,
+                            unsigned int num_of_points)
+{
+    // Generate random DATA_TYPE data
+    std::fill(query.begin(), query.end(), 0.0);
+    std::fill(searchSpace.begin(), searchSpace.end(), 0.0);
+    std::fill(dist.begin(), dist.end(), MAX_DATA_TYPE_VAL);
+    std::fill(id.begin(), id.end(), 0);
+
+    for (unsigned int i=0; i<NUM_QUERIES*INPUT_DIM; ++i){
+        // For a float payload, we want to normalize everything between 0 and 1
+        query[i] = static_cast <DATA_TYPE>(rand()) / static_cast<DATA_TYPE>(RAND_MAX);
+    }
+
+#if DATA_TYPE_TOTAL_SZ <= 20
+    unsigned long long int two_pow_data_type_total_sz = pow(static_cast<double> (2),
+                                                    static_cast<double> (DATA_TYPE_TOTAL_SZ));
+    unsigned long long int num_of_non_max_values = two_pow_data_type_total_sz / 4;
+    //unsigned long long int num_of_non_max_values = 500;
+    unsigned int start_of_non_max_values = rand() % (num_of_points - num_of_non_max_values);
+    //unsigned int start_of_non_max_values = 15;
+
+    printf("\nStart of non-max values = %d\n", start_of_non_max_values);
+    printf("\nNum of non-max value = %lld\n", num_of_non_max_values);
+#endif
+
+
+    for (unsigned long long int i=0; i<num_of_points*INPUT_DIM; ++i){
+        // For a float payload, we want to normalize everything between 0 and 1
+        searchSpace[i] = static_cast <DATA_TYPE>(rand()) / static_cast<DATA_TYPE>(RAND_MAX);
+
+    }
+
+    // The top K of query q are dist[q*TOP, (q+1)*TOP) and id[q*TOP, (q+1)*TOP).
+    for (int q = 0; q < NUM_QUERIES; ++q){
+        Compute_sw_top_k(&query[q*INPUT_DIM], searchSpace, &dist[q*TOP], &id[q*TOP], num_of_points);
+    }
 
     return;
 }
@@ -319,12 +332,12 @@ int main(int argc, char* argv[]) {
     int dataSize = NUM_SP_PTS_PADDED * num_pe;
     vector<float> searchspace_data(dataSize*INPUT_DIM);
 	vector<float> searchspace_data_part[num_pe];
-    vector<float> query_data(INPUT_DIM);
+    vector<float> query_data(NUM_QUERIES*INPUT_DIM);
 
-    vector<float> sw_dist(TOP);
-    vector<int> sw_id(TOP);
-    vector<float> hw_dist(TOP);
-    vector<int> hw_id(TOP);
+    vector<float> sw_dist(NUM_QUERIES*TOP);
+    vector<int> sw_id(NUM_QUERIES*TOP);
+    vector<float> hw_dist(NUM_QUERIES*TOP);
+    vector<int> hw_id(NUM_QUERIES*TOP);
 
     // Initializing hw output vectors to zero
     std::fill(hw_dist.begin(), hw_dist.end(), 0.0);
@@ -341,7 +354,7 @@ int main(int argc, char* argv[]) {
         for (unsigned int j = 0; j < QUERY_FEATURE_RESERVE; ++j){
             searchspace_data_part[i][j] = 0.0;
         }
-        for (int j = 0; j < INPUT_DIM; ++j){
+        for (int j = 0; j < NUM_QUERIES*INPUT_DIM; ++j){
             searchspace_data_part[i][j] = query_data[j];
         }
         for (int j = 0; j < part_size; ++j){
@@ -380,10 +393,19 @@ int main(int argc, char* argv[]) {
 	auto stop = high_resolution_clock::now();
 	duration<double> elapsed = stop - start;
 	clog << "elapsed time: " << elapsed.count() << " s" << endl;
+	clog << "throughput: " << NUM_QUERIES / elapsed.count() << " queries/s" << endl;
 
 	// verify results
     bool match = true;
-    match = verify(sw_dist, hw_dist, sw_id, hw_id, query_data, searchspace_data, TOP);
+    for (int q = 0; q < NUM_QUERIES; ++q) {
+        clog << "query " << q << endl;
+        std::vector<DATA_TYPE> query(query_data.begin() + q*INPUT_DIM, query_data.begin() + (q+1)*INPUT_DIM);
+        std::vector<DATA_TYPE> q_sw_dist(sw_dist.begin() + q*TOP, sw_dist.begin() + (q+1)*TOP);
+        std::vector<DATA_TYPE> q_hw_dist(hw_dist.begin() + q*TOP, hw_dist.begin() + (q+1)*TOP);
+        std::vector<int> q_sw_id(sw_id.begin() + q*TOP, sw_id.begin() + (q+1)*TOP);
+        std::vector<int> q_hw_id(hw_id.begin() + q*TOP, hw_id.begin() + (q+1)*TOP);
+        match &= verify(q_sw_dist, q_hw_dist, q_sw_id, q_hw_id, query, searchspace_data, TOP);
+    }
     clog << (match ? "PASSED" : "FAILED") << endl;
     return (match ? EXIT_SUCCESS : EXIT_FAILURE);
 }
@@ -54,6 +54,14 @@ typedef ap_axiu<32, 0, 0, 0>    id_pkt;
 const int NUM_FEATURES_PER_READ = (IWIDTH/DATA_TYPE_TOTAL_SZ);
 const int QUERY_FEATURE_RESERVE = (128);
 #define QUERY_DATA_RESERVE (QUERY_FEATURE_RESERVE / NUM_FEATURES_PER_READ)
+// Number of queries evaluated in each pass over the search space. Query q is
+//  stored at feature q*INPUT_DIM of the reserved area; each query has its own
+//  distance buffers and top-K sorters, and the merge stages are shared.
+#ifndef NUM_QUERIES
+#define NUM_QUERIES (1)
+#endif
+static_assert(NUM_QUERIES * INPUT_DIM <= QUERY_FEATURE_RESERVE,
+              "the query batch must fit in the reserved area");
 #define MAX_DATA_TYPE_VAL (3.402823e+38f)
 #define FLOOR_SQRT_MAX_DATA_TYPE_VAL (1.8446742e+19f)
 
@@ -109,8 +117,8 @@ void load(int flag, int tile_idx, INTERFACE_WIDTH* local_SP, tapa::async_mmap<IN
 /******************* COMPUTES: *******************/
 /*************************************************/
 
-void compute(int flag, DATA_TYPE* local_Query, INTERFACE_WIDTH* local_SP,
-        LOCAL_DIST_DTYPE local_distance[NUM_SEGMENTS][SEGMENT_SIZE_IN_L+TOP],
+void compute(int flag, DATA_TYPE local_Query[NUM_QUERIES][INPUT_DIM], INTERFACE_WIDTH* local_SP,
+        LOCAL_DIST_DTYPE local_distance[NUM_QUERIES][NUM_SEGMENTS][SEGMENT_SIZE_IN_L+TOP],
         int debug_i)
 {
 #pragma HLS INLINE OFF
@@ -126,37 +134,43 @@ void compute(int flag, DATA_TYPE* local_Query, INTERFACE_WIDTH* local_SP,
                 for (int kk = 0; kk < D2I_FACTOR_W; ++kk){
                 #pragma HLS UNROLL
 
-                    DATA_TYPE delta_squared_sum = 0.0;
                     unsigned int dist_range_idx =  (kk % D2L_FACTOR_W) * DATA_TYPE_TOTAL_SZ;
                     int start_idx = kk * INPUT_DIM;
 
+                    // Each point is read once and compared with all queries.
+                    DATA_TYPE sp_dim_item_values[INPUT_DIM];
                     for (int ll = 0; ll < INPUT_DIM; ++ll){
                         unsigned int sp_range_idx = (start_idx + ll) * DATA_TYPE_TOTAL_SZ;
 
-                        DATA_TYPE sp_dim_item_value;
                         TRANSFER_TYPE tmp;
 
                         tmp.range(DATA_TYPE_TOTAL_SZ-1, 0) =
                             local_SP[SP_idx].range(sp_range_idx + (DATA_TYPE_TOTAL_SZ-1),
                                                    sp_range_idx);
 
-                        sp_dim_item_value = *((DATA_TYPE*) (&tmp));
+                        sp_dim_item_values[ll] = *((DATA_TYPE*) (&tmp));
+                    }
+
+                    for (int q = 0; q < NUM_QUERIES; ++q){
+                    #pragma HLS UNROLL
+                        DATA_TYPE delta_squared_sum = 0.0;
 
+                        for (int ll = 0; ll < INPUT_DIM; ++ll){
 #if DISTANCE_METRIC == 0 // manhattan
-                        DATA_TYPE delta = absval(sp_dim_item_value - local_Query[ll]);
-                        delta_squared_sum += delta;
+                            DATA_TYPE delta = absval(sp_dim_item_values[ll] - local_Query[q][ll]);
+                            delta_squared_sum += delta;
 #elif DISTANCE_METRIC == 1 // L2
-                        // NOTE(Kenny): I think this absval will help unsigned payloads.
-                        DATA_TYPE delta = absval(sp_dim_item_value - local_Query[ll]);
-                        delta_squared_sum += delta * delta;
+                            // NOTE(Kenny): I think this absval will help unsigned payloads.
+                            DATA_TYPE delta = absval(sp_dim_item_values[ll] - local_Query[q][ll]);
+                            delta_squared_sum += delta * delta;
 #endif
-                    }
-                    aggregated_local_dists = delta_squared_sum;
+                        }
+                        aggregated_local_dists = delta_squared_sum;
 
-                    if ((kk % D2L_FACTOR_W) == D2L_FACTOR_W - 1){
-                        unsigned int inner_idx_location = (jj*D2I_FACTOR_W + kk) / D2L_FACTOR_W;
-                        local_distance[ii][inner_idx_location] = aggregated_local_dists;
-                        aggregated_local_dists = 0;
+                        if ((kk % D2L_FACTOR_W) == D2L_FACTOR_W - 1){
+                            unsigned int inner_idx_location = (jj*D2I_FACTOR_W + kk) / D2L_FACTOR_W;
+                            local_distance[q][ii][inner_idx_location] = aggregated_local_dists;
+                        }
                     }
                 }
             }
@@ -360,25 +374,27 @@ void krnl_partialKnn(
 {
     #pragma HLS inline
 
-    DATA_TYPE local_Query_0[INPUT_DIM];
-    #pragma HLS ARRAY_PARTITION variable=local_Query_0 complete dim=1
+    DATA_TYPE local_Query_0[NUM_QUERIES][INPUT_DIM];
+    #pragma HLS ARRAY_PARTITION variable=local_Query_0 complete dim=0
     INTERFACE_WIDTH local_SP_0_A[TILE_LEN_IN_I];
     #pragma HLS RESOURCE variable=local_SP_0_A core=XPM_MEMORY uram
     INTERFACE_WIDTH local_SP_0_B[TILE_LEN_IN_I];
     #pragma HLS RESOURCE variable=local_SP_0_B core=XPM_MEMORY uram
 
-    LOCAL_DIST_DTYPE local_distance_0_A[NUM_SEGMENTS][SEGMENT_SIZE_IN_L+TOP];
+    LOCAL_DIST_DTYPE local_distance_0_A[NUM_QUERIES][NUM_SEGMENTS][SEGMENT_SIZE_IN_L+TOP];
     #pragma HLS ARRAY_PARTITION variable=local_distance_0_A complete dim=1
-    #pragma HLS ARRAY_PARTITION variable=local_distance_0_A cyclic factor=L2I_FACTOR_W dim=2
-    LOCAL_DIST_DTYPE local_distance_0_B[NUM_SEGMENTS][SEGMENT_SIZE_IN_L+TOP];
+    #pragma HLS ARRAY_PARTITION variable=local_distance_0_A complete dim=2
+    #pragma HLS ARRAY_PARTITION variable=local_distance_0_A cyclic factor=L2I_FACTOR_W dim=3
+    LOCAL_DIST_DTYPE local_distance_0_B[NUM_QUERIES][NUM_SEGMENTS][SEGMENT_SIZE_IN_L+TOP];
     #pragma HLS ARRAY_PARTITION variable=local_distance_0_B complete dim=1
-    #pragma HLS ARRAY_PARTITION variable=local_distance_0_B cyclic factor=L2I_FACTOR_W dim=2
+    #pragma HLS ARRAY_PARTITION variable=local_distance_0_B complete dim=2
+    #pragma HLS ARRAY_PARTITION variable=local_distance_0_B cyclic factor=L2I_FACTOR_W dim=3
 
     // These are the outputs of the sort() function.
-    //  Together, they contain the nearest (distance, ID) pairs for each segment of all tiles.
-    static DATA_TYPE local_kNearstDist_partial_0[NUM_SEGMENTS][D2L_FACTOR_W][(TOP+1)];
+    //  Together, they contain the nearest (distance, ID) pairs for each query and segment of all tiles.
+    static DATA_TYPE local_kNearstDist_partial_0[NUM_QUERIES][NUM_SEGMENTS][D2L_FACTOR_W][(TOP+1)];
     #pragma HLS ARRAY_PARTITION variable=local_kNearstDist_partial_0 complete dim=0
-    static int local_kNearstId_partial_0[NUM_SEGMENTS][D2L_FACTOR_W][(TOP+1)];
+    static int local_kNearstId_partial_0[NUM_QUERIES][NUM_SEGMENTS][D2L_FACTOR_W][(TOP+1)];
     #pragma HLS ARRAY_PARTITION variable=local_kNearstId_partial_0 complete dim=0
 
     // These store the top K results for each PE.
@@ -387,17 +403,17 @@ void krnl_partialKnn(
     int local_kNearstId[NUM_PART][TOP+1];
     #pragma HLS ARRAY_PARTITION variable=local_kNearstId complete dim=0
 
-    // These store the top K results for this KERNEL.
-    DATA_TYPE global_kNearstDist[TOP+1];
-    #pragma HLS ARRAY_PARTITION variable=global_kNearstDist complete
-    int global_kNearstId[TOP+1];
-    #pragma HLS ARRAY_PARTITION variable=global_kNearstId complete
+    // These store the top K results of each query for this KERNEL.
+    DATA_TYPE global_kNearstDist[NUM_QUERIES][TOP+1];
+    #pragma HLS ARRAY_PARTITION variable=global_kNearstDist complete dim=0
+    int global_kNearstId[NUM_QUERIES][TOP+1];
+    #pragma HLS ARRAY_PARTITION variable=global_kNearstId complete dim=0
 
-    LOAD_QUERY: for (int i_req = 0, i_resp = 0; i_resp < INPUT_DIM;){
+    LOAD_QUERY: for (int i_req = 0, i_resp = 0; i_resp < NUM_QUERIES*INPUT_DIM;){
         #pragma HLS pipeline II=1
         // issue read address
         int input_rd_idx = i_req / NUM_FEATURES_PER_READ;
-        if (i_req < INPUT_DIM && searchSpace_0.read_addr.try_write(input_rd_idx)) {
+        if (i_req < NUM_QUERIES*INPUT_DIM && searchSpace_0.read_addr.try_write(input_rd_idx)) {
           ++i_req;
         }
 
@@ -409,7 +425,7 @@ void krnl_partialKnn(
           tmp.range(DATA_TYPE_TOTAL_SZ - 1, 0)
               = resp.range(range_idx*DATA_TYPE_TOTAL_SZ + (DATA_TYPE_TOTAL_SZ-1),
                                                           range_idx*DATA_TYPE_TOTAL_SZ);
-          local_Query_0[i_resp] = *((DATA_TYPE*)(&tmp));
+          local_Query_0[i_resp / INPUT_DIM][i_resp % INPUT_DIM] = *((DATA_TYPE*)(&tmp));
 
           i_resp++;
         }
@@ -417,6 +433,7 @@ void krnl_partialKnn(
 
     ITERATION_LOOP: for (int it_idx = 0; it_idx < NUM_ITERATIONS; ++it_idx)
     {
+        for (int q = 0; q < NUM_QUERIES; ++q){
         for (int i = 0; i < NUM_SEGMENTS; ++i){
             for (int j = 0; j < TOP; ++j){
             #pragma HLS PIPELINE II=1
@@ -429,20 +446,23 @@ void krnl_partialKnn(
                     aggregated_local_dists = maxval;
                 }
 
-                local_distance_0_A[i][SEGMENT_SIZE_IN_L+j] = aggregated_local_dists;
-                local_distance_0_B[i][SEGMENT_SIZE_IN_L+j] = aggregated_local_dists;
+                local_distance_0_A[q][i][SEGMENT_SIZE_IN_L+j] = aggregated_local_dists;
+                local_distance_0_B[q][i][SEGMENT_SIZE_IN_L+j] = aggregated_local_dists;
             }
+        }
         }
 
+		for (int q = 0; q < NUM_QUERIES; ++q){
 		for (int i = 0; i < NUM_SEGMENTS; ++i){
 			for (int j = 0; j < D2L_FACTOR_W; ++j){
                 for (int k = 0; k < TOP+1; ++k){
 			    #pragma HLS UNROLL
-			    	local_kNearstId_partial_0[i][j][k] = -1;
-			        local_kNearstDist_partial_0[i][j][k] = MAX_DATA_TYPE_VAL;
+			    	local_kNearstId_partial_0[q][i][j][k] = -1;
+			        local_kNearstDist_partial_0[q][i][j][k] = MAX_DATA_TYPE_VAL;
 			    }
             }
 		}
+		}
 
         for(int i = 0; i < NUM_OF_TILES+2; ++i){
             int load_img_flag = i >= 0 && i < NUM_OF_TILES;
@@ -451,103 +471,119 @@ void krnl_partialKnn(
             if (i % 2 == 0) {
                 load(load_img_flag, i, local_SP_0_A, searchSpace_0);
                 compute(compute_flag, local_Query_0, local_SP_0_B, local_distance_0_B, i);
-                sort(sort_flag, start_id_0+(i-2)*TILE_LEN_IN_D, local_distance_0_A, local_kNearstDist_partial_0, local_kNearstId_partial_0);
+                for (int q = 0; q < NUM_QUERIES; ++q){
+                #pragma HLS UNROLL
+                    sort(sort_flag, start_id_0+(i-2)*TILE_LEN_IN_D, local_distance_0_A[q], local_kNearstDist_partial_0[q], local_kNearstId_partial_0[q]);
+                }
             }
             else {
                 load(load_img_flag, i, local_SP_0_B, searchSpace_0);
                 compute(compute_flag, local_Query_0, local_SP_0_A, local_distance_0_A, i);
-                sort(sort_flag, start_id_0+(i-2)*TILE_LEN_IN_D, local_distance_0_B, local_kNearstDist_partial_0, local_kNearstId_partial_0);
+                for (int q = 0; q < NUM_QUERIES; ++q){
+                #pragma HLS UNROLL
+                    sort(sort_flag, start_id_0+(i-2)*TILE_LEN_IN_D, local_distance_0_B[q], local_kNearstDist_partial_0[q], local_kNearstId_partial_0[q]);
+                }
             }
         }
         /**********************************************************************/
         /**************************  MERGING PARTIAL SORTS ********************/
         /**********************************************************************/
-        DATA_TYPE temp_kNearstDist[NUM_SEGMENTS][D2L_FACTOR_W*2][NUM_PART][TOP+1];
-        #pragma HLS ARRAY_PARTITION variable=temp_kNearstDist complete dim=1
-        #pragma HLS ARRAY_PARTITION variable=temp_kNearstDist complete dim=2
-        #pragma HLS ARRAY_PARTITION variable=temp_kNearstDist complete dim=3
-        #pragma HLS RESOURCE variable=temp_kNearstDist core=RAM_1P_LUTRAM
-        int       temp_kNearstId  [NUM_SEGMENTS][D2L_FACTOR_W*2][NUM_PART][TOP+1];
-        #pragma HLS ARRAY_PARTITION variable=temp_kNearstId complete dim=1
-        #pragma HLS ARRAY_PARTITION variable=temp_kNearstId complete dim=2
-        #pragma HLS ARRAY_PARTITION variable=temp_kNearstId complete dim=3
-        #pragma HLS RESOURCE variable=temp_kNearstId core=RAM_1P_LUTRAM
-
-        for (int i = 0; i < NUM_SEGMENTS; ++i)
+        // The merge stages are shared by the queries of the batch.
+        MERGE_QUERIES: for (int q = 0; q < NUM_QUERIES; ++q)
         {
-        #pragma HLS unroll
-            for (int j = 0; j < D2L_FACTOR_W; ++j)
+            DATA_TYPE temp_kNearstDist[NUM_SEGMENTS][D2L_FACTOR_W*2][NUM_PART][TOP+1];
+            #pragma HLS ARRAY_PARTITION variable=temp_kNearstDist complete dim=1
+            #pragma HLS ARRAY_PARTITION variable=temp_kNearstDist complete dim=2
+            #pragma HLS ARRAY_PARTITION variable=temp_kNearstDist complete dim=3
+            #pragma HLS RESOURCE variable=temp_kNearstDist core=RAM_1P_LUTRAM
+            int       temp_kNearstId  [NUM_SEGMENTS][D2L_FACTOR_W*2][NUM_PART][TOP+1];
+            #pragma HLS ARRAY_PARTITION variable=temp_kNearstId complete dim=1
+            #pragma HLS ARRAY_PARTITION variable=temp_kNearstId complete dim=2
+            #pragma HLS ARRAY_PARTITION variable=temp_kNearstId complete dim=3
+            #pragma HLS RESOURCE variable=temp_kNearstId core=RAM_1P_LUTRAM
+
+            for (int i = 0; i < NUM_SEGMENTS; ++i)
             {
             #pragma HLS unroll
-                for (int k = 0; k < TOP+1; ++k)
+                for (int j = 0; j < D2L_FACTOR_W; ++j)
                 {
                 #pragma HLS unroll
-                    temp_kNearstDist[i][j][0][k] = local_kNearstDist_partial_0[i][j][k];
-                    temp_kNearstId  [i][j][0][k] = local_kNearstId_partial_0  [i][j][k];
+                    for (int k = 0; k < TOP+1; ++k)
+                    {
+                    #pragma HLS unroll
+                        temp_kNearstDist[i][j][0][k] = local_kNearstDist_partial_0[q][i][j][k];
+                        temp_kNearstId  [i][j][0][k] = local_kNearstId_partial_0  [q][i][j][k];
 
+                    }
                 }
             }
-        }
 
-        /*********************************************/
-        /* Merge pairwise on the NUM_SEGMENTS-level. */
-        /*********************************************/
-
-        for (int i = 0; i < 4; ++i){
-        #pragma HLS unroll
-            merge_dual_all_PEs(temp_kNearstDist[i*2 + 0][0],
-                               temp_kNearstDist[i*2 + 1][0],
-                               temp_kNearstId  [i*2 + 0][0],
-                               temp_kNearstId  [i*2 + 1][0],
-                               temp_kNearstDist[i][D2L_FACTOR_W],
-                               temp_kNearstId  [i][D2L_FACTOR_W]);
-        }
-        for (int i = 0; i < 2; ++i){
-        #pragma HLS unroll
-            merge_dual_all_PEs(temp_kNearstDist[i*2 + 0][D2L_FACTOR_W],
-                               temp_kNearstDist[i*2 + 1][D2L_FACTOR_W],
-                               temp_kNearstId  [i*2 + 0][D2L_FACTOR_W],
-                               temp_kNearstId  [i*2 + 1][D2L_FACTOR_W],
-                               temp_kNearstDist[i][0],
-                               temp_kNearstId  [i][0]);
-        }
-        for (int i = 0; i < NUM_PART; ++i)
-        {
-        #pragma HLS UNROLL
-            merge_dual(temp_kNearstDist[0][0][i],
-                       temp_kNearstDist[1][0][i],
-                       temp_kNearstId  [0][0][i],
-                       temp_kNearstId  [1][0][i],
-                       local_kNearstDist[i],
-                       local_kNearstId  [i]);
-        }
+            /*********************************************/
+            /* Merge pairwise on the NUM_SEGMENTS-level. */
+            /*********************************************/
+
+            for (int i = 0; i < 4; ++i){
+            #pragma HLS unroll
+                merge_dual_all_PEs(temp_kNearstDist[i*2 + 0][0],
+                                   temp_kNearstDist[i*2 + 1][0],
+                                   temp_kNearstId  [i*2 + 0][0],
+                                   temp_kNearstId  [i*2 + 1][0],
+                                   temp_kNearstDist[i][D2L_FACTOR_W],
+                                   temp_kNearstId  [i][D2L_FACTOR_W]);
+            }
+            for (int i = 0; i < 2; ++i){
+            #pragma HLS unroll
+                merge_dual_all_PEs(temp_kNearstDist[i*2 + 0][D2L_FACTOR_W],
+                                   temp_kNearstDist[i*2 + 1][D2L_FACTOR_W],
+                                   temp_kNearstId  [i*2 + 0][D2L_FACTOR_W],
+                                   temp_kNearstId  [i*2 + 1][D2L_FACTOR_W],
+                                   temp_kNearstDist[i][0],
+                                   temp_kNearstId  [i][0]);
+            }
+            for (int i = 0; i < NUM_PART; ++i)
+            {
+            #pragma HLS UNROLL
+                merge_dual(temp_kNearstDist[0][0][i],
+                           temp_kNearstDist[1][0][i],
+                           temp_kNearstId  [0][0][i],
+                           temp_kNearstId  [1][0][i],
+                           local_kNearstDist[i],
+                           local_kNearstId  [i]);
+            }
 
-        // Copy the data to the global buffer.
-        for (int j = 0; j < TOP+1; ++j){
-            global_kNearstDist[j] = local_kNearstDist[0][j];
-            global_kNearstId[j] = local_kNearstId[0][j];
+            // Copy the data to the global buffer.
+            for (int j = 0; j < TOP+1; ++j){
+                global_kNearstDist[q][j] = local_kNearstDist[0][j];
+                global_kNearstId[q][j] = local_kNearstId[0][j];
+            }
         }
     }
 
     STREAM_WIDTH v_data;
     DATA_TYPE temp_data;
-    DIST_OUT: for (int i = 1; i < TOP+1; ++i)
+    DIST_OUT: for (int q = 0; q < NUM_QUERIES; ++q)
     {
-    #pragma HLS PIPELINE II=1
-        temp_data = global_kNearstDist[i];
+        for (int i = 1; i < TOP+1; ++i)
+        {
+        #pragma HLS PIPELINE II=1
+            temp_data = global_kNearstDist[q][i];
 
-        v_data = *((STREAM_WIDTH*)(&temp_data));
+            v_data = *((STREAM_WIDTH*)(&temp_data));
 
-        pkt v;
-        v.data = v_data;
-        out_dist.write(v);
+            pkt v;
+            v.data = v_data;
+            out_dist.write(v);
+        }
     }
-    ID_OUT: for (int i = 1; i < TOP+1; ++i)
+    ID_OUT: for (int q = 0; q < NUM_QUERIES; ++q)
     {
-    #pragma HLS PIPELINE II=1
-        id_pkt v_id;
-        v_id.data = global_kNearstId[i];
-        out_id.write(v_id);
+        for (int i = 1; i < TOP+1; ++i)
+        {
+        #pragma HLS PIPELINE II=1
+            id_pkt v_id;
+            v_id.data = global_kNearstId[q][i];
+            out_id.write(v_id);
+        }
     }
     return;
 }
@@ -786,50 +822,53 @@ void krnl_globalSort_L1_L2(
     int output_id[TOP];
     #pragma HLS ARRAY_PARTITION variable=output_id complete
 
-    for (unsigned int i=0; i<TOP; ++i) {
-    #pragma HLS PIPELINE II=1
-      pkt v0 = in_dist0.read();
-      STREAM_WIDTH v0_item = v0.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
-      local_kNearstDist_partial[0][i] = *((DATA_TYPE*)(&v0_item));
-      pkt v1 = in_dist1.read();
-      STREAM_WIDTH v1_item = v1.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
-      local_kNearstDist_partial[1][i] = *((DATA_TYPE*)(&v1_item));
-      pkt v2 = in_dist2.read();
-      STREAM_WIDTH v2_item = v2.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
-      local_kNearstDist_partial[2][i] = *((DATA_TYPE*)(&v2_item));
-    }
+    // The results of the queries of a batch arrive one query after another.
+    QUERY_LOOP: for (int q = 0; q < NUM_QUERIES; ++q) {
+        for (unsigned int i=0; i<TOP; ++i) {
+        #pragma HLS PIPELINE II=1
+          pkt v0 = in_dist0.read();
+          STREAM_WIDTH v0_item = v0.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
+          local_kNearstDist_partial[0][i] = *((DATA_TYPE*)(&v0_item));
+          pkt v1 = in_dist1.read();
+          STREAM_WIDTH v1_item = v1.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
+          local_kNearstDist_partial[1][i] = *((DATA_TYPE*)(&v1_item));
+          pkt v2 = in_dist2.read();
+          STREAM_WIDTH v2_item = v2.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
+          local_kNearstDist_partial[2][i] = *((DATA_TYPE*)(&v2_item));
+        }
 
-    for (unsigned int i=0; i<TOP; ++i) {
-    #pragma HLS PIPELINE II=1
-      id_pkt v0_id = in_id0.read();
-      local_kNearstId_partial[0][i] = v0_id.data;
-      id_pkt v1_id = in_id1.read();
-      local_kNearstId_partial[1][i] = v1_id.data;
-      id_pkt v2_id = in_id2.read();
-      local_kNearstId_partial[2][i] = v2_id.data;
-    }
+        for (unsigned int i=0; i<TOP; ++i) {
+        #pragma HLS PIPELINE II=1
+          id_pkt v0_id = in_id0.read();
+          local_kNearstId_partial[0][i] = v0_id.data;
+          id_pkt v1_id = in_id1.read();
+          local_kNearstId_partial[1][i] = v1_id.data;
+          id_pkt v2_id = in_id2.read();
+          local_kNearstId_partial[2][i] = v2_id.data;
+        }
 
-    seq_global_merge_L1_L2(local_kNearstDist_partial, local_kNearstId_partial, output_dist, output_id);
+        seq_global_merge_L1_L2(local_kNearstDist_partial, local_kNearstId_partial, output_dist, output_id);
 
-    STREAM_WIDTH v_data;
-    DATA_TYPE temp_data;
-    DIST_OUT: for (int i = 0; i < TOP; ++i)
-    {
-    #pragma HLS PIPELINE II=1
-        temp_data = output_dist[i];
+        STREAM_WIDTH v_data;
+        DATA_TYPE temp_data;
+        DIST_OUT: for (int i = 0; i < TOP; ++i)
+        {
+        #pragma HLS PIPELINE II=1
+            temp_data = output_dist[i];
 
-        v_data = *((STREAM_WIDTH*)(&temp_data));
+            v_data = *((STREAM_WIDTH*)(&temp_data));
 
-        pkt v;
-        v.data = v_data;
-        out_dist.write(v);
-    }
-    ID_OUT: for (int i = 0; i < TOP; ++i)
-    {
-    #pragma HLS PIPELINE II=1
-        id_pkt v_id;
-        v_id.data = output_id[i];
-        out_id.write(v_id);
+            pkt v;
+            v.data = v_data;
+            out_dist.write(v);
+        }
+        ID_OUT: for (int i = 0; i < TOP; ++i)
+        {
+        #pragma HLS PIPELINE II=1
+            id_pkt v_id;
+            v_id.data = output_id[i];
+            out_id.write(v_id);
+        }
     }
 
 }
@@ -884,60 +923,64 @@ void krnl_globalSort_L3(
     int output_id[TOP];
     #pragma HLS ARRAY_PARTITION variable=output_id complete
 
-    for (unsigned int i=0; i<TOP; ++i) {
-    #pragma HLS PIPELINE II=1
-      pkt v0 = in_dist0.read();
-      STREAM_WIDTH v0_item = v0.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
-      local_kNearstDist_partial[0][i] = *((DATA_TYPE*)(&v0_item));
-      pkt v1 = in_dist1.read();
-      STREAM_WIDTH v1_item = v1.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
-      local_kNearstDist_partial[1][i] = *((DATA_TYPE*)(&v1_item));
-    }
+    // The results of query q are written to output[q*TOP, (q+1)*TOP).
+    QUERY_LOOP: for (int q = 0; q < NUM_QUERIES; ++q) {
+        for (unsigned int i=0; i<TOP; ++i) {
+        #pragma HLS PIPELINE II=1
+          pkt v0 = in_dist0.read();
+          STREAM_WIDTH v0_item = v0.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
+          local_kNearstDist_partial[0][i] = *((DATA_TYPE*)(&v0_item));
+          pkt v1 = in_dist1.read();
+          STREAM_WIDTH v1_item = v1.data.range(DATA_TYPE_TOTAL_SZ-1, 0);
+          local_kNearstDist_partial[1][i] = *((DATA_TYPE*)(&v1_item));
+        }
 
-    for (unsigned int i=0; i<TOP; ++i) {
-    #pragma HLS PIPELINE II=1
-      id_pkt v0_id = in_id0.read();
-      local_kNearstId_partial[0][i] = v0_id.data;
-      id_pkt v1_id = in_id1.read();
-      local_kNearstId_partial[1][i] = v1_id.data;
-    }
+        for (unsigned int i=0; i<TOP; ++i) {
+        #pragma HLS PIPELINE II=1
+          id_pkt v0_id = in_id0.read();
+          local_kNearstId_partial[0][i] = v0_id.data;
+          id_pkt v1_id = in_id1.read();
+          local_kNearstId_partial[1][i] = v1_id.data;
+        }
 
-    seq_global_merge_L3(local_kNearstDist_partial, local_kNearstId_partial, output_dist, output_id);
+        seq_global_merge_L3(local_kNearstDist_partial, local_kNearstId_partial, output_dist, output_id);
 
-for (unsigned int i_req_dist = 0, i_resp_dist = 0, i_req_id = 0, i_resp_id = 0; i_resp_dist < TOP || i_resp_id < TOP; ) {
-      #pragma HLS pipeline II=1
+        for (unsigned int i_req_dist = 0, i_resp_dist = 0, i_req_id = 0, i_resp_id = 0; i_resp_dist < TOP || i_resp_id < TOP; ) {
+          #pragma HLS pipeline II=1
 
-      // write to output_KnnDist
-      if (i_req_dist < TOP &&
-          !output_knnDist.write_addr.full() &&
-          !output_knnDist.write_data.full()
-      ) {
-        output_knnDist.write_addr.try_write(i_req_dist);
-        output_knnDist.write_data.try_write(output_dist[i_req_dist]);
+          // write to output_KnnDist
+          if (i_req_dist < TOP &&
+              !output_knnDist.write_addr.full() &&
+              !output_knnDist.write_data.full()
+          ) {
+            output_knnDist.write_addr.try_write(q*TOP + i_req_dist);
+            output_knnDist.write_data.try_write(output_dist[i_req_dist]);
 
-        ++i_req_dist;
-      }
+            ++i_req_dist;
+          }
 
-      if (!output_knnDist.write_resp.empty()) {
-        i_resp_dist += (unsigned int)(output_knnDist.write_resp.read(nullptr)) + 1;
-      }
+          if (!output_knnDist.write_resp.empty()) {
+            i_resp_dist += (unsigned int)(output_knnDist.write_resp.read(nullptr)) + 1;
+          }
 
-      // write to output_KnnId
-      if (i_req_id < TOP &&
-          !output_knnId.write_addr.full() &&
-          !output_knnId.write_data.full()
-      ) {
-        output_knnId.write_addr.try_write(i_req_id);
-        output_knnId.write_data.try_write(output_id[i_req_id]);
+          // write to output_KnnId
+          if (i_req_id < TOP &&
+              !output_knnId.write_addr.full() &&
+              !output_knnId.write_data.full()
+          ) {
+            output_knnId.write_addr.try_write(q*TOP + i_req_id);
+            output_knnId.write_data.try_write(output_id[i_req_id]);
 
-        ++i_req_id;
-      }
+            ++i_req_id;
+          }
 
-      if (!output_knnId.write_resp.empty()) {
-        i_resp_id += (unsigned int)(output_knnId.write_resp.read(nullptr)) + 1;
-      }
+          if (!output_knnId.write_resp.empty()) {
+            i_resp_id += (unsigned int)(output_knnId.write_resp.read(nullptr)) + 1;
+          }
 
+        }
     }
+
 }
 
 void Knn(
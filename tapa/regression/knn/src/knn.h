@@ -53,6 +53,10 @@ typedef ap_axiu<32, 0, 0, 0>    id_pkt;
 const int NUM_FEATURES_PER_READ = (IWIDTH/DATA_TYPE_TOTAL_SZ);
 const int QUERY_FEATURE_RESERVE = (128);
 #define QUERY_DATA_RESERVE (QUERY_FEATURE_RESERVE / NUM_FEATURES_PER_READ)
+// Number of queries evaluated in each pass over the search space.
+#ifndef NUM_QUERIES
+#define NUM_QUERIES (1)
+#endif
 #define MAX_DATA_TYPE_VAL (3.402823e+38f)
 #define FLOOR_SQRT_MAX_DATA_TYPE_VAL (1.8446742e+19f)
 
@@ -52,6 +52,44 @@ struct Partition {
   std::unique_ptr<EdgeType, std::function<void(EdgeType*)>> shard;
 };
 
+// Tracks the active partitions of an iterative algorithm. All partitions are
+// active in the first iteration. A partition is active in the next iteration
+// if any of its vertices is updated in the current one; the shards of inactive
+// partitions cannot produce new updates and can be skipped.
+template <typename Vid>
+class Frontier {
+ public:
+  Frontier(Vid base_vid, Vid partition_size, size_t num_partitions)
+      : base_vid_(base_vid),
+        partition_size_(partition_size),
+        active_(num_partitions, true),
+        next_active_(num_partitions, false) {}
+
+  size_t NumPartitions() const { return active_.size(); }
+  size_t NumActivePartitions() const {
+    return std::count(active_.begin(), active_.end(), true);
+  }
+  bool IsActive(size_t pid) const { return active_[pid]; }
+
+  // Activates the partition of vid in the next iteration.
+  void Activate(Vid vid) {
+    next_active_[(vid - base_vid_) / partition_size_] = true;
+  }
+
+  // Starts the next iteration. Returns whether any partition is active.
+  bool Advance() {
+    active_.swap(next_active_);
+    std::fill(next_active_.begin(), next_active_.end(), false);
+    return NumActivePartitions() > 0;
+  }
+
+ private:
+  Vid base_vid_;
+  Vid partition_size_;
+  std::vector<bool> active_;
+  std::vector<bool> next_active_;
+};
+
 // Processes text between begin_ptr and end_ptr and return the edge array as a
 // unique_ptr. If max_vid or min_vid is not nullptr, it will be updated.
 template <typename Vid, typename EdgeAttr = std::nullptr_t>
@@ -118,6 +118,16 @@ class obuffer : public virtual internal::basic_buffer<T, n_sections> {
  public:
   using section_t = section<T, n_sections, dims...>;
   section_t acquire() { return section_t(*this, true); }
+
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+  /// Acquires a free section in a @c tapa::coroutine task, suspending the
+  /// calling coroutine until one is available.
+  auto async_acquire() {
+    return internal::make_awaiter(
+        [this] { return !this->inner_data->free_sections.empty(); },
+        [this] { return section_t(*this, true); });
+  }
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
 };
 
 /// Provides consumer-side access to a @c tapa::buffer object where it is used
@@ -150,6 +160,16 @@ class ibuffer : public virtual internal::basic_buffer<T, n_sections> {
  public:
   using section_t = section<T, n_sections, dims...>;
   section_t acquire() { return section_t(*this, false); }
+
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+  /// Acquires an occupied section in a @c tapa::coroutine task, suspending the
+  /// calling coroutine until one is available.
+  auto async_acquire() {
+    return internal::make_awaiter(
+        [this] { return !this->inner_data->occupied_sections.empty(); },
+        [this] { return section_t(*this, false); });
+  }
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
 };
 
 // diamond inheritance so that `buffer&` can be cast to `ibuffer&` and
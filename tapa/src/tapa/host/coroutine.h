@@ -4,11 +4,117 @@
 #include <functional>
 #include <string>
 
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+#include <coroutine>
+#include <exception>
+#include <utility>
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+
 namespace tapa {
 namespace internal {
-void schedule(bool detach, const std::function<void()>&);
+// `task` is the address of the task function, which identifies the task in
+// profiles; null for tasks of the runtime, e.g., async_mmap.
+void schedule(bool detach, const std::function<void()>&,
+              const void* task = nullptr);
 void yield(const std::string& msg);
 }  // namespace internal
+
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+
+/// Return type of tasks implemented as C++20 stackless coroutines.
+///
+/// Such tasks use @c co_await on the @c async_* operations of streams and
+/// buffers instead of the blocking operations, e.g.,
+///
+/// @code{.cpp}
+///  tapa::coroutine Add(tapa::istream<float>& a, tapa::istream<float>& b,
+///                      tapa::ostream<float>& c, uint64_t n) {
+///    for (uint64_t i = 0; i < n; ++i) {
+///      float a_i = co_await a.async_read();
+///      float b_i = co_await b.async_read();
+///      co_await c.async_write(a_i + b_i);
+///    }
+///  }
+/// @endcode
+///
+/// A suspended task costs one scheduler entry plus its coroutine frame. Its
+/// worker thread keeps running other tasks, so blocking operations must not be
+/// used in such tasks; non-blocking operations are fine.
+class coroutine {
+ public:
+  struct promise_type {
+    coroutine get_return_object() {
+      return coroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  coroutine(coroutine&& other) : handle_(std::exchange(other.handle_, {})) {}
+  coroutine(const coroutine&) = delete;
+  coroutine& operator=(coroutine&&) = delete;
+  coroutine& operator=(const coroutine&) = delete;
+  ~coroutine() {
+    if (handle_) handle_.destroy();
+  }
+
+  /// Transfers the ownership of the coroutine frame to the caller.
+  std::coroutine_handle<> release() { return std::exchange(handle_, {}); }
+
+ private:
+  explicit coroutine(std::coroutine_handle<> handle) : handle_(handle) {}
+
+  std::coroutine_handle<> handle_;
+};
+
+namespace internal {
+
+/// Condition that a suspended coroutine waits for.
+class awaiter_base {
+ public:
+  virtual bool ready() = 0;
+
+ protected:
+  ~awaiter_base() = default;
+};
+
+// Makes the scheduler resume the running coroutine once `awaiter` is ready.
+void suspend(awaiter_base* awaiter);
+
+void schedule_coroutine(bool detach, std::function<coroutine()> f);
+
+// Runs `f` as a top-level task and waits for all joined tasks.
+void run_coroutine(std::function<coroutine()> f);
+
+/// Awaitable that is ready if @c Ready returns true, and produces the result
+/// of @c Resume when resumed.
+template <typename Ready, typename Resume>
+class awaiter : public awaiter_base {
+ public:
+  awaiter(Ready ready, Resume resume)
+      : ready_(std::move(ready)), resume_(std::move(resume)) {}
+
+  bool ready() override { return ready_(); }
+  bool await_ready() { return ready_(); }
+  void await_suspend(std::coroutine_handle<>) { suspend(this); }
+  decltype(auto) await_resume() { return resume_(); }
+
+ private:
+  Ready ready_;
+  Resume resume_;
+};
+
+template <typename Ready, typename Resume>
+awaiter<Ready, Resume> make_awaiter(Ready ready, Resume resume) {
+  return {std::move(ready), std::move(resume)};
+}
+
+}  // namespace internal
+
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+
 }  // namespace tapa
 
 #endif  // TAPA_HOST_COROUTINE_H_
@@ -2,10 +2,14 @@
 #define TAPA_HOST_MMAP_H_
 
 #include <cstddef>
+#include <cstdint>
 
+#include <memory>
 #include <queue>
 #include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <frt.h>
@@ -13,6 +17,7 @@
 #include "tapa/base/mmap.h"
 
 #include "tapa/host/coroutine.h"
+#include "tapa/host/rtl_sim.h"
 #include "tapa/host/stream.h"
 #include "tapa/host/vec.h"
 
@@ -25,6 +30,159 @@ struct accessor;
 
 }  // namespace internal
 
+/// Options of @c tapa::mmap<T>::from_file, combined with @c operator|.
+///
+/// Read and write are with respect to the kernel, as in @c read_only_mmap and
+/// @c write_only_mmap.
+enum class file_mode : uint32_t {
+  /// The kernel reads the file. The mapping is read-only on the host, so stray
+  /// writes in software simulation fault instead of corrupting the file.
+  read_only = 1 << 0,
+  /// The kernel writes the file. The file is created if it does not exist.
+  write_only = 1 << 1,
+  /// The kernel reads and writes the file.
+  read_write = read_only | write_only,
+  /// Prefaults the whole file at construction using @c MAP_POPULATE.
+  populate = 1 << 2,
+  /// Advises the OS to back the mapping with transparent huge pages.
+  huge_pages = 1 << 3,
+};
+
+constexpr file_mode operator|(file_mode lhs, file_mode rhs) {
+  return file_mode(uint32_t(lhs) | uint32_t(rhs));
+}
+
+constexpr bool operator&(file_mode lhs, file_mode rhs) {
+  return (uint32_t(lhs) & uint32_t(rhs)) != 0;
+}
+
+/// Statistics of the memory timing model of @c tapa::mmap<T>::timed.
+struct memory_stats {
+  /// Number of read requests.
+  uint64_t read_count = 0;
+  /// Number of write requests.
+  uint64_t write_count = 0;
+  /// Number of read bursts after coalescing consecutive requests.
+  uint64_t read_burst_count = 0;
+  /// Number of write bursts after coalescing consecutive requests.
+  uint64_t write_burst_count = 0;
+  /// Number of bursts that open another page.
+  uint64_t page_miss_count = 0;
+  /// Estimated number of cycles until the last burst completes.
+  uint64_t cycle_count = 0;
+};
+
+/// Parameters of the memory timing model of @c tapa::mmap<T>::timed.
+///
+/// Each field is in cycles of the kernel clock or in bytes. The defaults
+/// roughly describe one DDR4 channel with a 300 MHz kernel.
+struct memory_timing {
+  /// Cycles from issuing a burst to its first data beat.
+  uint64_t latency = 64;
+  /// Bytes transferred per cycle, shared by reads and writes.
+  uint64_t bytes_per_cycle = 64;
+  /// Longest burst in bytes, which is the default of @c tapac.
+  uint64_t max_burst_bytes = 1024;
+  /// Requests in flight in each direction, or any number if 0.
+  uint64_t max_outstanding = 64;
+  /// Bytes per DRAM page.
+  uint64_t page_bytes = 8192;
+  /// Cycles added to a burst that opens another page.
+  uint64_t page_miss_cycles = 16;
+  /// Cycles added when the memory switches between reads and writes.
+  uint64_t turnaround_cycles = 8;
+  /// If not null, receives the statistics once the kernel finishes.
+  memory_stats* stats = nullptr;
+};
+
+namespace internal {
+
+// Maps file `path` into memory. `length` is the length of the mapping in
+// bytes; if 0, it is set to the size of the file. Returns the owner of the
+// mapping, which unmaps the file when destroyed.
+std::shared_ptr<void> map_file(const std::string& path, file_mode mode,
+                               uint64_t& length);
+
+// Models the stride prefetcher of async_mmap read channels.
+//
+// Prefetches are assumed to return before they are needed, so the counts are
+// the upper bound of what the prefetcher in hardware serves. The counts are
+// logged when the model is destroyed.
+class prefetch_model {
+ public:
+  prefetch_model(const void* ptr, uint64_t depth) : ptr_(ptr), depth_(depth) {}
+  ~prefetch_model();
+
+  // Updates the model with read address `addr`.
+  void read(int64_t addr);
+
+ private:
+  const void* ptr_;
+  const uint64_t depth_;
+
+  int64_t last_addr_ = 0;
+  int64_t stride_ = 0;
+  int confidence_ = 0;
+  int64_t head_addr_ = 0;   // oldest prefetched address
+  uint64_t prefetched_ = 0;  // number of prefetched addresses
+
+  uint64_t hit_count_ = 0;
+  uint64_t miss_count_ = 0;
+};
+
+// Estimates the cycles an async_mmap needs to serve its requests.
+//
+// Consecutive requests are coalesced into bursts as the burst detector does.
+// The kernel is assumed to issue one request per cycle in each direction, and
+// a burst is issued once its last request arrives and it fits among the
+// `max_outstanding` requests in flight. Bursts are served in issue order by
+// one memory that pays for latency, page misses, and read/write turnarounds.
+// The statistics are logged when the model is destroyed.
+class timing_model {
+ public:
+  timing_model(const void* ptr, uint64_t elem_bytes,
+               const memory_timing& timing);
+  ~timing_model();
+
+  // Updates the model with read address `addr`.
+  void read(int64_t addr) { access(reads_, addr); }
+
+  // Updates the model with write address `addr`.
+  void write(int64_t addr) { access(writes_, addr); }
+
+ private:
+  struct channel {
+    explicit channel(bool is_write) : is_write(is_write) {}
+
+    const bool is_write;
+    int64_t burst_addr = 0;
+    uint64_t burst_len = 0;      // 0 if no burst is open
+    uint64_t request_cycle = 0;  // cycle of the last request
+    uint64_t outstanding = 0;    // requests in flight
+    // completion cycles and lengths of the bursts in flight
+    std::queue<std::pair<uint64_t, uint64_t>> done;
+    uint64_t request_count = 0;
+    uint64_t burst_count = 0;
+  };
+
+  void access(channel& ch, int64_t addr);
+  void issue(channel& ch);
+
+  const void* ptr_;
+  const uint64_t elem_bytes_;
+  const memory_timing timing_;
+  const uint64_t max_burst_len_;
+
+  channel reads_{false};
+  channel writes_{true};
+  uint64_t free_cycle_ = 0;  // cycle when the memory finishes the last burst
+  bool is_writing_ = false;
+  int64_t open_page_ = -1;
+  uint64_t page_miss_count_ = 0;
+};
+
+}  // namespace internal
+
 template <typename T>
 class async_mmap;
 
@@ -52,6 +210,43 @@ class mmap {
   explicit mmap(Container& container)
       : ptr_{container.data()}, size_{container.size()} {}
 
+  /// Constructs a @c tapa::mmap backed by the content of a binary file.
+  ///
+  /// The file is mapped into memory directly, i.e., it is neither read into a
+  /// separate buffer nor copied on the host. The mapping is page-aligned, so
+  /// it can be used as the host memory of device buffers, and it is unmapped
+  /// when the last @c tapa::mmap referencing it is destroyed. Changes made by
+  /// the kernel are written back to the file if @c mode includes
+  /// @c file_mode::write_only.
+  ///
+  /// This should be used on the host only.
+  ///
+  /// @code{.cpp}
+  ///  auto edges = tapa::mmap<const Edge>::from_file("edges.bin");
+  ///  auto updates = tapa::mmap<Update>::from_file(
+  ///      "updates.bin", tapa::file_mode::write_only, edges.size());
+  ///  tapa::invoke(Graph, bitstream, tapa::read_only_mmap<const Edge>(edges),
+  ///               tapa::write_only_mmap<Update>(updates));
+  /// @endcode
+  ///
+  /// @param path Path to the file, read as a raw array of @c T.
+  /// @param mode Options of the mapping.
+  /// @param size Number of elements to map. If 0, the whole file is mapped.
+  ///             Otherwise, a file opened for writing is resized to @c size.
+  /// @return @c tapa::mmap of the mapped file.
+  static mmap from_file(const std::string& path,
+                        file_mode mode = file_mode::read_only,
+                        uint64_t size = 0) {
+    uint64_t length = size * sizeof(T);
+    auto owner = internal::map_file(path, mode, length);
+    CHECK_EQ(length % sizeof(T), 0)
+        << "size of file '" << path << "' must be a multiple of sizeof(T) = "
+        << sizeof(T) << "; got " << length << " bytes";
+    mmap result(static_cast<T*>(owner.get()), length / sizeof(T));
+    result.owner_ = std::move(owner);
+    return result;
+  }
+
   /// Implicitly casts to a regular pointer.
   ///
   /// @c tapa::mmap should be used just like a pointer in the kernel.
@@ -97,6 +292,57 @@ class mmap {
   /// @return The size of the mapped memory (in unit of element count).
   uint64_t size() const { return size_; }
 
+  /// Models a stride prefetcher in front of the read channel of the mapped
+  /// memory when it is accessed as a @c tapa::async_mmap.
+  ///
+  /// This should be used on the host only.
+  /// Software simulation logs how many reads would be served by prefetches.
+  /// The prefetcher in hardware is enabled for the same argument with
+  /// <tt>tapac --async-mmap-prefetch-args</tt>.
+  ///
+  /// @param depth Number of reads prefetched ahead.
+  /// @return @c tapa::mmap of the same piece of memory with the prefetcher.
+  mmap prefetched(uint64_t depth = 16) const {
+    mmap result = *this;
+    result.prefetch_depth_ = depth;
+    return result;
+  }
+
+  /// Models the timing of the mapped memory when it is accessed as a
+  /// @c tapa::async_mmap.
+  ///
+  /// This should be used on the host only.
+  /// Software simulation logs the estimated number of cycles the memory needs
+  /// to serve the requests of the kernel, and fills @c timing.stats if set.
+  ///
+  /// @param timing Parameters of the model.
+  /// @return @c tapa::mmap of the same piece of memory with the model.
+  mmap timed(const memory_timing& timing = {}) const {
+    mmap result = *this;
+    result.timing_ = std::make_shared<const memory_timing>(timing);
+    return result;
+  }
+
+  /// Retrieves a view of a range of the mapped memory.
+  ///
+  /// This should be used on the host only.
+  /// The view shares the memory, i.e., nothing is copied. Device buffers are
+  /// created from the host memory directly only if @c get() of the view is
+  /// aligned as required by the runtime.
+  ///
+  /// @param offset Index of the first element of the view.
+  /// @param size   Number of elements of the view.
+  /// @return @c tapa::mmap of elements [offset, offset + size).
+  mmap slice(uint64_t offset, uint64_t size) const {
+    CHECK_LE(offset + size, size_)
+        << "slice [" << offset << ", " << offset + size
+        << ") is out of the mapped memory of size " << size_;
+    mmap result = *this;
+    result.ptr_ += offset;
+    result.size_ = size;
+    return result;
+  }
+
   /// Reinterprets the element type of the mapped memory as
   /// <tt>tapa::vec_t<T, N></tt>.
   ///
@@ -113,7 +359,8 @@ class mmap {
            "mmap<vec_t<T, N>> (i.e., `vectorized<N>()`); got size = "
         << size() << ", N = " << N << ", but " << size() << " % " << N
         << " != 0";
-    return mmap<vec_t<T, N>>(reinterpret_cast<vec_t<T, N>*>(get()), size() / N);
+    return mmap<vec_t<T, N>>(reinterpret_cast<vec_t<T, N>*>(get()), size() / N,
+                             owner_);
   }
 
   /// Reinterprets the element type of the mapped memory as @c U.
@@ -160,12 +407,28 @@ class mmap {
         << "-byte aligned when reinterpreted as mmap<U> (i.e., "
            "`reinterpret<U>()`) because alignof(U) = "
         << alignof(U);
-    return mmap<U>(reinterpret_cast<U*>(get()), size() * sizeof(T) / sizeof(U));
+    return mmap<U>(reinterpret_cast<U*>(get()), size() * sizeof(T) / sizeof(U),
+                   owner_);
   }
 
  protected:
+  template <typename U>
+  friend class mmap;
+
+  mmap(T* ptr, uint64_t size, std::shared_ptr<void> owner)
+      : ptr_{ptr}, size_{size}, owner_{std::move(owner)} {}
+
   T* ptr_;
   uint64_t size_;
+
+  // Keeps the memory of `from_file` mapped; null otherwise.
+  std::shared_ptr<void> owner_;
+
+  // Number of reads prefetched ahead by async_mmap; 0 if not prefetched.
+  uint64_t prefetch_depth_ = 0;
+
+  // Parameters of the timing model of async_mmap; null if not timed.
+  std::shared_ptr<const memory_timing> timing_;
 };
 
 /// Defines a view of a piece of consecutive memory with asynchronous random
@@ -188,6 +451,13 @@ class async_mmap : public mmap<T> {
   stream<T, 64> write_data_q_{"write_data"};
   stream<resp_t, 64> write_resp_q_{"write_resp"};
 
+  // Owned by the copies used by the kernel, so that the counts are logged once
+  // the kernel finishes; the scheduled copy never returns.
+  std::shared_ptr<internal::prefetch_model> prefetch_;
+  std::weak_ptr<internal::prefetch_model> prefetch_model_;
+  std::shared_ptr<internal::timing_model> timing_owner_;
+  std::weak_ptr<internal::timing_model> timing_model_;
+
   // Only convert when scheduled.
   async_mmap(const super& mem)
       : super(mem),
@@ -257,6 +527,8 @@ class async_mmap : public mmap<T> {
         if (addr != 0) {
           CHECK_LT(addr, this->size_);
         }
+        if (auto prefetch = prefetch_model_.lock()) prefetch->read(addr);
+        if (auto timing = timing_model_.lock()) timing->read(addr);
         read_data_q_.write(this->ptr_[addr]);
       }
       if (write_count != 256 && !write_addr_q_.empty() &&
@@ -266,6 +538,7 @@ class async_mmap : public mmap<T> {
         if (addr != 0) {
           CHECK_LT(addr, this->size_);
         }
+        if (auto timing = timing_model_.lock()) timing->write(addr);
         this->ptr_[addr] = write_data_q_.read();
         ++write_count;
       } else if (write_count > 0 &&
@@ -277,9 +550,23 @@ class async_mmap : public mmap<T> {
   }
 
   static async_mmap schedule(super mem) {
-    // a copy of async_mem is stored in std::function<void()>
     async_mmap async_mem(mem);
-    internal::schedule(/*detach=*/true, async_mem);
+    if (async_mem.prefetch_depth_ != 0) {
+      async_mem.prefetch_ = std::make_shared<internal::prefetch_model>(
+          async_mem.get(), async_mem.prefetch_depth_);
+    }
+    if (async_mem.timing_ != nullptr) {
+      async_mem.timing_owner_ = std::make_shared<internal::timing_model>(
+          async_mem.get(), sizeof(T), *async_mem.timing_);
+    }
+
+    // a copy of async_mem is stored in std::function<void()>
+    async_mmap scheduled_mem = async_mem;
+    scheduled_mem.prefetch_model_ = scheduled_mem.prefetch_;
+    scheduled_mem.prefetch_.reset();
+    scheduled_mem.timing_model_ = scheduled_mem.timing_owner_;
+    scheduled_mem.timing_owner_.reset();
+    internal::schedule(/*detach=*/true, scheduled_mem);
     return async_mem;
   }
 };
@@ -447,6 +734,17 @@ class mmaps {
     tag##_mmap<U> reinterpret() const {                \
       return mmap<T>::template reinterpret<U>();       \
     }                                                  \
+    tag##_mmap prefetched(uint64_t depth = 16) const { \
+      return mmap<T>::prefetched(depth);               \
+    }                                                  \
+    tag##_mmap timed(const memory_timing& timing = {}) \
+        const {                                        \
+      return mmap<T>::timed(timing);                   \
+    }                                                  \
+    tag##_mmap slice(uint64_t offset, uint64_t size)  \
+        const {                                        \
+      return mmap<T>::slice(offset, size);             \
+    }                                                  \
   }
 TAPA_DEFINE_MMAP(placeholder);
 TAPA_DEFINE_MMAP(read_only);
@@ -527,6 +825,10 @@ struct accessor<async_mmap<T>&, mmaps<T, S>&> {
       auto buf = fpga::frt_tag(arg.get(), arg.size());         \
       instance.SetArg(idx++, buf);                             \
     }                                                          \
+    static void access(rtl_sim& sim, int& idx,                 \
+                       tag##_mmap<T> arg) {                    \
+      sim.SetArg(idx++, arg.get(), arg.size());                \
+    }                                                          \
   };                                                           \
   template <typename T, uint64_t S>                            \
   struct accessor<mmaps<T, S>, tag##_mmaps<T, S>> {            \
@@ -537,6 +839,12 @@ struct accessor<async_mmap<T>&, mmaps<T, S>&> {
         instance.SetArg(idx++, buf);                           \
       }                                                        \
     }                                                          \
+    static void access(rtl_sim& sim, int& idx,                 \
+                       tag##_mmaps<T, S> arg) {                \
+      for (uint64_t i = 0; i < S; ++i) {                       \
+        sim.SetArg(idx++, arg[i].get(), arg[i].size());        \
+      }                                                        \
+    }                                                          \
   }
 TAPA_DEFINE_ACCESSER(placeholder, Placeholder);
 // read/write are with respect to the kernel in tapa but host in frt
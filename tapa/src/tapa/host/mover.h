@@ -0,0 +1,124 @@
+#ifndef TAPA_HOST_MOVER_H_
+#define TAPA_HOST_MOVER_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include <type_traits>
+
+#include <glog/logging.h>
+
+#include "tapa/host/mmap.h"
+#include "tapa/host/stream.h"
+
+#ifdef TAPA_BUFFER_SUPPORT
+#include "tapa/host/buffer.h"
+#endif
+
+namespace tapa {
+
+namespace internal {
+
+// Elements of type U are packed into or split from elements of type T,
+// lowest bytes first.
+template <typename T, typename U>
+inline uint64_t mover_bytes(uint64_t n) {
+  static_assert(std::is_trivially_copyable_v<T> &&
+                    std::is_trivially_copyable_v<U>,
+                "movers only copy trivially copyable types");
+  static_assert(sizeof(T) % sizeof(U) == 0 || sizeof(U) % sizeof(T) == 0,
+                "mmap and stream element sizes must divide one another");
+  const uint64_t bytes = n * sizeof(T);
+  CHECK_EQ(bytes % sizeof(U), 0)
+      << "cannot move " << n << " elements of " << sizeof(T)
+      << " bytes as elements of " << sizeof(U) << " bytes";
+  return bytes;
+}
+
+}  // namespace internal
+
+/// Reads @c n elements of @c mem and writes them to @c out.
+///
+/// If the element sizes differ, each mmap element is split into stream
+/// elements, or consecutive mmap elements are packed into one stream element,
+/// lowest bytes first. The end-of-transaction is not written.
+///
+/// In a task annotated with @c [[tapa::target("rtl","xilinx")]] that only
+/// forwards its parameters to this function, @c tapac replaces the task with
+/// a burst-optimized RTL implementation instead of synthesizing it with HLS.
+///
+/// @param mem Source memory.
+/// @param n   Number of @c mem elements to read.
+/// @param out Destination stream.
+template <typename T, typename U>
+inline void mmap_to_stream(mmap<T> mem, uint64_t n, ostream<U>& out) {
+  const uint64_t bytes = internal::mover_bytes<T, U>(n);
+  const char* src = reinterpret_cast<const char*>(mem.get());
+  for (uint64_t i = 0; i < bytes; i += sizeof(U)) {
+    U elem;
+    std::memcpy(&elem, src + i, sizeof(U));
+    out.write(elem);
+  }
+}
+
+/// Reads stream elements from @c in and writes @c n elements to @c mem.
+///
+/// This is the reverse of @c tapa::mmap_to_stream and has an RTL
+/// implementation as well.
+///
+/// @param in  Source stream.
+/// @param mem Destination memory.
+/// @param n   Number of @c mem elements to write.
+template <typename T, typename U>
+inline void stream_to_mmap(istream<U>& in, mmap<T> mem, uint64_t n) {
+  const uint64_t bytes = internal::mover_bytes<T, U>(n);
+  char* dst = reinterpret_cast<char*>(mem.get());
+  for (uint64_t i = 0; i < bytes; i += sizeof(U)) {
+    const U elem = in.read();
+    std::memcpy(dst + i, &elem, sizeof(U));
+  }
+}
+
+#ifdef TAPA_BUFFER_SUPPORT
+
+/// Copies consecutive chunks of @c mem into @c n sections of @c buf, one
+/// section at a time.
+///
+/// @param mem Source memory.
+/// @param n   Number of sections to fill.
+/// @param buf Destination buffer.
+template <typename T, typename U, int n_sections, typename... dims>
+inline void mmap_to_buffer(mmap<U> mem, uint64_t n,
+                           obuffer<T, n_sections, dims...>& buf) {
+  static_assert(sizeof(T) % sizeof(U) == 0,
+                "buffer sections must hold whole mmap elements");
+  const char* src = reinterpret_cast<const char*>(mem.get());
+  for (uint64_t i = 0; i < n; ++i) {
+    auto section = buf.acquire();
+    std::memcpy(&section(), src + i * sizeof(T), sizeof(T));
+  }
+}
+
+/// Copies @c n sections of @c buf into consecutive chunks of @c mem, one
+/// section at a time.
+///
+/// @param buf Source buffer.
+/// @param mem Destination memory.
+/// @param n   Number of sections to copy.
+template <typename T, typename U, int n_sections, typename... dims>
+inline void buffer_to_mmap(ibuffer<T, n_sections, dims...>& buf, mmap<U> mem,
+                           uint64_t n) {
+  static_assert(sizeof(T) % sizeof(U) == 0,
+                "buffer sections must hold whole mmap elements");
+  char* dst = reinterpret_cast<char*>(mem.get());
+  for (uint64_t i = 0; i < n; ++i) {
+    auto section = buf.acquire();
+    std::memcpy(dst + i * sizeof(T), &section(), sizeof(T));
+  }
+}
+
+#endif  // TAPA_BUFFER_SUPPORT
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_MOVER_H_
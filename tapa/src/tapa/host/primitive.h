@@ -0,0 +1,219 @@
+#ifndef TAPA_HOST_PRIMITIVE_H_
+#define TAPA_HOST_PRIMITIVE_H_
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <type_traits>
+
+#include "tapa/host/stream.h"
+
+// Stream routing primitives. Each of them runs forever and models its RTL
+// implementation cycle by cycle: an iteration of the loop looks at the heads
+// of the inputs and the fullness of the outputs, and moves the tokens that
+// the RTL would move in one cycle. EoT tokens are forwarded like data tokens.
+
+namespace tapa {
+
+namespace internal {
+
+inline constexpr int log2_of(uint64_t n) {
+  return n <= 1 ? 0 : 1 + log2_of(n / 2);
+}
+
+// Returns bits [lsb, lsb + width) of the object representation of val,
+// lowest bits first, or 0 for EoT tokens, whose value is undefined in RTL.
+template <int lsb, int width, typename T>
+inline uint64_t key_of(const T& val, bool is_eot) {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "routing keys are taken from trivially copyable types");
+  static_assert(lsb >= 0 && lsb + width <= sizeof(T) * CHAR_BIT,
+                "routing key is out of range");
+  if (is_eot) return 0;
+  unsigned char bytes[sizeof(T)];
+  std::memcpy(bytes, &val, sizeof(T));
+  uint64_t key = 0;
+  for (int i = 0; i < width; ++i) {
+    const int bit = lsb + i;
+    key |= uint64_t((bytes[bit / CHAR_BIT] >> (bit % CHAR_BIT)) & 1) << i;
+  }
+  return key;
+}
+
+template <typename T>
+inline void pop_token(istream<T> in, bool is_eot) {
+  T val;
+  is_eot ? in.try_open() : in.try_read(val);
+}
+
+template <typename T>
+inline void push_token(ostream<T> out, const T& val, bool is_eot) {
+  is_eot ? out.try_close() : out.try_write(val);
+}
+
+}  // namespace internal
+
+/// Merges @c N input streams into @c out in round-robin order.
+///
+/// Each iteration forwards the first available token after the input that was
+/// forwarded last, starting from input 0. This function never returns, so the
+/// calling task must be invoked with @c tapa::detach. In a task annotated with
+/// @c [[tapa::target("rtl","xilinx")]] that only forwards its parameters to
+/// this function, @c tapac implements the task with a zero-latency RTL module.
+///
+/// @param in  Input streams.
+/// @param out Output stream.
+template <typename T, uint64_t N>
+inline void merge(istreams<T, N>& in, ostream<T>& out) {
+  uint64_t last = N - 1;
+  for (;;) {
+    for (uint64_t i = 1; i <= N; ++i) {
+      const uint64_t idx = (last + i) % N;
+      bool is_success, is_eot;
+      const T val = in[idx].peek(is_success, is_eot);
+      if (is_success) {
+        if (!out.full()) {
+          internal::pop_token(in[idx], is_eot);
+          internal::push_token(out, val, is_eot);
+          last = idx;
+        }
+        break;
+      }
+    }
+  }
+}
+
+/// Routes each token of @c in to @c out[key], where @c key is bits
+/// [@c key_lsb, @c key_lsb + log2(@c N)) of the token's object representation.
+///
+/// @c N must be a power of 2. EoT tokens are routed to @c out[0]. A token
+/// whose output is full blocks the tokens behind it. This function never
+/// returns and has an RTL implementation as @c tapa::merge does.
+///
+/// @param in  Input stream.
+/// @param out Output streams.
+template <int key_lsb, typename T, uint64_t N>
+inline void demux(istream<T>& in, ostreams<T, N>& out) {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of 2");
+  for (;;) {
+    bool is_success, is_eot;
+    const T val = in.peek(is_success, is_eot);
+    if (!is_success) continue;
+    const uint64_t key =
+        internal::key_of<key_lsb, internal::log2_of(N)>(val, is_eot);
+    if (!out[key].full()) {
+      internal::pop_token(in, is_eot);
+      internal::push_token(out[key], val, is_eot);
+    }
+  }
+}
+
+/// Copies each token of @c in to all of @c out, once none of them is full.
+///
+/// This function never returns and has an RTL implementation as
+/// @c tapa::merge does.
+///
+/// @param in  Input stream.
+/// @param out Output streams.
+template <typename T, uint64_t N>
+inline void broadcast(istream<T>& in, ostreams<T, N>& out) {
+  for (;;) {
+    bool is_success, is_eot;
+    const T val = in.peek(is_success, is_eot);
+    if (!is_success) continue;
+    bool is_full = false;
+    for (uint64_t i = 0; i < N; ++i) {
+      is_full |= out[i].full();
+    }
+    if (!is_full) {
+      internal::pop_token(in, is_eot);
+      for (uint64_t i = 0; i < N; ++i) {
+        internal::push_token(out[i], val, is_eot);
+      }
+    }
+  }
+}
+
+/// Routes tokens of @c in to @c out through a butterfly network of 2x2
+/// switches, where each token goes to @c out[key] as in @c tapa::demux.
+///
+/// @c N must be a power of 2. Stage @c s of the network pairs the lanes that
+/// only differ in bit log2(@c N)-1-@c s and forwards each token to the lane
+/// that matches the same bit of its key. If both tokens of a switch want the
+/// same lane, the switch alternates between them, starting from the lower
+/// lane. This function never returns and has an RTL implementation as
+/// @c tapa::merge does.
+///
+/// @param in  Input streams.
+/// @param out Output streams.
+template <int key_lsb, typename T, uint64_t N>
+inline void butterfly(istreams<T, N>& in, ostreams<T, N>& out) {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of 2");
+  constexpr int kStages = internal::log2_of(N);
+
+  struct Token {
+    bool valid;
+    bool is_eot;
+    uint64_t key;
+    uint64_t src;  // input lane
+    T val;
+  };
+  std::array<std::array<bool, N / 2 + 1>, kStages + 1> prio{};
+  std::array<std::array<bool, N / 2 + 1>, kStages + 1> conflict{};
+
+  for (;;) {
+    // valid tokens go forward through the stages
+    std::array<std::array<Token, N>, kStages + 1> lanes{};
+    for (uint64_t i = 0; i < N; ++i) {
+      auto& token = lanes[0][i];
+      token.val = in[i].peek(token.valid, token.is_eot);
+      token.key = internal::key_of<key_lsb, kStages>(token.val, token.is_eot);
+      token.src = i;
+    }
+    for (int s = 0; s < kStages; ++s) {
+      const uint64_t bit = uint64_t{1} << (kStages - 1 - s);
+      for (uint64_t p = 0; p < N / 2; ++p) {
+        const uint64_t a = p / bit * 2 * bit + p % bit;
+        const uint64_t b = a + bit;
+        const Token& token_a = lanes[s][a];
+        const Token& token_b = lanes[s][b];
+        conflict[s][p] = token_a.valid && token_b.valid &&
+                         bool(token_a.key & bit) == bool(token_b.key & bit);
+        const bool is_a_granted =
+            token_a.valid && !(conflict[s][p] && prio[s][p]);
+        const bool is_b_granted =
+            token_b.valid && !(conflict[s][p] && !prio[s][p]);
+        if (is_a_granted) lanes[s + 1][token_a.key & bit ? b : a] = token_a;
+        if (is_b_granted) lanes[s + 1][token_b.key & bit ? b : a] = token_b;
+      }
+    }
+
+    // the tokens that reach a non-full output are accepted
+    std::array<bool, N> accepted{};
+    for (uint64_t i = 0; i < N; ++i) {
+      const Token& token = lanes[kStages][i];
+      if (token.valid && !out[i].full()) {
+        internal::pop_token(in[token.src], token.is_eot);
+        internal::push_token(out[i], token.val, token.is_eot);
+        accepted[token.src] = true;
+      }
+    }
+
+    // a switch flips its priority once the winner of a conflict is accepted
+    for (int s = 0; s < kStages; ++s) {
+      for (uint64_t p = 0; p < N / 2; ++p) {
+        if (!conflict[s][p]) continue;
+        const uint64_t bit = uint64_t{1} << (kStages - 1 - s);
+        const uint64_t a = p / bit * 2 * bit + p % bit;
+        const uint64_t winner = prio[s][p] ? a + bit : a;
+        if (accepted[lanes[s][winner].src]) prio[s][p] = !prio[s][p];
+      }
+    }
+  }
+}
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_PRIMITIVE_H_
@@ -0,0 +1,140 @@
+#ifndef TAPA_HOST_QDMA_H_
+#define TAPA_HOST_QDMA_H_
+
+#include <cstdint>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "tapa/host/logging.h"
+#include "tapa/host/stream.h"
+
+namespace tapa {
+
+/// Host-side models of QDMA AXI-Stream queues for software simulation.
+///
+/// Each @c istreams / @c ostreams port of the top-level task is mapped to one
+/// QDMA queue per channel. A queue carries packets whose last beat has @c TLAST
+/// set, which is modeled as an end-of-transaction (EoT) token. Invoke these
+/// tasks next to the top-level task to drive its queues, e.g.,
+///
+/// @code{.cpp}
+///  tapa::streams<float, 4> in, out;
+///  tapa::task()
+///    .invoke(tapa::qdma_file_source<float, 4>, input_paths, in)
+///    .invoke(Top, in, out)
+///    .invoke(tapa::qdma_file_sink<float, 4>, out, output_paths);
+/// @endcode
+
+namespace internal {
+
+// Queues are served round-robin so that a task consuming or producing several
+// queues in lockstep does not deadlock.
+
+template <typename T, uint64_t S>
+void write_qdma_queues(const std::vector<std::vector<T>>& rings,
+                       ostreams<T, S>& queues) {
+  std::vector<size_t> pos(S, 0);
+  std::vector<bool> is_done(S, false);
+  for (uint64_t done_count = 0; done_count < S;) {
+    for (uint64_t i = 0; i < S; ++i) {
+      if (is_done[i]) continue;
+      if (pos[i] < rings[i].size()) {
+        if (queues[i].try_write(rings[i][pos[i]])) ++pos[i];
+      } else if (queues[i].try_close()) {
+        is_done[i] = true;
+        ++done_count;
+      }
+    }
+  }
+}
+
+template <typename T, uint64_t S>
+void read_qdma_queues(istreams<T, S>& queues,
+                      std::vector<std::vector<T>>& rings) {
+  rings.assign(S, {});
+  std::vector<bool> is_done(S, false);
+  for (uint64_t done_count = 0; done_count < S;) {
+    for (uint64_t i = 0; i < S; ++i) {
+      bool is_eot;
+      if (is_done[i] || !queues[i].try_eot(is_eot)) continue;
+      if (is_eot) {
+        queues[i].open();
+        is_done[i] = true;
+        ++done_count;
+      } else {
+        rings[i].push_back(queues[i].read());
+      }
+    }
+  }
+}
+
+}  // namespace internal
+
+/// Writes @c rings[i] to queue @c i as a single packet.
+///
+/// @param rings  Data of each queue; must contain @c S rings.
+/// @param queues QDMA queues connected to the top-level task.
+template <typename T, uint64_t S>
+void qdma_ring_source(const std::vector<std::vector<T>>& rings,
+                      ostreams<T, S>& queues) {
+  CHECK_EQ(rings.size(), S) << "expecting one ring per queue";
+  internal::write_qdma_queues(rings, queues);
+}
+
+/// Reads one packet from each queue @c i into @c rings[i].
+///
+/// @param queues QDMA queues connected to the top-level task.
+/// @param rings  Data of each queue; resized to @c S rings. Passed as a pointer
+///               because task arguments are copied when invoked.
+template <typename T, uint64_t S>
+void qdma_ring_sink(istreams<T, S>& queues,
+                    std::vector<std::vector<T>>* rings) {
+  internal::read_qdma_queues(queues, *rings);
+}
+
+/// Writes the content of file @c paths[i] to queue @c i as a single packet.
+///
+/// Files are read as raw arrays of @c T.
+///
+/// @param paths  Path of the file of each queue; must contain @c S paths.
+/// @param queues QDMA queues connected to the top-level task.
+template <typename T, uint64_t S>
+void qdma_file_source(const std::vector<std::string>& paths,
+                      ostreams<T, S>& queues) {
+  CHECK_EQ(paths.size(), S) << "expecting one file per queue";
+  std::vector<std::vector<T>> rings(S);
+  for (uint64_t i = 0; i < S; ++i) {
+    std::ifstream file(paths[i], std::ios::binary);
+    CHECK(file) << "cannot open '" << paths[i] << "' for queue " << i;
+    for (T value; file.read(reinterpret_cast<char*>(&value), sizeof(T));) {
+      rings[i].push_back(value);
+    }
+  }
+  internal::write_qdma_queues(rings, queues);
+}
+
+/// Writes one packet from each queue @c i to file @c paths[i].
+///
+/// Files are written as raw arrays of @c T.
+///
+/// @param queues QDMA queues connected to the top-level task.
+/// @param paths  Path of the file of each queue; must contain @c S paths.
+template <typename T, uint64_t S>
+void qdma_file_sink(istreams<T, S>& queues,
+                    const std::vector<std::string>& paths) {
+  CHECK_EQ(paths.size(), S) << "expecting one file per queue";
+  std::vector<std::vector<T>> rings;
+  internal::read_qdma_queues(queues, rings);
+  for (uint64_t i = 0; i < S; ++i) {
+    std::ofstream file(paths[i], std::ios::binary);
+    CHECK(file) << "cannot open '" << paths[i] << "' for queue " << i;
+    file.write(reinterpret_cast<const char*>(rings[i].data()),
+               rings[i].size() * sizeof(T));
+  }
+}
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_QDMA_H_
@@ -0,0 +1,33 @@
+#include "tapa/host/rtl_sim.h"
+
+#include <dlfcn.h>
+
+namespace tapa {
+
+namespace internal {
+
+rtl_sim::rtl_sim(const std::string& path) {
+  handle_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  CHECK(handle_ != nullptr) << "cannot load RTL simulation: " << dlerror();
+  run_ = reinterpret_cast<run_t>(dlsym(handle_, "tapa_rtl_sim_run"));
+  CHECK(run_ != nullptr) << "'" << path
+                         << "' is not generated by tapac --verilator-sim";
+}
+
+rtl_sim::~rtl_sim() {
+  if (handle_ != nullptr) dlclose(handle_);
+}
+
+int64_t rtl_sim::Run() {
+  for (size_t i = 0; i < args_.size(); ++i) {
+    if (i < scalars_.size() && !scalars_[i].empty()) {
+      args_[i] = scalars_[i].data();
+    }
+  }
+  LOG(INFO) << "running RTL simulation with Verilator";
+  return run_(args_.data(), sizes_.data(), args_.size());
+}
+
+}  // namespace internal
+
+}  // namespace tapa
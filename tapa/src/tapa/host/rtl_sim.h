@@ -0,0 +1,86 @@
+#ifndef TAPA_HOST_RTL_SIM_H_
+#define TAPA_HOST_RTL_SIM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace tapa {
+
+namespace internal {
+
+/// Runs the Verilator simulation generated by `tapac --verilator-sim`.
+///
+/// The simulation is a shared library exporting @c tapa_rtl_sim_run. Kernel
+/// arguments are set in the same order as for @c fpga::Instance; memory-mapped
+/// arguments are accessed in place, so no explicit data transfer is needed.
+class rtl_sim {
+ public:
+  /// Loads the simulation.
+  ///
+  /// @param path Path to the shared library.
+  explicit rtl_sim(const std::string& path);
+  ~rtl_sim();
+  rtl_sim(const rtl_sim&) = delete;
+  rtl_sim& operator=(const rtl_sim&) = delete;
+
+  /// Sets a scalar argument.
+  template <typename T>
+  void SetArg(int idx, const T& arg) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      // Scalars are referenced by `Run` after all of them are set.
+      Resize(idx, scalars_).assign(reinterpret_cast<const char*>(&arg),
+                                   sizeof(arg));
+      SetRawArg(idx, nullptr, sizeof(arg));
+    } else {
+      LOG(FATAL) << "argument #" << idx
+                 << " is not trivially copyable and cannot be passed to RTL "
+                    "simulation";
+    }
+  }
+
+  /// Sets a memory-mapped argument.
+  ///
+  /// @param ptr  Pointer to the host buffer.
+  /// @param size Number of elements in the host buffer.
+  template <typename T>
+  void SetArg(int idx, T* ptr, uint64_t size) {
+    SetRawArg(idx, ptr, size * sizeof(T));
+  }
+
+  /// Runs the simulation until the kernel finishes. Returns the simulated
+  /// kernel time in nanoseconds.
+  int64_t Run();
+
+ private:
+  using run_t = int64_t (*)(const void* const*, const uint64_t*, size_t);
+
+  template <typename T>
+  T& Resize(int idx, std::vector<T>& vec) {
+    if (vec.size() <= size_t(idx)) vec.resize(idx + 1);
+    return vec[idx];
+  }
+
+  void SetRawArg(int idx, const void* ptr, uint64_t size) {
+    Resize(idx, args_) = ptr;
+    Resize(idx, sizes_) = size;
+  }
+
+  void* handle_ = nullptr;
+  run_t run_ = nullptr;
+  std::vector<const void*> args_;
+  std::vector<uint64_t> sizes_;
+  std::vector<std::string> scalars_;
+};
+
+}  // namespace internal
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_RTL_SIM_H_
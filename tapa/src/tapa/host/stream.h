@@ -470,6 +470,47 @@ class istream : virtual public internal::basic_stream<T> {
     }
   }
 
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+  /// Tests whether the next token is EoT in a @c tapa::coroutine task.
+  ///
+  /// This is a @a blocking and @a non-destructive operation that suspends the
+  /// calling coroutine until the stream is not empty.
+  ///
+  /// @return Awaitable that produces whether the next token is EoT.
+  auto async_eot() const {
+    return internal::make_awaiter([this] { return !this->ptr->empty(); },
+                                  [this] { return this->ptr->front().eot; });
+  }
+
+  /// Reads the stream in a @c tapa::coroutine task.
+  ///
+  /// This is a @a blocking and @a destructive operation that suspends the
+  /// calling coroutine until the stream is not empty.
+  ///
+  /// The next token must not be EoT.
+  ///
+  /// @return Awaitable that produces the value of the next token.
+  auto async_read() {
+    return internal::make_awaiter([this] { return !this->ptr->empty(); },
+                                  [this] {
+                                    T val;
+                                    try_read(val);
+                                    return val;
+                                  });
+  }
+
+  /// Consumes an EoT token in a @c tapa::coroutine task.
+  ///
+  /// This is a @a blocking and @a destructive operation that suspends the
+  /// calling coroutine until the stream is not empty.
+  ///
+  /// The next token must be EoT.
+  auto async_open() {
+    return internal::make_awaiter([this] { return !this->ptr->empty(); },
+                                  [this] { try_open(); });
+  }
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+
  protected:
   // allow derived class to omit initialization
   istream() : internal::basic_stream<T>(nullptr) {}
@@ -561,6 +602,28 @@ class ostream : virtual public internal::basic_stream<T> {
     }
   }
 
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+  /// Writes @c value to the stream in a @c tapa::coroutine task.
+  ///
+  /// This is a @a blocking and @a destructive operation that suspends the
+  /// calling coroutine until the stream is not full.
+  ///
+  /// @param[in] value The value to write.
+  auto async_write(const T& value) {
+    return internal::make_awaiter([this] { return !this->ptr->full(); },
+                                  [this, value] { try_write(value); });
+  }
+
+  /// Produces an EoT token to the stream in a @c tapa::coroutine task.
+  ///
+  /// This is a @a blocking and @a destructive operation that suspends the
+  /// calling coroutine until the stream is not full.
+  auto async_close() {
+    return internal::make_awaiter([this] { return !this->ptr->full(); },
+                                  [this] { try_close(); });
+  }
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+
  protected:
   // allow derived class to omit initialization
   ostream() : internal::basic_stream<T>(nullptr) {}
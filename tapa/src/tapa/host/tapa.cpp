@@ -1,12 +1,17 @@
 #include "tapa/host/tapa.h"
 
+#include <cerrno>
 #include <csignal>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
+#include <fstream>
 #include <functional>
 #include <list>
 #include <memory>
@@ -16,8 +21,12 @@
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #if TAPA_ENABLE_COROUTINE
 
@@ -26,7 +35,11 @@
 #include <boost/coroutine2/fixedsize_stack.hpp>
 #include <boost/stacktrace.hpp>
 
+#include <cxxabi.h>
+#include <dlfcn.h>
 #include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
 #include <time.h>
 
 using std::condition_variable;
@@ -100,6 +113,168 @@ rlim_t get_stack_size() {
   return rl.rlim_cur;
 }
 
+// Samples the task run by each worker thread every millisecond of CPU time if
+// TAPA_PROFILE is set. Sampling profilers cannot unwind from coroutine stacks
+// to the worker thread, so the runtime records which task is being run instead
+// and writes the samples of each task function to the file named by
+// TAPA_PROFILE once each top-level task finishes.
+class profiler {
+ public:
+  static constexpr int kIntervalUs = 1000;
+
+  // Counter of samples of the task run by a registered thread. The handler
+  // finds the slot by the kernel thread ID and only reads atomics, because
+  // thread_local variables may be allocated lazily, e.g., by __tls_get_addr
+  // in a shared library, which is not async-signal-safe.
+  struct thread_slot {
+    std::atomic<pid_t> tid{0};
+    std::atomic<std::atomic<uint64_t>*> current{nullptr};
+  };
+
+  // Claims a slot for the calling thread, or returns null if all slots are
+  // taken, in which case its samples are attributed to the other threads.
+  thread_slot* register_thread() {
+    const pid_t tid = syscall(SYS_gettid);
+    for (auto& slot : this->slots) {
+      pid_t expected = 0;
+      if (slot.tid.compare_exchange_strong(expected, tid)) {
+        slot.current = &this->scheduler;
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  static void unregister_thread(thread_slot* slot) {
+    if (slot == nullptr) return;
+    slot->current = nullptr;
+    slot->tid = 0;
+  }
+
+  // Returns the counter of samples of `task`, which may be null for tasks of
+  // the runtime. Must not be called in the signal handler.
+  std::atomic<uint64_t>* get_samples(const void* task) {
+    unique_lock lock(this->mtx);
+    auto& entry = this->entries[task];
+    ++entry.instance_count;
+    return &entry.samples;
+  }
+
+  // Counter of samples taken in worker threads outside coroutines.
+  std::atomic<uint64_t>* scheduler_samples() { return &this->scheduler; }
+
+  void start() {
+    struct sigaction action = {};
+    action.sa_handler = handle;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &this->old_action);
+    itimerval timer = {{0, kIntervalUs}, {0, kIntervalUs}};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+  }
+
+  void stop() {
+    itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &this->old_action, nullptr);
+    this->report();
+  }
+
+ private:
+  static constexpr int kMaxThreads = 1024;
+
+  struct entry {
+    std::atomic<uint64_t> samples{0};
+    uint64_t instance_count = 0;
+  };
+
+  // Samples are attributed to the counter of the slot of the current thread,
+  // or to the other threads if it has none.
+  static void handle(int) {
+    const int saved_errno = errno;
+    const pid_t tid = syscall(SYS_gettid);
+    std::atomic<uint64_t>* samples = &instance->other;
+    for (auto& slot : instance->slots) {
+      if (slot.tid.load(std::memory_order_relaxed) == tid) {
+        if (auto current = slot.current.load(std::memory_order_relaxed)) {
+          samples = current;
+        }
+        break;
+      }
+    }
+    samples->fetch_add(1, std::memory_order_relaxed);
+    errno = saved_errno;
+  }
+
+  // Returns the demangled name of `task`, or its offset in the binary if the
+  // symbol is not exported, which `addr2line -f -C -e` resolves.
+  static string get_name(const void* task) {
+    if (task == nullptr) return "(async_mmap and other runtime tasks)";
+    Dl_info info;
+    if (dladdr(task, &info) == 0 || info.dli_fname == nullptr) {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%p", task);
+      return buf;
+    }
+    if (info.dli_sname != nullptr) {
+      int status = 0;
+      std::unique_ptr<char, decltype(&free)> demangled(
+          abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status),
+          free);
+      return status == 0 ? demangled.get() : info.dli_sname;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "+%#zx",
+             static_cast<const char*>(task) -
+                 static_cast<const char*>(info.dli_fbase));
+    return info.dli_fname + string(buf);
+  }
+
+  void report() {
+    std::vector<std::tuple<uint64_t, uint64_t, string>> rows;
+    {
+      unique_lock lock(this->mtx);
+      for (auto& pair : this->entries) {
+        rows.emplace_back(pair.second.samples.load(), pair.second.instance_count,
+                          get_name(pair.first));
+      }
+    }
+    rows.emplace_back(this->scheduler.load(), 0, "(scheduler)");
+    rows.emplace_back(this->other.load(), 0, "(other threads)");
+    std::sort(rows.rbegin(), rows.rend());
+
+    uint64_t total = 0;
+    for (auto& row : rows) total += std::get<0>(row);
+    const char* path = getenv("TAPA_PROFILE");
+    std::ofstream os(path);
+    os << "# cpu_ms percent instances task\n";
+    for (auto& row : rows) {
+      if (std::get<0>(row) == 0) continue;
+      os << std::get<0>(row) * kIntervalUs / 1000 << ' '
+         << 100. * std::get<0>(row) / total << "% " << std::get<1>(row) << ' '
+         << std::get<2>(row) << '\n';
+    }
+    LOG_IF(WARNING, !os) << "cannot write profile to '" << path << "'";
+    LOG_IF(INFO, os) << "profile of " << total * kIntervalUs / 1000
+                     << " ms of CPU time written to '" << path << "'";
+  }
+
+  mutex mtx;
+  unordered_map<const void*, entry> entries;
+  std::atomic<uint64_t> scheduler{0};
+  std::atomic<uint64_t> other{0};
+  thread_slot slots[kMaxThreads];
+  struct sigaction old_action = {};
+
+ public:
+  // Not null if TAPA_PROFILE is set. Never destroyed so that the handler
+  // always sees a valid instance.
+  static profiler* const instance;
+};
+
+profiler* const profiler::instance =
+    getenv("TAPA_PROFILE") ? new profiler : nullptr;
+
 class worker {
   // dict mapping detach to list of coroutine
   // list is used because the stable pointer can be used as key in handle_table
@@ -108,7 +283,10 @@ class worker {
   // dict mapping coroutine to handle
   unordered_map<push_type*, pull_type*> handle_table;
 
-  std::queue<std::tuple<bool, function<void()>>> tasks;
+  // dict mapping coroutine to its counter of samples if profiling
+  unordered_map<push_type*, std::atomic<uint64_t>*> samples_table;
+
+  std::queue<std::tuple<bool, function<void()>, const void*>> tasks;
   mutex mtx;
   condition_variable task_cv;
   condition_variable wait_cv;
@@ -120,6 +298,9 @@ class worker {
   worker() {
     auto stack_size = get_stack_size();
     this->thread = std::thread([this, stack_size]() {
+      profiler::thread_slot* profile_slot =
+          profiler::instance == nullptr ? nullptr
+                                        : profiler::instance->register_thread();
       for (;;) {
         // accept new tasks
         {
@@ -136,7 +317,8 @@ class worker {
           while (!this->tasks.empty()) {
             bool detach;
             function<void()> f;
-            std::tie(detach, f) = this->tasks.front();
+            const void* task;
+            std::tie(detach, f, task) = this->tasks.front();
             this->tasks.pop();
 
             auto& l = this->coroutines[detach];  // list of coroutines
@@ -147,6 +329,10 @@ class worker {
               f();
             };
             l.emplace_back(fixedsize_stack(stack_size), call_back);
+            if (profiler::instance != nullptr) {
+              this->samples_table[&l.back()] =
+                  profiler::instance->get_samples(task);
+            }
             *coroutine = &l.back();
           }
         }
@@ -161,7 +347,13 @@ class worker {
           for (auto it = coroutines.begin(); it != coroutines.end();) {
             if (auto& coroutine = *it) {
               current_handle = this->handle_table[&coroutine];
-              coroutine();
+              if (profile_slot != nullptr) {
+                profile_slot->current = this->samples_table[&coroutine];
+                coroutine();
+                profile_slot->current = profiler::instance->scheduler_samples();
+              } else {
+                coroutine();
+              }
             }
 
             if (*it) {
@@ -169,6 +361,7 @@ class worker {
               ++it;
             } else {
               unique_lock lock(this->mtx);
+              this->samples_table.erase(&*it);
               it = coroutines.erase(it);
             }
           }
@@ -180,13 +373,14 @@ class worker {
         // response to wait requests
         if (!active) this->wait_cv.notify_all();
       }
+      profiler::unregister_thread(profile_slot);
     });
   }
 
-  void add_task(bool detach, const function<void()>& f) {
+  void add_task(bool detach, const function<void()>& f, const void* task) {
     {
       unique_lock lock(this->mtx);
-      this->tasks.emplace(detach, f);
+      this->tasks.emplace(detach, f, task);
     }
     this->task_cv.notify_one();
   }
@@ -229,6 +423,7 @@ class thread_pool {
     }
     this->add_worker(worker_count);
     it = workers.begin();
+    if (profiler::instance != nullptr) profiler::instance->start();
   }
 
   void add_worker(size_t count = 1) {
@@ -238,9 +433,9 @@ class thread_pool {
     }
   }
 
-  void add_task(bool detach, const function<void()>& f) {
+  void add_task(bool detach, const function<void()>& f, const void* task) {
     unique_lock lock(this->worker_mtx);
-    it->add_task(detach, f);
+    it->add_task(detach, f, task);
     ++it;
     if (it == this->workers.end()) it = this->workers.begin();
   }
@@ -256,6 +451,7 @@ class thread_pool {
   ~thread_pool() {
     unique_lock lock(this->worker_mtx);
     this->workers.clear();
+    if (profiler::instance != nullptr) profiler::instance->stop();
   }
 };
 
@@ -290,8 +486,8 @@ void signal_handler(int signal) {
 
 }  // namespace
 
-void schedule(bool detach, const function<void()>& f) {
-  pool->add_task(detach, f);
+void schedule(bool detach, const function<void()>& f, const void* task) {
+  pool->add_task(detach, f, task);
 }
 
 }  // namespace internal
@@ -320,28 +516,277 @@ task::~task() {
 namespace tapa {
 namespace internal {
 
-void yield(const std::string& msg) { std::this_thread::yield(); }
-
 namespace {
 
 std::deque<std::thread>* threads = nullptr;
 const task* top_task = nullptr;
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+std::mutex mtx;
+
+// Unfinished joined tasks, including both threads and coroutines. A task is
+// counted when it is scheduled, i.e., before its parent finishes, so the count
+// drops to zero only after all descendants of the top-level task finish.
+int64_t joined_task_count = 0;
+std::condition_variable joined_cv;
+
+void finish_joined_task() {
+  std::unique_lock<std::mutex> lock(mtx);
+  if (--joined_task_count == 0) joined_cv.notify_all();
+}
+#else   // TAPA_ENABLE_STACKLESS_COROUTINE
 int active_task_count = 0;
 std::mutex mtx;
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
 
 }  // namespace
 
-void schedule(bool detach, const std::function<void()>& f) {
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+
+namespace {
+
+struct coroutine_entry {
+  // Owns the bound arguments referenced by the coroutine frame.
+  std::unique_ptr<std::function<coroutine()>> f;
+  std::coroutine_handle<> handle;
+  awaiter_base* awaiter = nullptr;
+  bool detach;
+};
+
+thread_local coroutine_entry* current_entry = nullptr;
+thread_local bool is_coroutine_worker = false;
+
+// Awaiters have no wakeup hooks, so a worker that made no progress in a pass
+// sleeps until another worker makes progress, a task is added, or a timeout
+// elapses, which bounds the latency of progress made by threads.
+std::atomic<uint64_t> progress_epoch{0};
+std::atomic<int> idle_worker_count{0};
+std::mutex idle_mtx;
+std::condition_variable idle_cv;
+
+void notify_progress() {
+  ++progress_epoch;
+  if (idle_worker_count != 0) {
+    std::unique_lock<std::mutex> lock(idle_mtx);
+    idle_cv.notify_all();
+  }
+}
+
+// Waits until `notify_progress` is called after `epoch` was loaded.
+void wait_for_progress(uint64_t epoch) {
+  constexpr auto kIdleTimeout = std::chrono::milliseconds(1);
+  std::unique_lock<std::mutex> lock(idle_mtx);
+  ++idle_worker_count;
+  idle_cv.wait_for(lock, kIdleTimeout,
+                   [epoch] { return progress_epoch != epoch; });
+  --idle_worker_count;
+}
+
+// Runs coroutines round-robin on one thread. A coroutine is resumed only if
+// the awaiter it is suspended on is ready.
+class coroutine_worker {
+  std::list<coroutine_entry> entries;  // only accessed by `thread`
+  std::deque<coroutine_entry> new_entries;
+  bool done = false;
+  std::mutex mtx;
+  std::condition_variable task_cv;
+  std::thread thread;
+
+  void run() {
+    // passes without progress before the worker sleeps
+    constexpr int kSpinPasses = 16;
+    int idle_passes = 0;
+    is_coroutine_worker = true;
+    for (;;) {
+      const uint64_t epoch = progress_epoch;
+      {
+        std::unique_lock<std::mutex> lock(this->mtx);
+        this->task_cv.wait(lock, [this] {
+          return this->done || !this->entries.empty() ||
+                 !this->new_entries.empty();
+        });
+        if (this->done) break;
+        for (auto& entry : this->new_entries) {
+          this->entries.push_back(std::move(entry));
+        }
+        this->new_entries.clear();
+      }
+
+      bool is_progressing = false;
+      for (auto it = this->entries.begin(); it != this->entries.end();) {
+        auto& entry = *it;
+        if (entry.awaiter != nullptr && !entry.awaiter->ready()) {
+          ++it;
+          continue;
+        }
+        is_progressing = true;
+        entry.awaiter = nullptr;
+        current_entry = &entry;
+        entry.handle.resume();
+        current_entry = nullptr;
+        if (!entry.handle.done()) {
+          ++it;
+          continue;
+        }
+        entry.handle.destroy();
+        if (!entry.detach) finish_joined_task();
+        it = this->entries.erase(it);
+      }
+      if (is_progressing) {
+        idle_passes = 0;
+        notify_progress();
+      } else if (++idle_passes < kSpinPasses) {
+        std::this_thread::yield();
+      } else {
+        wait_for_progress(epoch);
+      }
+    }
+
+    for (auto& entry : this->entries) entry.handle.destroy();
+    for (auto& entry : this->new_entries) entry.handle.destroy();
+  }
+
+ public:
+  coroutine_worker() : thread([this] { this->run(); }) {}
+
+  void add_task(bool detach, std::function<coroutine()> f) {
+    coroutine_entry entry;
+    entry.f = std::make_unique<std::function<coroutine()>>(std::move(f));
+    entry.handle = (*entry.f)().release();
+    entry.detach = detach;
+    {
+      std::unique_lock<std::mutex> lock(this->mtx);
+      this->new_entries.push_back(std::move(entry));
+    }
+    this->task_cv.notify_one();
+    notify_progress();
+  }
+
+  ~coroutine_worker() {
+    {
+      std::unique_lock<std::mutex> lock(this->mtx);
+      this->done = true;
+    }
+    this->task_cv.notify_all();
+    notify_progress();
+    this->thread.join();
+  }
+};
+
+class coroutine_pool {
+  std::list<coroutine_worker> workers;
+  decltype(workers)::iterator it;
+  std::mutex mtx;
+
+ public:
+  coroutine_pool() {
+    size_t worker_count = std::thread::hardware_concurrency();
+    if (auto concurrency = getenv("TAPA_CONCURRENCY")) {
+      worker_count = atoi(concurrency);
+    }
+    for (size_t i = 0; i < std::max<size_t>(worker_count, 1); ++i) {
+      this->workers.emplace_back();
+    }
+    this->it = this->workers.begin();
+  }
+
+  void add_task(bool detach, std::function<coroutine()> f) {
+    std::unique_lock<std::mutex> lock(this->mtx);
+    this->it->add_task(detach, std::move(f));
+    if (++this->it == this->workers.end()) this->it = this->workers.begin();
+  }
+};
+
+std::unique_ptr<coroutine_pool> coroutines;
+std::mutex coroutines_mtx;
+
+// Must be called after all joined tasks finish.
+void destroy_coroutines() {
+  std::unique_lock<std::mutex> lock(coroutines_mtx);
+  coroutines.reset();  // destroys detached coroutines
+}
+
+}  // namespace
+
+void suspend(awaiter_base* awaiter) {
+  CHECK(current_entry != nullptr)
+      << "co_await is only allowed in tasks returning tapa::coroutine";
+  current_entry->awaiter = awaiter;
+}
+
+void schedule_coroutine(bool detach, std::function<coroutine()> f) {
+  if (!detach) {
+    std::unique_lock<std::mutex> lock(internal::mtx);
+    ++joined_task_count;
+  }
+  std::unique_lock<std::mutex> lock(coroutines_mtx);
+  if (coroutines == nullptr) coroutines = std::make_unique<coroutine_pool>();
+  coroutines->add_task(detach, std::move(f));
+}
+
+void run_coroutine(std::function<coroutine()> f) {
+  task top;
+  schedule_coroutine(/* detach= */ false, std::move(f));
+}
+
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+
+void yield(const std::string& msg) {
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+  // Coroutine workers poll awaiters instead of yielding the thread.
+  if (is_coroutine_worker) return;
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+  std::this_thread::yield();
+}
+
+void schedule(bool detach, const std::function<void()>& f, const void* task) {
   if (detach) {
     std::thread(f).detach();
   } else {
     std::unique_lock<std::mutex> lock(internal::mtx);
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+    ++joined_task_count;
+    threads->emplace_back([f] {
+      f();
+      finish_joined_task();
+    });
+#else   // TAPA_ENABLE_STACKLESS_COROUTINE
     threads->emplace_back(f);
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
   }
 }
 
 }  // namespace internal
 
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+
+task::task() {
+  std::unique_lock<std::mutex> lock(internal::mtx);
+  if (internal::top_task == nullptr) {
+    internal::top_task = this;
+  }
+  if (internal::threads == nullptr) {
+    internal::threads = new std::deque<std::thread>;
+  }
+}
+
+task::~task() {
+  if (this == internal::top_task) {
+    std::deque<std::thread> threads;
+    {
+      std::unique_lock<std::mutex> lock(internal::mtx);
+      internal::joined_cv.wait(
+          lock, [] { return internal::joined_task_count == 0; });
+      threads.swap(*internal::threads);
+    }
+    for (auto& t : threads) t.join();
+    internal::destroy_coroutines();
+    std::unique_lock<std::mutex> lock(internal::mtx);
+    internal::top_task = nullptr;
+  }
+}
+
+#else  // TAPA_ENABLE_STACKLESS_COROUTINE
+
 task::task() {
   std::unique_lock<std::mutex> lock(internal::mtx);
   ++internal::active_task_count;
@@ -378,6 +823,8 @@ task::~task() {
   --internal::active_task_count;
 }
 
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+
 }  // namespace tapa
 
 #endif  // TAPA_ENABLE_COROUTINE
@@ -395,5 +842,171 @@ void deallocate(void* addr, size_t length) {
   if (::munmap(addr, length) != 0) throw std::bad_alloc();
 }
 
+std::shared_ptr<void> map_file(const std::string& path, file_mode mode,
+                               uint64_t& length) {
+  const bool is_written = mode & file_mode::write_only;
+  const int fd =
+      ::open(path.c_str(), is_written ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+  PCHECK(fd != -1) << "cannot open '" << path << "'";
+
+  struct stat file_stat;
+  PCHECK(::fstat(fd, &file_stat) == 0) << "cannot stat '" << path << "'";
+  const uint64_t file_size = file_stat.st_size;
+  if (length == 0) {
+    length = file_size;
+  } else if (is_written) {
+    if (length != file_size) {
+      PCHECK(::ftruncate(fd, length) == 0) << "cannot resize '" << path << "'";
+    }
+  } else {
+    CHECK_LE(length, file_size)
+        << "cannot map " << length << " bytes from '" << path
+        << "', which has only " << file_size << " bytes";
+  }
+  CHECK_GT(length, 0) << "cannot map empty file '" << path << "'";
+
+  // Read-only mappings let stray writes of the kernel fault in simulation.
+  const int prot = is_written ? PROT_READ | PROT_WRITE : PROT_READ;
+  int flags = MAP_SHARED;
+  if (mode & file_mode::populate) flags |= MAP_POPULATE;
+  void* addr = ::mmap(nullptr, length, prot, flags, fd, /*offset=*/0);
+  PCHECK(addr != MAP_FAILED) << "cannot map '" << path << "'";
+  ::close(fd);  // the mapping holds its own reference to the file
+
+  if ((mode & file_mode::huge_pages) &&
+      ::madvise(addr, length, MADV_HUGEPAGE) != 0) {
+    PLOG(WARNING) << "cannot use huge pages for '" << path << "'";
+  }
+
+  return std::shared_ptr<void>(
+      addr, [length = length](void* addr) { ::munmap(addr, length); });
+}
+
+prefetch_model::~prefetch_model() {
+  const uint64_t read_count = hit_count_ + miss_count_;
+  if (read_count == 0) return;
+  LOG(INFO) << "async_mmap at " << ptr_ << " with prefetch depth " << depth_
+            << ": " << hit_count_ << " of " << read_count
+            << " reads served by prefetches (" << 100 * hit_count_ / read_count
+            << "%)";
+}
+
+void prefetch_model::read(int64_t addr) {
+  const int64_t stride = addr - last_addr_;
+  if (prefetched_ != 0 && addr == head_addr_) {
+    ++hit_count_;
+    head_addr_ += stride_;
+    --prefetched_;
+  } else {
+    // outstanding prefetches are dropped, and prefetching resumes after addr
+    ++miss_count_;
+    head_addr_ = addr + stride;
+    prefetched_ = 0;
+  }
+
+  if (stride == stride_) {
+    if (confidence_ < 3) ++confidence_;
+  } else {
+    stride_ = stride;
+    confidence_ = 0;
+  }
+  last_addr_ = addr;
+
+  // same as the default Threshold of stride_prefetch.v
+  constexpr int kThreshold = 2;
+  if (confidence_ >= kThreshold && stride_ != 0) prefetched_ = depth_;
+}
+
+timing_model::timing_model(const void* ptr, uint64_t elem_bytes,
+                           const memory_timing& timing)
+    : ptr_(ptr),
+      elem_bytes_(elem_bytes),
+      timing_(timing),
+      max_burst_len_(
+          std::max<uint64_t>(1, timing.max_burst_bytes / elem_bytes)) {
+  CHECK_GT(timing_.bytes_per_cycle, 0);
+  CHECK_GT(timing_.page_bytes, 0);
+}
+
+timing_model::~timing_model() {
+  if (reads_.burst_len != 0) issue(reads_);
+  if (writes_.burst_len != 0) issue(writes_);
+
+  memory_stats stats;
+  stats.read_count = reads_.request_count;
+  stats.write_count = writes_.request_count;
+  stats.read_burst_count = reads_.burst_count;
+  stats.write_burst_count = writes_.burst_count;
+  stats.page_miss_count = page_miss_count_;
+  stats.cycle_count = free_cycle_;
+  if (timing_.stats != nullptr) *timing_.stats = stats;
+
+  if (stats.cycle_count == 0) return;
+  const uint64_t bytes = (stats.read_count + stats.write_count) * elem_bytes_;
+  LOG(INFO) << "async_mmap at " << ptr_ << ": " << stats.read_count
+            << " reads in " << stats.read_burst_count << " bursts, "
+            << stats.write_count << " writes in " << stats.write_burst_count
+            << " bursts, " << stats.page_miss_count << " page misses, "
+            << stats.cycle_count << " cycles ("
+            << double(bytes) / stats.cycle_count << " bytes/cycle)";
+}
+
+void timing_model::access(channel& ch, int64_t addr) {
+  ++ch.request_count;
+
+  // bursts cannot cross 4 KB boundaries in AXI
+  constexpr int64_t kBoundary = 4096;
+  const int64_t begin = ch.burst_addr * elem_bytes_;
+  const int64_t end = addr * elem_bytes_;
+  if (ch.burst_len != 0 && addr == ch.burst_addr + int64_t(ch.burst_len) &&
+      ch.burst_len < max_burst_len_ && begin / kBoundary == end / kBoundary) {
+    ++ch.burst_len;
+  } else {
+    if (ch.burst_len != 0) issue(ch);
+    ch.burst_addr = addr;
+    ch.burst_len = 1;
+  }
+  ++ch.request_cycle;
+}
+
+void timing_model::issue(channel& ch) {
+  // wait until the burst fits among the requests in flight
+  uint64_t cycle = ch.request_cycle;
+  const uint64_t max_outstanding = timing_.max_outstanding;
+  while (!ch.done.empty() &&
+         (ch.done.front().first <= cycle ||
+          (max_outstanding != 0 &&
+           ch.outstanding + ch.burst_len > max_outstanding))) {
+    cycle = std::max(cycle, ch.done.front().first);
+    ch.outstanding -= ch.done.front().second;
+    ch.done.pop();
+  }
+  ch.request_cycle = cycle;  // the kernel stalls until the burst is issued
+
+  uint64_t start = std::max(cycle + timing_.latency, free_cycle_);
+  if (ch.is_write != is_writing_ &&
+      reads_.burst_count + writes_.burst_count != 0) {
+    start += timing_.turnaround_cycles;
+  }
+  is_writing_ = ch.is_write;
+
+  const uint64_t bytes = ch.burst_len * elem_bytes_;
+  const int64_t first_page = ch.burst_addr * elem_bytes_ / timing_.page_bytes;
+  const int64_t last_page =
+      (ch.burst_addr * elem_bytes_ + bytes - 1) / timing_.page_bytes;
+  if (first_page != open_page_) {
+    start += timing_.page_miss_cycles;
+    ++page_miss_count_;
+  }
+  open_page_ = last_page;
+
+  free_cycle_ = start + (bytes + timing_.bytes_per_cycle - 1) /
+                            timing_.bytes_per_cycle;
+  ch.done.emplace(free_cycle_, ch.burst_len);
+  ch.outstanding += ch.burst_len;
+  ++ch.burst_count;
+  ch.burst_len = 0;
+}
+
 }  // namespace internal
 }  // namespace tapa
@@ -5,6 +5,9 @@
 
 #include "tapa/host/coroutine.h"
 #include "tapa/host/mmap.h"
+#include "tapa/host/mover.h"
+#include "tapa/host/primitive.h"
+#include "tapa/host/qdma.h"
 #include "tapa/host/stream.h"
 #include "tapa/host/task.h"
 #include "tapa/host/util.h"
@@ -14,6 +17,7 @@
 #include "tapa/host/buffer.h"
 #endif
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <iostream>
@@ -22,6 +26,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -56,6 +61,114 @@ inline int64_t invoke_in_new_process(Func&& f, const std::string& bitstream,
       std::forward<Args>(args)...);
 }
 
+/// Shard function of @c tapa::invoke_sharded that splits each mmap argument
+/// into contiguous ranges of (almost) equal size and passes any other argument,
+/// including @c tapa::mmaps, to every instance unchanged.
+struct shard_evenly {
+  /// Returns the number of elements of shard @c index of @c total elements.
+  static uint64_t size(uint64_t index, uint64_t count, uint64_t total) {
+    return offset(index + 1, count, total) - offset(index, count, total);
+  }
+
+  /// Returns the index of the first element of shard @c index of @c total
+  /// elements.
+  static uint64_t offset(uint64_t index, uint64_t count, uint64_t total) {
+    return total / count * index + std::min(total % count, index);
+  }
+
+  template <typename Arg>
+  Arg operator()(uint64_t index, uint64_t count, const Arg& arg) const {
+    if constexpr (decltype(is_mmap(&arg))::value) {
+      return arg.slice(offset(index, count, arg.size()),
+                       size(index, count, arg.size()));
+    } else {
+      return arg;
+    }
+  }
+
+ private:
+  template <typename T>
+  static std::true_type is_mmap(const mmap<T>*);
+  static std::false_type is_mmap(...);
+};
+
+/// Invokes top-level task @c f on several instances concurrently, each
+/// processing a shard of the arguments, and returns the kernel time of each
+/// instance in nanoseconds.
+///
+/// Instance @c i receives <tt>shard(i, bitstreams.size(), arg)</tt> for each
+/// @c arg of @c args. @c tapa::shard_evenly slices mmap arguments without
+/// copying them; a custom shard function can delegate to it and adjust the
+/// other arguments, e.g., the number of elements:
+///
+/// @code{.cpp}
+///  auto shard = [n](uint64_t i, uint64_t count, auto arg) {
+///    if constexpr (std::is_same_v<decltype(arg), uint64_t>) {
+///      return tapa::shard_evenly::size(i, count, n);
+///    } else {
+///      return tapa::shard_evenly()(i, count, arg);
+///    }
+///  };
+///  tapa::invoke_sharded(VecAdd, std::vector<std::string>(4, bitstream), shard,
+///                       tapa::read_only_mmap<const float>(a), ..., n);
+/// @endcode
+///
+/// Each non-empty bitstream runs in its own thread as in @c tapa::invoke, so
+/// instances may be different cards or bitstreams. If all bitstreams are
+/// empty, the instances run in one software simulation concurrently, standing
+/// in for replicated kernels, and each returned time is the simulation time.
+///
+/// @param f          Top-level task.
+/// @param bitstreams Bitstream of each instance; must be all empty or none.
+/// @param shard      Function returning the argument of an instance.
+/// @param args       Arguments of @c f before sharding.
+/// @return Kernel time of each instance in nanoseconds.
+template <typename Func, typename Shard, typename... Args>
+inline std::vector<int64_t> invoke_sharded(
+    Func&& f, const std::vector<std::string>& bitstreams, Shard&& shard,
+    Args&&... args) {
+  static_assert(std::is_function_v<typename std::remove_reference_t<Func>>,
+                "the first argument for tapa::invoke_sharded() must be a "
+                "function");
+  const uint64_t count = bitstreams.size();
+  CHECK_GT(count, 0) << "tapa::invoke_sharded() needs at least one instance";
+  const bool is_csim = bitstreams.front().empty();
+  for (const auto& bitstream : bitstreams) {
+    CHECK_EQ(bitstream.empty(), is_csim)
+        << "tapa::invoke_sharded() cannot mix software simulation and "
+           "bitstreams";
+  }
+
+  std::vector<int64_t> kernel_time_ns(count);
+  if (is_csim) {
+    LOG(INFO) << "running software simulation of " << count
+              << " instances with TAPA library";
+    const auto tic = std::chrono::steady_clock::now();
+    {
+      task top;
+      for (uint64_t i = 0; i < count; ++i) {
+        internal::invoker<Func>::schedule_top(f, shard(i, count, args)...);
+      }
+    }
+    const auto toc = std::chrono::steady_clock::now();
+    std::fill(kernel_time_ns.begin(), kernel_time_ns.end(),
+              std::chrono::duration_cast<std::chrono::nanoseconds>(toc - tic)
+                  .count());
+  } else {
+    std::vector<std::thread> threads;
+    for (uint64_t i = 0; i < count; ++i) {
+      threads.emplace_back([&, i] {
+        kernel_time_ns[i] = internal::invoker<Func>::template invoke<
+            decltype(shard(i, count, args))...>(
+            /*run_in_new_process*/ false, f, bitstreams[i],
+            shard(i, count, args)...);
+      });
+    }
+    for (auto& thread : threads) thread.join();
+  }
+  return kernel_time_ns;
+}
+
 template <typename T>
 struct aligned_allocator {
   using value_type = T;
@@ -5,6 +5,7 @@
 
 #include "tapa/host/coroutine.h"
 #include "tapa/host/logging.h"
+#include "tapa/host/rtl_sim.h"
 
 #include <sys/wait.h>
 #include <chrono>
@@ -23,6 +24,9 @@ struct accessor {
   static void access(fpga::Instance& instance, int& idx, Arg&& arg) {
     instance.SetArg(idx++, static_cast<Param>(arg));
   }
+  static void access(rtl_sim& sim, int& idx, Arg&& arg) {
+    sim.SetArg(idx++, static_cast<Param>(arg));
+  }
 };
 
 template <typename T>
@@ -31,6 +35,9 @@ struct accessor<T, seq> {
   static void access(fpga::Instance& instance, int& idx, seq&& arg) {
     instance.SetArg(idx++, static_cast<T>(arg.pos++));
   }
+  static void access(rtl_sim& sim, int& idx, seq&& arg) {
+    sim.SetArg(idx++, static_cast<T>(arg.pos++));
+  }
 };
 
 void* allocate(size_t length);
@@ -39,22 +46,52 @@ void deallocate(void* addr, size_t length);
 template <typename T>
 struct invoker;
 
-template <typename... Params>
-struct invoker<void (&)(Params...)> {
+// Returns true if `R` is the return type of a task implemented as a stackless
+// coroutine.
+template <typename R>
+inline constexpr bool is_coroutine_v =
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+    std::is_same_v<R, coroutine>;
+#else   // TAPA_ENABLE_STACKLESS_COROUTINE
+    false;
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+
+template <typename R, typename... Params>
+struct invoker<R (&)(Params...)> {
+  static_assert(std::is_void_v<R> || is_coroutine_v<R>,
+                "task functions must return void");
+
   template <typename... Args>
-  static void invoke(bool detach, void (&f)(Params...), Args&&... args) {
+  static void invoke(bool detach, R (&f)(Params...), Args&&... args) {
     // std::bind creates a copy of args
-    internal::schedule(detach, std::bind(f, accessor<Params, Args>::access(
-                                                std::forward<Args>(args))...));
+    auto bound = std::bind(
+        f, accessor<Params, Args>::access(std::forward<Args>(args))...);
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+    if constexpr (is_coroutine_v<R>) {
+      internal::schedule_coroutine(detach, std::move(bound));
+    } else
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+    {
+      internal::schedule(detach, std::move(bound),
+                         reinterpret_cast<const void*>(&f));
+    }
   }
 
   template <typename... Args>
-  static int64_t invoke(bool run_in_new_process, void (&f)(Params...),
+  static int64_t invoke(bool run_in_new_process, R (&f)(Params...),
                         const std::string& bitstream, Args&&... args) {
     if (bitstream.empty()) {
       LOG(INFO) << "running software simulation with TAPA library";
       const auto tic = std::chrono::steady_clock::now();
-      f(std::forward<Args>(args)...);
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+      if constexpr (is_coroutine_v<R>) {
+        internal::run_coroutine(std::bind(
+            f, accessor<Params, Args>::access(std::forward<Args>(args))...));
+      } else
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+      {
+        f(std::forward<Args>(args)...);
+      }
       const auto toc = std::chrono::steady_clock::now();
       return std::chrono::duration_cast<std::chrono::nanoseconds>(toc - tic)
           .count();
@@ -83,10 +120,39 @@ struct invoker<void (&)(Params...)> {
     }
   }
 
+  // Schedules software simulation of top-level task `f` as a child of the
+  // current task. Unlike children, `f` receives `args` as in a direct call.
+  template <typename... Args>
+  static void schedule_top(R (&f)(Params...), Args&&... args) {
+    auto bound = std::bind(f, std::forward<Args>(args)...);
+#if TAPA_ENABLE_STACKLESS_COROUTINE
+    if constexpr (is_coroutine_v<R>) {
+      internal::schedule_coroutine(/* detach= */ false, std::move(bound));
+    } else
+#endif  // TAPA_ENABLE_STACKLESS_COROUTINE
+    {
+      internal::schedule(/* detach= */ false, std::move(bound),
+                         reinterpret_cast<const void*>(&f));
+    }
+  }
+
  private:
   template <typename... Args>
-  static int64_t invoke(void (&f)(Params...), const std::string& bitstream,
+  static int64_t invoke(R (&f)(Params...), const std::string& bitstream,
                         Args&&... args) {
+    // Shared libraries are generated by `tapac --verilator-sim`.
+    const std::string so_suffix = ".so";
+    if (bitstream.size() > so_suffix.size() &&
+        bitstream.compare(bitstream.size() - so_suffix.size(),
+                          so_suffix.size(), so_suffix) == 0) {
+      rtl_sim sim(bitstream);
+      int idx = 0;
+      int _[] = {(
+          accessor<Params, Args>::access(sim, idx, std::forward<Args>(args)),
+          0)...};
+      return sim.Run();
+    }
+
     auto instance = fpga::Instance(bitstream);
     int idx = 0;
     int _[] = {(
@@ -0,0 +1,318 @@
+#ifndef TAPA_STENCIL_H_
+#define TAPA_STENCIL_H_
+
+#include <cstdint>
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "tapa.h"
+
+// A stencil is declared by a struct S with the following members:
+//
+//   using type = float;                  // element type
+//   static constexpr int kWidth = 1024;  // elements per row
+//   static constexpr int kUnroll = 16;   // elements per token and PEs per stage
+//   static constexpr tapa::stencil::offset kTaps[] = {{-1, 0}, {0, 0}, ...};
+//   static float compute(const float (&taps)[kTapCount]);
+//
+// Elements are processed in row-major order. Output element i is computed
+// from input elements i + row * kWidth + col of all taps, so taps in the first
+// and last columns of a row wrap around to the neighboring rows. Output
+// elements with taps out of the grid keep their input values.
+
+namespace tapa {
+namespace stencil {
+
+/// Offset of a tap relative to the output element, in rows and columns.
+struct offset {
+  int row;
+  int col;
+};
+
+namespace internal {
+
+inline constexpr int floor_div(int a, int b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+template <typename S>
+inline constexpr int tap_count() {
+  return std::extent<decltype(S::kTaps)>::value;
+}
+
+template <typename S>
+inline constexpr int linear_offset(int tap) {
+  return S::kTaps[tap].row * S::kWidth + S::kTaps[tap].col;
+}
+
+// Range of linear offsets read by a stage, which always includes 0.
+template <typename S>
+inline constexpr int min_offset() {
+  int result = 0;
+  for (int t = 0; t < tap_count<S>(); ++t) {
+    if (linear_offset<S>(t) < result) result = linear_offset<S>(t);
+  }
+  return result;
+}
+
+template <typename S>
+inline constexpr int max_offset() {
+  int result = 0;
+  for (int t = 0; t < tap_count<S>(); ++t) {
+    if (linear_offset<S>(t) > result) result = linear_offset<S>(t);
+  }
+  return result;
+}
+
+// Tokens read by a stage are [first_token, last_token] relative to the token
+// being produced.
+template <typename S>
+inline constexpr int first_token() {
+  return floor_div(min_offset<S>(), S::kUnroll);
+}
+
+template <typename S>
+inline constexpr int last_token() {
+  return floor_div(max_offset<S>() + S::kUnroll - 1, S::kUnroll);
+}
+
+template <typename S>
+inline constexpr bool is_read(int token) {
+  if (token == 0 || token == first_token<S>() || token == last_token<S>()) {
+    return true;
+  }
+  for (int t = 0; t < tap_count<S>(); ++t) {
+    for (int k = 0; k < S::kUnroll; ++k) {
+      if (floor_div(linear_offset<S>(t) + k, S::kUnroll) == token) return true;
+    }
+  }
+  return false;
+}
+
+// Tokens that are read are kept in registers, newest first.
+template <typename S>
+inline constexpr int reg_count() {
+  int result = 0;
+  for (int token = first_token<S>(); token <= last_token<S>(); ++token) {
+    result += is_read<S>(token);
+  }
+  return result;
+}
+
+template <typename S>
+inline constexpr int reg_of(int token) {
+  int result = 0;
+  for (int i = last_token<S>(); i > token; --i) {
+    result += is_read<S>(i);
+  }
+  return result;
+}
+
+// Where each tap of each lane is found in the registers, and how many tokens
+// are delayed in memory between consecutive registers.
+template <typename S>
+struct layout {
+  int reg[tap_count<S>()][S::kUnroll];
+  int lane[tap_count<S>()][S::kUnroll];
+  int gap[reg_count<S>()];
+  int max_gap;
+};
+
+template <typename S>
+inline constexpr layout<S> make_layout() {
+  layout<S> result{};
+  for (int t = 0; t < tap_count<S>(); ++t) {
+    for (int k = 0; k < S::kUnroll; ++k) {
+      const int elem = linear_offset<S>(t) + k;
+      const int token = floor_div(elem, S::kUnroll);
+      result.reg[t][k] = reg_of<S>(token);
+      result.lane[t][k] = elem - token * S::kUnroll;
+    }
+  }
+  result.max_gap = 1;
+  for (int token = last_token<S>(), r = 0; token > first_token<S>();) {
+    int next = token - 1;
+    while (!is_read<S>(next)) --next;
+    result.gap[r] = token - next - 1;
+    if (result.gap[r] > result.max_gap) result.max_gap = result.gap[r];
+    token = next;
+    ++r;
+  }
+  return result;
+}
+
+}  // namespace internal
+
+/// Type of the tokens of stencil @c S, each holding @c S::kUnroll elements.
+template <typename S>
+using vec = vec_t<typename S::type, S::kUnroll>;
+
+/// Runs one temporal iteration of stencil @c S on @c n tokens of @c in.
+///
+/// The reuse buffer only keeps the tokens read by the taps in registers and
+/// delays the tokens between them in memory, so a stage reads one token and
+/// writes one token per cycle, and streams between stages need no extra depth
+/// to balance the reconvergent paths. Chain stages for more iterations.
+///
+/// @param in  Input tokens.
+/// @param out Output tokens.
+/// @param n   Number of tokens.
+template <typename S>
+inline void iterate(istream<vec<S>>& in, ostream<vec<S>>& out, uint64_t n) {
+  using T = typename S::type;
+  constexpr int kTapCount = internal::tap_count<S>();
+  constexpr int kRegCount = internal::reg_count<S>();
+  constexpr int kLastToken = internal::last_token<S>();
+  constexpr int kCenter = internal::reg_of<S>(0);
+  constexpr int64_t kMinOffset = internal::min_offset<S>();
+  constexpr int64_t kMaxOffset = internal::max_offset<S>();
+  constexpr internal::layout<S> kLayout = internal::make_layout<S>();
+  constexpr int kMaxGap = kLayout.max_gap;
+
+  vec<S> regs[kRegCount];
+#pragma HLS array_partition variable = regs complete
+  vec<S> delay[kRegCount][kMaxGap];
+#pragma HLS array_partition variable = delay complete dim = 1
+  int ptr[kRegCount] = {};
+#pragma HLS array_partition variable = ptr complete
+
+  const int64_t n_elems = n * S::kUnroll;
+  for (uint64_t i = 0; i < n + kLastToken; ++i) {
+#pragma HLS pipeline II = 1
+#pragma HLS dependence variable = delay inter false
+    // shift the window by one token
+    vec<S> next[kRegCount];
+#pragma HLS array_partition variable = next complete
+    next[0] = i < n ? in.read() : vec<S>();
+    for (int r = 1; r < kRegCount; ++r) {
+#pragma HLS unroll
+      const int gap = kLayout.gap[r - 1];
+      if (gap == 0) {
+        next[r] = regs[r - 1];
+      } else {
+        next[r] = delay[r - 1][ptr[r - 1]];
+        delay[r - 1][ptr[r - 1]] = regs[r - 1];
+        ptr[r - 1] = ptr[r - 1] + 1 == gap ? 0 : ptr[r - 1] + 1;
+      }
+    }
+    for (int r = 0; r < kRegCount; ++r) {
+#pragma HLS unroll
+      regs[r] = next[r];
+    }
+
+    // produce a token once all tokens it reads are in the window
+    if (i >= kLastToken) {
+      const int64_t base = int64_t(i - kLastToken) * S::kUnroll;
+      vec<S> result;
+      for (int k = 0; k < S::kUnroll; ++k) {
+#pragma HLS unroll
+        T taps[kTapCount];
+#pragma HLS array_partition variable = taps complete
+        for (int t = 0; t < kTapCount; ++t) {
+#pragma HLS unroll
+          taps[t] = regs[kLayout.reg[t][k]][kLayout.lane[t][k]];
+        }
+        const int64_t elem = base + k;
+        const bool is_inner =
+            elem + kMinOffset >= 0 && elem + kMaxOffset < n_elems;
+        result.set(k, is_inner ? S::compute(taps) : regs[kCenter][k]);
+      }
+      out.write(result);
+    }
+  }
+}
+
+/// Reads @c n tokens from @c mem and writes them to @c out, keeping as many
+/// read requests in flight as the memory accepts.
+///
+/// @param mem Source memory.
+/// @param n   Number of tokens.
+/// @param out Output tokens.
+template <typename T>
+inline void load(async_mmap<T>& mem, uint64_t n, ostream<T>& out) {
+  for (uint64_t i_req = 0, i_resp = 0; i_resp < n;) {
+#pragma HLS pipeline II = 1
+    if (i_req < n && mem.read_addr.try_write(i_req)) {
+      ++i_req;
+    }
+    if (!mem.read_data.empty() && !out.full()) {
+      out.try_write(mem.read_data.read(nullptr));
+      ++i_resp;
+    }
+  }
+}
+
+/// Reads @c n tokens from @c in and writes them to @c mem, keeping as many
+/// write requests in flight as the memory accepts.
+///
+/// @param in  Input tokens.
+/// @param mem Destination memory.
+/// @param n   Number of tokens.
+template <typename T>
+inline void store(istream<T>& in, async_mmap<T>& mem, uint64_t n) {
+  for (uint64_t i_req = 0, i_resp = 0; i_resp < n;) {
+#pragma HLS pipeline II = 1
+    if (i_req < n && !in.empty() && !mem.write_addr.full() &&
+        !mem.write_data.full()) {
+      mem.write_addr.try_write(i_req);
+      mem.write_data.try_write(in.read(nullptr));
+      ++i_req;
+    }
+    if (!mem.write_resp.empty()) {
+      i_resp += unsigned(mem.write_resp.read(nullptr)) + 1;
+    }
+  }
+}
+
+#ifndef __SYNTHESIS__
+
+/// Runs @c iterations temporal iterations of stencil @c S on the host.
+///
+/// The result is the same as that of chained @c tapa::stencil::iterate stages.
+/// The inner elements of each iteration are computed in one loop without
+/// boundary checks, which compilers vectorize.
+///
+/// @param in         Input elements.
+/// @param out        Output elements, which may alias @c in.
+/// @param n          Number of elements.
+/// @param iterations Number of temporal iterations.
+template <typename S>
+inline void run(const typename S::type* in, typename S::type* out, uint64_t n,
+                int iterations) {
+  using T = typename S::type;
+  constexpr int kTapCount = internal::tap_count<S>();
+  constexpr int64_t kMinOffset = internal::min_offset<S>();
+  constexpr int64_t kMaxOffset = internal::max_offset<S>();
+  int64_t offsets[kTapCount];
+  for (int t = 0; t < kTapCount; ++t) {
+    offsets[t] = internal::linear_offset<S>(t);
+  }
+
+  const int64_t size = n;
+  const int64_t begin = -kMinOffset < size ? -kMinOffset : size;
+  const int64_t end = size - kMaxOffset > begin ? size - kMaxOffset : begin;
+  std::vector<T> src(in, in + n);
+  std::vector<T> dst(src);
+  for (int i = 0; i < iterations; ++i) {
+    const T* x = src.data();
+    T* y = dst.data();
+    for (int64_t elem = begin; elem < end; ++elem) {
+      T taps[kTapCount];
+      for (int t = 0; t < kTapCount; ++t) {
+        taps[t] = x[elem + offsets[t]];
+      }
+      y[elem] = S::compute(taps);
+    }
+    src.swap(dst);
+  }
+  std::copy(src.begin(), src.end(), out);
+}
+
+#endif  // __SYNTHESIS__
+
+}  // namespace stencil
+}  // namespace tapa
+
+#endif  // TAPA_STENCIL_H_
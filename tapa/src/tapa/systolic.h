@@ -0,0 +1,454 @@
+#ifndef TAPA_SYSTOLIC_H_
+#define TAPA_SYSTOLIC_H_
+
+#include <cstdint>
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "tapa.h"
+
+// A systolic array computing C = A * B, where A is m x k and B is k x n, is
+// declared by a struct S with the following members:
+//
+//   using type = float;                   // element type
+//   static constexpr int kRows = 4;       // PE rows
+//   static constexpr int kCols = 4;       // PE columns
+//   static constexpr int kTileM = 8;      // rows of C kept by each PE
+//   static constexpr int kTileN = 2;      // columns of C computed by each PE
+//   static constexpr tapa::systolic::dataflow kDataflow =
+//       tapa::systolic::output_stationary;
+//
+// Each column of the array is a task; the kRows PEs of a column are unrolled
+// in the task and share the B operand. Columns are chained by streams that
+// move A to the east, and each column writes its results to its own stream.
+//
+// With output_stationary, each PE accumulates kTileM x kTileN elements of C
+// and processes one row of its tile per cycle. The sum of a row is only read
+// kTileM cycles later, so kTileM must be at least min_tile_m<type>(), a bound
+// of the latency of the addition. A and C are column-major, B is row-major,
+// m is a multiple of kRows * kTileM, and n is a multiple of kCols * kTileN.
+//
+// With weight_stationary, each PE keeps one row of kTileN elements of B and
+// the sums are reduced over the rows of a column; kTileM is not used. A, B,
+// and C are row-major, k is a multiple of kRows, and n is a multiple of
+// kCols * kTileN.
+
+namespace tapa {
+namespace systolic {
+
+/// Which operand stays in the PEs.
+enum dataflow {
+  output_stationary,
+  weight_stationary,
+};
+
+/// Type of the tokens of A, each holding one element for each PE row.
+template <typename S>
+using a_vec = vec_t<typename S::type, S::kRows>;
+
+/// Type of the tokens of B sent to each column.
+template <typename S>
+using b_vec = vec_t<typename S::type, S::kTileN>;
+
+/// Type of the tokens of C written by each column.
+template <typename S>
+using c_vec = typename std::conditional<S::kDataflow == output_stationary,
+                                        vec_t<typename S::type, S::kRows>,
+                                        b_vec<S>>::type;
+
+/// Type of the elements of the B memory, each holding a row for all columns.
+template <typename S>
+using b_mem = vec_t<typename S::type, S::kCols * S::kTileN>;
+
+/// Type of the elements of the C memory.
+template <typename S>
+using c_mem = typename std::conditional<S::kDataflow == output_stationary,
+                                        c_vec<S>, b_mem<S>>::type;
+
+/// Minimum kTileM of output_stationary arrays of element type @c T.
+///
+/// Floating-point additions take up to this many cycles at high clock
+/// frequencies; integer additions complete in one cycle.
+template <typename T>
+constexpr int min_tile_m() {
+  return std::is_floating_point<T>::value ? 8 : 1;
+}
+
+namespace internal {
+
+template <dataflow D>
+using dataflow_tag = std::integral_constant<dataflow, D>;
+
+template <typename S>
+using dataflow_of = dataflow_tag<S::kDataflow>;
+
+template <typename S>
+inline void feed_a(dataflow_tag<output_stationary>, const a_vec<S>* mem,
+                   ostream<a_vec<S>>& out, uint64_t m, uint64_t n,
+                   uint64_t k) {
+  const uint64_t m_words = m / S::kRows;
+  for (uint64_t bm = 0; bm < m / (S::kRows * S::kTileM); ++bm) {
+    for (uint64_t bn = 0; bn < n / (S::kCols * S::kTileN); ++bn) {
+      for (uint64_t kk = 0; kk < k; ++kk) {
+        for (int t = 0; t < S::kTileM; ++t) {
+#pragma HLS pipeline II = 1
+          out.write(mem[kk * m_words + bm * S::kTileM + t]);
+        }
+      }
+    }
+  }
+}
+
+template <typename S>
+inline void feed_a(dataflow_tag<weight_stationary>, const a_vec<S>* mem,
+                   ostream<a_vec<S>>& out, uint64_t m, uint64_t n,
+                   uint64_t k) {
+  const uint64_t k_words = k / S::kRows;
+  for (uint64_t bn = 0; bn < n / (S::kCols * S::kTileN); ++bn) {
+    for (uint64_t bk = 0; bk < k_words; ++bk) {
+      for (uint64_t mm = 0; mm < m; ++mm) {
+#pragma HLS pipeline II = 1
+        out.write(mem[mm * k_words + bk]);
+      }
+    }
+  }
+}
+
+template <typename S>
+inline void write_b(const b_mem<S>& row, ostreams<b_vec<S>, S::kCols>& out) {
+#pragma HLS inline
+  for (int j = 0; j < S::kCols; ++j) {
+#pragma HLS unroll
+    out[j].write(truncated<S::kTileN>(row, j * S::kTileN));
+  }
+}
+
+template <typename S>
+inline void feed_b(dataflow_tag<output_stationary>, const b_mem<S>* mem,
+                   ostreams<b_vec<S>, S::kCols>& out, uint64_t m, uint64_t n,
+                   uint64_t k) {
+  const uint64_t n_words = n / (S::kCols * S::kTileN);
+  for (uint64_t bm = 0; bm < m / (S::kRows * S::kTileM); ++bm) {
+    for (uint64_t bn = 0; bn < n_words; ++bn) {
+      for (uint64_t kk = 0; kk < k; ++kk) {
+#pragma HLS pipeline II = 1
+        write_b<S>(mem[kk * n_words + bn], out);
+      }
+    }
+  }
+}
+
+template <typename S>
+inline void feed_b(dataflow_tag<weight_stationary>, const b_mem<S>* mem,
+                   ostreams<b_vec<S>, S::kCols>& out, uint64_t m, uint64_t n,
+                   uint64_t k) {
+  const uint64_t n_words = n / (S::kCols * S::kTileN);
+  for (uint64_t bn = 0; bn < n_words; ++bn) {
+    for (uint64_t kk = 0; kk < k; ++kk) {
+#pragma HLS pipeline II = 1
+      write_b<S>(mem[kk * n_words + bn], out);
+    }
+  }
+}
+
+template <typename S>
+inline void column(dataflow_tag<output_stationary>, istream<a_vec<S>>& a_in,
+                   ostream<a_vec<S>>& a_out, istream<b_vec<S>>& b_in,
+                   ostream<c_vec<S>>& c_out, uint64_t m, uint64_t n,
+                   uint64_t k) {
+  using T = typename S::type;
+  // the accumulator dependence is removed below, which is only valid if a row
+  // of acc is not read before its previous update completes
+  static_assert(S::kTileM >= min_tile_m<T>(),
+                "kTileM must cover the latency of the addition");
+  T acc[S::kTileM][S::kRows][S::kTileN];
+#pragma HLS array_partition variable = acc complete dim = 2
+#pragma HLS array_partition variable = acc complete dim = 3
+  for (uint64_t bm = 0; bm < m / (S::kRows * S::kTileM); ++bm) {
+    for (uint64_t bn = 0; bn < n / (S::kCols * S::kTileN); ++bn) {
+      b_vec<S> b;
+      for (uint64_t kk = 0; kk < k; ++kk) {
+        for (int t = 0; t < S::kTileM; ++t) {
+#pragma HLS pipeline II = 1
+#pragma HLS dependence variable = acc inter false
+          const a_vec<S> a = a_in.read();
+          a_out.write(a);
+          if (t == 0) b = b_in.read();
+          for (int i = 0; i < S::kRows; ++i) {
+#pragma HLS unroll
+            for (int j = 0; j < S::kTileN; ++j) {
+#pragma HLS unroll
+              acc[t][i][j] = (kk == 0 ? T() : acc[t][i][j]) + a[i] * b[j];
+            }
+          }
+        }
+      }
+
+      // each token is a column of the tile
+      for (int j = 0; j < S::kTileN; ++j) {
+        for (int t = 0; t < S::kTileM; ++t) {
+#pragma HLS pipeline II = 1
+          c_vec<S> c;
+          for (int i = 0; i < S::kRows; ++i) {
+#pragma HLS unroll
+            c.set(i, acc[t][i][j]);
+          }
+          c_out.write(c);
+        }
+      }
+    }
+  }
+}
+
+template <typename S>
+inline void column(dataflow_tag<weight_stationary>, istream<a_vec<S>>& a_in,
+                   ostream<a_vec<S>>& a_out, istream<b_vec<S>>& b_in,
+                   ostream<c_vec<S>>& c_out, uint64_t m, uint64_t n,
+                   uint64_t k) {
+  using T = typename S::type;
+  b_vec<S> w[S::kRows];
+#pragma HLS array_partition variable = w complete
+  for (uint64_t bn = 0; bn < n / (S::kCols * S::kTileN); ++bn) {
+    for (uint64_t bk = 0; bk < k / S::kRows; ++bk) {
+      for (int i = 0; i < S::kRows; ++i) {
+#pragma HLS pipeline II = 1
+        w[i] = b_in.read();
+      }
+      for (uint64_t mm = 0; mm < m; ++mm) {
+#pragma HLS pipeline II = 1
+        const a_vec<S> a = a_in.read();
+        a_out.write(a);
+        c_vec<S> c;
+        for (int j = 0; j < S::kTileN; ++j) {
+#pragma HLS unroll
+          T sum = T();
+          for (int i = 0; i < S::kRows; ++i) {
+#pragma HLS unroll
+            sum += a[i] * w[i][j];
+          }
+          c.set(j, sum);
+        }
+        c_out.write(c);
+      }
+    }
+  }
+}
+
+template <typename S>
+inline void store_c(dataflow_tag<output_stationary>, istream<a_vec<S>>& a_in,
+                    istreams<c_vec<S>, S::kCols>& c_in, c_mem<S>* mem,
+                    uint64_t m, uint64_t n, uint64_t k) {
+  const uint64_t m_words = m / S::kRows;
+  for (uint64_t bm = 0; bm < m / (S::kRows * S::kTileM); ++bm) {
+    for (uint64_t bn = 0; bn < n / (S::kCols * S::kTileN); ++bn) {
+      for (uint64_t i = 0; i < k * S::kTileM; ++i) {
+#pragma HLS pipeline II = 1
+        a_in.read();
+      }
+      for (int j = 0; j < S::kCols; ++j) {
+        for (int jj = 0; jj < S::kTileN; ++jj) {
+          for (int t = 0; t < S::kTileM; ++t) {
+#pragma HLS pipeline II = 1
+            const uint64_t col = (bn * S::kCols + j) * S::kTileN + jj;
+            mem[col * m_words + bm * S::kTileM + t] = c_in[j].read();
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename S>
+inline void store_c(dataflow_tag<weight_stationary>, istream<a_vec<S>>& a_in,
+                    istreams<c_vec<S>, S::kCols>& c_in, c_mem<S>* mem,
+                    uint64_t m, uint64_t n, uint64_t k) {
+  const uint64_t n_words = n / (S::kCols * S::kTileN);
+  for (uint64_t bn = 0; bn < n_words; ++bn) {
+    for (uint64_t bk = 0; bk < k / S::kRows; ++bk) {
+      for (uint64_t mm = 0; mm < m; ++mm) {
+#pragma HLS pipeline II = 1
+        // mem[idx] of the previous row block may still be in flight when m is
+        // small, so the dependence on mem must be kept.
+        a_in.read();
+        c_mem<S> c;
+        for (int j = 0; j < S::kCols; ++j) {
+#pragma HLS unroll
+          const c_vec<S> sum = c_in[j].read();
+          for (int jj = 0; jj < S::kTileN; ++jj) {
+#pragma HLS unroll
+            c.set(j * S::kTileN + jj, sum[jj]);
+          }
+        }
+        const uint64_t idx = mm * n_words + bn;
+        mem[idx] = bk == 0 ? c : mem[idx] + c;
+      }
+    }
+  }
+}
+
+}  // namespace internal
+
+/// Reads A from @c mem and writes it to the first column of systolic array
+/// @c S in the order the columns consume it.
+///
+/// @param mem A, whose layout depends on @c S::kDataflow.
+/// @param out Stream to the first column.
+/// @param m   Rows of A and C.
+/// @param n   Columns of B and C.
+/// @param k   Columns of A and rows of B.
+template <typename S>
+inline void feed_a(const a_vec<S>* mem, ostream<a_vec<S>>& out, uint64_t m,
+                   uint64_t n, uint64_t k) {
+  internal::feed_a<S>(internal::dataflow_of<S>(), mem, out, m, n, k);
+}
+
+/// Reads row-major B from @c mem and writes the slice of each column of
+/// systolic array @c S to its stream, one row of B per cycle.
+///
+/// @param mem Row-major B.
+/// @param out Streams to the columns.
+/// @param m   Rows of A and C.
+/// @param n   Columns of B and C.
+/// @param k   Columns of A and rows of B.
+template <typename S>
+inline void feed_b(const b_mem<S>* mem, ostreams<b_vec<S>, S::kCols>& out,
+                   uint64_t m, uint64_t n, uint64_t k) {
+  internal::feed_b<S>(internal::dataflow_of<S>(), mem, out, m, n, k);
+}
+
+/// Runs one column of systolic array @c S.
+///
+/// Each cycle, the column reads a token of A from the west, forwards it to the
+/// east, and updates its PEs with the slice of B read from @c b_in. Invoke the
+/// columns with @c tapa::join over the same streams of A, so column @c j reads
+/// the @c j-th stream and writes the next one.
+///
+/// @param a_in  A from the west.
+/// @param a_out A to the east.
+/// @param b_in  B of this column.
+/// @param c_out C of this column.
+/// @param m     Rows of A and C.
+/// @param n     Columns of B and C.
+/// @param k     Columns of A and rows of B.
+template <typename S>
+inline void column(istream<a_vec<S>>& a_in, ostream<a_vec<S>>& a_out,
+                   istream<b_vec<S>>& b_in, ostream<c_vec<S>>& c_out,
+                   uint64_t m, uint64_t n, uint64_t k) {
+  internal::column<S>(internal::dataflow_of<S>(), a_in, a_out, b_in, c_out, m,
+                      n, k);
+}
+
+/// Writes the results of all columns of systolic array @c S to @c mem.
+///
+/// With @c weight_stationary, the sums of successive row blocks of B are
+/// accumulated in @c mem, which is read back for all blocks but the first.
+/// Each read waits for the write of the same element by the previous block,
+/// so small @c m limits the throughput by the memory latency.
+///
+/// @param a_in A from the last column, which is discarded.
+/// @param c_in C of the columns.
+/// @param mem  C, whose layout depends on @c S::kDataflow.
+/// @param m    Rows of A and C.
+/// @param n    Columns of B and C.
+/// @param k    Columns of A and rows of B.
+template <typename S>
+inline void store_c(istream<a_vec<S>>& a_in,
+                    istreams<c_vec<S>, S::kCols>& c_in, c_mem<S>* mem,
+                    uint64_t m, uint64_t n, uint64_t k) {
+  internal::store_c<S>(internal::dataflow_of<S>(), a_in, c_in, mem, m, n, k);
+}
+
+#ifndef __SYNTHESIS__
+
+/// Computes C = A * B on the host in the layouts of systolic array @c S.
+///
+/// The sums are accumulated in the same order as in the array, so the result
+/// is the same as that of the array. The innermost loops run over contiguous
+/// elements without dependences, which compilers vectorize.
+///
+/// @param a A, whose layout depends on @c S::kDataflow.
+/// @param b Row-major B.
+/// @param c C, whose layout depends on @c S::kDataflow.
+/// @param m Rows of A and C.
+/// @param n Columns of B and C.
+/// @param k Columns of A and rows of B.
+template <typename S>
+inline void run(const typename S::type* a, const typename S::type* b,
+                typename S::type* c, uint64_t m, uint64_t n, uint64_t k) {
+  using T = typename S::type;
+  if (S::kDataflow == output_stationary) {
+    // c[j][i] += b[kk][j] * a[kk][i]
+    for (uint64_t j = 0; j < n; ++j) {
+      T* c_col = c + j * m;
+      for (uint64_t i = 0; i < m; ++i) c_col[i] = T();
+      for (uint64_t kk = 0; kk < k; ++kk) {
+        const T b_elem = b[kk * n + j];
+        const T* a_col = a + kk * m;
+        for (uint64_t i = 0; i < m; ++i) {
+          c_col[i] += a_col[i] * b_elem;
+        }
+      }
+    }
+  } else {
+    // sums of S::kRows elements are accumulated in c
+    std::vector<T> sum(n);
+    for (uint64_t i = 0; i < m; ++i) {
+      T* c_row = c + i * n;
+      for (uint64_t bk = 0; bk < k / S::kRows; ++bk) {
+        std::fill(sum.begin(), sum.end(), T());
+        for (int r = 0; r < S::kRows; ++r) {
+          const uint64_t kk = bk * S::kRows + r;
+          const T a_elem = a[i * k + kk];
+          const T* b_row = b + kk * n;
+          for (uint64_t j = 0; j < n; ++j) {
+            sum[j] += a_elem * b_row[j];
+          }
+        }
+        for (uint64_t j = 0; j < n; ++j) {
+          c_row[j] = bk == 0 ? sum[j] : c_row[j] + sum[j];
+        }
+      }
+    }
+  }
+}
+
+/// Lowers a valid 2D convolution with stride 1 to the B operand of a GEMM.
+///
+/// @c out is row-major with @c channels * @c kernel * @c kernel rows and
+/// (@c height - @c kernel + 1) * (@c width - @c kernel + 1) columns. With the
+/// row-major weights of each output channel as the rows of A, C = A * B is the
+/// row-major output of the convolution, so @c weight_stationary arrays can
+/// compute it directly.
+///
+/// @param in       Input with @c channels x @c height x @c width elements.
+/// @param channels Input channels.
+/// @param height   Input rows.
+/// @param width    Input columns.
+/// @param kernel   Rows and columns of the kernel.
+/// @param out      Lowered matrix.
+template <typename T>
+inline void im2col(const T* in, int channels, int height, int width,
+                   int kernel, T* out) {
+  const int out_height = height - kernel + 1;
+  const int out_width = width - kernel + 1;
+  for (int c = 0; c < channels; ++c) {
+    for (int p = 0; p < kernel; ++p) {
+      for (int q = 0; q < kernel; ++q) {
+        for (int y = 0; y < out_height; ++y) {
+          const T* src = in + (c * height + y + p) * width + q;
+          std::copy(src, src + out_width, out);
+          out += out_width;
+        }
+      }
+    }
+  }
+}
+
+#endif  // __SYNTHESIS__
+
+}  // namespace systolic
+}  // namespace tapa
+
+#endif  // TAPA_SYSTOLIC_H_
@@ -0,0 +1,83 @@
+#ifndef TAPA_XILINX_HLS_MOVER_H_
+#define TAPA_XILINX_HLS_MOVER_H_
+
+#include <cstdint>
+
+#include <type_traits>
+
+#include "tapa/xilinx/hls/mmap.h"
+#include "tapa/xilinx/hls/stream.h"
+#include "tapa/xilinx/hls/util.h"
+
+#ifdef TAPA_BUFFER_SUPPORT
+#include "tapa/xilinx/hls/buffer.h"
+#endif
+
+// HLS fallbacks of the movers, used when the calling task is not an RTL task.
+// Width conversion is only available in the RTL implementation.
+
+namespace tapa {
+
+template <typename T, typename U>
+inline void mmap_to_stream(T* mem, uint64_t n, ostream<U>& out) {
+#pragma HLS inline
+  static_assert(sizeof(T) == sizeof(U),
+                "width conversion requires an rtl task");
+  for (uint64_t i = 0; i < n; ++i) {
+#pragma HLS pipeline II = 1
+    out.write(bit_cast<U>(mem[i]));
+  }
+}
+
+template <typename T, typename U>
+inline void stream_to_mmap(istream<U>& in, T* mem, uint64_t n) {
+#pragma HLS inline
+  static_assert(sizeof(T) == sizeof(U),
+                "width conversion requires an rtl task");
+  for (uint64_t i = 0; i < n; ++i) {
+#pragma HLS pipeline II = 1
+    mem[i] = bit_cast<T>(in.read());
+  }
+}
+
+#ifdef TAPA_BUFFER_SUPPORT
+
+template <typename T, typename U, int n_sections, typename... dims>
+inline void mmap_to_buffer(U* mem, uint64_t n,
+                           obuffer<T, n_sections, dims...>& buf) {
+#pragma HLS inline
+  using elem_t = std::remove_all_extents_t<T>;
+  constexpr uint64_t kLen = sizeof(T) / sizeof(elem_t);
+  static_assert(std::rank<T>::value == 1 && sizeof(elem_t) == sizeof(U),
+                "sections must be arrays of mmap elements");
+  for (uint64_t i = 0; i < n; ++i) {
+    auto section = buf.acquire();
+    for (uint64_t j = 0; j < kLen; ++j) {
+#pragma HLS pipeline II = 1
+      section()[j] = bit_cast<elem_t>(mem[i * kLen + j]);
+    }
+  }
+}
+
+template <typename T, typename U, int n_sections, typename... dims>
+inline void buffer_to_mmap(ibuffer<T, n_sections, dims...>& buf, U* mem,
+                           uint64_t n) {
+#pragma HLS inline
+  using elem_t = std::remove_all_extents_t<T>;
+  constexpr uint64_t kLen = sizeof(T) / sizeof(elem_t);
+  static_assert(std::rank<T>::value == 1 && sizeof(elem_t) == sizeof(U),
+                "sections must be arrays of mmap elements");
+  for (uint64_t i = 0; i < n; ++i) {
+    auto section = buf.acquire();
+    for (uint64_t j = 0; j < kLen; ++j) {
+#pragma HLS pipeline II = 1
+      mem[i * kLen + j] = bit_cast<std::remove_const_t<U>>(section()[j]);
+    }
+  }
+}
+
+#endif  // TAPA_BUFFER_SUPPORT
+
+}  // namespace tapa
+
+#endif  // TAPA_XILINX_HLS_MOVER_H_
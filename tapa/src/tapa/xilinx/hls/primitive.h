@@ -0,0 +1,28 @@
+#ifndef TAPA_XILINX_HLS_PRIMITIVE_H_
+#define TAPA_XILINX_HLS_PRIMITIVE_H_
+
+#include <cstdint>
+
+#include "tapa/xilinx/hls/stream.h"
+
+// The stream routing primitives are only available in RTL tasks, which are
+// implemented by the built-in RTL modules and never synthesized with HLS, so
+// they are declared but not defined here.
+
+namespace tapa {
+
+template <typename T, uint64_t N>
+void merge(istreams<T, N>& in, ostream<T>& out);
+
+template <int key_lsb, typename T, uint64_t N>
+void demux(istream<T>& in, ostreams<T, N>& out);
+
+template <typename T, uint64_t N>
+void broadcast(istream<T>& in, ostreams<T, N>& out);
+
+template <int key_lsb, typename T, uint64_t N>
+void butterfly(istreams<T, N>& in, ostreams<T, N>& out);
+
+}  // namespace tapa
+
+#endif  // TAPA_XILINX_HLS_PRIMITIVE_H_
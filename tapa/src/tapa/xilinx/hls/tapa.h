@@ -6,6 +6,8 @@
 #ifdef __SYNTHESIS__
 
 #include "tapa/xilinx/hls/mmap.h"
+#include "tapa/xilinx/hls/mover.h"
+#include "tapa/xilinx/hls/primitive.h"
 #include "tapa/xilinx/hls/stream.h"
 #include "tapa/xilinx/hls/task.h"
 #include "tapa/xilinx/hls/util.h"